@@ -26,17 +26,18 @@ namespace gui{
   //! Application tool type
   enum ToolType{NoneTool, SelectTool, DragTool, DBGenTool, MeasureTool, ElectrodeTool,
                 AFMAreaTool, AFMPathTool, ScreenshotAreaTool, ScaleBarAnchorTool,
-                LabelTool};
+                LabelTool, AreaOfInterestTool};
 
   //! Design Panel display mode
   enum DisplayMode{DesignMode, SimDisplayMode, ScreenshotMode};
 
   //! Design save/export area inclusion policy
   //! IncludeEntireDesign: All items contained in layers.
-  //! IncludeAreaOfInterest: All items within the indiciated area of interest 
-  //!                        (NOTE AoE feature not implemented yet).
   //! IncludeSelectedItems: All items that are currently selected.
-  enum DesignInclusionArea{IncludeEntireDesign, IncludeSelectedItems};
+  //! IncludeAreaOfInterest: All items within the area of interest polygon or
+  //!                        within its halo distance.
+  enum DesignInclusionArea{IncludeEntireDesign, IncludeSelectedItems,
+                           IncludeAreaOfInterest};
   Q_ENUM_NS(DesignInclusionArea)
 
   // Handy unit functions
@@ -19,6 +19,8 @@
 // gui includes
 #include "application.h"
 #include "settings/settings.h"
+#include "save_context.h"
+#include "widgets/gzip_device.h"
 
 
 // init the DialogPanel to NULL until build in constructor
@@ -61,6 +63,9 @@ gui::ApplicationGUI::ApplicationGUI(const QString &f_path, QWidget *parent)
 // destructor
 gui::ApplicationGUI::~ApplicationGUI()
 {
+  // finish a running autosave before the autosave directory is removed
+  autosave_pool.waitForDone();
+
   QStringList settings_remove_paths;
   if (reset_settings) {
     // store list of config files to be removed at the end
@@ -127,10 +132,11 @@ void gui::ApplicationGUI::dropEvent(QDropEvent *e)
   QList<QUrl> url_list = mime_data->urls();
   if (url_list.length() == 1) {
     QString f_path = url_list.at(0).toLocalFile();
-    if (f_path.right(4) == ".sqd")
+    QString design_path = gui::GzipDevice::stripGzipSuffix(f_path);
+    if (design_path.right(4) == ".sqd" || sqb::isBinaryDesignPath(design_path))
       openFromFile(f_path);
     else
-      qWarning() << tr("Only accept dropping of *.sqd files. Your attempted path was %1.").arg(f_path);
+      qWarning() << tr("Only accept dropping of *.sqd, *.sqd.gz and *.sqb files. Your attempted path was %1.").arg(f_path);
   } else {
     qWarning() << tr("Drop event only supports opening exactly 1 file, %1 \
         received instead.").arg(url_list.length());
@@ -170,6 +176,7 @@ void gui::ApplicationGUI::initGUI()
   sim_visualize = new gui::SimVisualizer(design_pan, this);
   job_manager = new gui::JobManager(plugin_manager, sim_visualize, this);
   settings_dialog = new settings::SettingsDialog(this);
+  design_loader = new gui::DesignLoader(design_pan, this);
 
   // initialise docks
   initDialogDock();
@@ -178,6 +185,7 @@ void gui::ApplicationGUI::initGUI()
   initSimVisualizerDock();
   initInfoDock();
   tabifyDockWidget(item_dock, layer_dock);
+  initLoadProgress();
 
   // initialise bars
   initMenuBar(); // must run before initTopBar
@@ -206,12 +214,17 @@ void gui::ApplicationGUI::initGUI()
 
   // widget-app gui signals
   connect(job_manager, &gui::JobManager::sig_exportJobProblem,
-          [this](comp::JobStep *js, gui::DesignInclusionArea inclusion_area)
+          [this](comp::JobStep *js, gui::DesignInclusionArea inclusion_area,
+                 const prim::AreaOfInterest &area)
           {
-            saveToFile(SaveSimulationProblem, js->problemPath(), inclusion_area, js);
+            saveToFile(SaveSimulationProblem, js->problemPath(), inclusion_area, js, area);
           });
+  connect(design_pan, &gui::DesignPanel::sig_areaOfInterestChanged,
+          job_manager, &gui::JobManager::setAreaOfInterest);
   connect(settings_dialog, &settings::SettingsDialog::sig_resetSettings,
           [this](){reset_settings = true;});
+  connect(settings_dialog, &settings::SettingsDialog::sig_settingsApplied,
+          [](){gui::SaveContext::refreshDefault();});
   connect(design_pan, &gui::DesignPanel::sig_preDPResetCleanUp,
           [this]()
           {
@@ -314,6 +327,7 @@ void gui::ApplicationGUI::initMenuBar()
       QIcon::fromTheme("document-save-as", QIcon(":/ico/fb/document-save.svg")), 
       tr("Save &As..."), this);
   QAction *import_job_results = new QAction(tr("Import Past Results"), this);
+  QAction *recover_autosave = new QAction(tr("Recover Autosave..."), this);
   QAction *quit = new QAction(QIcon::fromTheme("application-exit",
         QIcon(":/ico/fb/exit.svg")), tr("&Quit"), this);
   // new_file->setShortcut(tr("CTRL+N"));
@@ -327,6 +341,7 @@ void gui::ApplicationGUI::initMenuBar()
   file->addAction(save);
   file->addAction(save_as);
   file->addSeparator();
+  file->addAction(recover_autosave);
   file->addAction(import_job_results);
   file->addSeparator();
   file->addAction(quit);
@@ -383,11 +398,20 @@ void gui::ApplicationGUI::initMenuBar()
 
   action_screenshot_mode->setCheckable(true);
 
+  // area of interest for region exports
+  QMenu *aoi_menu = new QMenu(tr("Area of Interest"), this);
+  QAction *action_aoi_tool = aoi_menu->addAction(tr("Draw Area of Interest"));
+  QAction *action_aoi_from_clip = aoi_menu->addAction(tr("Use Screenshot Clip Area"));
+  QAction *action_aoi_clear = aoi_menu->addAction(tr("Clear Area of Interest"));
+  action_aoi_tool->setStatusTip(tr("Click to place vertices, double click or "
+        "press Enter to close the area."));
+
   
   //tools->addAction(select_color);
   //tools->addSeparator();
   //tools->addAction(window_screenshot);  // TODO disabled due to imperfect screenshot results
   tools->addAction(action_screenshot_mode);
+  tools->addMenu(aoi_menu);
   tools->addSeparator();
   tools->addAction(action_plugin_man);
   tools->addSeparator();
@@ -419,6 +443,8 @@ void gui::ApplicationGUI::initMenuBar()
       });
   connect(open_save, &QAction::triggered,
       [this](){openFromFile();});
+  connect(recover_autosave, &QAction::triggered,
+      [this](){recoverAutosave();});
   connect(import_job_results, &QAction::triggered,
       [this](){
         comp::SimJob *j = comp::SimJob::importSimJob();
@@ -459,6 +485,12 @@ void gui::ApplicationGUI::initMenuBar()
       });
   connect(action_screenshot_mode, &QAction::triggered,
           this, &gui::ApplicationGUI::toggleScreenshotMode);
+  connect(action_aoi_tool, &QAction::triggered,
+      [this](){setTool(gui::ToolType::AreaOfInterestTool);});
+  connect(action_aoi_from_clip, &QAction::triggered,
+      [this](){design_pan->setAreaOfInterestFromClip();});
+  connect(action_aoi_clear, &QAction::triggered,
+      [this](){design_pan->setAreaOfInterest(prim::AreaOfInterest());});
   connect(action_settings_dialog, &QAction::triggered,
       [this](){settings_dialog->show();});
   connect(about_version, &QAction::triggered, this, &gui::ApplicationGUI::aboutVersion);
@@ -745,6 +777,45 @@ void gui::ApplicationGUI::initInfoDock()
   addDockWidget(area, info_dock);
 }
 
+void gui::ApplicationGUI::initLoadProgress()
+{
+  load_progress = new QProgressBar(this);
+  load_progress->setRange(0, 100);
+  load_progress->setMaximumWidth(200);
+  load_cancel_button = new QPushButton(tr("Cancel"), this);
+
+  statusBar()->addPermanentWidget(load_progress);
+  statusBar()->addPermanentWidget(load_cancel_button);
+  load_progress->hide();
+  load_cancel_button->hide();
+  statusBar()->hide();
+
+  connect(load_cancel_button, &QPushButton::clicked,
+          design_loader, &gui::DesignLoader::cancel);
+  connect(design_loader, &gui::DesignLoader::sig_progress,
+          load_progress, &QProgressBar::setValue);
+  connect(design_loader, &gui::DesignLoader::sig_finished,
+          [this](bool ok)
+          {
+            load_progress->hide();
+            load_cancel_button->hide();
+            if (ok) {
+              statusBar()->clearMessage();
+              statusBar()->hide();
+            } else {
+              // never save a partial design over the complete file
+              working_path.clear();
+              statusBar()->showMessage(tr("Design load incomplete"), 5000);
+              QTimer::singleShot(5000, this, [this]()
+                  {
+                    if (!design_loader->isLoading())
+                      statusBar()->hide();
+                  });
+            }
+            updateWindowTitle();
+          });
+}
+
 void gui::ApplicationGUI::initCommander()
 {
   commander = new Commander();
@@ -812,6 +883,9 @@ void gui::ApplicationGUI::loadSettings()
   // autosave related settings
   settings::AppSettings *app_settings = settings::AppSettings::instance();
   autosave_num = app_settings->get<int>("save/autosavenum");
+  autosave_gz_level = app_settings->get<int>("save/autosave_gzip_level");
+  autosave_pool.setMaxThreadCount(1);
+  checkpoint_every = qMax(1, app_settings->get<int>("save/journal_checkpoint_every"));
   autosave_root.setPath(app_settings->getPath("save/autosaveroot"));
 
   // autosave directory for current instance
@@ -905,6 +979,9 @@ void gui::ApplicationGUI::setTool(gui::ToolType tool)
       action_scale_bar_anchor_tool->setChecked(true);
       setToolScaleBarAnchor();
       break;
+    case gui::ToolType::AreaOfInterestTool:
+      setToolAreaOfInterest();
+      break;
       /*
     case gui::ToolType::LabelTool:
       action_label_tool->setChecked(true);
@@ -960,6 +1037,16 @@ void gui::ApplicationGUI::setToolScaleBarAnchor()
   design_pan->setTool(gui::ToolType::ScaleBarAnchorTool);
 }
 
+void gui::ApplicationGUI::setToolAreaOfInterest()
+{
+  if(design_pan->displayMode() != gui::DisplayMode::DesignMode){
+    qDebug() << tr("area of interest tool not allowed outside of design mode");
+    return;
+  }
+  qDebug() << tr("selecting area of interest tool");
+  design_pan->setTool(gui::ToolType::AreaOfInterestTool);
+}
+
 void gui::ApplicationGUI::setToolLabel()
 {
   qDebug() << tr("selecting label tool");
@@ -1242,8 +1329,15 @@ void gui::ApplicationGUI::newFile(QString lattice_file_path)
 bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
                                      const QString &path,
                                      gui::DesignInclusionArea inclusion_area,
-                                     comp::JobStep *job_step)
+                                     comp::JobStep *job_step,
+                                     const prim::AreaOfInterest &area)
 {
+  if (design_loader->isLoading()) {
+    // a partially loaded design would overwrite the complete file
+    qWarning() << tr("Cannot save while a design is loading.");
+    return false;
+  }
+
   if (design_pan->displayMode() == gui::SimDisplayMode
       && (flag == Save || flag == SaveAs)) {
     // Don't allow saving to file when displaying simulation results. This is 
@@ -1278,16 +1372,23 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
   } else if (working_path.isEmpty() || flag==SaveAs) {
     save_dialog.setDefaultSuffix("sqd");
     write_path = save_dialog.getSaveFileName(this, tr("Save File"),
-                  save_dir.filePath("new-db-layout.sqd"), tr("SQD (*.sqd);;All files (*)"));
+                  save_dir.filePath("new-db-layout.sqd"),
+                  tr("SQD (*.sqd);;Compressed SQD (*.sqd.gz);;SQB binary (*.sqb);;All files (*)"));
     if (write_path.isEmpty())
       return false;
   } else {
     write_path = working_path;
   }
 
-  // add .sqd extension if there isn't
-  if (!QStringList({"sqd", "qad", "xml"}).contains(QFileInfo(write_path).suffix()))
-    write_path.append(".sqd");
+  // add .sqd extension if there isn't, .sqb selects the binary container and
+  // a trailing .gz compresses the XML
+  QString design_path = gui::GzipDevice::stripGzipSuffix(write_path);
+  if (!QStringList({"sqd", "sqb", "qad", "xml"}).contains(QFileInfo(design_path).suffix()))
+    write_path = design_path.append(gui::GzipDevice::isGzipPath(write_path) ? ".sqd.gz" : ".sqd");
+
+  // an autosave may still be copying tiles from the file about to be replaced
+  if (design_pan->isTiled())
+    autosave_pool.waitForDone();
 
   // set file name to write_path.writing while writing to prevent loss of
   // previous save if this save fails
@@ -1298,18 +1399,82 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
     return false;
   }
 
-  // WRITE TO XML
-  QXmlStreamWriter ws(&file);
-  qDebug() << tr("Save: Beginning write to %1").arg(file.fileName());
-  ws.setAutoFormatting(true);
-  ws.writeStartDocument();
+  // simulation problems are only read by the engines and skip the indentation
+  bool compact = flag == SaveSimulationProblem
+      && settings::AppSettings::instance()->get<bool>("save/compact_sim_problems");
+  gui::SaveContext save_ctx(compact ? gui::SaveContext::Compact : gui::SaveContext::Pretty);
+  gui::SaveContext::Scope save_scope(&save_ctx);
+
+  if (sqb::isBinaryDesignPath(write_path)) {
+    // WRITE TO BINARY CONTAINER
+    qDebug() << tr("Save: Beginning binary write to %1").arg(file.fileName());
+    QByteArray head;
+    QXmlStreamWriter hs(&head);
+    hs.setAutoFormatting(true);
+    writeProgramFlags(&hs, flag, job_step);
+
+    sqb::Writer wr(&file);
+    if (!(wr.begin() && wr.writeHead(head)
+          && design_pan->writeToBinaryStream(&wr, inclusion_area, area) && wr.finish())) {
+      qCritical() << tr("Save: Error when writing %1: %2").arg(file.fileName())
+          .arg(wr.errorString());
+      file.close();
+      file.remove();
+      return false;
+    }
+    file.close();
+  } else {
+    // WRITE TO XML
+    int gz_level = settings::AppSettings::instance()->get<int>(
+        flag == AutoSave ? "save/autosave_gzip_level" : "save/gzip_level");
+    QIODevice *out = gui::GzipDevice::compressing(&file, write_path, gz_level);
+    QXmlStreamWriter ws(out);
+    qDebug() << tr("Save: Beginning write to %1").arg(file.fileName());
+    save_ctx.setupWriter(&ws);
+    ws.writeStartDocument();
+
+    // call the save functions for each relevant class
+    ws.writeStartElement("siqad");
+
+    writeProgramFlags(&ws, flag, job_step);
+
+    // save design panel content (including GUI flags, layers and their corresponding contents (electrode, dbs, etc.)
+    design_pan->writeToXmlStream(&ws, inclusion_area, area);
+
+    // close root element & close file
+    ws.writeEndElement();
+    out->close();
+    file.close();
+  }
+
+  // delete the existing file and rename the new one to it
+  QFile::remove(write_path);
+  file.rename(write_path);
+
+  // clean tiles are read from the saved file from now on
+  if ((flag == Save || flag == SaveAs) && inclusion_area == gui::IncludeEntireDesign
+      && design_pan->isTiled() && sqb::isBinaryDesignPath(write_path))
+    design_pan->rebaseTiles(write_path);
+
+  qDebug() << tr("Save: Write completed for %1").arg(file.fileName());
+
+  // update working path if needed
+  if(flag == Save || flag == SaveAs){
+    save_dir.setPath(write_path);
+    working_path = write_path;
+    updateWindowTitle();
+  }
+
+  return true;
+}
 
-  // call the save functions for each relevant class
-  ws.writeStartElement("siqad");
 
+void gui::ApplicationGUI::writeProgramFlags(QXmlStreamWriter *ws,
+    gui::ApplicationGUI::SaveFlag flag, comp::JobStep *job_step)
+{
   // save program flags
-  ws.writeComment("Program Flags");
-  ws.writeStartElement("program");
+  ws->writeComment("Program Flags");
+  ws->writeStartElement("program");
 
   QString file_purpose;
   switch(flag){
@@ -1324,65 +1489,229 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
       file_purpose = "save";
       break;
   }
-  ws.writeTextElement("file_purpose", file_purpose);
-  ws.writeTextElement("version", QCoreApplication::applicationVersion());
-  ws.writeTextElement("date", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+  ws->writeTextElement("file_purpose", file_purpose);
+  ws->writeTextElement("version", QCoreApplication::applicationVersion());
+  ws->writeTextElement("date", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
 
-  ws.writeEndElement();
+  ws->writeEndElement();
 
   // save simulation parameters
   if (flag == SaveSimulationProblem && job_step != nullptr) {
-    ws.writeStartElement("sim_params");
+    ws->writeStartElement("sim_params");
     for (const QString &key : job_step->jobParameters().keys()) {
-      ws.writeTextElement(key, job_step->jobParameters().value(key));
+      ws->writeTextElement(key, job_step->jobParameters().value(key));
     }
-    ws.writeEndElement();
+    ws->writeEndElement();
   }
+}
 
-  // save design panel content (including GUI flags, layers and their corresponding contents (electrode, dbs, etc.)
-  design_pan->writeToXmlStream(&ws, inclusion_area);
-
-  // close root element & close file
-  ws.writeEndElement();
-  file.close();
 
-  // delete the existing file and rename the new one to it
-  QFile::remove(write_path);
-  file.rename(write_path);
+void gui::ApplicationGUI::autoSave()
+{
+  // unchanged designs and designs still loading are not saved
+  if (design_loader->isLoading())
+    return;
+  quint64 revision = design_pan->designRevision();
+  if (revision == autosave_revision) {
+    qDebug() << tr("Autosave: no changes since the last autosave, skipped");
+    return;
+  }
+  if (autosave_running) {
+    qDebug() << tr("Autosave: previous autosave still writing, skipped");
+    return;
+  }
 
-  qDebug() << tr("Save: Write completed for %1").arg(file.fileName());
+  qDebug() << tr("Autosave: %1").arg(autosave_dir.absolutePath());
+  if(!autosave_dir.exists()){
+    qCritical() << tr("Autosave: unable to create tmp instance directory at %1").arg(autosave_dir.path());
+    return;
+  }
 
-  // update working path if needed
-  if(flag == Save || flag == SaveAs){
-    save_dir.setPath(write_path);
-    working_path = write_path;
-    updateWindowTitle();
+  // append the recorded edits to the journal unless a checkpoint is due, the
+  // journal outgrowing the checkpoint makes replay slower than a reload.
+  // Tiled designs are always checkpointed, their item indices shift as tiles
+  // come and go and their checkpoints copy unchanged tiles as stored.
+  gui::DesignJournal *journal = design_pan->designJournal();
+  bool checkpoint = !journal->isRecording() || journal_path.isEmpty()
+      || journal_appends >= checkpoint_every || journal_bytes > checkpoint_bytes
+      || design_pan->isTiled();
+
+  QElapsedTimer snap_timer;
+  snap_timer.start();
+  sqb::DesignSnapshot snap;
+  QByteArray record;
+  QString autosave_path;
+  bool transient_only = false;
+  if (checkpoint) {
+    // capture the design on the GUI thread, serialize and write it on the pool
+    QByteArray program_flags;
+    QXmlStreamWriter hs(&program_flags);
+    hs.setAutoFormatting(true);
+    writeProgramFlags(&hs, AutoSave, nullptr);
+    snap = design_pan->snapshot(gui::IncludeEntireDesign);
+    snap.heads.prepend(program_flags);
+    journal->restart();
+
+    autosave_ind = (autosave_ind+1) % autosave_num;
+    // .sqb checkpoints of tiled designs are compressed by chunk
+    autosave_path = autosave_dir.filePath(tr("autosave-%1.%2").arg(autosave_ind)
+        .arg(design_pan->isTiled() ? "sqb" : (autosave_gz_level > 0 ? "xml.gz" : "xml")));
+    journal_path = gui::DesignJournal::journalPath(autosave_path);
+    journal_appends = 0;
+    journal_bytes = 0;
+  } else {
+    transient_only = journal->isTransientOnly();
+    record = journal->takeRecord();
+    autosave_path = journal_path;
+    journal_appends++;
+    journal_bytes += record.size();
+  }
+  qint64 snap_ms = snap_timer.elapsed();
+
+  // edits not kept in saved designs leave nothing to append, any other
+  // change of the design must have been journaled
+  if (!checkpoint && record.isEmpty()) {
+    if (transient_only) {
+      autosave_revision = revision;
+      qDebug() << tr("Autosave: no saved content changed, skipped");
+      return;
+    }
+    qCritical() << tr("Autosave: the design changed without journaled edits, "
+        "writing a checkpoint instead");
+    journal_path.clear();
+    autoSave();
+    return;
   }
 
-  return true;
+  autosave_running = true;
+  QString ckpt_journal_path = journal_path;
+  int gz_level = autosave_gz_level;
+  autosave_pool.start([this, snap, record, checkpoint, autosave_path, ckpt_journal_path,
+                       gz_level, revision, snap_ms]() {
+    QElapsedTimer write_timer;
+    write_timer.start();
+    QString err;
+    bool ok;
+    qint64 written;
+    if (checkpoint) {
+      // the checkpoint is complete before its journal starts
+      ok = sqb::saveSnapshot(snap, autosave_path, err, gz_level)
+          && gui::DesignJournal::createFile(ckpt_journal_path, err);
+      written = QFileInfo(autosave_path).size();
+    } else {
+      ok = gui::DesignJournal::appendRecord(autosave_path, record, err);
+      written = record.size();
+    }
+    qint64 write_ms = write_timer.elapsed();
+
+    QMetaObject::invokeMethod(this, [=]() {
+      autosave_running = false;
+      if (!ok) {
+        qCritical() << tr("Autosave: error when writing %1: %2").arg(autosave_path).arg(err);
+        // start over with a checkpoint so that no edits are lost
+        journal_path.clear();
+        return;
+      }
+      autosave_revision = revision;
+      if (checkpoint)
+        checkpoint_bytes = written;
+      qDebug() << tr("Autosave complete: %1 %2, %3 bytes, capture %4 ms on the GUI thread, write %5 ms")
+          .arg(checkpoint ? tr("checkpoint") : tr("journal record"))
+          .arg(autosave_path).arg(written).arg(snap_ms).arg(write_ms);
+    }, Qt::QueuedConnection);
+  });
 }
 
 
-void gui::ApplicationGUI::autoSave()
+void gui::ApplicationGUI::recoverAutosave(const QString &checkpoint_path)
 {
-  // no check for changes in state... unneccesary complexity
+  if (design_loader->isLoading()) {
+    qWarning() << tr("Wait for the current design to finish loading or cancel it.");
+    return;
+  }
+  if (design_pan->stateChanged())
+    if (!resolveUnsavedChanges())
+      return;
 
-  qDebug() << tr("Autosave: %1").arg(autosave_dir.absolutePath());
-  if(!autosave_dir.exists()){
-    qCritical() << tr("Autosave: unable to create tmp instance directory at %1").arg(autosave_dir.path());
+  QString ckpt_path = checkpoint_path;
+  if (ckpt_path.isEmpty()) {
+    ckpt_path = QFileDialog::getOpenFileName(this, tr("Recover Autosave"),
+        autosave_root.absolutePath(),
+        tr("Autosave checkpoints (autosave-*.xml autosave-*.xml.gz autosave-*.sqb);;All files (*.*)"));
+    if (ckpt_path.isEmpty())
+      return;
+  }
+
+  if (sqb::isBinaryDesignPath(ckpt_path)) {
+    // checkpoints of tiled designs have no journal, the copy backs the tiles
+    // since later autosaves replace the checkpoint
+    QString recovered_path = autosave_dir.filePath("recovered.sqb");
+    QFile::remove(recovered_path);
+    if (!QFile::copy(ckpt_path, recovered_path)) {
+      qCritical() << tr("Recovery: can't copy %1 to %2").arg(ckpt_path).arg(recovered_path);
+      return;
+    }
+    if (!design_pan->openTiled(recovered_path)) {
+      QFile file(recovered_path);
+      sqb::Reader rd(&file);
+      if (!file.open(QFile::ReadOnly) || !rd.begin()) {
+        qCritical() << tr("Recovery: error when opening %1: %2").arg(ckpt_path)
+            .arg(rd.hasError() ? rd.errorString() : file.errorString());
+        return;
+      }
+      design_pan->loadFromFile(&rd);
+    }
+    qDebug() << tr("Recovery: loaded %1").arg(ckpt_path);
+    working_path.clear();
+    design_pan->stateUnset();
+    updateWindowTitle();
     return;
   }
 
-  autosave_ind = (autosave_ind+1) % autosave_num;
-  QString autosave_path = autosave_dir.filePath(tr("autosave-%1.xml").arg(autosave_ind));
-  saveToFile(AutoSave, autosave_path);
+  // load the checkpoint synchronously so that the journal applies to it
+  QFile file(ckpt_path);
+  if (!file.open(QFile::ReadOnly)) {
+    qCritical() << tr("Recovery: error when opening %1: %2").arg(ckpt_path).arg(file.errorString());
+    return;
+  }
+  QXmlStreamReader rs(gui::GzipDevice::decompressing(&file));
+  rs.readNextStartElement();
+  design_pan->loadFromFile(&rs);
+  file.close();
 
-  qDebug() << tr("Autosave complete");
+  // replay the journal records in order, stopping at the first bad one
+  QString jpath = gui::DesignJournal::journalPath(ckpt_path);
+  QList<QByteArray> records;
+  QString err;
+  int applied = 0;
+  if (QFile::exists(jpath)) {
+    if (!gui::DesignJournal::readRecords(jpath, records, err))
+      qCritical() << tr("Recovery: can't read journal %1: %2").arg(jpath).arg(err);
+    else if (!err.isEmpty())
+      qWarning() << tr("Recovery: journal %1 ends with a damaged record: %2").arg(jpath).arg(err);
+    for (const QByteArray &record : records) {
+      if (!design_pan->applyJournalRecord(record))
+        break;
+      applied++;
+    }
+  }
+  qDebug() << tr("Recovery: loaded %1 and applied %2 of %3 journal records")
+      .arg(ckpt_path).arg(applied).arg(records.size());
+
+  // the recovered design is unsaved
+  working_path.clear();
+  design_pan->stateUnset();
+  updateWindowTitle();
 }
 
 
 void gui::ApplicationGUI::openFromFile(const QString &f_path)
 {
+  if (design_loader->isLoading()) {
+    qWarning() << tr("Wait for the current design to finish loading or cancel it.");
+    return;
+  }
+
   // prompt user to resolve unsaved changes if program has been modified
   if(design_pan->stateChanged())
     if(!resolveUnsavedChanges())
@@ -1395,38 +1724,34 @@ void gui::ApplicationGUI::openFromFile(const QString &f_path)
     QFileDialog load_dialog;
     load_dialog.setDefaultSuffix("sqd");
     open_path = load_dialog.getOpenFileName(this, tr("Open File"),
-        save_dir.absolutePath(), tr("SQD (*.sqd);;All files (*.*)"));
+        save_dir.absolutePath(), tr("SiQAD designs (*.sqd *.sqd.gz *.sqb);;All files (*.*)"));
     if(open_path.isEmpty()) {
       qDebug() << "No file chosen, cancelling file open operation.";
       return;
     }
   }
 
-  QFile file(open_path);
-
-  if(!file.open(QFile::ReadOnly | QFile::Text)){
-    qDebug() << tr("Error when opening file to read: %1").arg(file.errorString());
+  if (!QFileInfo(open_path).isReadable()) {
+    qDebug() << tr("Error when opening file to read: %1 is not readable").arg(open_path);
     return;
   }
 
-  working_path = open_path;
-  save_dir.setPath(QFileInfo(open_path).absolutePath());
-  updateWindowTitle();
-
-  // read from XML stream
-  QXmlStreamReader rs(&file);
-  qDebug() << tr("Beginning load from %1").arg(file.fileName());
-
   // TODO load program status here instead of from file
   // TODO if save type is simulation, warn the user when opening the file, especially the fact that sim params will not be retained the next time they save
 
-  // enter the root node and hand the loading over to design panel
-  rs.readNextStartElement();
-  design_pan->loadFromFile(&rs);
+  // the file is parsed on a worker thread and the design shows up as it loads
+  if (!design_loader->start(open_path))
+    return;
 
-  // clean up
-  file.close();
-  qDebug() << tr("Load complete");
+  working_path = open_path;
+  save_dir.setPath(QFileInfo(open_path).absolutePath());
+  updateWindowTitle();
+
+  load_progress->setValue(0);
+  load_progress->show();
+  load_cancel_button->show();
+  statusBar()->show();
+  statusBar()->showMessage(tr("Loading %1").arg(QFileInfo(open_path).fileName()));
 }
 
 void gui::ApplicationGUI::aboutVersion()
@@ -21,6 +21,7 @@
 
 // Widget includes
 #include "widgets/design_panel.h"
+#include "widgets/design_loader.h"
 #include "widgets/dialog_panel.h"
 #include "widgets/input_field.h"
 #include "widgets/info_panel.h"
@@ -70,6 +71,7 @@ namespace gui{
     void setToolElectrode();
     void setToolScreenshotArea();
     void setToolScaleBarAnchor();
+    void setToolAreaOfInterest();
     void setToolLabel();
 
     // add or remove actions from sidebar
@@ -121,14 +123,20 @@ namespace gui{
     // choose lattice for new file
     void chooseLatticeForNewFile();
 
-    //! Save design to file.
+    //! Save design to file. area is the area of interest saved with
+    //! IncludeAreaOfInterest, the design's area of interest if invalid.
     bool saveToFile(SaveFlag flag=Save, const QString &path=QString(),
                     gui::DesignInclusionArea inclusion_area=gui::IncludeEntireDesign,
-                    comp::JobStep *job_step=nullptr);
+                    comp::JobStep *job_step=nullptr,
+                    const prim::AreaOfInterest &area=prim::AreaOfInterest());
 
     //! Perform autosave.
     void autoSave();
 
+    //! Recover a design from an autosave checkpoint and its journal. A file
+    //! chooser dialog would be presented if no checkpoint path is given.
+    void recoverAutosave(const QString &checkpoint_path=QString());
+
     //! Open a previous save. A file chooser dialog would be presented if no
     //! file path is given.
     void openFromFile(const QString &f_path=QString());
@@ -149,6 +157,9 @@ namespace gui{
 
   private:
 
+    // write program flags and simulation parameters of a save
+    void writeProgramFlags(QXmlStreamWriter *ws, SaveFlag flag, comp::JobStep *job_step);
+
     // graphics initialisation
     void initGUI();               // initialise the mainwindow GUI
     void initMenuBar();           // initialise the GUI menubar
@@ -160,6 +171,7 @@ namespace gui{
     void initCommander();         // initialise the input field whitelist
     void initItemDock();          // initialise the side item dock
     void initInfoDock();          // initialise the bottom info dock
+    void initLoadProgress();      // initialise the status bar load progress
     // void initColorDialog();       // initialise the color dialog for changing item colors.
     void setLayerManagerWidget(QWidget *widget);
     void setItemManagerWidget(QWidget *widget);
@@ -202,6 +214,11 @@ namespace gui{
     gui::JobManager     *job_manager;     // pop-up job manager
     gui::SimVisualizer   *sim_visualize;   // simulation visualizer that goes in sim visualize dock
     settings::SettingsDialog *settings_dialog;  // dialog for changing settings
+    gui::DesignLoader   *design_loader;   // threaded design file loader
+
+    // status bar widgets shown while a design loads
+    QProgressBar *load_progress;
+    QPushButton *load_cancel_button;
 
     // dockable widgets
     QDockWidget *dialog_dock; // bottom panel for terminal dialog
@@ -242,6 +259,15 @@ namespace gui{
 
     int autosave_ind=0;        // current autosave file index
     int autosave_num;          // number of autosaves to keep
+    int autosave_gz_level;     // compression of XML checkpoints, 0 for none
+    QThreadPool autosave_pool; // writes autosave snapshots off the GUI thread
+    bool autosave_running=false;  // an autosave snapshot is being written
+    quint64 autosave_revision=0;  // design revision of the last autosave
+    int checkpoint_every;      // journaled autosaves between full checkpoints
+    QString journal_path;      // journal of the last checkpoint, empty if none
+    int journal_appends=0;     // records appended since the last checkpoint
+    qint64 journal_bytes=0;    // size of the records since the last checkpoint
+    qint64 checkpoint_bytes=0; // size of the last checkpoint
 
     QString working_path;      // path currently in use
     Commander* commander;      // Handles commands
@@ -0,0 +1,89 @@
+// @file:     save_context.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Number formatting and writer layout shared by the XML writers of
+//            a save or problem export.
+
+#include <charconv>
+
+#include "save_context.h"
+#include "settings/settings.h"
+
+namespace{
+  // context of the save in progress on each thread
+  thread_local gui::SaveContext *current_ctx=nullptr;
+
+  // context of item saves outside of a save scope, e.g. copies to the
+  // clipboard, read from the settings once per thread
+  gui::SaveContext &defaultContext()
+  {
+    thread_local gui::SaveContext ctx(gui::SaveContext::Pretty);
+    return ctx;
+  }
+}
+
+
+gui::SaveContext::SaveContext(Layout t_layout)
+  : lay(t_layout)
+{
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  prc = app_settings->get<int>("float_prc");
+  fmt = app_settings->get<QString>("float_fmt").at(0).toLatin1();
+}
+
+gui::SaveContext::SaveContext(Layout t_layout, int t_precision, char t_format)
+  : lay(t_layout), prc(t_precision), fmt(t_format)
+{}
+
+QString gui::SaveContext::number(int val)
+{
+  // integers format identically in both layouts
+  std::to_chars_result res = std::to_chars(buf, buf+sizeof(buf), val);
+  return QString::fromLatin1(buf, res.ptr-buf);
+}
+
+gui::SaveContext *gui::SaveContext::current()
+{
+  return current_ctx ? current_ctx : &defaultContext();
+}
+
+void gui::SaveContext::refreshDefault()
+{
+  defaultContext() = SaveContext(Pretty);
+}
+
+gui::SaveContext::Layout gui::SaveContext::currentLayout()
+{
+  return current_ctx ? current_ctx->layout() : Pretty;
+}
+
+gui::SaveContext::Scope::Scope(SaveContext *ctx)
+  : prev(current_ctx)
+{
+  current_ctx = ctx;
+}
+
+gui::SaveContext::Scope::~Scope()
+{
+  current_ctx = prev;
+}
+
+QString gui::SaveContext::formatFloat(double val, char format, int precision)
+{
+  // Qt's 'g' picks the shorter of 'e' and 'f' which printf style formatting
+  // doesn't, keep Qt's formatting for files that are diffed
+  if (lay == Pretty)
+    return QString::number(val, format, precision);
+
+  std::chars_format cf = std::chars_format::general;
+  if (format == 'f')
+    cf = std::chars_format::fixed;
+  else if (format == 'e')
+    cf = std::chars_format::scientific;
+  std::to_chars_result res = std::to_chars(buf, buf+sizeof(buf), val, cf, precision);
+  if (res.ec != std::errc())
+    return QString::number(val, format, precision);
+  return QString::fromLatin1(buf, res.ptr-buf);
+}
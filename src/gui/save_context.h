@@ -0,0 +1,90 @@
+// @file:     save_context.h
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Number formatting and writer layout shared by the XML writers of
+//            a save or problem export.
+
+#ifndef _GUI_SAVE_CONTEXT_H_
+#define _GUI_SAVE_CONTEXT_H_
+
+#include <QtCore>
+#include <QXmlStreamWriter>
+
+
+namespace gui{
+
+  //! Serialization context of one save or problem export. The float settings
+  //! are read once when the context is made, item save functions format their
+  //! numbers through the context of the save in progress, see current().
+  class SaveContext
+  {
+  public:
+
+    //! Pretty output is indented and formats floats like QString::number, so
+    //! the files are byte-identical to those of earlier versions and can be
+    //! diffed. Compact output isn't indented and formats floats with
+    //! std::to_chars to the same significant digits, for machine-consumed
+    //! files such as simulation problems.
+    enum Layout{Pretty, Compact};
+
+    //! Construct with the float_prc and float_fmt settings, read on the
+    //! calling thread.
+    explicit SaveContext(Layout t_layout=Pretty);
+
+    //! Construct with the given float precision and format.
+    SaveContext(Layout t_layout, int t_precision, char t_format);
+
+    //! Return the layout.
+    Layout layout() const {return lay;}
+
+    //! Set up a writer for the layout.
+    void setupWriter(QXmlStreamWriter *ws) const {ws->setAutoFormatting(lay == Pretty);}
+
+    //! Format a float with the float_prc and float_fmt settings.
+    QString real(double val) {return formatFloat(val, fmt, prc);}
+
+    //! Format a float like QString::number(val).
+    QString number(double val) {return formatFloat(val, 'g', 6);}
+
+    //! Format an integer like QString::number(val).
+    QString number(int val);
+
+    //! Context of the save in progress on this thread, a pretty context with
+    //! the settings of this thread's first call if there is none.
+    static SaveContext *current();
+
+    //! Re-read the settings of this thread's pretty context, called on the GUI
+    //! thread after the settings changed.
+    static void refreshDefault();
+
+    //! Layout of the save in progress on this thread, Pretty if there is none.
+    //! Unlike current() it never reads the settings, so it is safe on worker
+    //! threads.
+    static Layout currentLayout();
+
+    //! Makes a context current on this thread for the lifetime of the scope.
+    class Scope
+    {
+    public:
+      Scope(SaveContext *ctx);
+      ~Scope();
+    private:
+      SaveContext *prev;
+    };
+
+  private:
+
+    // format into the reusable buffer
+    QString formatFloat(double val, char format, int precision);
+
+    Layout lay=Pretty;
+    int prc=6;
+    char fmt='g';
+    char buf[128];
+  };
+
+} // end gui namespace
+
+#endif
@@ -0,0 +1,150 @@
+// @file:     job_archive.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Read access to the files of an imported .sqjx.zip job archive.
+
+#include "job_archive.h"
+#include "../../../libs/miniz/miniz.h"
+
+using namespace comp;
+
+struct JobArchive::Zip
+{
+  mz_zip_archive archive;
+  bool open=false;
+};
+
+
+JobArchive::JobArchive(const QString &zip_path, const QString &local_root)
+  : zip_path(zip_path), local_root(QDir(local_root).absolutePath()), zip(new Zip)
+{
+  memset(&zip->archive, 0, sizeof(zip->archive));
+}
+
+JobArchive::~JobArchive()
+{
+  if (zip->open)
+    mz_zip_reader_end(&zip->archive);
+}
+
+bool JobArchive::open(QString &err)
+{
+  QMutexLocker locker(&mutex);
+  if (!mz_zip_reader_init_file(&zip->archive, QFile::encodeName(zip_path).constData(), 0)) {
+    err = QObject::tr("Could not open %1: %2").arg(zip_path)
+        .arg(mz_zip_get_error_string(mz_zip_get_last_error(&zip->archive)));
+    return false;
+  }
+  zip->open = true;
+
+  mz_uint num_files = mz_zip_reader_get_num_files(&zip->archive);
+  for (mz_uint i=0; i<num_files; i++) {
+    mz_zip_archive_file_stat file_stat;
+    if (!mz_zip_reader_file_stat(&zip->archive, i, &file_stat) || file_stat.m_is_directory)
+      continue;
+    entries.insert(QDir::cleanPath(QString::fromUtf8(file_stat.m_filename)), int(i));
+  }
+  return true;
+}
+
+QString JobArchive::findFile(const QString &file_name) const
+{
+  QString found;
+  for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+    if (QFileInfo(it.key()).fileName() == file_name
+        && (found.isEmpty() || it.key().count('/') < found.count('/')))
+      found = it.key();
+  }
+  return found.isEmpty() ? found : QDir(local_root).absoluteFilePath(found);
+}
+
+bool JobArchive::contains(const QString &local_path) const
+{
+  return entries.contains(entryName(local_path));
+}
+
+bool JobArchive::read(const QString &local_path, QByteArray &data, QString &err) const
+{
+  if (QFileInfo::exists(local_path)) {
+    QFile file(local_path);
+    if (!file.open(QFile::ReadOnly)) {
+      err = file.errorString();
+      return false;
+    }
+    data = file.readAll();
+    return true;
+  }
+
+  int index = entries.value(entryName(local_path), -1);
+  if (index < 0) {
+    err = QObject::tr("%1 is not in the job archive.").arg(entryName(local_path));
+    return false;
+  }
+
+  // inflate straight into the returned buffer
+  QMutexLocker locker(&mutex);
+  mz_zip_archive_file_stat file_stat;
+  if (!mz_zip_reader_file_stat(&zip->archive, mz_uint(index), &file_stat)) {
+    err = mz_zip_get_error_string(mz_zip_get_last_error(&zip->archive));
+    return false;
+  }
+  data.resize(qsizetype(file_stat.m_uncomp_size));
+  if (!mz_zip_reader_extract_to_mem(&zip->archive, mz_uint(index), data.data(),
+        size_t(data.size()), 0)) {
+    err = mz_zip_get_error_string(mz_zip_get_last_error(&zip->archive));
+    data.clear();
+    return false;
+  }
+  return true;
+}
+
+bool JobArchive::extract(const QString &local_path, QString &err) const
+{
+  QMutexLocker locker(&mutex);
+  if (QFileInfo::exists(local_path))
+    return true;
+  int index = entries.value(entryName(local_path), -1);
+  if (index < 0) {
+    err = QObject::tr("%1 is not in the job archive.").arg(entryName(local_path));
+    return false;
+  }
+  return extractEntry(index, local_path, err);
+}
+
+bool JobArchive::extractDir(const QString &local_dir, QString &err,
+                            const QStringList &name_filters) const
+{
+  QString prefix = entryName(local_dir);
+  prefix = (prefix == ".") ? QString() : prefix + "/";
+  QMutexLocker locker(&mutex);
+  for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+    if (!it.key().startsWith(prefix))
+      continue;
+    if (!name_filters.isEmpty() && !QDir::match(name_filters, QFileInfo(it.key()).fileName()))
+      continue;
+    QString local_path = QDir(local_root).absoluteFilePath(it.key());
+    if (!QFileInfo::exists(local_path) && !extractEntry(it.value(), local_path, err))
+      return false;
+  }
+  return true;
+}
+
+QString JobArchive::entryName(const QString &local_path) const
+{
+  return QDir::cleanPath(QDir(local_root).relativeFilePath(local_path));
+}
+
+bool JobArchive::extractEntry(int index, const QString &local_path, QString &err) const
+{
+  QDir().mkpath(QFileInfo(local_path).absolutePath());
+  qDebug() << QObject::tr("Extracting file: %1").arg(local_path);
+  if (!mz_zip_reader_extract_to_file(&zip->archive, mz_uint(index),
+        QFile::encodeName(local_path).constData(), 0)) {
+    err = QObject::tr("Could not extract %1: %2").arg(local_path)
+        .arg(mz_zip_get_error_string(mz_zip_get_last_error(&zip->archive)));
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+/** @file:     job_archive.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Read access to the files of an imported .sqjx.zip job archive.
+ *
+ *  Imported jobs keep their archive open instead of extracting it. Opening
+ *  an archive only reads its central directory. The files of the job are
+ *  addressed by the local path they would have if the archive were
+ *  extracted to the local root, results are read from the archive into
+ *  memory and files other code needs on disk (problem files, plots) are
+ *  extracted to their local path on request.
+ */
+
+#ifndef _COMP_JOB_ARCHIVE_H_
+#define _COMP_JOB_ARCHIVE_H_
+
+#include <QtCore>
+#include <memory>
+
+namespace comp{
+
+  class JobArchive
+  {
+  public:
+
+    //! Construct an archive whose files extract to below local_root.
+    JobArchive(const QString &zip_path, const QString &local_root);
+
+    //! Destructor, closes the archive.
+    ~JobArchive();
+
+    //! Open the archive, reading only its central directory.
+    bool open(QString &err);
+
+    //! Local root the archive extracts to.
+    QString localRoot() const {return local_root;}
+
+    //! Return the local path of the shallowest file with the given name, or
+    //! an empty string if the archive has none.
+    QString findFile(const QString &file_name) const;
+
+    //! Return whether the archive holds the file at local_path.
+    bool contains(const QString &local_path) const;
+
+    //! Read the file at local_path, from disk if it has been extracted and
+    //! from the archive otherwise.
+    bool read(const QString &local_path, QByteArray &data, QString &err) const;
+
+    //! Extract the file at local_path unless it exists on disk.
+    bool extract(const QString &local_path, QString &err) const;
+
+    //! Extract the files below local_dir matching the name filters (all if
+    //! empty) that don't exist on disk.
+    bool extractDir(const QString &local_dir, QString &err,
+                    const QStringList &name_filters=QStringList()) const;
+
+  private:
+
+    // name of the archive entry of local_path
+    QString entryName(const QString &local_path) const;
+
+    // extract the entry to local_path, the caller holds the lock
+    bool extractEntry(int index, const QString &local_path, QString &err) const;
+
+    struct Zip;
+
+    QString zip_path;
+    QString local_root;
+    std::unique_ptr<Zip> zip;
+    QHash<QString, int> entries;  // file index of each entry name
+    mutable QMutex mutex;         // miniz readers aren't thread-safe
+  };
+
+} // end of comp namespace
+
+#endif
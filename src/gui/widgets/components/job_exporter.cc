@@ -0,0 +1,211 @@
+// @file:     job_exporter.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Writes the job directory of a SimJob to a .sqjx.zip archive on a
+//            worker thread.
+
+#include "job_exporter.h"
+#include "../../../libs/miniz/miniz.h"
+
+#include <algorithm>
+
+namespace {
+  // bounds of the files deflated in memory at once
+  const int batch_files_per_thread = 2;
+  const qint64 default_batch_bytes = qint64(256) << 20;
+}
+
+using namespace comp;
+
+
+JobExporter::JobExporter(const QString &src_dir, const QString &out_path, int level,
+                         QObject *parent)
+  : QObject(parent), src_dir(src_dir), out_path(out_path), level(qBound(0, level, 9)),
+    batch_bytes(default_batch_bytes)
+{}
+
+JobExporter::~JobExporter()
+{
+  if (thread != nullptr) {
+    cancel();
+    thread->wait();
+    delete thread;
+  }
+}
+
+void JobExporter::start()
+{
+  if (thread != nullptr) {
+    qWarning() << tr("Job export to %1 was already started.").arg(out_path);
+    return;
+  }
+  thread = QThread::create([this]() {
+    QString err;
+    bool ok = run(err);
+    QMetaObject::invokeMethod(this, [this, ok, err]() {
+      emit sig_finished(ok, err);
+    }, Qt::QueuedConnection);
+  });
+  thread->start();
+}
+
+bool JobExporter::isCompressedMedia(const QString &path)
+{
+  static const QStringList compressed_suffixes = {"png", "gif", "jpg", "jpeg",
+    "webp", "mp4", "zip", "gz", "sqb"};
+  return compressed_suffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+bool JobExporter::run(QString &err)
+{
+  // list the files in a stable order
+  QDir dir(src_dir);
+  QList<Entry> entries;
+  qint64 total = 0;
+  QDirIterator it(src_dir, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    Entry entry;
+    entry.path = it.filePath();
+    entry.name = dir.relativeFilePath(entry.path).toUtf8();
+    entry.size = it.fileInfo().size();
+    entry.store = level == 0 || isCompressedMedia(entry.path);
+    entry.stream = entry.size > batch_bytes;
+    total += entry.size;
+    entries.append(entry);
+  }
+  std::sort(entries.begin(), entries.end(),
+      [](const Entry &a, const Entry &b) {return a.name < b.name;});
+
+  // keep a previous archive until the new one is complete
+  QString tmp_path = out_path + ".writing";
+  mz_zip_archive zip;
+  memset(&zip, 0, sizeof(zip));
+  if (!mz_zip_writer_init_file_v2(&zip, QFile::encodeName(tmp_path).constData(), 0, 0)) {
+    err = tr("Could not initialize zip archive %1.").arg(tmp_path);
+    return false;
+  }
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(QThread::idealThreadCount());
+  const int batch_files = batch_files_per_thread * pool.maxThreadCount();
+  qint64 done = 0;
+  reportProgress(done, total);
+  bool ok = true;
+  for (int i=0; ok && i<entries.size();) {
+    if (cancelled.loadRelaxed()) {
+      err = tr("Export cancelled.");
+      ok = false;
+      break;
+    }
+
+    // deflate a batch in parallel, files above the batch bound are stored or
+    // deflated from disk on their own
+    int end = i;
+    qint64 bytes = 0;
+    if (entries[i].stream)
+      end++;
+    while (end < entries.size() && end - i < batch_files && !entries[end].stream
+        && bytes + entries[end].size <= batch_bytes)
+      bytes += entries[end++].size;
+    for (int j=i; j<end; j++) {
+      if (!entries[j].store && !entries[j].stream) {
+        Entry *entry = &entries[j];
+        pool.start([this, entry]() {deflateEntry(*entry);});
+      }
+    }
+    pool.waitForDone();
+
+    // append the batch in order
+    for (; ok && i<end; i++) {
+      Entry &entry = entries[i];
+      if (!entry.err.isEmpty()) {
+        err = entry.err;
+        ok = false;
+        break;
+      }
+      if (entry.deflated) {
+        ok = mz_zip_writer_add_mem_ex(&zip, entry.name.constData(), entry.data.constData(),
+            entry.data.size(), nullptr, 0, level | MZ_ZIP_FLAG_COMPRESSED_DATA,
+            entry.size, entry.crc);
+      } else {
+        ok = mz_zip_writer_add_file(&zip, entry.name.constData(),
+            QFile::encodeName(entry.path).constData(), nullptr, 0,
+            entry.store ? MZ_NO_COMPRESSION : level);
+      }
+      if (!ok)
+        err = tr("Error adding file %1: %2").arg(entry.path)
+            .arg(mz_zip_get_error_string(mz_zip_get_last_error(&zip)));
+      entry.data = QByteArray();
+      done += entry.size;
+      reportProgress(done, total);
+    }
+  }
+
+  if (ok && !mz_zip_writer_finalize_archive(&zip)) {
+    err = tr("Could not finalize zip archive: %1")
+        .arg(mz_zip_get_error_string(mz_zip_get_last_error(&zip)));
+    ok = false;
+  }
+  mz_zip_writer_end(&zip);
+
+  if (!ok) {
+    QFile::remove(tmp_path);
+    return false;
+  }
+  QFile::remove(out_path);
+  if (!QFile::rename(tmp_path, out_path)) {
+    err = tr("Could not move %1 to %2.").arg(tmp_path).arg(out_path);
+    return false;
+  }
+  return true;
+}
+
+void JobExporter::deflateEntry(Entry &entry) const
+{
+  QFile file(entry.path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    entry.err = tr("Error reading file %1: %2").arg(entry.path).arg(file.errorString());
+    return;
+  }
+  QByteArray raw = file.readAll();
+  file.close();
+
+  // miniz stores tiny files anyway
+  entry.size = raw.size();
+  if (raw.size() <= 3) {
+    entry.store = true;
+    return;
+  }
+
+  entry.crc = static_cast<quint32>(mz_crc32(MZ_CRC32_INIT,
+      reinterpret_cast<const unsigned char*>(raw.constData()), raw.size()));
+  size_t deflated_len = 0;
+  void *deflated = tdefl_compress_mem_to_heap(raw.constData(), raw.size(), &deflated_len,
+      tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS,
+                                              MZ_DEFAULT_STRATEGY));
+  if (deflated == nullptr) {
+    entry.err = tr("Error compressing file %1.").arg(entry.path);
+    return;
+  }
+  // incompressible files are stored
+  if (deflated_len < size_t(raw.size())) {
+    entry.data = QByteArray(static_cast<const char*>(deflated), qsizetype(deflated_len));
+    entry.deflated = true;
+  } else {
+    entry.store = true;
+  }
+  mz_free(deflated);
+}
+
+void JobExporter::reportProgress(qint64 done, qint64 total)
+{
+  int percent = total > 0 ? static_cast<int>(100 * done / total) : 100;
+  if (percent != last_percent) {
+    last_percent = percent;
+    emit sig_progress(percent);
+  }
+}
@@ -0,0 +1,101 @@
+/** @file:     job_exporter.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Writes the job directory of a SimJob to a .sqjx.zip archive on
+ *             a worker thread.
+ *
+ *  Files are deflated in parallel into memory in batches, each batch is then
+ *  appended to the archive in directory order so that archives don't depend
+ *  on the thread timing. Already compressed media (PNG, GIF, ...) is stored
+ *  as is, deflating it again costs time and saves nothing. Files larger than
+ *  the batch bound are written on their own, read from disk in chunks.
+ */
+
+#ifndef _COMP_JOB_EXPORTER_H_
+#define _COMP_JOB_EXPORTER_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  class JobExporter : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Prepare the export of the files below src_dir to out_path, deflated at
+    //! level (0 stores all files, 1 to 9 trade speed for size).
+    JobExporter(const QString &src_dir, const QString &out_path, int level,
+                QObject *parent=nullptr);
+
+    //! Destructor, cancels a running export and waits for it.
+    ~JobExporter();
+
+    //! Start the export on a worker thread.
+    void start();
+
+    //! Request the export to stop after the current batch, thread-safe.
+    void cancel() {cancelled.storeRelaxed(1);}
+
+    //! Set the bytes deflated in memory at once, larger files are streamed
+    //! from disk one at a time. Must be called before start().
+    void setBatchBytes(qint64 bytes) {batch_bytes = qMax<qint64>(1, bytes);}
+
+    //! Return whether the export is running.
+    bool isRunning() const {return thread != nullptr && thread->isRunning();}
+
+    //! Archive path.
+    QString outPath() const {return out_path;}
+
+    //! Return whether the file is stored without deflating it.
+    static bool isCompressedMedia(const QString &path);
+
+  signals:
+
+    //! Percentage of the input bytes written to the archive.
+    void sig_progress(int percent);
+
+    //! Emitted on the GUI thread once the export is over, err is empty on
+    //! success.
+    void sig_finished(bool ok, const QString &err);
+
+  private:
+
+    // one input file of the archive
+    struct Entry
+    {
+      QString path;       // absolute path of the file
+      QByteArray name;    // path in the archive, UTF-8
+      qint64 size=0;      // uncompressed size
+      bool store=false;   // store instead of deflate
+      bool stream=false;  // above the batch bound, miniz streams it from disk
+      bool deflated=false;  // data holds the deflated file
+      QByteArray data;    // deflated data once compressed
+      quint32 crc=0;      // CRC-32 of the uncompressed data
+      QString err;        // set if the file couldn't be compressed
+    };
+
+    // write the archive, runs on the worker thread
+    bool run(QString &err);
+
+    // read and deflate an entry, runs on the compression pool
+    void deflateEntry(Entry &entry) const;
+
+    // report the progress if the percentage changed
+    void reportProgress(qint64 done, qint64 total);
+
+    QString src_dir;
+    QString out_path;
+    int level;
+    qint64 batch_bytes;
+    QThread *thread=nullptr;
+    QAtomicInt cancelled;
+    int last_percent=-1;
+  };
+
+} // end of comp namespace
+
+#endif
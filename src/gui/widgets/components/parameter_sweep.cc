@@ -0,0 +1,144 @@
+// @file:     parameter_sweep.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.17
+// @license:  GNU LGPL v3
+//
+// @desc:     Expansion of sweep expressions in job parameters.
+
+#include "parameter_sweep.h"
+#include <cmath>
+
+using namespace comp;
+
+namespace {
+
+  // start:stop:step with numbers in any notation QString::toDouble accepts
+  const QRegularExpression range_regex("^\\s*([^:\\[\\]]+):([^:\\[\\]]+):([^:\\[\\]]+)\\s*$");
+
+  // [a, b, c]
+  const QRegularExpression list_regex("^\\s*\\[(.*)\\]\\s*$");
+
+}
+
+bool ParameterSweep::isSweepExpression(const QString &text)
+{
+  return range_regex.match(text).hasMatch() || list_regex.match(text).hasMatch();
+}
+
+bool ParameterSweep::expandExpression(const QString &text, QStringList &values, QString &err)
+{
+  values.clear();
+
+  QRegularExpressionMatch match = list_regex.match(text);
+  if (match.hasMatch()) {
+    for (const QString &val : match.captured(1).split(',', Qt::SkipEmptyParts)) {
+      if (!val.trimmed().isEmpty())
+        values.append(val.trimmed());
+    }
+    if (values.isEmpty()) {
+      err = QObject::tr("The list %1 has no values.").arg(text);
+      return false;
+    }
+    return true;
+  }
+
+  match = range_regex.match(text);
+  if (!match.hasMatch()) {
+    err = QObject::tr("%1 is not a sweep expression.").arg(text);
+    return false;
+  }
+  bool ok[3];
+  double start = match.captured(1).trimmed().toDouble(&ok[0]);
+  double stop = match.captured(2).trimmed().toDouble(&ok[1]);
+  double step = match.captured(3).trimmed().toDouble(&ok[2]);
+  if (!ok[0] || !ok[1] || !ok[2]) {
+    err = QObject::tr("The range %1 must be numbers as start:stop:step.").arg(text);
+    return false;
+  }
+  if (step == 0 || (stop - start) / step < 0) {
+    err = QObject::tr("The step of the range %1 doesn't lead from start to stop.").arg(text);
+    return false;
+  }
+  // tolerate rounding so that the stop value is included
+  double steps = std::floor((stop - start) / step + 1e-9);
+  if (steps + 1 > max_points) {
+    err = QObject::tr("The range %1 has more than %2 values.").arg(text).arg(max_points);
+    return false;
+  }
+  for (int i=0; i<=int(steps); i++)
+    values.append(QString::number(start + i * step, 'g', 12));
+  return true;
+}
+
+bool ParameterSweep::addParameter(const QString &key, const QString &expr, QString &err)
+{
+  Axis axis;
+  axis.key = key;
+  if (!expandExpression(expr, axis.values, err)) {
+    err = QObject::tr("Parameter %1: %2").arg(key).arg(err);
+    return false;
+  }
+  axes.append(axis);
+  return true;
+}
+
+bool ParameterSweep::validate(QString &err) const
+{
+  if (mode == ZippedSweep) {
+    for (const Axis &axis : axes) {
+      if (axis.values.length() != axes.first().values.length()) {
+        err = QObject::tr("Zipped parameters must have the same number of "
+            "values, %1 has %2 and %3 has %4.").arg(axes.first().key)
+          .arg(axes.first().values.length()).arg(axis.key).arg(axis.values.length());
+        return false;
+      }
+    }
+    return true;
+  }
+  qint64 count = 1;
+  for (const Axis &axis : axes) {
+    count *= axis.values.length();
+    if (count > max_points) {
+      err = QObject::tr("The sweep has more than %1 points.").arg(max_points);
+      return false;
+    }
+  }
+  return true;
+}
+
+QStringList ParameterSweep::keys() const
+{
+  QStringList sweep_keys;
+  for (const Axis &axis : axes)
+    sweep_keys.append(axis.key);
+  return sweep_keys;
+}
+
+int ParameterSweep::pointCount() const
+{
+  if (axes.isEmpty())
+    return 0;
+  if (mode == ZippedSweep)
+    return axes.first().values.length();
+  int count = 1;
+  for (const Axis &axis : axes)
+    count *= axis.values.length();
+  return count;
+}
+
+QMap<QString, QString> ParameterSweep::point(int i) const
+{
+  QMap<QString, QString> values;
+  if (mode == ZippedSweep) {
+    for (const Axis &axis : axes)
+      values.insert(axis.key, axis.values.at(i));
+    return values;
+  }
+  // mixed radix decomposition, the last axis varies fastest
+  for (int a=axes.length()-1; a>=0; a--) {
+    const Axis &axis = axes.at(a);
+    values.insert(axis.key, axis.values.at(i % axis.values.length()));
+    i /= axis.values.length();
+  }
+  return values;
+}
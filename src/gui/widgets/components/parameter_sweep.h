@@ -0,0 +1,80 @@
+/** @file:     parameter_sweep.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.17
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Expansion of sweep expressions in job parameters into a grid of
+ *             parameter points.
+ *
+ *  A numeric runtime parameter entered as a sweep expression takes several
+ *  values, text parameters are never swept:
+ *    start:stop:step   inclusive range, e.g. -0.35:-0.25:0.05
+ *    [a, b, c]         list of values, e.g. [5.6, 8.0, 11.7]
+ *  Swept parameters are combined either as a Cartesian product (every
+ *  combination, the last key varying fastest) or zipped (the i-th value of
+ *  every swept parameter, all must have the same count). Each point becomes
+ *  one job step.
+ */
+
+#ifndef _COMP_PARAMETER_SWEEP_H_
+#define _COMP_PARAMETER_SWEEP_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  class ParameterSweep
+  {
+  public:
+
+    //! How the values of the swept parameters are combined.
+    enum SweepMode{CartesianSweep, ZippedSweep};
+
+    //! Upper bound on the number of points of a sweep.
+    static const int max_points = 10000;
+
+    //! Return whether the text is a sweep expression rather than a value.
+    static bool isSweepExpression(const QString &text);
+
+    //! Expand a sweep expression into its values. Returns false and sets err
+    //! if the expression is malformed.
+    static bool expandExpression(const QString &text, QStringList &values, QString &err);
+
+    //! Construct an empty sweep.
+    ParameterSweep(SweepMode mode=CartesianSweep) : mode(mode) {};
+
+    //! Add a swept parameter with its sweep expression. Returns false and sets
+    //! err if the expression is malformed.
+    bool addParameter(const QString &key, const QString &expr, QString &err);
+
+    //! Return whether no parameter is swept.
+    bool isEmpty() const {return axes.isEmpty();}
+
+    //! Check that the swept parameters combine into at most max_points points.
+    bool validate(QString &err) const;
+
+    //! Return the swept parameter keys in the order they were added.
+    QStringList keys() const;
+
+    //! Return the number of points.
+    int pointCount() const;
+
+    //! Return the values of the swept parameters at point i.
+    QMap<QString, QString> point(int i) const;
+
+  private:
+
+    // one swept parameter
+    struct Axis
+    {
+      QString key;
+      QStringList values;
+    };
+
+    SweepMode mode;
+    QList<Axis> axes;
+  };
+
+} // end of comp namespace
+
+#endif
@@ -104,6 +104,9 @@ PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
           unrecognizedXMLElement(rs);
         }
       }
+    } else if (elem_name == "cores") {
+      // number of cores the plugin process keeps busy, used by the job queue
+      declared_cores = qMax(0, rs.readElementText().toInt());
     } else if (elem_name == "services") {
       plugin_services = rs.readElementText().split(",");
     } else if (elem_name == "bin_path") {
@@ -179,6 +182,17 @@ PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
   }
 }
 
+int PluginEngine::coreRequirement() const
+{
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  QVariantMap plugin_cores = app_settings->get<QVariantMap>("plugs/plugin_cores");
+  if (plugin_cores.contains(plugin_name))
+    return qMax(1, plugin_cores.value(plugin_name).toInt());
+  if (declared_cores > 0)
+    return declared_cores;
+  return qMax(1, app_settings->get<int>("plugs/default_plugin_cores"));
+}
+
 void PluginEngine::prepareVirtualenv()
 {
   if (!py_use_virtualenv) {
@@ -141,6 +141,12 @@ namespace comp{
     //! Return the plugin version.
     QString version() const {return plugin_version;}
 
+    //! Return the number of CPU cores a process of this plugin occupies. A
+    //! per-plugin entry in the plugs/plugin_cores setting takes precedence
+    //! over the <cores> element of the description file, plugins declaring
+    //! neither use plugs/default_plugin_cores.
+    int coreRequirement() const;
+
     //! Return the path to the plugin root directory.
     QString pluginRootPath() const {return plugin_root_path;}
 
@@ -192,6 +198,7 @@ namespace comp{
     bool venv_use_system_site;    // use system site packages for venv
     QString plugin_name;          // plugin name
     QString plugin_version;       // plugin version
+    int declared_cores=0;         // cores declared by the description file, 0 if none
     QStringList plugin_services;  // plugin service types
     QString plugin_root_path;     // plugin root path
     QString bin_path;             // binary/script path
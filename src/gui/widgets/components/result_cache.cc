@@ -0,0 +1,247 @@
+// @file:     result_cache.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.17
+// @license:  GNU LGPL v3
+//
+// @desc:     On-disk cache of job step results.
+
+#include "result_cache.h"
+#include "settings/settings.h"
+
+using namespace comp;
+
+namespace {
+
+  // files of an entry
+  const QString result_file_name = "result.xml";
+  const QString stdout_file_name = "stdout.log";
+  const QString stderr_file_name = "stderr.log";
+  const QString last_used_file_name = "last_used";
+  const QString files_dir_name = "files";
+
+  // total size of the files below path except the excluded paths
+  qint64 treeBytes(const QString &path, const QStringList &exclude_paths=QStringList())
+  {
+    qint64 bytes = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      it.next();
+      if (!exclude_paths.contains(it.fileInfo().absoluteFilePath()))
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+  }
+
+  // copy the files below src_dir to dst_dir except the excluded paths
+  bool copyTree(const QString &src_dir, const QString &dst_dir,
+                const QStringList &exclude_paths=QStringList())
+  {
+    QDir src(src_dir);
+    QDirIterator it(src_dir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      it.next();
+      QString src_path = it.fileInfo().absoluteFilePath();
+      if (exclude_paths.contains(src_path))
+        continue;
+      QString dst_path = QDir(dst_dir).absoluteFilePath(src.relativeFilePath(src_path));
+      QDir().mkpath(QFileInfo(dst_path).absolutePath());
+      QFile::remove(dst_path);
+      if (!QFile::copy(src_path, dst_path)) {
+        qWarning() << QObject::tr("Result cache: failed to copy %1 to %2")
+          .arg(src_path).arg(dst_path);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool writeText(const QString &path, const QString &text)
+  {
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly))
+      return false;
+    return file.write(text.toUtf8()) >= 0;
+  }
+
+  QString readText(const QString &path)
+  {
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+      return QString();
+    return QString::fromUtf8(file.readAll());
+  }
+
+}
+
+
+ResultCache *ResultCache::instance()
+{
+  static ResultCache cache;
+  return &cache;
+}
+
+bool ResultCache::enabledByDefault()
+{
+  return settings::AppSettings::instance()->get<bool>("plugs/result_cache_enabled");
+}
+
+void ResultCache::setEnabledByDefault(bool enabled)
+{
+  settings::AppSettings::instance()->setValue("plugs/result_cache_enabled", enabled);
+}
+
+bool ResultCache::lookup(const QByteArray &key, const QString &js_dir_path,
+                         const QString &result_path, QString &std_out, QString &std_err)
+{
+  scan();
+  QString name = QString::fromLatin1(key);
+  if (key.isEmpty() || !entries.contains(name)) {
+    session.misses++;
+    return false;
+  }
+
+  QDir entry_dir(cacheDir().absoluteFilePath(name));
+  QDir(js_dir_path).mkpath(".");
+  QFile::remove(result_path);
+  if (!copyTree(entry_dir.absoluteFilePath(files_dir_name), js_dir_path)
+      || !QFile::copy(entry_dir.absoluteFilePath(result_file_name), result_path)) {
+    // treat broken entries as misses and drop them
+    qWarning() << QObject::tr("Result cache: entry %1 is broken, removing it.").arg(name);
+    total_bytes -= entries.take(name).bytes;
+    entry_dir.removeRecursively();
+    session.misses++;
+    return false;
+  }
+  std_out = readText(entry_dir.absoluteFilePath(stdout_file_name));
+  std_err = readText(entry_dir.absoluteFilePath(stderr_file_name));
+  touch(name);
+  session.hits++;
+  qDebug() << QObject::tr("Result cache: hit for %1").arg(name);
+  return true;
+}
+
+bool ResultCache::store(const QByteArray &key, const QString &js_dir_path,
+                        const QString &result_path, const QStringList &exclude_paths,
+                        const QString &std_out, const QString &std_err)
+{
+  scan();
+  QString name = QString::fromLatin1(key);
+  if (key.isEmpty() || entries.contains(name))
+    return false;
+
+  // entries larger than the whole cache aren't kept
+  qint64 limit = settings::AppSettings::instance()->get<qint64>("plugs/result_cache_max_mb") << 20;
+  QStringList excluded;
+  for (const QString &path : exclude_paths + QStringList({result_path}))
+    excluded.append(QFileInfo(path).absoluteFilePath());
+  qint64 bytes = treeBytes(js_dir_path, excluded) + QFileInfo(result_path).size()
+    + std_out.size() + std_err.size();
+  if (bytes > limit) {
+    qDebug() << QObject::tr("Result cache: %1 bytes of results exceed the cache "
+        "size, not cached.").arg(bytes);
+    return false;
+  }
+
+  // write to a temporary directory so that interrupted stores leave no entry
+  QDir cache_dir = cacheDir();
+  QDir tmp_dir(cache_dir.absoluteFilePath(name + ".tmp"));
+  tmp_dir.removeRecursively();
+  tmp_dir.mkpath(files_dir_name);
+  bool ok = copyTree(js_dir_path, tmp_dir.absoluteFilePath(files_dir_name), excluded)
+    && QFile::copy(result_path, tmp_dir.absoluteFilePath(result_file_name))
+    && writeText(tmp_dir.absoluteFilePath(stdout_file_name), std_out)
+    && writeText(tmp_dir.absoluteFilePath(stderr_file_name), std_err)
+    && cache_dir.rename(name + ".tmp", name);
+  if (!ok) {
+    qWarning() << QObject::tr("Result cache: failed to store %1").arg(name);
+    tmp_dir.removeRecursively();
+    return false;
+  }
+
+  Entry entry;
+  entry.bytes = treeBytes(cache_dir.absoluteFilePath(name));
+  entries.insert(name, entry);
+  total_bytes += entry.bytes;
+  touch(name);
+  session.stores++;
+  qDebug() << QObject::tr("Result cache: stored %1 (%2 bytes)").arg(name).arg(entry.bytes);
+  evict();
+  return true;
+}
+
+ResultCache::Stats ResultCache::stats()
+{
+  scan();
+  Stats s = session;
+  s.entries = entries.size();
+  s.bytes = total_bytes;
+  return s;
+}
+
+void ResultCache::clear()
+{
+  scan();
+  QDir cache_dir = cacheDir();
+  for (const QString &name : entries.keys())
+    QDir(cache_dir.absoluteFilePath(name)).removeRecursively();
+  entries.clear();
+  total_bytes = 0;
+}
+
+void ResultCache::scan()
+{
+  if (scanned)
+    return;
+  scanned = true;
+  QDir cache_dir = cacheDir();
+  for (const QFileInfo &info : cache_dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+    if (info.fileName().endsWith(".tmp")) {
+      // left behind by an interrupted store
+      QDir(info.absoluteFilePath()).removeRecursively();
+      continue;
+    }
+    Entry entry;
+    entry.bytes = treeBytes(info.absoluteFilePath());
+    entry.last_used = QDateTime::fromString(readText(QDir(info.absoluteFilePath())
+          .absoluteFilePath(last_used_file_name)), Qt::ISODateWithMs);
+    if (!entry.last_used.isValid())
+      entry.last_used = info.lastModified();
+    entries.insert(info.fileName(), entry);
+    total_bytes += entry.bytes;
+  }
+  qDebug() << QObject::tr("Result cache: %1 entries, %2 bytes in %3")
+    .arg(entries.size()).arg(total_bytes).arg(cache_dir.absolutePath());
+}
+
+QDir ResultCache::cacheDir()
+{
+  QDir cache_dir(settings::AppSettings::instance()->getPath("plugs/result_cache_path"));
+  if (!cache_dir.exists())
+    cache_dir.mkpath(".");
+  return cache_dir;
+}
+
+void ResultCache::touch(const QString &name)
+{
+  // persisted so that the order survives restarts
+  entries[name].last_used = QDateTime::currentDateTime();
+  writeText(QDir(cacheDir().absoluteFilePath(name)).absoluteFilePath(last_used_file_name),
+      entries[name].last_used.toString(Qt::ISODateWithMs));
+}
+
+void ResultCache::evict()
+{
+  qint64 limit = settings::AppSettings::instance()->get<qint64>("plugs/result_cache_max_mb") << 20;
+  QDir cache_dir = cacheDir();
+  while (total_bytes > limit && !entries.isEmpty()) {
+    auto lru = entries.begin();
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+      if (it.value().last_used < lru.value().last_used)
+        lru = it;
+    qDebug() << QObject::tr("Result cache: evicting %1").arg(lru.key());
+    QDir(cache_dir.absoluteFilePath(lru.key())).removeRecursively();
+    total_bytes -= lru.value().bytes;
+    entries.erase(lru);
+    session.evictions++;
+  }
+}
@@ -0,0 +1,100 @@
+/** @file:     result_cache.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.17
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    On-disk cache of job step results keyed by a hash of what the
+ *             step computes from.
+ *
+ *  Job steps hash their exported problem, engine and command format before
+ *  invoking the plugin. Steps whose hash has a cache entry have their result
+ *  file, the other files of the step directory and the terminal output
+ *  restored instead of running the plugin. Each entry is a directory named
+ *  after the hash below plugs/result_cache_path, the cache is kept under
+ *  plugs/result_cache_max_mb by evicting the least recently used entries.
+ *  The cache is only used from the GUI thread.
+ */
+
+#ifndef _COMP_RESULT_CACHE_H_
+#define _COMP_RESULT_CACHE_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  class ResultCache
+  {
+  public:
+
+    //! Cache statistics, hits and misses are counted since the start of the
+    //! session.
+    struct Stats
+    {
+      int hits=0;         // lookups served from the cache
+      int misses=0;       // lookups without an entry
+      int stores=0;       // entries written
+      int evictions=0;    // entries evicted to stay under the size limit
+      int entries=0;      // entries in the cache
+      qint64 bytes=0;     // size of all entries
+    };
+
+    //! Return the cache instance.
+    static ResultCache *instance();
+
+    //! Return whether new jobs use the cache (plugs/result_cache_enabled).
+    static bool enabledByDefault();
+
+    //! Set whether new jobs use the cache.
+    static void setEnabledByDefault(bool enabled);
+
+    //! Restore the entry of key into the job step directory, the result file
+    //! to result_path and the terminal output to std_out and std_err. Returns
+    //! false on a miss.
+    bool lookup(const QByteArray &key, const QString &js_dir_path,
+                const QString &result_path, QString &std_out, QString &std_err);
+
+    //! Store the result file, the files in the job step directory other than
+    //! the excluded ones and the terminal output under key.
+    bool store(const QByteArray &key, const QString &js_dir_path,
+               const QString &result_path, const QStringList &exclude_paths,
+               const QString &std_out, const QString &std_err);
+
+    //! Return the statistics.
+    Stats stats();
+
+    //! Remove all entries.
+    void clear();
+
+  private:
+
+    // one cache entry
+    struct Entry
+    {
+      qint64 bytes=0;
+      QDateTime last_used;
+    };
+
+    //! Constructor, private for the singleton.
+    ResultCache() {};
+
+    // read the entries on disk on first use
+    void scan();
+
+    // the cache directory, created if needed
+    QDir cacheDir();
+
+    // record the use of an entry for LRU eviction
+    void touch(const QString &name);
+
+    // evict the least recently used entries until the cache fits the limit
+    void evict();
+
+    bool scanned=false;
+    QHash<QString, Entry> entries;  // entries by directory name
+    qint64 total_bytes=0;
+    Stats session;                  // counters of this session
+  };
+
+} // end of comp namespace
+
+#endif
@@ -10,9 +10,11 @@
 #include <QProcess>
 #include <iostream>
 #include <algorithm>
+#include <functional>
 #include "sim_job.h"
+#include "job_exporter.h"
+#include "result_cache.h"
 #include "../../../global.h"
-#include "../../../helpers/zip_helper.h"
 
 using namespace comp;
 
@@ -26,7 +28,9 @@ JobStep::JobStep(PluginEngine *t_engine, QStringList t_command_format,
   }
 }
 
-JobStep::JobStep(QXmlStreamReader *rs, QDir job_root_dir)
+JobStep::JobStep(QXmlStreamReader *rs, QDir job_root_dir,
+                 QSharedPointer<JobArchive> t_archive)
+  : archive(t_archive)
 {
   job_tmp_dir_path = job_root_dir.absolutePath();
   while (rs->readNextStartElement()) {
@@ -46,6 +50,26 @@ JobStep::JobStep(QXmlStreamReader *rs, QDir job_root_dir)
       problem_path = job_root_dir.absoluteFilePath(rs->readElementText());
     } else if (elemName == "result_path") {
       result_path = job_root_dir.absoluteFilePath(rs->readElementText());
+    } else if (elemName == "dependencies") {
+      while (rs->readNextStartElement()) {
+        if (rs->name().toString() == "step")
+          dependencies.append(rs->readElementText().toInt());
+        else
+          rs->skipCurrentElement();
+      }
+    } else if (elemName == "cache_key") {
+      cache_key = rs->readElementText().toLatin1();
+    } else if (elemName == "cache_hit") {
+      cache_hit = rs->readElementText() == "1";
+    } else if (elemName == "sweep_point") {
+      while (rs->readNextStartElement()) {
+        if (rs->name().toString() == "param") {
+          QString key = rs->attributes().value("key").toString();
+          sweep_point.insert(key, rs->readElementText());
+        } else {
+          rs->skipCurrentElement();
+        }
+      }
     } else {
       qWarning() << tr("Unknown XML element encountered when importing JobStep:"
          " %1").arg(rs->name().toString());
@@ -72,6 +96,28 @@ void JobStep::writeManifest(QXmlStreamWriter *ws)
     ws->writeTextElement("line", line);
   ws->writeEndElement();
 
+  // edges of the step graph
+  ws->writeStartElement("dependencies");
+  for (int dep : dependencies)
+    ws->writeTextElement("step", QString::number(dep));
+  ws->writeEndElement();
+
+  if (!cache_key.isEmpty()) {
+    ws->writeTextElement("cache_key", QString::fromLatin1(cache_key));
+    ws->writeTextElement("cache_hit", cache_hit ? "1" : "0");
+  }
+
+  if (!sweep_point.isEmpty()) {
+    ws->writeStartElement("sweep_point");
+    for (auto it = sweep_point.constBegin(); it != sweep_point.constEnd(); ++it) {
+      ws->writeStartElement("param");
+      ws->writeAttribute("key", it.key());
+      ws->writeCharacters(it.value());
+      ws->writeEndElement();
+    }
+    ws->writeEndElement();
+  }
+
   QDir job_root_dir = QDir(job_tmp_dir_path);
   ws->writeComment("Paths below are relative to SimJob manifest");
   ws->writeTextElement("step_dir", job_root_dir.relativeFilePath(js_tmp_dir_path));
@@ -132,6 +178,22 @@ bool JobStep::invokeBinary()
     return false;
   }
 
+  // serve the results from the cache if the same problem has been solved
+  cache_hit = false;
+  cache_key = use_result_cache ? resultCacheKey() : QByteArray();
+  if (!cache_key.isEmpty() && ResultCache::instance()->lookup(cache_key,
+        js_tmp_dir_path, result_path, std_out, std_err)) {
+    qDebug() << tr("Job step %1 results served from the result cache.").arg(placement);
+    job_step_state = Running;
+    start_time = QDateTime::currentDateTime();
+    cache_hit = true;
+    // finish after returning like a process would, the parent job registers
+    // the step as running first
+    QTimer::singleShot(0, this, [this]()
+        {processJobStepCompletion(0, QProcess::NormalExit);});
+    return true;
+  }
+
   job_step_state = Running;
 
   qDebug() << tr("Job step %1 about to execute command: %2")
@@ -152,6 +214,7 @@ bool JobStep::invokeBinary()
   qDebug() << tr("Waiting for process start success signal...");
   if (!process->waitForStarted()) {
     qCritical() << tr("Failed to start plugin process.");
+    job_step_state = FinishedWithError;
     return false;
   } else {
     qDebug() << "Job step process started successfully.";
@@ -183,15 +246,70 @@ bool JobStep::readResults(bool attempt_import_logs)
     return true;
   }
 
-  QFile result_file(result_path);
+  QMap<comp::JobResult::ResultType, comp::JobResult*> results;
+  QMap<comp::JobResult::ResultType, ResultParseMetrics> metrics;
+  QString err;
+  bool ok = parseResultFile(result_path, archive, results, metrics, err);
+  installResults(ok, results, metrics, err, attempt_import_logs);
+  return ok;
+}
 
-  if(!result_file.open(QFile::ReadOnly | QFile::Text)){
-    qDebug() << tr("Error when opening job step result file to read: %1").arg(result_file.errorString());
-    return false;
+void JobStep::readResultsAsync(bool attempt_import_logs)
+{
+  if (results_read) {
+    emit sig_resultsRead(placement, true);
+    return;
   }
+  if (results_pending)
+    return;
+  results_pending = true;
+
+  // the step may be deleted while the worker runs, the results are discarded
+  // then
+  QPointer<JobStep> step(this);
+  QString t_result_path = result_path;
+  QSharedPointer<JobArchive> t_archive = archive;
+  QThreadPool::globalInstance()->start([step, t_result_path, t_archive, attempt_import_logs]() {
+    QMap<comp::JobResult::ResultType, comp::JobResult*> results;
+    QMap<comp::JobResult::ResultType, ResultParseMetrics> metrics;
+    QString err;
+    bool ok = parseResultFile(t_result_path, t_archive, results, metrics, err);
+    // hand the results over to the GUI thread
+    for (comp::JobResult *result : results)
+      result->moveToThread(qApp->thread());
+    QMetaObject::invokeMethod(qApp, [step, ok, results, metrics, err, attempt_import_logs]() {
+      if (step.isNull()) {
+        qDeleteAll(results);
+        return;
+      }
+      step->installResults(ok, results, metrics, err, attempt_import_logs);
+    }, Qt::QueuedConnection);
+  });
+}
 
-  QXmlStreamReader rs(&result_file);
-  qDebug() << tr("Reading simulation results from %1...").arg(result_file.fileName());
+bool JobStep::parseResultFile(const QString &t_result_path, QSharedPointer<JobArchive> t_archive,
+    QMap<comp::JobResult::ResultType, comp::JobResult*> &results,
+    QMap<comp::JobResult::ResultType, ResultParseMetrics> &metrics, QString &err)
+{
+  // results of imported steps are read from the archive into memory
+  QFile result_file(t_result_path);
+  QByteArray result_xml;
+  QXmlStreamReader rs;
+  if (t_archive && !QFileInfo::exists(t_result_path)) {
+    if (!t_archive->read(t_result_path, result_xml, err)) {
+      err = tr("Error when reading job step result from the archive: %1").arg(err);
+      return false;
+    }
+    rs.addData(result_xml);
+  } else {
+    if(!result_file.open(QFile::ReadOnly | QFile::Text)){
+      err = tr("Error when opening job step result file to read: %1").arg(result_file.errorString());
+      return false;
+    }
+    rs.setDevice(&result_file);
+  }
+  qDebug() << tr("Reading simulation results from %1...").arg(t_result_path);
+  QString result_dir_path = QFileInfo(t_result_path).absolutePath();
 
   // TODO store the following variables to the class itself
   QString engine_name = "";
@@ -208,8 +326,23 @@ bool JobStep::readResults(bool attempt_import_logs)
     rs.skipCurrentElement();
   };
 
+  // time each result element and measure its extent in the file
+  QElapsedTimer timer;
+  auto addResult = [&](comp::JobResult::ResultType type, qint64 start_offset,
+                       comp::JobResult *result)
+  {
+    delete results.value(type, nullptr);
+    results.insert(type, result);
+    ResultParseMetrics m;
+    m.parse_ms = timer.elapsed();
+    m.chars = rs.characterOffset() - start_offset;
+    metrics.insert(type, m);
+  };
+
   while (rs.readNextStartElement()) {
     QString elemName = rs.name().toString();
+    qint64 start_offset = rs.characterOffset();
+    timer.start();
     if (elemName == "eng_info") {
       while (rs.readNextStartElement()) {
         QString innerElemName = rs.name().toString();
@@ -234,17 +367,23 @@ bool JobStep::readResults(bool attempt_import_logs)
       // params already stored in job_params, don't need to read again.
       rs.skipCurrentElement();
     } else if (elemName == "physloc") {
-      job_results.insert(comp::JobResult::DBLocationsResult,
-                         new comp::DBLocations(&rs));
+      addResult(comp::JobResult::DBLocationsResult, start_offset,
+                new comp::DBLocations(&rs));
     } else if (elemName == "elec_dist") {
-      job_results.insert(comp::JobResult::ChargeConfigsResult,
-                         new comp::ChargeConfigSet(&rs));
+      addResult(comp::JobResult::ChargeConfigsResult, start_offset,
+                new comp::ChargeConfigSet(&rs));
     } else if (elemName == "potential_map") {
-      job_results.insert(comp::JobResult::PotentialLandscapeResult,
-                         new comp::PotentialLandscape(&rs, QFileInfo(resultPath()).absolutePath()));
+      // the landscape looks for its plots next to the result file
+      QString extract_err;
+      if (t_archive && !t_archive->extractDir(result_dir_path, extract_err,
+            {"*.png", "*.gif"}))
+        qWarning() << tr("Failed to extract potential landscape plots: %1").arg(extract_err);
+      timer.restart();
+      addResult(comp::JobResult::PotentialLandscapeResult, start_offset,
+                new comp::PotentialLandscape(&rs, result_dir_path));
     } else if (elemName == "sqcommands") {
-      job_results.insert(comp::JobResult::SQCommandsResult,
-                        new comp::SQCommands(&rs));
+      addResult(comp::JobResult::SQCommandsResult, start_offset,
+                new comp::SQCommands(&rs));
     } else {
       unrecognizedXMLElement(rs);
     }
@@ -252,45 +391,237 @@ bool JobStep::readResults(bool attempt_import_logs)
 
   // TODO remove the following workaround after SiQADConn has been updated to
   // put DB physical locations inside electron config set
-  if (job_results.keys().contains(comp::JobResult::DBLocationsResult)
-      && job_results.keys().contains(comp::JobResult::ChargeConfigsResult)) {
-    comp::ChargeConfigSet *ecs = static_cast<comp::ChargeConfigSet*>(job_results.value(comp::JobResult::ChargeConfigsResult));
+  if (results.keys().contains(comp::JobResult::DBLocationsResult)
+      && results.keys().contains(comp::JobResult::ChargeConfigsResult)) {
+    comp::ChargeConfigSet *ecs = static_cast<comp::ChargeConfigSet*>(results.value(comp::JobResult::ChargeConfigsResult));
     ecs->setDBPhysicalLocations(
-        static_cast<comp::DBLocations*>(job_results.value(comp::JobResult::DBLocationsResult))->locations());
+        static_cast<comp::DBLocations*>(results.value(comp::JobResult::DBLocationsResult))->locations());
   }
 
   // TODO remove line scans support from SiQADConn
 
   if(rs.hasError()){
-    qCritical() << tr("Failed to read results, XML error - ") << rs.errorString().data();
+    err = tr("Failed to read results, XML error - %1").arg(rs.errorString());
     return false;
   }
 
+  result_file.close();
+  return true;
+}
+
+void JobStep::installResults(bool ok, QMap<comp::JobResult::ResultType, comp::JobResult*> results,
+    QMap<comp::JobResult::ResultType, ResultParseMetrics> metrics, const QString &err,
+    bool attempt_import_logs)
+{
+  results_pending = false;
+  if (results_read) {
+    // a synchronous read got there first
+    qDeleteAll(results);
+    return;
+  }
+  if (!ok) {
+    qCritical() << err;
+    qDeleteAll(results);
+    emit sig_resultsRead(placement, false);
+    return;
+  }
+
+  job_results = results;
+  parse_metrics = metrics;
+  for (auto it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+    qDebug() << tr("Job step %1 parsed %2 in %3 ms (%4 characters).").arg(placement)
+      .arg(QString::fromLatin1(QMetaEnum::fromType<comp::JobResult::ResultType>().valueToKey(it.key())))
+      .arg(it.value().parse_ms).arg(it.value().chars);
+  }
+
   // try to read std out and std error from log files if indicated (normally 
   // these are acquired from the QProcess, so only applicable when importing 
   // a job from manifest.)
-  auto importLogFromFilePath = [](QString &s, const QString &fpath)
+  if (attempt_import_logs && !logs_read)
+    importLogs();
+
+  qDebug() << tr("Successfully read job step result.");
+  results_read = true;
+  emit sig_resultsRead(placement, true);
+}
+
+QList<comp::JobResult::ResultType> JobStep::resultTypes()
+{
+  if (!archive || results_read)
+    return job_results.keys();
+
+  // scan the top level elements of the result file, in the order readResults
+  // maps them to results
+  static const QMap<QString, comp::JobResult::ResultType> result_elems = {
+    {"physloc", comp::JobResult::DBLocationsResult},
+    {"elec_dist", comp::JobResult::ChargeConfigsResult},
+    {"potential_map", comp::JobResult::PotentialLandscapeResult},
+    {"sqcommands", comp::JobResult::SQCommandsResult}
+  };
+  QByteArray result_xml;
+  QString err;
+  if (!archive->read(result_path, result_xml, err)) {
+    qDebug() << tr("Error when reading job step result from the archive: %1").arg(err);
+    return QList<comp::JobResult::ResultType>();
+  }
+  QList<comp::JobResult::ResultType> types;
+  QXmlStreamReader rs(result_xml);
+  rs.readNextStartElement();
+  while (rs.readNextStartElement()) {
+    auto it = result_elems.constFind(rs.name().toString());
+    if (it != result_elems.constEnd() && !types.contains(it.value()))
+      types.append(it.value());
+    rs.skipCurrentElement();
+  }
+  std::sort(types.begin(), types.end());
+  return types;
+}
+
+QString JobStep::problemPath()
+{
+  QString err;
+  if (archive && !archive->extract(problem_path, err))
+    qWarning() << tr("Failed to extract the problem file: %1").arg(err);
+  return problem_path;
+}
+
+void JobStep::importLogs()
+{
+  auto importLogFromFilePath = [this](QString &s, const QString &fpath)
   {
-    QFile file(fpath);
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
-      qWarning() << tr("File cannot be opened for reading: %1").arg(fpath);
-      return;
+    QByteArray log;
+    QString err;
+    if (archive) {
+      if (!archive->read(fpath, log, err)) {
+        qWarning() << tr("Log cannot be read from the archive: %1").arg(err);
+        return;
+      }
+    } else {
+      QFile file(fpath);
+      if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        qWarning() << tr("File cannot be opened for reading: %1").arg(fpath);
+        return;
+      }
+      log = file.readAll();
     }
-    s = QString(file.readAll());
+    s = QString(log);
   };
-  if (attempt_import_logs) {
-    QDir js_tmp_dir(js_tmp_dir_path);
-    importLogFromFilePath(std_out, js_tmp_dir.absoluteFilePath("runtime_stdout.log"));
-    importLogFromFilePath(std_err, js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
-  }
+  QDir js_tmp_dir(js_tmp_dir_path);
+  importLogFromFilePath(std_out, js_tmp_dir.absoluteFilePath("runtime_stdout.log"));
+  importLogFromFilePath(std_err, js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
+  logs_read = true;
+}
 
-  qDebug() << tr("Successfully read job step result.");
-  result_file.close();
+bool JobStep::deriveProblem(const QString &base_problem_path)
+{
+  QFile base_file(base_problem_path);
+  if (!base_file.open(QFile::ReadOnly)) {
+    qWarning() << tr("Failed to open the base problem %1: %2")
+      .arg(base_problem_path).arg(base_file.errorString());
+    return false;
+  }
+  QByteArray xml = base_file.readAll();
+  base_file.close();
+
+  // locate the simulation parameters of the base step, the rest of the
+  // problem is the same for all sweep points
+  const QByteArray open_tag("<sim_params>"), empty_tag("<sim_params/>"),
+    close_tag("</sim_params>");
+  int start = xml.indexOf(open_tag);
+  int end = (start < 0) ? -1 : xml.indexOf(close_tag, start);
+  if (end >= 0) {
+    end += close_tag.size();
+  } else if ((start = xml.indexOf(empty_tag)) >= 0) {
+    end = start + empty_tag.size();
+  } else {
+    qWarning() << tr("No simulation parameters in the base problem %1.").arg(base_problem_path);
+    return false;
+  }
 
-  results_read = true;
+  QByteArray params;
+  QXmlStreamWriter ws(&params);
+  ws.writeStartElement("sim_params");
+  for (auto it = job_params.constBegin(); it != job_params.constEnd(); ++it)
+    ws.writeTextElement(it.key(), it.value());
+  ws.writeEndElement();
+  xml.replace(start, end - start, params);
+
+  QFile file(problem_path);
+  if (!file.open(QFile::WriteOnly) || file.write(xml) != xml.size()) {
+    qWarning() << tr("Failed to write the problem %1: %2")
+      .arg(problem_path).arg(file.errorString());
+    return false;
+  }
   return true;
 }
 
+bool JobStep::addCanonicalXml(QCryptographicHash &hash, const QString &path)
+{
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly))
+    return false;
+  auto addValue = [&hash](const QString &text)
+  {
+    bool is_num;
+    double num = text.toDouble(&is_num);
+    hash.addData(is_num ? QByteArray::number(num, 'g', 12) : text.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+  };
+  QXmlStreamReader rs(&file);
+  while (!rs.atEnd()) {
+    rs.readNext();
+    if (rs.isStartElement()) {
+      if (rs.name() == QLatin1String("program") || rs.name() == QLatin1String("gui")) {
+        rs.skipCurrentElement();
+        continue;
+      }
+      hash.addData("<" + rs.name().toUtf8());
+      QXmlStreamAttributes attrs = rs.attributes();
+      std::sort(attrs.begin(), attrs.end(),
+          [](const QXmlStreamAttribute &a, const QXmlStreamAttribute &b)
+          {return a.qualifiedName() < b.qualifiedName();});
+      for (const QXmlStreamAttribute &attr : attrs) {
+        hash.addData(" " + attr.qualifiedName().toUtf8() + "=");
+        addValue(attr.value().toString());
+      }
+    } else if (rs.isEndElement()) {
+      hash.addData(">");
+    } else if (rs.isCharacters() && !rs.isWhitespace()) {
+      addValue(rs.text().toString().trimmed());
+    }
+  }
+  return !rs.hasError();
+}
+
+QByteArray JobStep::resultCacheKey()
+{
+  // the engine's unique identifier is seeded per session, its name, version
+  // and binary identify it across sessions
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  QFileInfo bin_info(engine->binaryPath());
+  hash.addData(QString("siqad-result-v1\n%1\n%2\n%3\n%4\n%5\n")
+      .arg(engine->name()).arg(engine->version()).arg(bin_info.size())
+      .arg(bin_info.lastModified().toMSecsSinceEpoch())
+      .arg(command_format.join("\n")).toUtf8());
+  if (!addCanonicalXml(hash, problem_path)) {
+    qWarning() << tr("Failed to hash the problem %1, the result cache is "
+        "bypassed.").arg(problem_path);
+    return QByteArray();
+  }
+  for (auto it = dep_result_paths.constBegin(); it != dep_result_paths.constEnd(); ++it) {
+    hash.addData(QByteArray::number(it.key()));
+    if (!addCanonicalXml(hash, it.value()))
+      return QByteArray();
+  }
+  return hash.result().toHex();
+}
+
+void JobStep::setDependencyResultPaths(const QMap<int, QString> &t_dep_result_paths)
+{
+  dep_result_paths = t_dep_result_paths;
+  commandKeywordReplacement();
+}
+
 void JobStep::exportTerminalOutputs(QString std_out_path, QString std_err_path)
 {
   // store std out and std error into file log
@@ -310,6 +641,10 @@ void JobStep::exportTerminalOutputs(QString std_out_path, QString std_err_path)
 
 void JobStep::terminateJobStep()
 {
+  // steps served from the cache or parsing their results have no process to
+  // terminate
+  if (process == nullptr || process->state() == QProcess::NotRunning)
+    return;
 #ifdef _WIN32
   process->kill();
 #else
@@ -326,11 +661,26 @@ void JobStep::processJobStepCompletion(int t_exit_code, QProcess::ExitStatus t_e
   end_time = QDateTime::currentDateTime();
 
   bool successful = (exit_code == 0) && (exit_status == QProcess::NormalExit);
-  if (successful)
-    readResults();
+  if (!successful) {
+    job_step_state = FinishedWithError;
+    emit sig_jobStepFinishState(placement, false);
+    return;
+  }
 
-  // inform the parent of the success state.
-  emit sig_jobStepFinishState(placement, successful);
+  // results are parsed off the GUI thread, the step stays running until they
+  // are in so that the parent only sees finished steps with their results
+  connect(this, &JobStep::sig_resultsRead, this, [this](int, bool results_ok)
+      {
+        if (results_ok && !cache_hit && !cache_key.isEmpty()) {
+          ResultCache::instance()->store(cache_key, js_tmp_dir_path, result_path,
+              {problem_path}, std_out, std_err);
+        }
+        job_step_state = FinishedNormally;
+
+        // inform the parent of the success state.
+        emit sig_jobStepFinishState(placement, true);
+      }, Qt::SingleShotConnection);
+  readResultsAsync();
 }
 
 bool JobStep::commandKeywordReplacement()
@@ -350,6 +700,8 @@ bool JobStep::commandKeywordReplacement()
   replace_map["@RESULTPATH@"] = result_path;
   replace_map["@JOBTMP@"] = job_tmp_dir_path;
   replace_map["@STEPTMP@"] = js_tmp_dir_path;
+  for (auto it = dep_result_paths.constBegin(); it != dep_result_paths.constEnd(); ++it)
+    replace_map[QString("@RESULTPATH_%1@").arg(it.key())] = it.value();
 
   QRegularExpression regex("@([^@]+)@");
   regex.setPatternOptions(QRegularExpression::InvertedGreedinessOption); // make the match non-greedy
@@ -375,7 +727,10 @@ bool JobStep::commandKeywordReplacement()
 
 SimJob::SimJob(const QString &nm, QWidget *parent)
   : QObject(parent), job_state(NotInvoked), job_name(nm), gui_ctrl_elems(this)
-{}
+{
+  setMaxParallelSteps(settings::AppSettings::instance()->get<int>("plugs/max_parallel_job_steps"));
+  use_result_cache = ResultCache::enabledByDefault();
+}
 
 SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override, 
     QWidget *parent)
@@ -385,25 +740,13 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
   QString manifest_path;
   gui_ctrl_elems.pb_terminate->setDisabled(true);
 
-  auto find_manifest = [](QDir xdir)
-  {
-    QDirIterator it(xdir, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-      it.next();
-      if (it.fileInfo().fileName() == "manifest.xml") {
-        return it.fileInfo().absoluteFilePath();
-      }
-    }
-    return QString();
-  };
-
   // lambda function for importing job steps
-  auto importJobSteps = [this](QXmlStreamReader &rs, QFile &file)
+  auto importJobSteps = [this](QXmlStreamReader &rs, const QDir &job_root)
   {
     while (rs.readNextStartElement()) {
       QString elemName = rs.name().toString();
       if (elemName == "job_step") {
-        job_steps.append(new JobStep(&rs, QFileInfo(file).dir()));
+        job_steps.append(new JobStep(&rs, job_root, archive));
       } else {
         qWarning() << tr("Unknown XML tag encountered when importing job steps:"
            " %1").arg(elemName);
@@ -412,9 +755,11 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     }
   };
 
-  // decompress the archive if dcmp flag is true
+  // open the archive if dcmp flag is true, files are only extracted when
+  // they're needed
+  QByteArray manifest_xml;
   if (dcmp) {
-    qDebug() << "Decompressing SimJob archive...";
+    qDebug() << "Opening SimJob archive...";
     QString tmpd = settings::AppSettings::instance()->getPath("plugs/runtime_tmp_root_path");
     QDir xdir(QDir(tmpd).absoluteFilePath("IM_" + QDateTime::currentDateTime().toString("yyMMdd_HHmmss")));
 
@@ -422,14 +767,17 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
       xdir.mkpath(".");
     }
 
-    if (!extract_all_from_zip(fpath, xdir.absolutePath())) {
-      QMessageBox::critical(nullptr, "Extraction Error", "Failed to extract the SimJob archive.");
+    archive = QSharedPointer<JobArchive>::create(fpath, xdir.absolutePath());
+    QString err;
+    if (!archive->open(err)) {
+      qWarning() << err;
+      QMessageBox::critical(nullptr, "Extraction Error", "Failed to open the SimJob archive.");
       return;
     }
 
     qDebug() << "Searching for SimJob manifest...";
-    manifest_path = find_manifest(xdir);
-    if (manifest_path.isEmpty()) {
+    manifest_path = archive->findFile("manifest.xml");
+    if (manifest_path.isEmpty() || !archive->read(manifest_path, manifest_xml, err)) {
       QMessageBox msg;
       msg.setText("manifest.xml not found in the provided archive. Import halted.");
       msg.exec();
@@ -443,11 +791,17 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
 
   // get file and XML stream
   QFile file(manifest_path);
-  if (!file.open(QFile::ReadOnly | QFile::Text)) {
-    qWarning() << tr("Error when opening file to read: %1").arg(file.errorString());
-    return;
+  QXmlStreamReader rs;
+  if (archive) {
+    rs.addData(manifest_xml);
+    job_tmp_dir_path = QFileInfo(manifest_path).absolutePath();
+  } else {
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+      qWarning() << tr("Error when opening file to read: %1").arg(file.errorString());
+      return;
+    }
+    rs.setDevice(&file);
   }
-  QXmlStreamReader rs(&file);
 
   // read manifest from stream
   qDebug() << "Reading SimJob manifest";
@@ -476,8 +830,18 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     } else if (elemName == "time_end") {
       // TODO implement
       rs.skipCurrentElement();
+    } else if (elemName == "inclusion_area") {
+      auto&& meta_enum = QMetaEnum::fromType<gui::DesignInclusionArea>();
+      bool ok;
+      int area_val = meta_enum.keyToValue(rs.readElementText().toLocal8Bit(), &ok);
+      if (ok)
+        inclusion_area = static_cast<gui::DesignInclusionArea>(area_val);
+    } else if (elemName == "area_of_interest") {
+      area_of_interest = prim::AreaOfInterest::fromXml(&rs);
+    } else if (elemName == "max_parallel_steps") {
+      setMaxParallelSteps(rs.readElementText().toInt());
     } else if (elemName == "job_steps") {
-      importJobSteps(rs, file);
+      importJobSteps(rs, QFileInfo(manifest_path).dir());
     } else {
       qWarning() << tr("Unknown XML tag encountered when importing SimJob: %1")
         .arg(elemName);
@@ -492,11 +856,13 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     job_name = name_override;
   }
 
-  // import results
+  // import results, steps of archived jobs only list their result types and
+  // read the results when they're first shown
   qDebug() << "Reading JobStep results";
   for (JobStep *js : job_steps) {
-    js->readResults(true);
-    for (comp::JobResult::ResultType type : js->jobResults().keys()) {
+    if (!archive)
+      js->readResults(true);
+    for (comp::JobResult::ResultType type : js->resultTypes()) {
       result_type_step_map.insert(type, js);
     }
   }
@@ -543,6 +909,12 @@ void SimJob::writeManifest(QXmlStreamWriter *ws)
   if (end_time.isValid()) {
     ws->writeTextElement("time_end", QVariant::fromValue(end_time).toString());
   }
+  ws->writeTextElement("inclusion_area", QVariant::fromValue(inclusion_area).toString());
+  ws->writeTextElement("max_parallel_steps", QString::number(max_parallel_steps));
+  if (inclusion_area == gui::IncludeAreaOfInterest && area_of_interest.isValid()) {
+    // kept so that the region can be reused by later runs
+    area_of_interest.writeXml(ws);
+  }
 
   // all job steps
   ws->writeStartElement("job_steps");
@@ -563,10 +935,25 @@ void SimJob::confirmJobStepsPlacement()
   for (int i=0; i<job_steps.length(); i++) {
     job_steps.at(i)->prepareJobStep(i, runtimeTempPath());
   }
+
+  // result paths are only known once every step has been placed
+  for (JobStep *js : job_steps) {
+    if (js->stepDependencies().isEmpty())
+      continue;
+    QMap<int, QString> dep_result_paths;
+    for (int dep : js->stepDependencies())
+      if (dep >= 0 && dep < job_steps.length())
+        dep_result_paths.insert(dep, job_steps.at(dep)->resultPath());
+    js->setDependencyResultPaths(dep_result_paths);
+  }
 }
 
 void SimJob::prepareJob()
 {
+  if (job_prepared)
+    return;
+  job_prepared = true;
+
   if (!placement_confirmed) {
     qDebug() << "Confirming job steps placement...";
     confirmJobStepsPlacement();
@@ -575,11 +962,26 @@ void SimJob::prepareJob()
   // export problem files for all job steps
   qDebug() << "Exporting job step problem files...";
   for (JobStep *job_step : job_steps) {
-    emit sig_exportJobStepProblem(job_step, inclusion_area);
+    if (job_step->problemSource() < 0)
+      emit sig_exportJobStepProblem(job_step, inclusion_area, area_of_interest);
+  }
+
+  // sweep points reuse the exported design with their own parameters
+  for (JobStep *job_step : job_steps) {
+    int src = job_step->problemSource();
+    if (src < 0)
+      continue;
+    if (src >= job_steps.length() || job_steps.at(src)->problemSource() >= 0
+        || !job_step->deriveProblem(job_steps.at(src)->problemPath())) {
+      qWarning() << tr("Exporting the problem of step %1 instead of reusing "
+          "the problem of step %2.").arg(job_step->jobStepPlacement()).arg(src);
+      emit sig_exportJobStepProblem(job_step, inclusion_area, area_of_interest);
+    }
   }
 
   // connect necessary signals
   for (JobStep *job_step : job_steps) {
+    job_step->setUseResultCache(use_result_cache);
     connect(job_step, &comp::JobStep::sig_jobStepFinishState,
             this, &SimJob::continueJob);
   }
@@ -588,55 +990,160 @@ void SimJob::prepareJob()
   writeManifest();
 }
 
+int SimJob::coreRequirement() const
+{
+  QList<int> step_cores;
+  for (JobStep *js : job_steps) {
+    comp::PluginEngine *engine = js->pluginEngine();
+    step_cores.append(engine != nullptr ? engine->coreRequirement() : 1);
+  }
+  std::sort(step_cores.begin(), step_cores.end(), std::greater<int>());
+  int cores = 0;
+  for (int i=0; i<qMin(max_parallel_steps, int(step_cores.length())); i++)
+    cores += step_cores.at(i);
+  return qMax(1, cores);
+}
+
+void SimJob::enqueue()
+{
+  job_state = Queued;
+  queue_time = QDateTime::currentDateTime();
+  gui_ctrl_elems.pb_terminate->setText("Dequeue");
+}
+
+qint64 SimJob::waitSecs() const
+{
+  if (!queue_time.isValid())
+    return 0;
+  if (job_state == Queued)
+    return queue_time.secsTo(QDateTime::currentDateTime());
+  return start_time.isValid() ? queue_time.secsTo(start_time) : 0;
+}
+
 bool SimJob::beginJob()
 {
-  if (!placement_confirmed)
+  if (!validateStepGraph()) {
+    jobFinishActions(FinishedWithError);
+    return false;
+  }
+
+  if (!job_prepared)
     prepareJob();
 
-  qDebug() << "Beginning job step invocation.";
+  qDebug() << tr("Beginning job step invocation, up to %1 steps at a time.")
+    .arg(max_parallel_steps);
   job_state = Running;
-  curr_step = job_steps.at(0);
-  return job_steps.at(0)->invokeBinary();
+  start_time = QDateTime::currentDateTime();
+  gui_ctrl_elems.pb_terminate->setText("Terminate");
+  step_failed = false;
+  bool invoked = invokeReadySteps();
+  if (running_steps.isEmpty()) {
+    // nothing could be started
+    jobFinishActions(FinishedWithError);
+    return false;
+  }
+  return invoked;
 }
 
 void SimJob::continueJob(int prev_step_ind, bool prev_step_successful)
 {
-  if (!prev_step_successful) {
-    qDebug() << tr("Last job step finished unsuccessfully, ceasing job.");
-    jobFinishActions(FinishedWithError);
-    return;
+  JobStep *prev_step = job_steps.at(prev_step_ind);
+  running_steps.removeAll(prev_step);
+
+  if (prev_step_successful) {
+    qDebug() << tr("Received step completion notice from job step %1.").arg(prev_step_ind);
+    // make the results available as they arrive
+    for (comp::JobResult::ResultType type : prev_step->jobResults().keys())
+      addResultTypeStep(type, prev_step);
+    emit sig_jobStepResultsAvailable(this, prev_step_ind);
+  } else {
+    qDebug() << tr("Job step %1 finished unsuccessfully, no further steps will "
+        "be invoked.").arg(prev_step_ind);
+    step_failed = true;
   }
 
-  qDebug() << tr("Received step completion notice from job step %1.").arg(prev_step_ind);
-
-  qDebug() << tr("Prev step engine name %1").arg(job_steps[0]->pluginEngine()->name());
-  qDebug() << tr("job_steps.length=%1").arg(job_steps.length());
-
-  for (comp::JobResult::ResultType type : job_steps.at(prev_step_ind)->jobResults().keys())
-    result_type_step_map.insert(type, job_steps.at(prev_step_ind));
+  if (!step_failed && !invokeReadySteps())
+    step_failed = true;
 
-  int i = prev_step_ind + 1;
-  if (i < job_steps.length()) {
-    // invoke next step if any
-    job_steps.at(i)->invokeBinary();
-    curr_step = job_steps.at(i);
-  } else {
-    // wrap up job if no more steps
-    curr_step = nullptr;
-    jobFinishActions(FinishedNormally);
+  // wrap up the job once no step is running
+  if (running_steps.isEmpty()) {
+    bool all_finished = std::all_of(job_steps.cbegin(), job_steps.cend(),
+        [](JobStep *js) {return js->jobStepState() == JobStep::FinishedNormally;});
+    jobFinishActions((!step_failed && all_finished) ? FinishedNormally : FinishedWithError);
   }
   writeManifest();
 }
 
+void SimJob::addResultTypeStep(comp::JobResult::ResultType type, JobStep *step)
+{
+  // QMultiMap lists the latest insertion first, so reinsert by ascending
+  // placement to list the highest placement first
+  QList<JobStep*> steps = result_type_step_map.values(type);
+  if (steps.contains(step))
+    return;
+  steps.append(step);
+  std::sort(steps.begin(), steps.end(),
+      [](JobStep *a, JobStep *b) {return a->jobStepPlacement() < b->jobStepPlacement();});
+  result_type_step_map.remove(type);
+  for (JobStep *js : steps)
+    result_type_step_map.insert(type, js);
+}
+
 void SimJob::terminateJob()
 {
-  if (curr_step != nullptr)
-    curr_step->terminateJobStep();
+  if (job_state == Queued || job_state == NotInvoked) {
+    // never started, report the job as failed so that it leaves the queue
+    jobFinishActions(FinishedWithError);
+    gui_ctrl_elems.pb_terminate->setText("Dequeued");
+    return;
+  }
+  step_failed = true;
+  for (JobStep *js : running_steps)
+    js->terminateJobStep();
+}
+
+bool SimJob::validateStepGraph()
+{
+  for (int i=0; i<job_steps.length(); i++) {
+    for (int dep : job_steps.at(i)->stepDependencies()) {
+      if (dep < 0 || dep >= i) {
+        qWarning() << tr("Job step %1 depends on step %2, steps may only depend "
+            "on earlier steps.").arg(i).arg(dep);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SimJob::invokeReadySteps()
+{
+  bool ok = true;
+  for (JobStep *js : job_steps) {
+    if (running_steps.length() >= max_parallel_steps)
+      break;
+    if (js->jobStepState() != JobStep::NotInvoked)
+      continue;
+    QList<int> deps = js->stepDependencies();
+    bool ready = std::all_of(deps.cbegin(), deps.cend(), [this](int dep)
+        {return job_steps.at(dep)->jobStepState() == JobStep::FinishedNormally;});
+    if (!ready)
+      continue;
+    if (js->invokeBinary()) {
+      running_steps.append(js);
+    } else {
+      qWarning() << tr("Failed to invoke job step %1.").arg(js->jobStepPlacement());
+      ok = false;
+      break;
+    }
+  }
+  return ok;
 }
 
 void SimJob::jobFinishActions(JobState t_job_state)
 {
   job_state = t_job_state;
+  end_time = QDateTime::currentDateTime();
   switch(job_state)
   {
     case FinishedWithError:
@@ -693,6 +1200,18 @@ QList<QStandardItem*> SimJob::jobInfoStandardItemRow(QList<JobInfoStandardItemFi
   return info_si_row;
 }
 
+bool SimJob::extractArchive()
+{
+  if (!archive)
+    return true;
+  QString err;
+  if (!archive->extractDir(archive->localRoot(), err)) {
+    qWarning() << tr("Failed to extract the SimJob archive: %1").arg(err);
+    return false;
+  }
+  return true;
+}
+
 QString SimJob::runtimeTempPath()
 {
   QString phys_tmp_rt_path = settings::AppSettings::instance()->getPath("plugs/runtime_tmp_root_path");
@@ -764,6 +1283,134 @@ QWidget *SimJob::terminalOutputDialog(QWidget *parent, Qt::WindowFlags w_flags)
   return w_job_term_out;
 }
 
+bool SimJob::isSweep() const
+{
+  return std::any_of(job_steps.cbegin(), job_steps.cend(),
+      [](JobStep *js) {return !js->sweepPoint().isEmpty();});
+}
+
+QStringList SimJob::sweepTableHeader() const
+{
+  QStringList sweep_keys;
+  for (JobStep *js : job_steps)
+    for (const QString &key : js->sweepPoint().keys())
+      if (!sweep_keys.contains(key))
+        sweep_keys.append(key);
+  return QStringList({"step"}) + sweep_keys
+    + QStringList({"ground_state_energy", "net_charge", "validity"});
+}
+
+QList<QStringList> SimJob::sweepTableRows()
+{
+  QStringList header = sweepTableHeader();
+  QStringList sweep_keys = header.mid(1, header.length() - 4);
+  QList<QStringList> rows;
+  for (JobStep *js : job_steps) {
+    QMap<QString, QString> sweep_point = js->sweepPoint();
+    if (sweep_point.isEmpty())
+      continue;
+    QStringList row({QString::number(js->jobStepPlacement())});
+    for (const QString &key : sweep_keys)
+      row.append(sweep_point.value(key));
+
+    // the ground state is the lowest energy physically valid configuration,
+    // or the lowest energy configuration if none is known to be valid
+    auto *config_set = static_cast<ChargeConfigSet*>(
+        js->jobResults().value(JobResult::ChargeConfigsResult, nullptr));
+    QList<ChargeConfigSet::ChargeConfig> configs;
+    if (config_set != nullptr)
+      configs = config_set->chargeConfigs();
+    if (configs.isEmpty()) {
+      // no charge configurations, report why
+      row << "" << "" << QMetaEnum::fromType<JobStep::JobStepState>()
+        .valueToKey(js->jobStepState());
+      rows.append(row);
+      continue;
+    }
+    auto lower = [](const ChargeConfigSet::ChargeConfig &a,
+                    const ChargeConfigSet::ChargeConfig &b)
+    {
+      if ((a.is_valid == 1) != (b.is_valid == 1))
+        return a.is_valid == 1;
+      return a.energy < b.energy;
+    };
+    ChargeConfigSet::ChargeConfig ground = *std::min_element(configs.cbegin(),
+        configs.cend(), lower);
+    row << QString::number(ground.energy, 'g', 10)
+      << QString::number(ground.netNegCharge())
+      << (ground.is_valid == 1 ? "valid" : (ground.is_valid == 0 ? "invalid" : "unknown"));
+    rows.append(row);
+  }
+  return rows;
+}
+
+bool SimJob::exportSweepTable(const QString &csv_path)
+{
+  QFile file(csv_path);
+  if (!file.open(QFile::WriteOnly | QFile::Text)) {
+    qWarning() << tr("Failed to open %1 for writing: %2").arg(csv_path)
+      .arg(file.errorString());
+    return false;
+  }
+  // quote fields that would break the row
+  auto csvRow = [](const QStringList &fields)
+  {
+    QStringList quoted;
+    for (QString field : fields) {
+      if (field.contains(QRegularExpression("[\",\n]")))
+        field = "\"" + field.replace("\"", "\"\"") + "\"";
+      quoted.append(field);
+    }
+    return quoted.join(",") + "\n";
+  };
+  QTextStream out(&file);
+  out << csvRow(sweepTableHeader());
+  for (const QStringList &row : sweepTableRows())
+    out << csvRow(row);
+  file.close();
+  qDebug() << tr("Sweep table written to %1").arg(csv_path);
+  return true;
+}
+
+QWidget *SimJob::sweepTableDialog(QWidget *parent, Qt::WindowFlags w_flags)
+{
+  QWidget *w_sweep_table = new QWidget(parent, w_flags);
+  w_sweep_table->setAttribute(Qt::WA_DeleteOnClose);
+
+  QStringList header = sweepTableHeader();
+  QList<QStringList> rows = sweepTableRows();
+  QTableWidget *tw_sweep = new QTableWidget(rows.length(), header.length());
+  tw_sweep->setHorizontalHeaderLabels(header);
+  tw_sweep->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  for (int r=0; r<rows.length(); r++)
+    for (int c=0; c<rows.at(r).length(); c++)
+      tw_sweep->setItem(r, c, new QTableWidgetItem(rows.at(r).at(c)));
+  tw_sweep->resizeColumnsToContents();
+  tw_sweep->setSortingEnabled(true);
+
+  QPushButton *pb_export_csv = new QPushButton(tr("Export CSV"));
+  connect(pb_export_csv, &QPushButton::clicked,
+          [this, w_sweep_table]()
+          {
+            QString csv_path = QFileDialog::getSaveFileName(w_sweep_table,
+                tr("Export Sweep Table"), name() + ".csv", tr("CSV (*.csv)"));
+            if (!csv_path.isEmpty())
+              exportSweepTable(csv_path);
+          });
+
+  QHBoxLayout *hl_buttons = new QHBoxLayout();
+  hl_buttons->addStretch();
+  hl_buttons->addWidget(pb_export_csv);
+
+  QVBoxLayout *vl_sweep_table = new QVBoxLayout();
+  vl_sweep_table->addWidget(tw_sweep);
+  vl_sweep_table->addLayout(hl_buttons);
+
+  w_sweep_table->setWindowTitle(tr("%1 Sweep Table").arg(name()));
+  w_sweep_table->setLayout(vl_sweep_table);
+  return w_sweep_table;
+}
+
 bool SimJob::exportJob(QString out_path)
 {
   if (imported) {
@@ -780,13 +1427,16 @@ bool SimJob::exportJob(QString out_path)
     msg.exec();
     return false;
   }
-  if (out_path.isNull()) {
-    out_path = QFileDialog::getSaveFileName(nullptr, 
-        tr("Export SimJob"), name() + ".sqjx.zip");
-    if (out_path.isEmpty()) {
-      qWarning() << "No output path was chosen. Halting export.";
-      return false;
-    }
+  if (exporter != nullptr) {
+    QMessageBox msg;
+    msg.setText(tr("The SimJob is already being exported to %1.").arg(exporter->outPath()));
+    msg.exec();
+    return false;
+  }
+  int level = settings::AppSettings::instance()->get<int>("plugs/job_export_level");
+  if (out_path.isNull() && !exportDialog(out_path, level)) {
+    qWarning() << "No output path was chosen. Halting export.";
+    return false;
   }
 
   // tell job steps to write their terminal outputs to file
@@ -796,32 +1446,75 @@ bool SimJob::exportJob(QString out_path)
         js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
   }
 
-  // throw everything to archive
-  mz_zip_archive zip_archive;
-  memset(&zip_archive, 0, sizeof(zip_archive));
+  // throw everything to archive on a worker thread
+  exporter = new JobExporter(job_tmp_dir_path, out_path, level, this);
+  QProgressDialog *pd = new QProgressDialog(tr("Exporting %1...").arg(name()),
+      tr("Cancel"), 0, 100);
+  pd->setWindowTitle(tr("Export SimJob"));
+  pd->setAttribute(Qt::WA_DeleteOnClose);
+  pd->setMinimumDuration(500);
+  connect(exporter, &JobExporter::sig_progress, pd, &QProgressDialog::setValue);
+  connect(pd, &QProgressDialog::canceled, exporter, &JobExporter::cancel);
+  connect(exporter, &JobExporter::sig_finished,
+          [this, pd](bool ok, const QString &err)
+          {
+            pd->close();
+            if (ok) {
+              qDebug() << tr("SimJob exported successfully to %1").arg(exporter->outPath());
+            } else {
+              qWarning() << tr("SimJob export to %1 failed: %2").arg(exporter->outPath()).arg(err);
+            }
+            gui_ctrl_elems.pb_export_results->setEnabled(true);
+            exporter->deleteLater();
+            exporter = nullptr;
+          });
+  gui_ctrl_elems.pb_export_results->setEnabled(false);
+  exporter->start();
 
-  // Initialize a new zip archive
-  if (!mz_zip_writer_init_file(&zip_archive, out_path.toStdString().c_str(), 0)) {
-    qWarning() << "Could not initialize zip archive";
-    return false;
-  }
+  return true;
+}
 
-  // Add the directory to the zip
-  if (!add_directory_to_zip(zip_archive, job_tmp_dir_path.toStdString())) {
-    mz_zip_writer_end(&zip_archive);
-    return false;
-  }
+bool SimJob::exportDialog(QString &out_path, int &level)
+{
+  QDialog dialog;
+  dialog.setWindowTitle(tr("Export SimJob"));
 
-  // Finalize the archive
-  if (!mz_zip_writer_finalize_archive(&zip_archive)) {
-    qWarning() << "Could not finalize zip archive";
-    mz_zip_writer_end(&zip_archive);
+  QLineEdit *le_path = new QLineEdit(QDir::current().absoluteFilePath(name() + ".sqjx.zip"));
+  QPushButton *pb_browse = new QPushButton(tr("Browse..."));
+  connect(pb_browse, &QPushButton::clicked,
+          [&dialog, le_path]()
+          {
+            QString path = QFileDialog::getSaveFileName(&dialog, tr("Export SimJob"),
+                le_path->text(), tr("SimJob archives (*.sqjx.zip);;All files (*)"));
+            if (!path.isEmpty())
+              le_path->setText(path);
+          });
+  QHBoxLayout *hl_path = new QHBoxLayout();
+  hl_path->addWidget(le_path);
+  hl_path->addWidget(pb_browse);
+
+  // media files are always stored, the level applies to the others
+  QComboBox *cb_level = new QComboBox();
+  cb_level->addItem(tr("Store only"), 0);
+  cb_level->addItem(tr("Fastest"), 1);
+  cb_level->addItem(tr("Balanced"), 6);
+  cb_level->addItem(tr("Smallest"), 9);
+  cb_level->setCurrentIndex(qMax(0, cb_level->findData(level)));
+
+  QDialogButtonBox *bb = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  connect(bb, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+  connect(bb, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+  QFormLayout *fl = new QFormLayout();
+  fl->addRow(tr("Archive"), hl_path);
+  fl->addRow(tr("Compression"), cb_level);
+  QVBoxLayout *vl = new QVBoxLayout(&dialog);
+  vl->addLayout(fl);
+  vl->addWidget(bb);
+
+  if (dialog.exec() != QDialog::Accepted || le_path->text().isEmpty())
     return false;
-  }
-
-  mz_zip_writer_end(&zip_archive);
-
-  qDebug() << tr("SimJob exported successfully to %1").arg(out_path);
-
+  out_path = le_path->text();
+  level = cb_level->currentData().toInt();
   return true;
 }
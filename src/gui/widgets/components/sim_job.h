@@ -13,14 +13,17 @@
 #include <QtWidgets>
 #include <QtCore>
 #include "plugin_engine.h"
+#include "job_archive.h"
 #include "job_results/job_result_types.h"
 #include "settings/settings.h" // TODO probably need this later
+#include "../primitives/visual_aids/area_of_interest.h"
 #include <tuple> //std::tuple for 3+ article data structure, std::get for accessing the tuples
 #include <QDir>
 
 namespace comp{
 
   class SimJob;
+  class JobExporter;
 
   //! A single job step in a job.
   class JobStep : public QObject
@@ -32,12 +35,21 @@ namespace comp{
     enum JobStepState{NotInvoked, Running, FinishedWithError, FinishedNormally};
     Q_ENUM(JobStepState);
 
+    //! Time and size of parsing one result element of the result file.
+    struct ResultParseMetrics
+    {
+      qint64 parse_ms=0;    // time spent constructing the result
+      qint64 chars=0;       // characters of the result element
+    };
+
     //! Constructor.
     JobStep(PluginEngine *t_engine, QStringList t_command_format, 
             gui::PropertyMap t_job_prop_map);
     
-    //! XML import constructor.
-    JobStep(QXmlStreamReader *rs, QDir job_root_dir);
+    //! XML import constructor. Steps imported from an archive read their
+    //! files from it on demand.
+    JobStep(QXmlStreamReader *rs, QDir job_root_dir,
+            QSharedPointer<JobArchive> t_archive=QSharedPointer<JobArchive>());
 
     //! Destructor.
     ~JobStep();
@@ -64,28 +76,91 @@ namespace comp{
     //! Process the job finish signal.
     void processJobStepCompletion(int t_exit_code, QProcess::ExitStatus t_exit_status);
 
-    //! Read job step results.
+    //! Read job step results on the calling thread.
     bool readResults(bool attempt_import_logs=false);
 
+    //! Read job step results on a worker thread and return immediately. The
+    //! results are moved to the GUI thread and installed there, followed by
+    //! sig_resultsRead.
+    void readResultsAsync(bool attempt_import_logs=false);
+
+    //! Return the parse metrics of the results that have been read, by type.
+    QMap<comp::JobResult::ResultType, ResultParseMetrics> resultParseMetrics() const {return parse_metrics;}
+
+    //! Return the result types of the step. Steps imported from an archive
+    //! list the result elements of their result file without reading the
+    //! results.
+    QList<comp::JobResult::ResultType> resultTypes();
+
     //! Write the terminal outputs to files.
     void exportTerminalOutputs(QString std_out_path, QString std_err_path);
 
     //! Kill job step
     void terminateJobStep();
 
+    //! Set the placements of the earlier steps this step depends on. The step
+    //! is only invoked once all of them have finished normally, and their
+    //! result paths are available to the command as @RESULTPATH_<placement>@.
+    //! Steps without dependencies may run alongside any other step.
+    void setDependencies(const QList<int> &t_dependencies) {dependencies = t_dependencies;}
+
+    //! Set the result paths of the steps this step depends on, called by the
+    //! parent job once all steps have been placed.
+    void setDependencyResultPaths(const QMap<int, QString> &t_dep_result_paths);
+
+    //! Set the values of the swept parameters if this step is a point of a
+    //! parameter sweep.
+    void setSweepPoint(const QMap<QString, QString> &t_sweep_point) {sweep_point = t_sweep_point;}
+
+    //! Return the values of the swept parameters, empty if the step isn't a
+    //! sweep point.
+    QMap<QString, QString> sweepPoint() const {return sweep_point;}
+
+    //! Set the placement of the step whose exported problem this step reuses
+    //! with its own parameters, -1 to export the design for this step.
+    void setProblemSource(int t_problem_source) {problem_source = t_problem_source;}
+
+    //! Return the placement of the step whose problem this step reuses.
+    int problemSource() const {return problem_source;}
+
+    //! Write the problem file of this step as a copy of the base problem with
+    //! the simulation parameters replaced by the parameters of this step.
+    bool deriveProblem(const QString &base_problem_path);
+
+    //! Set whether the step looks its results up in the result cache before
+    //! invoking the plugin and stores them there afterwards.
+    void setUseResultCache(bool use) {use_result_cache = use;}
+
+    //! Return whether the results were restored from the result cache.
+    bool resultFromCache() const {return cache_hit;}
+
+    //! Add the content of an XML file to the hash independently of its
+    //! layout: element names, sorted attributes and non-whitespace text, with
+    //! numbers in a fixed notation. Program flags (save date and version) and
+    //! GUI flags (zoom and view position) are left out, they don't change the
+    //! simulation. Returns false if the file can't be read or parsed.
+    static bool addCanonicalXml(QCryptographicHash &hash, const QString &path);
+
     // ACCESSORS
 
     //! Return the placement.
     int jobStepPlacement() {return placement;}
 
+    //! Return the run state.
+    JobStepState jobStepState() const {return job_step_state;}
+
+    //! Return the placements of the steps this step depends on.
+    QList<int> stepDependencies() const {return dependencies;}
+
     //! Return the engine pointer.
     PluginEngine *pluginEngine() {return engine;}
 
     //! Return the simulation parameters.
     QMap<QString, QString> jobParameters() {return job_params;}
 
-    //! Return the problem file path.
-    QString problemPath() {return problem_path;}
+    //! Return the problem file path, extracting the file from the archive of
+    //! imported steps.
+    QString problemPath();
 
     //! Return the result file path.
     QString resultPath() {return result_path;}
@@ -99,6 +174,8 @@ namespace comp{
     //! Return the terminal output from the specified channel.
     QString terminalOutput(QProcess::ProcessChannel channel)
     {
+      if (archive && !logs_read)
+        importLogs();
       switch (channel) {
         case QProcess::StandardOutput:
           return std_out;
@@ -109,8 +186,14 @@ namespace comp{
       }
     }
 
-    //! Return the job results.
-    QMap <comp::JobResult::ResultType, comp::JobResult*> jobResults() {return job_results;}
+    //! Return the job results, steps imported from an archive read them on
+    //! first use.
+    QMap <comp::JobResult::ResultType, comp::JobResult*> jobResults()
+    {
+      if (archive && !results_read)
+        readResults(true);
+      return job_results;
+    }
 
     //! Return the job step tmp directory path.
     QString jobStepTempDirPath() const {return js_tmp_dir_path;}
@@ -120,6 +203,10 @@ namespace comp{
     //! Emit job step completion status.
     void sig_jobStepFinishState(int placement, bool successful);
 
+    //! Emitted on the GUI thread once the results have been read, the parse
+    //! metrics are available from resultParseMetrics().
+    void sig_resultsRead(int placement, bool successful);
+
   private:
 
     //! Perform keyword replacement on the command and returns whether 
@@ -128,10 +215,35 @@ namespace comp{
     //! replacements can be done to a certain path.
     bool commandKeywordReplacement();
 
+    //! Read the terminal outputs from the log files of an imported step.
+    void importLogs();
+
+    //! Parse the result file into results and their metrics. Doesn't touch
+    //! the step so that it can run on any thread, the results are created on
+    //! the calling thread.
+    static bool parseResultFile(const QString &t_result_path, QSharedPointer<JobArchive> t_archive,
+        QMap<comp::JobResult::ResultType, comp::JobResult*> &results,
+        QMap<comp::JobResult::ResultType, ResultParseMetrics> &metrics, QString &err);
+
+    //! Take over parsed results, or delete them if the parse failed or the
+    //! results have been read in the meantime, and emit sig_resultsRead.
+    void installResults(bool ok, QMap<comp::JobResult::ResultType, comp::JobResult*> results,
+        QMap<comp::JobResult::ResultType, ResultParseMetrics> metrics, const QString &err,
+        bool attempt_import_logs);
+
+    //! Return the result cache key: a hash of the engine, the command format,
+    //! the problem with its program flags left out and the results of the
+    //! steps this step depends on. Empty if the problem can't be read.
+    QByteArray resultCacheKey();
+
     // variables from GUI/initial setup
     PluginEngine *engine;
     QStringList command_format;
     QMap<QString, QString> job_params;
+    QList<int> dependencies;                // placements of the steps this step waits for
+    QMap<QString, QString> sweep_point;     // values of the swept parameters of a sweep point
+    int problem_source=-1;                  // placement of the step whose problem is reused
+    bool use_result_cache=false;            // look results up in and store them to the result cache
 
     // pre-invocation variables
     int placement=-1;                       // execution order of this step within the job
@@ -142,6 +254,7 @@ namespace comp{
     QString js_tmp_dir_path;                // temp directory dedicated to this job step
     QString problem_path;                   // problem file path
     QString result_path;                    // result file path
+    QMap<int, QString> dep_result_paths;    // result paths of the steps this step depends on
 
     // post-invocation, runtime-related variables
     QDateTime start_time;                   // start time of this job step
@@ -149,11 +262,17 @@ namespace comp{
     QString std_out;                        // stdout from process
     QString std_err;                        // stderr from process
     int exit_code=-1;                       // exit code of the process, -1 if haven't invoked nor finished
+    QByteArray cache_key;                   // result cache key of the invocation, empty if uncached
+    bool cache_hit=false;                   // the results were restored from the result cache
     QProcess::ExitStatus exit_status;       // exit status of the process (normal or crashed)
 
     // post-invocation, results-related variables
     bool results_read=false;                // indicates whether results have been read
+    bool results_pending=false;             // results are being read on a worker thread
+    bool logs_read=false;                   // the log files of an imported step have been read
+    QSharedPointer<JobArchive> archive;     // archive of imported steps, files not on disk are read from it
     QMap<comp::JobResult::ResultType, comp::JobResult*> job_results;  // store job results
+    QMap<comp::JobResult::ResultType, ResultParseMetrics> parse_metrics;  // parse metrics of job_results
   };
 
 
@@ -173,6 +292,7 @@ namespace comp{
         pb_job_terminal = new QPushButton("Log");
         pb_sim_visualize = new QPushButton("Visualize Results");
         pb_export_results = new QPushButton("Export Results");
+        pb_sweep_table = new QPushButton("Sweep Table");
 
         connect(pb_job_terminal, &QPushButton::clicked,
                 [job](){job->terminalOutputDialog()->show();});
@@ -190,6 +310,8 @@ namespace comp{
                 [job](){emit job->sig_requestJobVisualization(job);});
         connect(pb_export_results, &QPushButton::clicked,
                 [job](){job->exportJob();});
+        connect(pb_sweep_table, &QPushButton::clicked,
+                [job](){job->sweepTableDialog()->show();});
       }
 
       SimJob *job=nullptr;
@@ -197,11 +319,17 @@ namespace comp{
       QPushButton *pb_job_terminal=nullptr;
       QPushButton *pb_sim_visualize=nullptr;
       QPushButton *pb_export_results=nullptr;
+      QPushButton *pb_sweep_table=nullptr;
     };
 
-    enum JobState{NotInvoked, Running, FinishedWithError, FinishedNormally};
+    enum JobState{NotInvoked, Queued, Running, FinishedWithError, FinishedNormally};
     Q_ENUM(JobState);
 
+    //! Priority of a job waiting in the job queue, higher priority jobs are
+    //! started first.
+    enum JobPriority{LowPriority, NormalPriority, HighPriority};
+    Q_ENUM(JobPriority);
+
     enum JobInfoStandardItemField{JobNameField, JobStartTimeField, 
       JobEndTimeField, JobStepCountField, JobFinishStateField, JobTempPathField};
     Q_ENUM(JobInfoStandardItemField);
@@ -233,6 +361,26 @@ namespace comp{
     //! Return a pointer to the list of all job steps.
     QList<JobStep*> jobSteps() {return job_steps;}
 
+    //! Set the maximum number of job steps running at the same time.
+    void setMaxParallelSteps(int n) {max_parallel_steps = qMax(1, n);}
+
+    //! Return the maximum number of job steps running at the same time.
+    int maxParallelSteps() const {return max_parallel_steps;}
+
+    //! Set the queue priority.
+    void setPriority(JobPriority p) {priority = p;}
+
+    //! Return the queue priority.
+    JobPriority jobPriority() const {return priority;}
+
+    //! Set whether the steps of the job use the result cache.
+    void setUseResultCache(bool use) {use_result_cache = use;}
+
+    //! Return the number of CPU cores the job occupies while running: the sum
+    //! of the core requirements of the most demanding steps that may run at
+    //! the same time.
+    int coreRequirement() const;
+
     //! Write the manifest of this job step to the default file location.
     void writeManifest(QString fpath="");
 
@@ -247,26 +395,47 @@ namespace comp{
     //! Return the inclusion area.
     gui::DesignInclusionArea inclusionArea() {return inclusion_area;}
 
+    //! Set the area of interest exported with IncludeAreaOfInterest.
+    void setAreaOfInterest(const prim::AreaOfInterest &a) {area_of_interest = a;}
+
+    //! Return the area of interest, written to and read from the manifest.
+    prim::AreaOfInterest areaOfInterest() const {return area_of_interest;}
+
 
     // JOB EXECUTION
 
+    //! Mark the job as waiting in the job queue.
+    void enqueue();
+
+    //! Return the time the job was queued, invalid if it never was.
+    QDateTime queueTime() const {return queue_time;}
+
+    //! Return the seconds the job has waited in the queue, up to now if it's
+    //! still queued.
+    qint64 waitSecs() const;
+
     //! Confirm the job steps order placement, must be done before execution 
     //! begins (beginJob() does this if it hasn't already been done elsewhere).
     void confirmJobStepsPlacement();
 
-    //! Prepare the job and contained job steps for invocation.
+    //! Prepare the job and contained job steps for invocation, exporting the
+    //! problem files from the current design. Only the first call has an
+    //! effect, JobManager prepares jobs as they are queued so that they
+    //! simulate the design as it was submitted.
     void prepareJob();
 
-    //! Begin execution sequence - the first job step would be invoked, 
-    //! appropriate signals connected and at the end of each job step the next 
-    //! one would be invoked. Returns whether the job has begun execution.
+    //! Begin execution - every step whose dependencies are met is invoked, up
+    //! to maxParallelSteps() at a time, and each finished step invokes the
+    //! steps it unblocks. Returns whether the job has begun execution.
     bool beginJob();
 
-    //! Continue the job if previous step was successful, stop it otherwise.
+    //! Record the results of the finished step and invoke the steps that
+    //! became ready. After a failed step no further steps are invoked and the
+    //! job finishes with an error once the running steps are done.
     void continueJob(int prev_step_ind, bool prev_step_successful);
 
-    //! Terminal the running job step process and prevent remaining job steps 
-    //! from executing.
+    //! Terminate the running job step processes and prevent remaining job
+    //! steps from executing. Queued jobs are taken off the queue.
     void terminateJob();
 
     //! Job finish actions.
@@ -309,6 +478,10 @@ namespace comp{
     //! Runtime temporary directory (all job steps share the same dir).
     QString runtimeTempPath();
 
+    //! Extract the files of an imported archive that haven't been extracted
+    //! yet to the runtime temporary directory. Returns true for other jobs.
+    bool extractArchive();
+
     //! Return the overall start time of the job (start time of the first step).
     QDateTime startTime() const {return job_steps.first()->startTime();}
 
@@ -322,21 +495,39 @@ namespace comp{
     GuiControlElems guiControlElems() const {return gui_ctrl_elems;}
 
     //! Return a QMap of result types mapped to job steps that have that type
-    //! of result.
+    //! of result, the steps of each type are listed by descending placement.
     QMultiMap<comp::JobResult::ResultType, JobStep*> resultTypeStepMap() {return result_type_step_map;}
 
     //! Show a dialog containing the job's terminal output.
     QWidget *terminalOutputDialog(QWidget *parent=nullptr, Qt::WindowFlags w_flags=Qt::Dialog);
 
-    //! Export the finished SimJob into an archive and return whether the export 
-    //! was successful.
+    //! Return whether the job is a parameter sweep.
+    bool isSweep() const;
+
+    //! Return the header of the sweep table: the step, the swept parameters
+    //! and the ground state of each sweep point.
+    QStringList sweepTableHeader() const;
+
+    //! Return the sweep table, a row per sweep point.
+    QList<QStringList> sweepTableRows();
+
+    //! Write the sweep table to a CSV file.
+    bool exportSweepTable(const QString &csv_path);
+
+    //! Show a dialog with the sweep table and a CSV export button.
+    QWidget *sweepTableDialog(QWidget *parent=nullptr, Qt::WindowFlags w_flags=Qt::Dialog);
+
+    //! Export the finished SimJob into an archive on a worker thread and
+    //! return whether the export was started. Without outpath the user picks
+    //! the archive and compression level, the export shows its progress.
     bool exportJob(QString outpath=QString());
 
 
   signals:
 
-    //! Export problem files.
-    void sig_exportJobStepProblem(JobStep *job_step, gui::DesignInclusionArea inclusion_area);
+    //! Export problem files, area is the job's area of interest.
+    void sig_exportJobStepProblem(JobStep *job_step, gui::DesignInclusionArea inclusion_area,
+                                  const prim::AreaOfInterest &area);
 
     //! Emit the job finish state.
     void sig_jobFinishState(SimJob *job, JobState finish_state);
@@ -344,6 +535,10 @@ namespace comp{
     //! Request the job results to be shown.
     void sig_requestJobVisualization(SimJob *job);
 
+    //! Emitted once the results of a finished step have been read and added
+    //! to the result type step map.
+    void sig_jobStepResultsAvailable(SimJob *job, int placement);
+
 
   private:
 
@@ -352,13 +547,37 @@ namespace comp{
     QList<JobStep*> job_steps;          // list of steps in this simulation job, each step invokes one simulation
     QMultiMap<comp::JobResult::ResultType, JobStep*> result_type_step_map;  // all result types contained in job steps
     bool placement_confirmed=false;     // the job steps execution order has been confirmed, must be true before execution begins
+    bool job_prepared=false;            // the problems have been exported and the steps connected
     gui::DesignInclusionArea inclusion_area=gui::IncludeEntireDesign;       // the inclusion area for this job
+    prim::AreaOfInterest area_of_interest;  // exported area for IncludeAreaOfInterest
     QString job_name;                   // job name for identification
     QString job_tmp_dir_path;           // job directory for storing runtime data
     QDateTime start_time, end_time;     // start and end times of the job
-    JobStep *curr_step=nullptr;
+    QDateTime queue_time;               // time the job entered the job queue
+    JobPriority priority=NormalPriority;  // priority in the job queue
+    bool use_result_cache=false;        // steps use the result cache
+    QList<JobStep*> running_steps;      // steps whose process is running
+    int max_parallel_steps=1;           // maximum number of steps running at the same time
+    bool step_failed=false;             // a step has failed, no further steps are invoked
     GuiControlElems gui_ctrl_elems;     // store GUI control elements
     bool imported=false;
+    JobExporter *exporter=nullptr;      // running export, if any
+    QSharedPointer<JobArchive> archive; // archive of an imported job, if any
+
+    // ask for the export path and compression level
+    bool exportDialog(QString &out_path, int &level);
+
+    // return whether the step dependencies refer to earlier steps only, which
+    // keeps the step graph acyclic
+    bool validateStepGraph();
+
+    // invoke the steps whose dependencies have finished while there is room,
+    // return whether all invocations succeeded
+    bool invokeReadySteps();
+
+    // map the result type to the step, keeping the steps of the type ordered
+    // by placement regardless of the order in which parallel steps finish
+    void addResultTypeStep(comp::JobResult::ResultType type, JobStep *step);
 
     // read xml
     QStringList ignored_xml_elements; // XML elements to ignore when reading results
@@ -0,0 +1,1447 @@
+// @file:     design_binary.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Compact binary design container (.sqb) and .sqd conversion.
+
+#include "design_binary.h"
+#include "settings/settings.h"
+#include "gui/save_context.h"
+#include "gzip_device.h"
+#include "../../libs/miniz/miniz.h"
+
+#include <QtEndian>
+
+using namespace gui;
+
+namespace {
+
+  const char sqb_magic[4] = {'S', 'Q', 'B', '\x1a'};
+  const int chunk_header_size = 28;
+
+  enum ChunkFlag : quint32 {Deflated=0x1};
+
+  // payloads are decoded with a fixed stream version so files don't depend on
+  // the Qt version they were written with
+  void prepareStream(QDataStream &s)
+  {
+    s.setVersion(QDataStream::Qt_6_0);
+    s.setByteOrder(QDataStream::LittleEndian);
+  }
+
+  // packed little-endian 32-bit arrays preceded by their element count
+  template<typename T>
+  void writeArray(QDataStream &s, const QVector<T> &v)
+  {
+    static_assert(sizeof(T) == 4, "packed arrays hold 32-bit values");
+    s << quint32(v.size());
+    QByteArray packed(v.size()*4, Qt::Uninitialized);
+    qToLittleEndian<T>(v.constData(), v.size(), packed.data());
+    s.writeRawData(packed.constData(), packed.size());
+  }
+
+  template<typename T>
+  bool readArray(QDataStream &s, QVector<T> &v)
+  {
+    quint32 count;
+    s >> count;
+    if (s.status() != QDataStream::Ok || s.device()->bytesAvailable() < qint64(count)*4)
+      return false;
+    QByteArray packed(qsizetype(count)*4, Qt::Uninitialized);
+    s.readRawData(packed.data(), packed.size());
+    v.resize(count);
+    qFromLittleEndian<T>(packed.constData(), count, v.data());
+    return true;
+  }
+
+  // read the layer_prop element, including the lattice vectors if present
+  void parseLayerProp(QXmlStreamReader *rs, sqb::LayerRecord &rec,
+      sqb::LatticeRecord &lat, bool &has_lat)
+  {
+    while (rs->readNextStartElement()) {
+      QString elem_name = rs->name().toString();
+      if (elem_name == "name") {
+        rec.name = rs->readElementText();
+      } else if (elem_name == "type") {
+        rec.type = rs->readElementText();
+      } else if (elem_name == "role") {
+        rec.role = rs->readElementText();
+      } else if (elem_name == "zoffset") {
+        rec.zoffset = rs->readElementText().toFloat();
+      } else if (elem_name == "zheight") {
+        rec.zheight = rs->readElementText().toFloat();
+      } else if (elem_name == "visible") {
+        rec.visible = rs->readElementText() == "1";
+      } else if (elem_name == "active") {
+        rec.active = rs->readElementText() == "1";
+      } else if (elem_name == "lat_vec") {
+        QMap<int, QPointF> atoms;
+        while (rs->readNextStartElement()) {
+          QString vec_name = rs->name().toString();
+          QPointF pt(rs->attributes().value("x").toFloat(),
+              rs->attributes().value("y").toFloat());
+          if (vec_name == "name") {
+            lat.name = rs->readElementText();
+            continue;
+          } else if (vec_name == "a1") {
+            lat.a[0] = pt;
+          } else if (vec_name == "a2") {
+            lat.a[1] = pt;
+          } else if (vec_name.startsWith("b")) {
+            atoms.insert(vec_name.mid(1).toInt(), pt);
+          }
+          rs->skipCurrentElement();
+        }
+        lat.b = atoms.values();
+        has_lat = true;
+      } else {
+        rs->skipCurrentElement();
+      }
+    }
+  }
+
+  // read the current dbdot or aggregate element of a DB layer, returns false
+  // for DBs without lattice coordinates
+  bool parseDBElement(QXmlStreamReader *rs, sqb::DBRecord &rec, QRgb default_color)
+  {
+    QString elem_name = rs->name().toString();
+    if (elem_name == "dbdot") {
+      qint32 n=0, m=0, l=-1;
+      QColor color;
+      while (rs->readNextStartElement()) {
+        QString prop_name = rs->name().toString();
+        if (prop_name == "latcoord") {
+          n = rs->attributes().value("n").toInt();
+          m = rs->attributes().value("m").toInt();
+          l = rs->attributes().value("l").toInt();
+          rs->skipCurrentElement();
+        } else if (prop_name == "color") {
+          color = QColor(rs->readElementText());
+        } else {
+          rs->skipCurrentElement();
+        }
+      }
+      if (l == -1)
+        return false;
+      rec.append(n, m, l, color.isValid() ? color.rgba() : default_color);
+      rec.appendStructure(1);
+    } else if (elem_name == "aggregate") {
+      rec.appendStructure(sqb::OpenAggregate);
+      while (rs->readNextStartElement())
+        if (!parseDBElement(rs, rec, default_color))
+          return false;
+      rec.appendStructure(sqb::CloseAggregate);
+    } else {
+      qDebug() << QObject::tr("Design parser: skipping invalid element on line %1 - %2")
+          .arg(rs->lineNumber()).arg(elem_name);
+      rs->skipCurrentElement();
+    }
+    return true;
+  }
+
+  // write the dbdots and aggregates of a DB record in the .sqd layout
+  void writeDBItems(QXmlStreamWriter *ws, const sqb::DBRecord &rec,
+      const sqb::LatticeRecord &lat, SaveContext &ctx)
+  {
+    auto write_db = [&](int i) {
+      const qint32 *c = rec.coords.constData() + 3*i;
+      QPointF physloc = c[0]*lat.a[0] + c[1]*lat.a[1] + lat.b.value(c[2]);
+      ws->writeStartElement("dbdot");
+      ws->writeTextElement("layer_id", ctx.number(rec.layer_pos));
+      ws->writeEmptyElement("latcoord");
+      ws->writeAttribute("n", ctx.number(c[0]));
+      ws->writeAttribute("m", ctx.number(c[1]));
+      ws->writeAttribute("l", ctx.number(c[2]));
+      ws->writeEmptyElement("physloc");
+      ws->writeAttribute("x", ctx.number(physloc.x()));
+      ws->writeAttribute("y", ctx.number(physloc.y()));
+      ws->writeTextElement("color", QColor::fromRgba(rec.color(i)).name(QColor::HexArgb));
+      ws->writeEndElement();
+    };
+
+    int db_ind = 0;
+    if (rec.structure.isEmpty()) {
+      for (; db_ind < rec.dbCount(); db_ind++)
+        write_db(db_ind);
+      return;
+    }
+    for (qint32 token : rec.structure) {
+      if (token == sqb::OpenAggregate) {
+        ws->writeStartElement("aggregate");
+      } else if (token == sqb::CloseAggregate) {
+        ws->writeEndElement();
+      } else {
+        for (int i=0; i<token && db_ind < rec.dbCount(); i++)
+          write_db(db_ind++);
+      }
+    }
+  }
+
+  // read the DBs of a tile handed over by reference to its stored chunk
+  bool readTileReference(const sqb::ItemChunk &chunk, sqb::DBRecord &rec, QString &err)
+  {
+    QFile file(chunk.tile.source);
+    if (!file.open(QIODevice::ReadOnly)) {
+      err = file.errorString();
+      return false;
+    }
+    sqb::Reader rd(&file);
+    quint32 tag;
+    QByteArray raw;
+    if (!rd.readChunkAt(chunk.tile.offset, tag, raw) || tag != sqb::DBChunk
+        || !sqb::Reader::readDBs(raw, rec)) {
+      err = rd.hasError() ? rd.errorString()
+          : QObject::tr("SQB tile chunk at offset %1 is corrupt.").arg(chunk.tile.offset);
+      return false;
+    }
+    rec.layer_pos = chunk.dbs.layer_pos;
+    return true;
+  }
+
+} // end anonymous namespace
+
+
+// DBRecord
+
+void gui::sqb::DBRecord::append(qint32 n, qint32 m, qint32 l, QRgb color)
+{
+  coords << n << m << l;
+  auto it = palette_ids.constFind(color);
+  quint32 id;
+  if (it == palette_ids.constEnd()) {
+    id = palette.size();
+    palette.append(color);
+    palette_ids.insert(color, id);
+  } else {
+    id = it.value();
+  }
+
+  // per-DB palette indices are only needed once a second color shows up
+  if (palette.size() > 1) {
+    if (color_ids.isEmpty())
+      color_ids.fill(0, dbCount()-1);
+    color_ids.append(id);
+  }
+}
+
+void gui::sqb::DBRecord::appendStructure(qint32 token)
+{
+  if (token > 0 && !structure.isEmpty() && structure.last() > 0)
+    structure.last() += token;
+  else
+    structure.append(token);
+}
+
+void gui::sqb::DBRecord::appendRecord(const DBRecord &other)
+{
+  // an empty structure stands for a single run, spell it out before merging
+  if (structure.isEmpty() && dbCount() > 0)
+    appendStructure(dbCount());
+  for (int i=0; i<other.dbCount(); i++) {
+    const qint32 *c = other.coords.constData() + 3*i;
+    append(c[0], c[1], c[2], other.color(i));
+  }
+  if (!other.structure.isEmpty()) {
+    for (qint32 token : other.structure)
+      appendStructure(token);
+  } else if (other.dbCount() > 0) {
+    appendStructure(other.dbCount());
+  }
+}
+
+QMap<QPair<qint32,qint32>, gui::sqb::DBRecord> gui::sqb::DBRecord::tiles(int tile_cells) const
+{
+  QMap<QPair<qint32,qint32>, DBRecord> out;
+  auto tile_of = [&](const qint32 *c) -> DBRecord& {
+    DBRecord &rec = out[qMakePair(tileCoord(c[0], tile_cells), tileCoord(c[1], tile_cells))];
+    rec.layer_pos = layer_pos;
+    return rec;
+  };
+
+  // aggregates are collected whole and go to the tile of their first DB
+  DBRecord agg;
+  int db_ind = 0, depth = 0;
+  auto take_dbs = [&](int count) {
+    for (int i=0; i<count && db_ind < dbCount(); i++, db_ind++) {
+      const qint32 *c = coords.constData() + 3*db_ind;
+      DBRecord &rec = depth == 0 ? tile_of(c) : agg;
+      rec.append(c[0], c[1], c[2], color(db_ind));
+      rec.appendStructure(1);
+    }
+  };
+
+  if (structure.isEmpty())
+    take_dbs(dbCount());
+  for (qint32 token : structure) {
+    if (token == OpenAggregate) {
+      depth++;
+      agg.appendStructure(OpenAggregate);
+    } else if (token == CloseAggregate) {
+      depth--;
+      agg.appendStructure(CloseAggregate);
+      if (depth == 0) {
+        if (agg.dbCount() > 0)
+          tile_of(agg.coords.constData()).appendRecord(agg);
+        agg = DBRecord();
+      }
+    } else {
+      take_dbs(token);
+    }
+  }
+  for (DBRecord &rec : out)
+    rec.palette_ids.clear();
+  return out;
+}
+
+quint64 gui::sqb::TileIndex::dbCount() const
+{
+  quint64 count = 0;
+  for (const TileEntry &entry : tiles)
+    count += entry.db_count;
+  return count;
+}
+
+
+// ItemChunker
+
+QXmlStreamWriter *gui::sqb::ItemChunker::beginItem(quint32 item_tag)
+{
+  if (ws && item_tag != tag)
+    flush();
+  if (!ws) {
+    tag = item_tag;
+    ws = new QXmlStreamWriter(&xml);
+    ws->setAutoFormatting(SaveContext::currentLayout() == SaveContext::Pretty);
+  }
+  return ws;
+}
+
+void gui::sqb::ItemChunker::flush()
+{
+  if (!ws)
+    return;
+  delete ws;
+  ws = nullptr;
+  if (!xml.trimmed().isEmpty()) {
+    ItemChunk chunk;
+    chunk.tag = tag;
+    chunk.xml.layer_pos = layer_pos;
+    chunk.xml.xml = xml;
+    out->append(chunk);
+  }
+  xml.clear();
+}
+
+
+// DesignSnapshot
+
+gui::sqb::FloatFormat gui::sqb::FloatFormat::fromSettings()
+{
+  FloatFormat ff;
+  ff.precision = settings::AppSettings::instance()->get<int>("float_prc");
+  ff.format = settings::AppSettings::instance()->get<QString>("float_fmt").at(0).toLatin1();
+  return ff;
+}
+
+bool gui::sqb::DesignSnapshot::replay(DesignSink *sink) const
+{
+  for (const QByteArray &head : heads)
+    sink->head(head);
+  if (has_lattice)
+    sink->lattice(lattice);
+  sink->layers(layers);
+  for (const ItemChunk &chunk : items)
+    if (!sink->items(chunk))
+      return false;
+  return true;
+}
+
+
+// Writer
+
+bool gui::sqb::Writer::begin()
+{
+  QByteArray header(sqb_magic, 4);
+  QDataStream s(&header, QIODevice::Append);
+  prepareStream(s);
+  s << version_major << version_minor;
+  if (dev->write(header) != header.size()) {
+    err = dev->errorString();
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Writer::finish()
+{
+  QByteArray raw;
+  if (tile_index_offset >= 0) {
+    QDataStream s(&raw, QIODevice::WriteOnly);
+    prepareStream(s);
+    s << quint64(tile_index_offset);
+  }
+  return writeChunk(EndChunk, raw);
+}
+
+bool gui::sqb::Writer::writeChunk(quint32 tag, const QByteArray &raw)
+{
+  quint32 flags = 0;
+  QByteArray stored;
+  if (!raw.isEmpty() && level > 0) {
+    mz_ulong stored_len = mz_compressBound(raw.size());
+    stored.resize(stored_len);
+    int status = mz_compress2(reinterpret_cast<unsigned char*>(stored.data()), &stored_len,
+        reinterpret_cast<const unsigned char*>(raw.constData()), raw.size(), level);
+    if (status == MZ_OK && stored_len < mz_ulong(raw.size())) {
+      stored.resize(stored_len);
+      flags |= Deflated;
+    }
+  }
+  if (!(flags & Deflated))
+    stored = raw;
+
+  quint32 crc = mz_crc32(MZ_CRC32_INIT,
+      reinterpret_cast<const unsigned char*>(raw.constData()), raw.size());
+  QByteArray header;
+  header.reserve(chunk_header_size);
+  QDataStream s(&header, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << tag << flags << quint64(raw.size()) << quint64(stored.size()) << crc;
+
+  if (dev->write(header) != header.size() || dev->write(stored) != stored.size()) {
+    err = dev->errorString();
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Writer::writeStoredChunk(const QByteArray &chunk)
+{
+  if (dev->write(chunk) != chunk.size()) {
+    err = dev->errorString();
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Writer::writeLattice(const LatticeRecord &lat)
+{
+  QByteArray raw;
+  QDataStream s(&raw, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << lat.name << lat.a[0] << lat.a[1] << lat.b;
+  return writeChunk(LatticeChunk, raw);
+}
+
+bool gui::sqb::Writer::writeLayers(const QList<LayerRecord> &layers)
+{
+  QByteArray raw;
+  QDataStream s(&raw, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << quint32(layers.size());
+  for (const LayerRecord &rec : layers)
+    s << rec.name << rec.type << rec.role << rec.zoffset << rec.zheight
+      << rec.visible << rec.active;
+  return writeChunk(LayerChunk, raw);
+}
+
+bool gui::sqb::Writer::writeDBs(const DBRecord &dbs)
+{
+  QByteArray raw;
+  QDataStream s(&raw, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << qint32(dbs.layer_pos);
+  writeArray(s, dbs.coords);
+  writeArray(s, dbs.palette);
+  writeArray(s, dbs.color_ids);
+  // a single run of DBs needs no structure
+  if (dbs.structure.contains(OpenAggregate))
+    writeArray(s, dbs.structure);
+  else
+    writeArray(s, QVector<qint32>());
+  return writeChunk(DBChunk, raw);
+}
+
+bool gui::sqb::Writer::writeXmlItems(quint32 tag, const XmlRecord &rec)
+{
+  QByteArray raw;
+  QDataStream s(&raw, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << qint32(rec.layer_pos) << rec.xml;
+  return writeChunk(tag, raw);
+}
+
+bool gui::sqb::Writer::writeTileIndex(const TileIndex &index)
+{
+  QByteArray raw;
+  QDataStream s(&raw, QIODevice::WriteOnly);
+  prepareStream(s);
+  s << qint32(index.tile_cells) << quint32(index.tiles.size());
+  for (const TileEntry &entry : index.tiles)
+    s << qint32(entry.layer_pos) << entry.tx << entry.ty << qint64(entry.offset)
+      << quint32(entry.db_count);
+  tile_index_offset = dev->pos();
+  return writeChunk(TileIndexChunk, raw);
+}
+
+
+// Reader
+
+bool gui::sqb::Reader::begin()
+{
+  QByteArray header = dev->read(8);
+  if (header.size() != 8 || !header.startsWith(QByteArray(sqb_magic, 4))) {
+    err = QObject::tr("Not an SQB design file.");
+    return false;
+  }
+  QDataStream s(header.mid(4));
+  prepareStream(s);
+  quint16 major, minor;
+  s >> major >> minor;
+  if (major > version_major) {
+    err = QObject::tr("SQB format version %1.%2 is newer than the supported "
+        "version %3.%4.").arg(major).arg(minor).arg(version_major).arg(version_minor);
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Reader::readChunkHeader(quint32 &tag, quint32 &flags, quint64 &raw_size,
+    quint64 &stored_size, quint32 &crc)
+{
+  QByteArray header = dev->read(chunk_header_size);
+  if (header.size() != chunk_header_size) {
+    err = QObject::tr("SQB file is truncated, END chunk missing.");
+    return false;
+  }
+  QDataStream s(header);
+  prepareStream(s);
+  s >> tag >> flags >> raw_size >> stored_size >> crc;
+
+  if (stored_size > quint64(dev->bytesAvailable()) && !dev->isSequential()) {
+    err = QObject::tr("SQB chunk size exceeds the file size.");
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Reader::readChunk(quint32 &tag, QByteArray &raw)
+{
+  return readChunk(tag, raw, EndChunk);
+}
+
+bool gui::sqb::Reader::readChunk(quint32 &tag, QByteArray &raw, quint32 skip_tag)
+{
+  quint32 flags, crc;
+  quint64 raw_size, stored_size;
+  if (!readChunkHeader(tag, flags, raw_size, stored_size, crc))
+    return false;
+
+  if (tag == skip_tag && tag != EndChunk) {
+    raw.clear();
+    if (dev->skip(stored_size) != qint64(stored_size)) {
+      err = QObject::tr("SQB file is truncated.");
+      return false;
+    }
+    return true;
+  }
+
+  QByteArray stored = dev->read(stored_size);
+  if (quint64(stored.size()) != stored_size) {
+    err = QObject::tr("SQB file is truncated.");
+    return false;
+  }
+
+  if (flags & Deflated) {
+    // deflate can't expand data by more than about 1032:1
+    if (raw_size > stored_size*1032 + 64) {
+      err = QObject::tr("SQB chunk size is corrupt.");
+      return false;
+    }
+    raw.resize(raw_size);
+    mz_ulong raw_len = raw_size;
+    int status = mz_uncompress(reinterpret_cast<unsigned char*>(raw.data()), &raw_len,
+        reinterpret_cast<const unsigned char*>(stored.constData()), stored.size());
+    if (status != MZ_OK || raw_len != raw_size) {
+      err = QObject::tr("Failed to inflate SQB chunk: %1").arg(mz_error(status));
+      return false;
+    }
+  } else {
+    raw = stored;
+  }
+
+  if (mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(raw.constData()),
+        raw.size()) != crc) {
+    err = QObject::tr("SQB chunk checksum mismatch.");
+    return false;
+  }
+  return tag != EndChunk;
+}
+
+bool gui::sqb::Reader::readChunkAt(qint64 offset, quint32 &tag, QByteArray &raw)
+{
+  if (!dev->seek(offset)) {
+    err = QObject::tr("SQB chunk offset %1 is out of range.").arg(offset);
+    return false;
+  }
+  return readChunk(tag, raw);
+}
+
+bool gui::sqb::Reader::readStoredChunkAt(qint64 offset, quint32 tag, QByteArray &chunk)
+{
+  quint32 chunk_tag, flags, crc;
+  quint64 raw_size, stored_size;
+  if (!dev->seek(offset)) {
+    err = QObject::tr("SQB chunk offset %1 is out of range.").arg(offset);
+    return false;
+  }
+  if (!readChunkHeader(chunk_tag, flags, raw_size, stored_size, crc))
+    return false;
+  if (chunk_tag != tag) {
+    err = QObject::tr("SQB chunk at offset %1 has an unexpected tag.").arg(offset);
+    return false;
+  }
+  dev->seek(offset);
+  chunk = dev->read(chunk_header_size + stored_size);
+  if (quint64(chunk.size()) != chunk_header_size + stored_size) {
+    err = QObject::tr("SQB file is truncated.");
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Reader::readTileIndex(TileIndex &index)
+{
+  // the END chunk of tiled files holds the offset of the tile index
+  qint64 end_offset = dev->size() - chunk_header_size - 8;
+  if (dev->isSequential() || end_offset < 8 || !dev->seek(end_offset))
+    return false;
+  quint32 tag;
+  QByteArray raw;
+  if (readChunk(tag, raw) || hasError() || raw.size() != 8) {
+    err.clear();
+    return false;
+  }
+
+  QDataStream s(raw);
+  prepareStream(s);
+  quint64 offset;
+  s >> offset;
+  if (!readChunkAt(offset, tag, raw) || tag != TileIndexChunk || !readTileIndex(raw, index)) {
+    if (!hasError())
+      err = QObject::tr("SQB tile index is corrupt.");
+    return false;
+  }
+  return true;
+}
+
+bool gui::sqb::Reader::readLattice(const QByteArray &raw, LatticeRecord &lat)
+{
+  QDataStream s(raw);
+  prepareStream(s);
+  s >> lat.name >> lat.a[0] >> lat.a[1] >> lat.b;
+  return s.status() == QDataStream::Ok;
+}
+
+bool gui::sqb::Reader::readLayers(const QByteArray &raw, QList<LayerRecord> &layers)
+{
+  QDataStream s(raw);
+  prepareStream(s);
+  quint32 count;
+  s >> count;
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; i++) {
+    LayerRecord rec;
+    s >> rec.name >> rec.type >> rec.role >> rec.zoffset >> rec.zheight
+      >> rec.visible >> rec.active;
+    layers.append(rec);
+  }
+  return s.status() == QDataStream::Ok;
+}
+
+bool gui::sqb::Reader::readDBs(const QByteArray &raw, DBRecord &dbs)
+{
+  QDataStream s(raw);
+  prepareStream(s);
+  qint32 layer_pos;
+  s >> layer_pos;
+  dbs.layer_pos = layer_pos;
+  if (!readArray(s, dbs.coords) || !readArray(s, dbs.palette)
+      || !readArray(s, dbs.color_ids) || !readArray(s, dbs.structure))
+    return false;
+
+  // validate the cross references so that loaders can index without checks
+  if (dbs.coords.size() % 3 != 0 || dbs.palette.isEmpty() != dbs.coords.isEmpty()
+      || (!dbs.color_ids.isEmpty() && dbs.color_ids.size() != dbs.dbCount()))
+    return false;
+  for (quint32 id : dbs.color_ids)
+    if (id >= quint32(dbs.palette.size()))
+      return false;
+
+  // aggregates must be balanced and the DB runs must cover every DB
+  if (dbs.structure.isEmpty())
+    return true;
+  int depth = 0;
+  qint64 run_dbs = 0;
+  for (qint32 token : dbs.structure) {
+    if (token == OpenAggregate) {
+      depth++;
+    } else if (token == CloseAggregate) {
+      if (--depth < 0)
+        return false;
+    } else if (token > 0) {
+      run_dbs += token;
+    } else {
+      return false;
+    }
+  }
+  return depth == 0 && run_dbs == dbs.dbCount();
+}
+
+bool gui::sqb::Reader::readTileIndex(const QByteArray &raw, TileIndex &index)
+{
+  QDataStream s(raw);
+  prepareStream(s);
+  qint32 tile_cells;
+  quint32 count;
+  s >> tile_cells >> count;
+  if (s.status() != QDataStream::Ok || tile_cells <= 0 || count > quint32(raw.size()/24))
+    return false;
+  index.tile_cells = tile_cells;
+  index.tiles.clear();
+  index.tiles.reserve(count);
+  for (quint32 i=0; i<count; i++) {
+    TileEntry entry;
+    qint32 layer_pos;
+    qint64 offset;
+    s >> layer_pos >> entry.tx >> entry.ty >> offset >> entry.db_count;
+    entry.layer_pos = layer_pos;
+    entry.offset = offset;
+    index.tiles.append(entry);
+  }
+  return s.status() == QDataStream::Ok;
+}
+
+bool gui::sqb::Reader::readXmlItems(const QByteArray &raw, XmlRecord &rec)
+{
+  QDataStream s(raw);
+  prepareStream(s);
+  qint32 layer_pos;
+  s >> layer_pos >> rec.xml;
+  rec.layer_pos = layer_pos;
+  return s.status() == QDataStream::Ok;
+}
+
+
+// helpers
+
+bool gui::sqb::isBinaryDesign(QIODevice *dev)
+{
+  return dev->peek(4) == QByteArray(sqb_magic, 4);
+}
+
+bool gui::sqb::isBinaryDesignPath(const QString &path)
+{
+  return QFileInfo(path).suffix().compare("sqb", Qt::CaseInsensitive) == 0;
+}
+
+quint32 gui::sqb::itemChunkTag(const QString &elem_name)
+{
+  if (elem_name == "electrode")
+    return ElectrodeChunk;
+  else if (elem_name.startsWith("afm"))
+    return AFMChunk;
+  else if (elem_name.contains("label"))
+    return LabelChunk;
+  return XmlItemChunk;
+}
+
+QByteArray gui::sqb::wrapLayerFragment(const QByteArray &xml)
+{
+  return QByteArray("<layer>\n") + xml + QByteArray("\n</layer>");
+}
+
+void gui::sqb::copyXmlElement(QXmlStreamReader *rs, QXmlStreamWriter *ws)
+{
+  // whitespace is left to the auto-formatting of the writer
+  int depth = 0;
+  while (true) {
+    if (rs->isStartElement())
+      depth++;
+    else if (rs->isEndElement())
+      depth--;
+    if (!rs->isWhitespace())
+      ws->writeCurrentToken(*rs);
+    if (depth == 0 || rs->atEnd())
+      break;
+    rs->readNext();
+  }
+}
+
+
+// parsing
+
+gui::sqb::ParseOptions gui::sqb::ParseOptions::fromSettings()
+{
+  ParseOptions opts;
+  opts.batch_dbs = settings::AppSettings::instance()->get<int>("load/batch_dbs");
+  opts.default_db_color = settings::GUISettings::instance()->get<QColor>("dbdot/fill_col").rgba();
+  return opts;
+}
+
+QList<gui::sqb::DBRecord> gui::sqb::DBRecord::split(int max_dbs) const
+{
+  if (max_dbs <= 0 || dbCount() <= max_dbs)
+    return QList<DBRecord>({*this});
+
+  // split only between top level items so that aggregates stay whole
+  QList<DBRecord> parts;
+  DBRecord part;
+  part.layer_pos = layer_pos;
+  int db_ind = 0, depth = 0;
+  auto take_dbs = [&](int count) {
+    for (int i=0; i<count && db_ind < dbCount(); i++, db_ind++) {
+      const qint32 *c = coords.constData() + 3*db_ind;
+      part.append(c[0], c[1], c[2], color(db_ind));
+      part.appendStructure(1);
+      if (depth == 0 && part.dbCount() >= max_dbs) {
+        parts.append(part);
+        part = DBRecord();
+        part.layer_pos = layer_pos;
+      }
+    }
+  };
+
+  if (structure.isEmpty())
+    take_dbs(dbCount());
+  for (qint32 token : structure) {
+    if (token == OpenAggregate) {
+      depth++;
+      part.appendStructure(OpenAggregate);
+    } else if (token == CloseAggregate) {
+      depth--;
+      part.appendStructure(CloseAggregate);
+      if (depth == 0 && part.dbCount() >= max_dbs) {
+        parts.append(part);
+        part = DBRecord();
+        part.layer_pos = layer_pos;
+      }
+    } else {
+      take_dbs(token);
+    }
+  }
+  if (part.dbCount() > 0)
+    parts.append(part);
+  return parts;
+}
+
+gui::sqb::ParseStatus gui::sqb::parseSqd(QIODevice *dev, DesignSink *sink,
+    const ParseOptions &opts, QString &err)
+{
+  LatticeRecord lat;
+  bool has_lat = false;
+  QList<LayerRecord> layers;
+  bool layers_sent = false;
+
+  // the layer table is complete once the design starts
+  auto send_layers = [&]() {
+    if (layers_sent)
+      return;
+    if (has_lat)
+      sink->lattice(lat);
+    sink->layers(layers);
+    layers_sent = true;
+  };
+
+  QXmlStreamReader rs(dev);
+  if (!rs.readNextStartElement() || rs.name().toString() != "siqad") {
+    err = QObject::tr("Not a SiQAD design file.");
+    return ParseError;
+  }
+  while (rs.readNextStartElement()) {
+    QString elem_name = rs.name().toString();
+    if (elem_name == "layers") {
+      while (rs.readNextStartElement()) {
+        if (rs.name().toString() == "layer_prop") {
+          LayerRecord rec;
+          parseLayerProp(&rs, rec, lat, has_lat);
+          layers.append(rec);
+        } else {
+          rs.skipCurrentElement();
+        }
+      }
+    } else if (elem_name == "layer_prop") {
+      // LEGACY layer_prop outside of the layers element
+      LayerRecord rec;
+      parseLayerProp(&rs, rec, lat, has_lat);
+      layers.append(rec);
+    } else if (elem_name == "design") {
+      send_layers();
+      int layer_pos = 0;
+      while (rs.readNextStartElement()) {
+        if (rs.name().toString() != "layer") {
+          rs.skipCurrentElement();
+          continue;
+        }
+        ItemChunk chunk;
+        if (layers.value(layer_pos).type == "DB") {
+          // DBs are handed over in batches of whole top level items
+          chunk.tag = DBChunk;
+          chunk.dbs.layer_pos = layer_pos;
+          while (rs.readNextStartElement()) {
+            if (!parseDBElement(&rs, chunk.dbs, opts.default_db_color)) {
+              err = QObject::tr("DB without lattice coordinates on line %1.")
+                  .arg(rs.lineNumber());
+              return ParseLegacy;
+            }
+            if (opts.batch_dbs > 0 && chunk.dbs.dbCount() >= opts.batch_dbs) {
+              if (!sink->items(chunk))
+                return ParseCancelled;
+              chunk.dbs = DBRecord();
+              chunk.dbs.layer_pos = layer_pos;
+            }
+          }
+          if (chunk.dbs.dbCount() > 0 && !sink->items(chunk))
+            return ParseCancelled;
+        } else {
+          // other items as XML, consecutive items of the same kind together
+          chunk.xml.layer_pos = layer_pos;
+          QScopedPointer<QXmlStreamWriter> ws;
+          auto send_xml = [&]() -> bool {
+            ws.reset();
+            bool ok = chunk.xml.xml.trimmed().isEmpty() || sink->items(chunk);
+            chunk.xml.xml.clear();
+            return ok;
+          };
+          while (rs.readNextStartElement()) {
+            quint32 item_tag = itemChunkTag(rs.name().toString());
+            if (ws && item_tag != chunk.tag && !send_xml())
+              return ParseCancelled;
+            if (!ws) {
+              chunk.tag = item_tag;
+              ws.reset(new QXmlStreamWriter(&chunk.xml.xml));
+              ws->setAutoFormatting(true);
+            }
+            copyXmlElement(&rs, ws.data());
+          }
+          if (!send_xml())
+            return ParseCancelled;
+        }
+        layer_pos++;
+      }
+    } else {
+      // program flags, simulation parameters and GUI flags
+      QByteArray head;
+      QXmlStreamWriter hs(&head);
+      hs.setAutoFormatting(true);
+      copyXmlElement(&rs, &hs);
+      sink->head(head);
+    }
+  }
+  if (rs.hasError()) {
+    err = QObject::tr("XML error on line %1: %2").arg(rs.lineNumber()).arg(rs.errorString());
+    return ParseError;
+  }
+  send_layers();
+  return ParseOk;
+}
+
+gui::sqb::ParseStatus gui::sqb::parseSqb(Reader *rd, DesignSink *sink,
+    const ParseOptions &opts, QString &err)
+{
+  quint32 tag;
+  QByteArray raw;
+  while (rd->readChunk(tag, raw)) {
+    bool chunk_ok = true;
+    switch (tag) {
+      case HeadChunk:
+        sink->head(raw);
+        break;
+      case LatticeChunk:
+      {
+        LatticeRecord lat;
+        chunk_ok = Reader::readLattice(raw, lat);
+        if (chunk_ok)
+          sink->lattice(lat);
+        break;
+      }
+      case LayerChunk:
+      {
+        QList<LayerRecord> layers;
+        chunk_ok = Reader::readLayers(raw, layers);
+        if (chunk_ok)
+          sink->layers(layers);
+        break;
+      }
+      case DBChunk:
+      {
+        DBRecord rec;
+        chunk_ok = Reader::readDBs(raw, rec);
+        if (!chunk_ok)
+          break;
+        ItemChunk chunk;
+        chunk.tag = DBChunk;
+        for (const DBRecord &part : rec.split(opts.batch_dbs)) {
+          chunk.dbs = part;
+          if (!sink->items(chunk))
+            return ParseCancelled;
+        }
+        break;
+      }
+      case ElectrodeChunk:
+      case AFMChunk:
+      case LabelChunk:
+      case XmlItemChunk:
+      {
+        ItemChunk chunk;
+        chunk.tag = tag;
+        chunk_ok = Reader::readXmlItems(raw, chunk.xml);
+        if (chunk_ok && !sink->items(chunk))
+          return ParseCancelled;
+        break;
+      }
+      case TileIndexChunk:
+        // tiles are read in file order like untiled DB chunks
+        break;
+      default:
+        qDebug() << QObject::tr("Design parser: skipping unknown chunk %1").arg(tag, 8, 16);
+        break;
+    }
+    if (!chunk_ok) {
+      err = QObject::tr("Malformed SQB chunk %1.").arg(tag, 8, 16);
+      return ParseError;
+    }
+  }
+  if (rd->hasError()) {
+    err = rd->errorString();
+    return ParseError;
+  }
+  return ParseOk;
+}
+
+gui::sqb::ParseStatus gui::sqb::parseDesign(QIODevice *dev, DesignSink *sink,
+    const ParseOptions &opts, QString &err)
+{
+  if (!isBinaryDesign(dev))
+    return parseSqd(dev, sink, opts, err);
+  Reader rd(dev);
+  if (!rd.begin()) {
+    err = rd.errorString();
+    return ParseError;
+  }
+  return parseSqb(&rd, sink, opts, err);
+}
+
+
+// conversion
+
+namespace {
+
+  // writes parsed designs to an .sqb container, with one DB chunk per tile if
+  // tile_cells is positive
+  class SqbWriteSink : public sqb::DesignSink
+  {
+  public:
+    SqbWriteSink(sqb::Writer *wr, int tile_cells=0) : wr(wr) {index.tile_cells = tile_cells;}
+    void head(const QByteArray &xml) override {ok = ok && wr->writeHead(xml);}
+    void lattice(const sqb::LatticeRecord &lat) override {ok = ok && wr->writeLattice(lat);}
+    void layers(const QList<sqb::LayerRecord> &layers) override {ok = ok && wr->writeLayers(layers);}
+    bool items(const sqb::ItemChunk &chunk) override
+    {
+      if (!ok)
+        return false;
+      if (chunk.tag == sqb::DBChunk && index.tile_cells > 0) {
+        if (chunk.tile.is_tile) {
+          ok = flushTiles() && writeTile(chunk);
+        } else {
+          // untiled DBs are collected by tile until the layer's other items
+          if (chunk.dbs.layer_pos != pending_layer)
+            ok = flushTiles();
+          pending_layer = chunk.dbs.layer_pos;
+          QMap<QPair<qint32,qint32>, sqb::DBRecord> tiles = chunk.dbs.tiles(index.tile_cells);
+          for (auto it = tiles.cbegin(); it != tiles.cend(); ++it) {
+            sqb::DBRecord &rec = pending[it.key()];
+            rec.layer_pos = pending_layer;
+            rec.appendRecord(it.value());
+          }
+        }
+        return ok;
+      }
+
+      ok = flushTiles();
+      if (ok && chunk.tag == sqb::DBChunk && chunk.tile.isReference()) {
+        sqb::DBRecord rec;
+        ok = resolve(chunk, rec) && wr->writeDBs(rec);
+      } else if (ok) {
+        ok = chunk.tag == sqb::DBChunk ? wr->writeDBs(chunk.dbs)
+            : wr->writeXmlItems(chunk.tag, chunk.xml);
+      }
+      return ok;
+    }
+
+    //! Write the pending tiles and the tile index.
+    bool finish()
+    {
+      ok = ok && flushTiles();
+      if (ok && !index.tiles.isEmpty())
+        ok = wr->writeTileIndex(index);
+      return ok;
+    }
+
+    bool ok=true;
+
+  private:
+
+    // read a referenced tile, reporting failures
+    bool resolve(const sqb::ItemChunk &chunk, sqb::DBRecord &rec)
+    {
+      QString err;
+      if (!readTileReference(chunk, rec, err)) {
+        qCritical() << QObject::tr("Design writer: can't read tile (%1, %2) from %3: %4")
+            .arg(chunk.tile.tx).arg(chunk.tile.ty).arg(chunk.tile.source).arg(err);
+        return false;
+      }
+      return true;
+    }
+
+    // write a tile chunk and add it to the index
+    bool writeTile(const sqb::ItemChunk &chunk)
+    {
+      sqb::TileEntry entry;
+      entry.layer_pos = chunk.dbs.layer_pos;
+      entry.tx = chunk.tile.tx;
+      entry.ty = chunk.tile.ty;
+      entry.offset = wr->pos();
+
+      if (chunk.tile.isReference() && chunk.tile.source_layer_pos == chunk.dbs.layer_pos) {
+        // unchanged tiles are copied as stored without inflating them
+        QFile file(chunk.tile.source);
+        QByteArray stored;
+        sqb::Reader rd(&file);
+        if (!file.open(QIODevice::ReadOnly)
+            || !rd.readStoredChunkAt(chunk.tile.offset, sqb::DBChunk, stored)) {
+          qCritical() << QObject::tr("Design writer: can't copy tile (%1, %2) from %3: %4")
+              .arg(entry.tx).arg(entry.ty).arg(chunk.tile.source)
+              .arg(rd.hasError() ? rd.errorString() : file.errorString());
+          return false;
+        }
+        entry.db_count = chunk.tile.db_count;
+        if (!wr->writeStoredChunk(stored))
+          return false;
+      } else {
+        sqb::DBRecord resolved;
+        if (chunk.tile.isReference() && !resolve(chunk, resolved))
+          return false;
+        const sqb::DBRecord &rec = chunk.tile.isReference() ? resolved : chunk.dbs;
+        if (rec.dbCount() == 0)
+          return true;
+        entry.db_count = rec.dbCount();
+        if (!wr->writeDBs(rec))
+          return false;
+      }
+      index.tiles.append(entry);
+      return true;
+    }
+
+    // write the collected tiles of the pending layer
+    bool flushTiles()
+    {
+      for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        sqb::TileEntry entry;
+        entry.layer_pos = pending_layer;
+        entry.tx = it.key().first;
+        entry.ty = it.key().second;
+        entry.offset = wr->pos();
+        entry.db_count = it.value().dbCount();
+        if (!wr->writeDBs(it.value()))
+          return false;
+        index.tiles.append(entry);
+      }
+      pending.clear();
+      pending_layer = -1;
+      return true;
+    }
+
+    sqb::Writer *wr;
+    sqb::TileIndex index;
+    QMap<QPair<qint32,qint32>, sqb::DBRecord> pending;
+    int pending_layer=-1;
+  };
+
+  // writes parsed designs in the layout of ApplicationGUI::saveToFile
+  class SqdWriteSink : public sqb::DesignSink
+  {
+  public:
+    // worker threads write snapshots, so the float format comes with the
+    // snapshot instead of the settings
+    SqdWriteSink(QXmlStreamWriter *ws, const sqb::FloatFormat &ff)
+      : ws(ws), ctx(SaveContext::currentLayout(), ff.precision, ff.format) {}
+
+    void head(const QByteArray &xml) override
+    {
+      QXmlStreamReader hrs(QByteArray("<siqad>") + xml + QByteArray("</siqad>"));
+      hrs.readNextStartElement();
+      while (hrs.readNextStartElement())
+        sqb::copyXmlElement(&hrs, ws);
+    }
+
+    void lattice(const sqb::LatticeRecord &lat_rec) override {lat = lat_rec;}
+
+    void layers(const QList<sqb::LayerRecord> &layer_recs) override
+    {
+      layers_table = layer_recs;
+
+      // layer table in the layout of Layer::saveLayer and Lattice::saveLayer
+      ws->writeComment("Layer Properties");
+      ws->writeComment("Layer ID is intrinsic to the layer order");
+      ws->writeStartElement("layers");
+      for (const sqb::LayerRecord &rec : layers_table) {
+        ws->writeStartElement("layer_prop");
+        ws->writeTextElement("name", rec.name);
+        ws->writeTextElement("type", rec.type);
+        ws->writeTextElement("role", rec.role);
+        ws->writeTextElement("zoffset", ctx.real(rec.zoffset));
+        ws->writeTextElement("zheight", ctx.real(rec.zheight));
+        ws->writeTextElement("visible", ctx.number(rec.visible));
+        ws->writeTextElement("active", ctx.number(rec.active));
+        if (rec.type == "Lattice") {
+          ws->writeStartElement("lat_vec");
+          ws->writeTextElement("name", lat.name);
+          for (int i=0; i<2; i++) {
+            ws->writeEmptyElement(QString("a%1").arg(i+1));
+            ws->writeAttribute("x", ctx.real(lat.a[i].x()));
+            ws->writeAttribute("y", ctx.real(lat.a[i].y()));
+          }
+          ws->writeTextElement("N", ctx.number(int(lat.b.size())));
+          for (int i=0; i<lat.b.size(); i++) {
+            ws->writeEmptyElement(QString("b%1").arg(i+1));
+            ws->writeAttribute("x", ctx.real(lat.b[i].x()));
+            ws->writeAttribute("y", ctx.real(lat.b[i].y()));
+          }
+          ws->writeEndElement();
+        }
+        ws->writeEndElement();
+      }
+      ws->writeEndElement();
+
+      // item hierarchy in the layout of Layer::saveItems
+      ws->writeComment("Item Hierarchy");
+      ws->writeStartElement("design");
+      design_open = true;
+    }
+
+    bool items(const sqb::ItemChunk &chunk) override
+    {
+      // chunks arrive in layer order, open the layers up to the chunk's
+      int layer_pos = chunk.layerPos();
+      if (!design_open || layer_pos < open_pos || layer_pos >= layers_table.size()) {
+        ok = false;
+        return false;
+      }
+      advanceTo(layer_pos);
+      if (chunk.tag == sqb::DBChunk && chunk.tile.isReference()) {
+        // referenced tiles are read one at a time
+        sqb::DBRecord rec;
+        QString err;
+        if (!readTileReference(chunk, rec, err)) {
+          qCritical() << QObject::tr("Design writer: can't read tile (%1, %2) from %3: %4")
+              .arg(chunk.tile.tx).arg(chunk.tile.ty).arg(chunk.tile.source).arg(err);
+          ok = false;
+          return false;
+        }
+        writeDBItems(ws, rec, lat, ctx);
+      } else if (chunk.tag == sqb::DBChunk) {
+        writeDBItems(ws, chunk.dbs, lat, ctx);
+      } else {
+        QXmlStreamReader xrs(sqb::wrapLayerFragment(chunk.xml.xml));
+        xrs.readNextStartElement();
+        while (xrs.readNextStartElement())
+          sqb::copyXmlElement(&xrs, ws);
+      }
+      return true;
+    }
+
+    //! Close the remaining layers and the design element.
+    void finish()
+    {
+      if (!design_open)
+        return;
+      advanceTo(layers_table.size());
+      ws->writeEndElement();
+    }
+
+    bool ok=true;
+
+  private:
+
+    // close the open layer and open empty layers until layer_pos
+    void advanceTo(int layer_pos)
+    {
+      while (open_pos < layer_pos) {
+        if (open_pos >= 0)
+          ws->writeEndElement();
+        open_pos++;
+        if (open_pos < layers_table.size()) {
+          ws->writeComment(layers_table[open_pos].name);
+          ws->writeStartElement("layer");
+          ws->writeAttribute("type", layers_table[open_pos].type);
+        }
+      }
+    }
+
+    QXmlStreamWriter *ws;
+    SaveContext ctx;
+    sqb::LatticeRecord lat;
+    QList<sqb::LayerRecord> layers_table;
+    bool design_open=false;
+    int open_pos=-1;
+  };
+
+  // replace path by the file written next to it if ok is set, remove the
+  // partial file otherwise
+  bool replaceWithWritten(QFile &file, const QString &path, bool ok, QString &err)
+  {
+    file.close();
+    if (!ok) {
+      file.remove();
+      return false;
+    }
+    QFile::remove(path);
+    if (!file.rename(path)) {
+      err = file.errorString();
+      return false;
+    }
+    return true;
+  }
+
+} // end anonymous namespace
+
+bool gui::sqb::writeSqb(const DesignSnapshot &snap, Writer *wr)
+{
+  SqbWriteSink sink(wr, snap.tile_cells);
+  return snap.replay(&sink) && sink.finish();
+}
+
+bool gui::sqb::writeSqd(const DesignSnapshot &snap, QXmlStreamWriter *ws)
+{
+  SqdWriteSink sink(ws, snap.float_format);
+  if (!snap.replay(&sink) || !sink.ok)
+    return false;
+  sink.finish();
+  return true;
+}
+
+bool gui::sqb::saveSnapshot(const DesignSnapshot &snap, const QString &path, QString &err,
+    int gz_level)
+{
+  // keep the previous file until the new one is complete
+  QFile file(path + ".writing");
+  if (!file.open(QIODevice::WriteOnly)) {
+    err = file.errorString();
+    return false;
+  }
+
+  bool ok;
+  if (isBinaryDesignPath(path)) {
+    Writer wr(&file);
+    ok = wr.begin() && writeSqb(snap, &wr) && wr.finish();
+    if (!ok)
+      err = wr.errorString();
+  } else {
+    QIODevice *out = GzipDevice::compressing(&file, path, gz_level);
+    QXmlStreamWriter ws(out);
+    ws.setAutoFormatting(true);
+    ws.writeStartDocument();
+    ws.writeStartElement("siqad");
+    ok = writeSqd(snap, &ws);
+    ws.writeEndElement();
+    ws.writeEndDocument();
+    out->close();
+    if (!ok)
+      err = QObject::tr("Snapshot items are out of layer order.");
+    else if (ws.hasError() || file.error() != QFileDevice::NoError)
+      err = ws.hasError() ? out->errorString() : file.errorString();
+    ok = ok && err.isEmpty();
+  }
+  return replaceWithWritten(file, path, ok, err);
+}
+
+bool gui::sqb::sqdToSqb(const QString &sqd_path, const QString &sqb_path, QString &err)
+{
+  QFile in_file(sqd_path);
+  if (!in_file.open(QFile::ReadOnly)) {
+    err = in_file.errorString();
+    return false;
+  }
+  QIODevice *in = GzipDevice::decompressing(&in_file);
+
+  // keep an existing file until the conversion is complete
+  QFile out_file(sqb_path + ".writing");
+  if (!out_file.open(QIODevice::WriteOnly)) {
+    err = out_file.errorString();
+    return false;
+  }
+
+  // no batching, every DB layer becomes one DBS chunk
+  ParseOptions opts = ParseOptions::fromSettings();
+  opts.batch_dbs = 0;
+
+  Writer wr(&out_file);
+  SqbWriteSink sink(&wr, settings::AppSettings::instance()->get<int>("save/sqb_tile_cells"));
+  bool ok = wr.begin();
+  if (ok) {
+    ParseStatus status = parseSqd(in, &sink, opts, err);
+    if (status == ParseLegacy)
+      err += QObject::tr(" Open and save the design in SiQAD before converting it.");
+    ok = status == ParseOk && sink.finish() && wr.finish();
+  }
+  if (!ok && err.isEmpty())
+    err = wr.errorString();
+  return replaceWithWritten(out_file, sqb_path, ok, err);
+}
+
+bool gui::sqb::sqbToSqd(const QString &sqb_path, const QString &sqd_path, QString &err)
+{
+  QFile in_file(sqb_path);
+  if (!in_file.open(QFile::ReadOnly)) {
+    err = in_file.errorString();
+    return false;
+  }
+  Reader rd(&in_file);
+  if (!rd.begin()) {
+    err = rd.errorString();
+    return false;
+  }
+
+  // keep an existing file until the conversion is complete
+  QFile out_file(sqd_path + ".writing");
+  if (!out_file.open(QIODevice::WriteOnly)) {
+    err = out_file.errorString();
+    return false;
+  }
+
+  QIODevice *out = GzipDevice::compressing(&out_file, sqd_path,
+      settings::AppSettings::instance()->get<int>("save/gzip_level"));
+  QXmlStreamWriter ws(out);
+  ws.setAutoFormatting(true);
+  ws.writeStartDocument();
+  ws.writeStartElement("siqad");
+
+  ParseOptions opts = ParseOptions::fromSettings();
+  opts.batch_dbs = 0;
+  SqdWriteSink sink(&ws, FloatFormat::fromSettings());
+  bool ok = parseSqb(&rd, &sink, opts, err) == ParseOk && sink.ok;
+  if (!ok && err.isEmpty())
+    err = QObject::tr("SQB item chunks are out of layer order.");
+  if (ok) {
+    sink.finish();
+    ws.writeEndElement();
+    ws.writeEndDocument();
+  }
+  out->close();
+  if (ok && (ws.hasError() || out_file.error() != QFileDevice::NoError)) {
+    err = ws.hasError() ? out->errorString() : out_file.errorString();
+    ok = false;
+  }
+  return replaceWithWritten(out_file, sqd_path, ok, err);
+}
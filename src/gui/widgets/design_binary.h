@@ -0,0 +1,393 @@
+/** @file:     design_binary.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Compact binary design container (.sqb) and lossless conversion
+ *             between .sqd and .sqb.
+ *
+ *  An .sqb file starts with the magic "SQB\x1a" and a format version,
+ *  followed by typed chunks until an END chunk:
+ *
+ *    quint32 tag, quint32 flags, quint64 raw size, quint64 stored size,
+ *    quint32 CRC-32 of the raw payload, stored payload
+ *
+ *  Payloads are deflated with miniz when that makes them smaller. Chunks
+ *  appear in the order HEAD, LATT, LAYR, then the per-layer item chunks:
+ *
+ *  HEAD: program flags, simulation parameters and GUI flags as XML
+ *        fragments, these are small and kept verbatim. There may be several.
+ *  LATT: lattice parameters.
+ *  LAYR: the layer table, in the same order as the layers of an .sqd file.
+ *  DBS:  DBs of one DB layer as packed little-endian (n,m,l) int32 triplets,
+ *        a color palette with per-DB palette indices, and the aggregate
+ *        structure.
+ *  ELEC, AFMP, LABL, XITM: electrode, AFM, label and other items of one
+ *        layer as XML fragments read by the items' own XML constructors.
+ *        Consecutive items of the same kind share a chunk and the chunks of
+ *        a layer keep the item order.
+ *  TIDX: tile index of tiled files, written after the last item chunk.
+ *
+ *  Tiled files split the DBs of each DB layer into one DBS chunk per square
+ *  tile of lattice cells, an aggregate belongs to the tile of its first DB.
+ *  The TIDX chunk lists the offset of every tile chunk and the END chunk
+ *  holds the offset of the TIDX chunk, so that readers can find the tiles
+ *  from the end of the file and read only those they need.
+ */
+
+#ifndef _GUI_DESIGN_BINARY_H_
+#define _GUI_DESIGN_BINARY_H_
+
+#include <QtCore>
+#include <QColor>
+
+namespace gui{
+namespace sqb{
+
+  //! Chunk tags, four characters read as a big-endian integer.
+  enum ChunkTag : quint32 {
+    HeadChunk = 0x48454144,     // "HEAD"
+    LatticeChunk = 0x4c415454,  // "LATT"
+    LayerChunk = 0x4c415952,    // "LAYR"
+    DBChunk = 0x44425320,       // "DBS "
+    ElectrodeChunk = 0x454c4543,// "ELEC"
+    AFMChunk = 0x41464d50,      // "AFMP"
+    LabelChunk = 0x4c41424c,    // "LABL"
+    XmlItemChunk = 0x5849544d,  // "XITM"
+    JournalChunk = 0x4a524e4c,  // "JRNL", autosave journal, see design_journal.h
+    TileIndexChunk = 0x54494458,// "TIDX"
+    EndChunk = 0x454e4420       // "END "
+  };
+
+  //! Current format version, readers reject files of a newer major version.
+  const quint16 version_major = 1;
+  const quint16 version_minor = 0;
+
+  //! Aggregate structure tokens of a DBRecord. Positive tokens take that many
+  //! DBs from the coordinate array at the current nesting level.
+  enum StructureToken : qint32 {OpenAggregate=-1, CloseAggregate=-2};
+
+  //! One entry of the layer table.
+  struct LayerRecord
+  {
+    QString name;
+    QString type="DB";      // prim::Layer::LayerType key
+    QString role="Design";  // prim::Layer::LayerRole key
+    float zoffset=0;
+    float zheight=0;
+    bool visible=false;
+    bool active=false;
+  };
+
+  //! Lattice parameters in angstrom.
+  struct LatticeRecord
+  {
+    QString name;
+    QPointF a[2];
+    QList<QPointF> b;
+  };
+
+  //! DBs of one DB layer.
+  struct DBRecord
+  {
+    int layer_pos=-1;           // position in the layer table
+    QVector<qint32> coords;     // n,m,l triplets in save order
+    QVector<QRgb> palette;      // distinct DB colors
+    QVector<quint32> color_ids; // palette index per DB, empty if one color
+    QVector<qint32> structure;  // aggregate structure, empty if no aggregates
+    QHash<QRgb, quint32> palette_ids; // palette lookup while appending
+
+    int dbCount() const {return coords.size()/3;}
+    void append(qint32 n, qint32 m, qint32 l, QRgb color);
+    QRgb color(int i) const {return color_ids.isEmpty() ? palette.value(0) : palette.value(color_ids[i]);}
+    //! Append a structure token, merging consecutive DB runs.
+    void appendStructure(qint32 token);
+    //! Split into records of at most max_dbs DBs between top level items,
+    //! aggregates are never split.
+    QList<DBRecord> split(int max_dbs) const;
+    //! Append the DBs and structure of another record.
+    void appendRecord(const DBRecord &other);
+    //! Split into one record per tile of tile_cells lattice cells, keyed by
+    //! tile coordinates. Aggregates go to the tile of their first DB.
+    QMap<QPair<qint32,qint32>, DBRecord> tiles(int tile_cells) const;
+  };
+
+  //! Tile coordinate of lattice coordinate n or m.
+  inline qint32 tileCoord(qint32 cell, qint32 tile_cells)
+  {
+    return cell >= 0 ? cell / tile_cells : -((-cell + tile_cells - 1) / tile_cells);
+  }
+
+  //! One tile chunk of a tiled file.
+  struct TileEntry
+  {
+    int layer_pos=-1;
+    qint32 tx=0;
+    qint32 ty=0;
+    qint64 offset=-1;     // file offset of the chunk
+    quint32 db_count=0;
+  };
+
+  //! Tile index of a tiled file.
+  struct TileIndex
+  {
+    qint32 tile_cells=0;
+    QList<TileEntry> tiles;
+
+    quint64 dbCount() const;
+  };
+
+  //! Placement of a DB chunk in a tiled design. A tile may be handed over by
+  //! reference to its stored chunk instead of its DBs, writers then copy or
+  //! decode the stored chunk.
+  struct TileRef
+  {
+    bool is_tile=false;   // the chunk holds exactly one tile
+    qint32 tx=0;
+    qint32 ty=0;
+    QString source;       // file holding the stored chunk, empty if DBs are given
+    qint64 offset=-1;     // offset of the stored chunk in source
+    int source_layer_pos=-1;  // layer position stored in the chunk
+    quint32 db_count=0;
+
+    bool isReference() const {return offset >= 0;}
+  };
+
+  //! Items of one layer as an XML fragment.
+  struct XmlRecord
+  {
+    int layer_pos=-1;
+    QByteArray xml;
+  };
+
+  //! Items of one layer handed over while parsing, a DB record for DBChunk
+  //! and an XML fragment for the other item chunk tags.
+  struct ItemChunk
+  {
+    quint32 tag=0;
+    DBRecord dbs;
+    XmlRecord xml;
+    TileRef tile;   // DBChunk only
+
+    int layerPos() const {return tag == DBChunk ? dbs.layer_pos : xml.layer_pos;}
+  };
+
+  //! Receives the parts of a design in file order while it is parsed. The
+  //! lattice, if any, precedes the layer table which precedes all items.
+  class DesignSink
+  {
+  public:
+    virtual ~DesignSink() {}
+    virtual void head(const QByteArray &xml) = 0;
+    virtual void lattice(const LatticeRecord &lat) = 0;
+    virtual void layers(const QList<LayerRecord> &layers) = 0;
+    //! Receive items, return false to stop parsing.
+    virtual bool items(const ItemChunk &chunk) = 0;
+  };
+
+  //! Outcome of parsing a design. ParseLegacy marks .sqd files with DBs
+  //! lacking lattice coordinates, which only the XML item loaders handle.
+  enum ParseStatus{ParseOk, ParseError, ParseCancelled, ParseLegacy};
+
+  //! Options for parsing designs, read from the settings on the calling
+  //! thread so that parsing can run on any thread.
+  struct ParseOptions
+  {
+    int batch_dbs=0;            // DBs per item chunk, 0 for no limit
+    QRgb default_db_color=0;    // color of DBs saved without one
+
+    static ParseOptions fromSettings();
+  };
+
+  //! Writes an .sqb container to a device.
+  class Writer
+  {
+  public:
+    //! Constructor, level is the miniz compression level.
+    Writer(QIODevice *dev, int level=6) : dev(dev), level(level) {}
+
+    //! Write the file header.
+    bool begin();
+    //! Write the END chunk, holding the tile index offset if one was written.
+    bool finish();
+
+    //! Deflate and write a raw chunk payload.
+    bool writeChunk(quint32 tag, const QByteArray &raw);
+
+    //! Write a chunk read by Reader::readStoredChunkAt verbatim.
+    bool writeStoredChunk(const QByteArray &chunk);
+
+    //! Offset of the next chunk.
+    qint64 pos() const {return dev->pos();}
+
+    bool writeHead(const QByteArray &xml) {return writeChunk(HeadChunk, xml);}
+    bool writeLattice(const LatticeRecord &lat);
+    bool writeLayers(const QList<LayerRecord> &layers);
+    bool writeDBs(const DBRecord &dbs);
+    bool writeXmlItems(quint32 tag, const XmlRecord &rec);
+    bool writeTileIndex(const TileIndex &index);
+
+    //! Error description of the last failure.
+    QString errorString() const {return err;}
+
+  private:
+    QIODevice *dev;
+    int level;
+    qint64 tile_index_offset=-1;
+    QString err;
+  };
+
+  //! Collects the XML of consecutive items of the same kind of one layer into
+  //! one item chunk per run.
+  class ItemChunker
+  {
+  public:
+    //! Constructor, chunks are appended to out.
+    ItemChunker(QList<ItemChunk> *out, int layer_pos) : out(out), layer_pos(layer_pos) {}
+    ~ItemChunker() {flush();}
+
+    //! Return the XML writer for the next item, which goes to a chunk with the
+    //! given tag.
+    QXmlStreamWriter *beginItem(quint32 item_tag);
+
+    //! Append the pending chunk.
+    void flush();
+
+  private:
+    QList<ItemChunk> *out;
+    int layer_pos;
+    quint32 tag=0;
+    QByteArray xml;
+    QXmlStreamWriter *ws=nullptr;
+  };
+
+  //! Float formatting of .sqd files, read from the settings on the GUI thread
+  //! so that .sqd files can be written on any thread.
+  struct FloatFormat
+  {
+    int precision=6;
+    char format='g';
+
+    static FloatFormat fromSettings();
+  };
+
+  //! A design captured as records that share no state with the scene, so it
+  //! can be written on any thread.
+  struct DesignSnapshot
+  {
+    QList<QByteArray> heads;
+    bool has_lattice=false;
+    LatticeRecord lattice;
+    QList<LayerRecord> layers;
+    QList<ItemChunk> items;
+    FloatFormat float_format;
+    int tile_cells=0;   // tile size of .sqb files, 0 for untiled DB layers
+
+    //! Hand the records to the sink in file order. Returns false if the sink
+    //! stopped early.
+    bool replay(DesignSink *sink) const;
+  };
+
+  //! Reads an .sqb container from a device.
+  class Reader
+  {
+  public:
+    //! Constructor.
+    Reader(QIODevice *dev) : dev(dev) {}
+
+    //! Read and check the file header.
+    bool begin();
+
+    //! Read and inflate the next chunk. Returns false at the END chunk or on
+    //! error, check hasError() to tell them apart.
+    bool readChunk(quint32 &tag, QByteArray &raw);
+
+    //! Like readChunk, but the payload of chunks tagged skip_tag is skipped
+    //! without being read and raw is left empty for them.
+    bool readChunk(quint32 &tag, QByteArray &raw, quint32 skip_tag);
+
+    //! Read and inflate the chunk at the given file offset.
+    bool readChunkAt(qint64 offset, quint32 &tag, QByteArray &raw);
+
+    //! Read the chunk at the given file offset as stored, header included,
+    //! for Writer::writeStoredChunk. The tag must match.
+    bool readStoredChunkAt(qint64 offset, quint32 tag, QByteArray &chunk);
+
+    //! Read the tile index located through the END chunk. Returns false
+    //! without an error if the file isn't tiled.
+    bool readTileIndex(TileIndex &index);
+
+    static bool readLattice(const QByteArray &raw, LatticeRecord &lat);
+    static bool readLayers(const QByteArray &raw, QList<LayerRecord> &layers);
+    static bool readDBs(const QByteArray &raw, DBRecord &dbs);
+    static bool readXmlItems(const QByteArray &raw, XmlRecord &rec);
+    static bool readTileIndex(const QByteArray &raw, TileIndex &index);
+
+    bool hasError() const {return !err.isEmpty();}
+    QString errorString() const {return err;}
+
+  private:
+    // read a chunk header, returns false on error
+    bool readChunkHeader(quint32 &tag, quint32 &flags, quint64 &raw_size,
+        quint64 &stored_size, quint32 &crc);
+
+    QIODevice *dev;
+    QString err;
+  };
+
+  //! Parse an .sqd design from the device into the sink.
+  ParseStatus parseSqd(QIODevice *dev, DesignSink *sink, const ParseOptions &opts,
+      QString &err);
+
+  //! Parse the chunks of an .sqb container, whose header has been read.
+  ParseStatus parseSqb(Reader *rd, DesignSink *sink, const ParseOptions &opts,
+      QString &err);
+
+  //! Parse an .sqd or .sqb design, told apart by the .sqb magic.
+  ParseStatus parseDesign(QIODevice *dev, DesignSink *sink, const ParseOptions &opts,
+      QString &err);
+
+  //! Return whether the device holds an .sqb container, without consuming
+  //! any data.
+  bool isBinaryDesign(QIODevice *dev);
+
+  //! Return whether the path names an .sqb file by its suffix.
+  bool isBinaryDesignPath(const QString &path);
+
+  //! Chunk tag holding items of the given XML element name.
+  quint32 itemChunkTag(const QString &elem_name);
+
+  //! Wrap an item XML fragment in a layer element for Layer::loadItems.
+  QByteArray wrapLayerFragment(const QByteArray &xml);
+
+  //! Copy the current element of rs, including children, to ws.
+  void copyXmlElement(QXmlStreamReader *rs, QXmlStreamWriter *ws);
+
+  //! Write a snapshot to an .sqb container after its header, without the END
+  //! chunk but with the tile index of tiled snapshots. Errors are reported by
+  //! the writer.
+  bool writeSqb(const DesignSnapshot &snap, Writer *wr);
+
+  //! Write the content of the root element of an .sqd file from a snapshot.
+  bool writeSqd(const DesignSnapshot &snap, QXmlStreamWriter *ws);
+
+  //! Save a snapshot as a complete .sqd or .sqb file, told apart by the
+  //! suffix. .sqd files with a .gz suffix are compressed at gz_level. The
+  //! file is written next to path and renamed once complete.
+  bool saveSnapshot(const DesignSnapshot &snap, const QString &path, QString &err,
+      int gz_level=6);
+
+  //! Convert an .sqd file to .sqb, the .sqd file may be compressed. Returns
+  //! false and sets err on failure. Like saveSnapshot, the output is written
+  //! next to sqb_path and only renamed once complete.
+  bool sqdToSqb(const QString &sqd_path, const QString &sqb_path, QString &err);
+
+  //! Convert an .sqb file to .sqd, compressed if sqd_path has a .gz suffix.
+  //! Returns false and sets err on failure, leaving any file at sqd_path
+  //! untouched.
+  bool sqbToSqd(const QString &sqb_path, const QString &sqd_path, QString &err);
+
+} // end sqb namespace
+} // end gui namespace
+
+#endif
@@ -0,0 +1,129 @@
+// @file:     design_journal.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Incremental autosave journal of design edits.
+
+#include "design_journal.h"
+#include "design_binary.h"
+#include "primitives/items.h"
+
+
+void gui::DesignJournal::recordInsert(prim::Item *item, int layer_id, int index)
+{
+  if (recording)
+    writeOp(InsertItem, item, layer_id, index);
+}
+
+void gui::DesignJournal::recordRemove(int layer_id, int index)
+{
+  if (recording)
+    writeOp(RemoveItem, nullptr, layer_id, index);
+}
+
+void gui::DesignJournal::recordUpdate(prim::Item *item, int layer_id, int index)
+{
+  if (recording)
+    writeOp(UpdateItem, item, layer_id, index);
+}
+
+QByteArray gui::DesignJournal::takeRecord()
+{
+  QByteArray record = ops;
+  clear();
+  return record;
+}
+
+void gui::DesignJournal::writeOp(JournalOp op, prim::Item *item, int layer_id, int index)
+{
+  QDataStream out(&ops, QIODevice::Append);
+  out.setVersion(QDataStream::Qt_6_0);
+  out.setByteOrder(QDataStream::LittleEndian);
+  out << quint8(op) << qint32(layer_id) << qint32(index);
+  op_count++;
+  if (op == RemoveItem)
+    return;
+
+  // the payload is the item state after the edit
+  if (item->item_type == prim::Item::DBDot) {
+    prim::DBDot *db = static_cast<prim::DBDot*>(item);
+    prim::LatticeCoord lc = db->latticeCoord();
+    out << quint8(DBPayload) << qint32(lc.n) << qint32(lc.m) << qint32(lc.l)
+        << quint32(db->getCurrentFillColor().rgba());
+  } else {
+    QByteArray xml;
+    QXmlStreamWriter ws(&xml);
+    ws.setAutoFormatting(true);
+    item->saveItems(&ws);
+    out << quint8(XmlPayload) << xml;
+  }
+}
+
+QString gui::DesignJournal::journalPath(const QString &checkpoint_path)
+{
+  QFileInfo info(checkpoint_path);
+  return info.dir().filePath(info.completeBaseName() + ".sqj");
+}
+
+bool gui::DesignJournal::createFile(const QString &path, QString &err)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    err = file.errorString();
+    return false;
+  }
+  sqb::Writer wr(&file);
+  if (!wr.begin()) {
+    err = wr.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool gui::DesignJournal::appendRecord(const QString &path, const QByteArray &record,
+    QString &err)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    err = file.errorString();
+    return false;
+  }
+
+  // records are small and written often, favour speed over size
+  sqb::Writer wr(&file, 1);
+  if (!wr.writeChunk(sqb::JournalChunk, record)) {
+    err = wr.errorString();
+    return false;
+  }
+  file.flush();
+  return true;
+}
+
+bool gui::DesignJournal::readRecords(const QString &path, QList<QByteArray> &records,
+    QString &err)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    err = file.errorString();
+    return false;
+  }
+  sqb::Reader rd(&file);
+  if (!rd.begin()) {
+    err = rd.errorString();
+    return false;
+  }
+
+  // the journal has no END chunk, it ends with the file or a torn record
+  quint32 tag;
+  QByteArray raw;
+  while (!file.atEnd()) {
+    if (!rd.readChunk(tag, raw)) {
+      err = rd.hasError() ? rd.errorString() : QString();
+      break;
+    }
+    if (tag == sqb::JournalChunk)
+      records.append(raw);
+  }
+  return true;
+}
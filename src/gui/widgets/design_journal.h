@@ -0,0 +1,107 @@
+/** @file:     design_journal.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Incremental autosave journal of design edits.
+ *
+ *  The design panel records every change the undo commands make to the item
+ *  stacks of its layers: item insertions, removals and in-place updates
+ *  (moves, resizes, rotations and color changes), keyed by layer ID and item
+ *  stack index. Autosave periodically writes a full checkpoint and otherwise
+ *  appends the edits recorded since the previous autosave to the journal of
+ *  that checkpoint. Replaying the journal on the loaded checkpoint restores
+ *  the design.
+ *
+ *  A journal file has the .sqb header followed by one JRNL chunk per
+ *  autosave. Each chunk holds a sequence of edits:
+ *
+ *    quint8 op, qint32 layer ID, qint32 item index, item payload (not for
+ *    removals)
+ *
+ *  DB payloads are packed lattice coordinates and color, other items are kept
+ *  as the XML their own constructors read. A chunk torn by a crash fails its
+ *  checksum and ends the replay.
+ */
+
+#ifndef _GUI_DESIGN_JOURNAL_H_
+#define _GUI_DESIGN_JOURNAL_H_
+
+#include <QtCore>
+
+namespace prim{
+  class Item;
+}
+
+namespace gui{
+
+  class DesignJournal
+  {
+  public:
+
+    enum JournalOp : quint8 {InsertItem=1, RemoveItem=2, UpdateItem=3};
+    enum ItemPayload : quint8 {DBPayload=0, XmlPayload=1};
+
+    //! Record the insertion of item at index of the layer.
+    void recordInsert(prim::Item *item, int layer_id, int index);
+
+    //! Record the removal of the item at index of the layer.
+    void recordRemove(int layer_id, int index);
+
+    //! Record a change of the item at index of the layer.
+    void recordUpdate(prim::Item *item, int layer_id, int index);
+
+    //! Record an edit of content that designs don't save, e.g. simulation
+    //! result plots, so that autosave can tell it from an edit that escaped
+    //! the journal.
+    void recordTransientEdit() {if (recording) transient_count++;}
+
+    //! Return whether edits are being recorded.
+    bool isRecording() const {return recording;}
+
+    //! Stop recording, e.g. when the design is reset, until the next
+    //! checkpoint restarts it.
+    void invalidate() {recording = false; clear();}
+
+    //! Restart recording relative to a checkpoint of the current design.
+    void restart() {recording = true; clear();}
+
+    //! Return whether no edits have been recorded since the last take.
+    bool isEmpty() const {return op_count == 0;}
+
+    //! Return whether only transient edits have been recorded since the last
+    //! take.
+    bool isTransientOnly() const {return op_count == 0 && transient_count > 0;}
+
+    //! Return and clear the edits recorded since the last take.
+    QByteArray takeRecord();
+
+    //! Path of the journal belonging to a checkpoint file.
+    static QString journalPath(const QString &checkpoint_path);
+
+    //! Start an empty journal at path, replacing any previous one.
+    static bool createFile(const QString &path, QString &err);
+
+    //! Append a record to the journal at path.
+    static bool appendRecord(const QString &path, const QByteArray &record, QString &err);
+
+    //! Read the records of the journal at path. Returns false if the journal
+    //! can't be read at all. A torn tail sets err and keeps the intact records.
+    static bool readRecords(const QString &path, QList<QByteArray> &records, QString &err);
+
+  private:
+
+    // write the op header and, unless removing, the payload of the item
+    void writeOp(JournalOp op, prim::Item *item, int layer_id, int index);
+
+    void clear() {ops.clear(); op_count = 0; transient_count = 0;}
+
+    bool recording=false;
+    QByteArray ops;   // serialized edits since the last take
+    int op_count=0;
+    int transient_count=0;  // edits of content that isn't saved
+  };
+
+} // end gui namespace
+
+#endif
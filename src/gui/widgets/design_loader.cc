@@ -0,0 +1,292 @@
+// @file:     design_loader.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Threaded design loading with progressive scene population.
+
+#include "design_loader.h"
+#include "design_panel.h"
+#include "gzip_device.h"
+#include "settings/settings.h"
+
+
+// DesignLoadWorker
+
+bool gui::DesignLoadWorker::items(const sqb::ItemChunk &chunk)
+{
+  emit sig_items(chunk);
+
+  // report the share of the file read, only when the percentage changes
+  if (file != nullptr && file->size() > 0) {
+    int percent = static_cast<int>(100 * file->pos() / file->size());
+    if (percent != last_percent) {
+      last_percent = percent;
+      emit sig_progress(percent);
+    }
+  }
+  return !cancelled.loadRelaxed();
+}
+
+void gui::DesignLoadWorker::run()
+{
+  QFile in_file(path);
+  if (!in_file.open(QFile::ReadOnly)) {
+    emit sig_finished(sqb::ParseError,
+        tr("Error when opening file to read: %1").arg(in_file.errorString()));
+    return;
+  }
+
+  // progress follows the compressed file of compressed designs
+  file = &in_file;
+  QString err;
+  sqb::ParseStatus status = sqb::parseDesign(GzipDevice::decompressing(&in_file),
+      this, opts, err);
+  file = nullptr;
+  in_file.close();
+
+  emit sig_finished(status, err);
+}
+
+
+// DesignLoader
+
+gui::DesignLoader::DesignLoader(DesignPanel *design_pan, QObject *parent)
+  : QObject(parent), design_pan(design_pan)
+{
+  qRegisterMetaType<gui::sqb::LatticeRecord>();
+  qRegisterMetaType<QList<gui::sqb::LayerRecord>>();
+  qRegisterMetaType<gui::sqb::ItemChunk>();
+
+  slice_timer.setInterval(0);
+  connect(&slice_timer, &QTimer::timeout, this, &gui::DesignLoader::processPending);
+}
+
+gui::DesignLoader::~DesignLoader()
+{
+  if (worker != nullptr)
+    worker->cancel();
+  stopThread();
+}
+
+bool gui::DesignLoader::start(const QString &f_path)
+{
+  if (isLoading()) {
+    qWarning() << tr("A design is already loading, ignoring %1").arg(f_path);
+    return false;
+  }
+
+  // large tiled designs only load the tiles around the view, which is quick
+  // enough for the GUI thread. Listeners still hear of the load once the
+  // caller has returned.
+  if (design_pan->openTiled(f_path)) {
+    QTimer::singleShot(0, this, [this]() {
+      emit sig_progress(100);
+      emit sig_finished(true);
+    });
+    return true;
+  }
+
+  path = f_path;
+  time_slice_ms = qMax(1, settings::AppSettings::instance()->get<int>("load/time_slice_ms"));
+  pending.clear();
+  parse_percent = chunks_received = chunks_done = 0;
+  last_percent = -1;
+  parse_done = cancelling = region_shown = false;
+  parse_status = sqb::ParseOk;
+
+  // items are added with tools and edits blocked and the scene index
+  // suspended, edits would shift the item indices the load relies on
+  design_pan->beginDescriptorLoad();
+  design_pan->setEditsBlocked(true);
+
+  thread = new QThread(this);
+  worker = new DesignLoadWorker(path, sqb::ParseOptions::fromSettings());
+  worker->moveToThread(thread);
+
+  connect(thread, &QThread::started, worker, &gui::DesignLoadWorker::run);
+  connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(worker, &gui::DesignLoadWorker::sig_head,
+          this, &gui::DesignLoader::receiveHead);
+  connect(worker, &gui::DesignLoadWorker::sig_lattice,
+          this, &gui::DesignLoader::receiveLattice);
+  connect(worker, &gui::DesignLoadWorker::sig_layers,
+          this, &gui::DesignLoader::receiveLayers);
+  connect(worker, &gui::DesignLoadWorker::sig_items,
+          this, &gui::DesignLoader::receiveItems);
+  connect(worker, &gui::DesignLoadWorker::sig_progress,
+          this, &gui::DesignLoader::receiveParseProgress);
+  connect(worker, &gui::DesignLoadWorker::sig_finished,
+          this, &gui::DesignLoader::parseFinished);
+
+  qDebug() << tr("Beginning threaded load from %1").arg(path);
+  emit sig_progress(0);
+  thread->start();
+  return true;
+}
+
+void gui::DesignLoader::cancel()
+{
+  if (!isLoading() || cancelling)
+    return;
+
+  qDebug() << tr("Cancelling load of %1").arg(path);
+  cancelling = true;
+  pending.clear();
+  slice_timer.stop();
+  if (worker != nullptr)
+    worker->cancel();
+
+  // the remaining records are discarded, wait for the parse to stop
+  if (parse_done)
+    finish(false);
+}
+
+void gui::DesignLoader::receiveHead(const QByteArray &xml)
+{
+  if (!cancelling)
+    design_pan->loadHead(xml);
+}
+
+void gui::DesignLoader::receiveLattice(const sqb::LatticeRecord &lat)
+{
+  if (!cancelling)
+    design_pan->loadLatticeRecord(lat);
+}
+
+void gui::DesignLoader::receiveLayers(const QList<sqb::LayerRecord> &layers)
+{
+  if (cancelling)
+    return;
+  design_pan->loadLayerTable(layers);
+
+  // show the saved region before the items arrive
+  design_pan->showLoadedRegion();
+  region_shown = true;
+}
+
+void gui::DesignLoader::receiveItems(const sqb::ItemChunk &chunk)
+{
+  if (cancelling)
+    return;
+  pending.enqueue(chunk);
+  chunks_received++;
+  if (!slice_timer.isActive())
+    slice_timer.start();
+}
+
+void gui::DesignLoader::receiveParseProgress(int percent)
+{
+  parse_percent = percent;
+}
+
+void gui::DesignLoader::parseFinished(int status, const QString &err)
+{
+  parse_done = true;
+  parse_status = status;
+  stopThread();
+
+  switch (status) {
+    case sqb::ParseOk:
+      parse_percent = 100;
+      break;
+    case sqb::ParseLegacy:
+      // DBs without lattice coordinates need the item XML constructors
+      qDebug() << tr("%1 predates lattice coordinates, loading it synchronously").arg(path);
+      cancelling = true;
+      pending.clear();
+      slice_timer.stop();
+      break;
+    case sqb::ParseCancelled:
+      break;
+    default:
+      qCritical() << tr("Error when loading %1: %2").arg(path).arg(err);
+      break;
+  }
+
+  if (cancelling || pending.isEmpty())
+    finish(status == sqb::ParseOk && !cancelling);
+}
+
+void gui::DesignLoader::processPending()
+{
+  QElapsedTimer slice;
+  slice.start();
+  bool added = false;
+  while (!pending.isEmpty() && slice.elapsed() < time_slice_ms) {
+    design_pan->loadItemChunk(pending.dequeue());
+    chunks_done++;
+    added = true;
+  }
+
+  if (added) {
+    design_pan->updateSceneRect();
+    if (!region_shown) {
+      design_pan->showLoadedRegion();
+      region_shown = true;
+    }
+
+    // parsing leads instantiation, scale its progress by the chunks done
+    int percent = parse_percent * chunks_done / qMax(1, chunks_received);
+    if (percent > last_percent) {
+      last_percent = percent;
+      emit sig_progress(percent);
+    }
+  }
+
+  if (pending.isEmpty()) {
+    slice_timer.stop();
+    if (parse_done)
+      finish(parse_status == sqb::ParseOk);
+  }
+}
+
+void gui::DesignLoader::stopThread()
+{
+  if (thread == nullptr)
+    return;
+  thread->quit();
+  thread->wait();
+  delete thread;
+  thread = nullptr;
+  worker = nullptr;
+}
+
+void gui::DesignLoader::finish(bool ok)
+{
+  bool legacy = parse_status == sqb::ParseLegacy;
+  slice_timer.stop();
+  pending.clear();
+
+  design_pan->endDescriptorLoad();
+  design_pan->setEditsBlocked(false);
+
+  if (legacy) {
+    legacy_pending = true;
+    loadLegacy();
+    legacy_pending = false;
+    ok = true;
+  }
+
+  cancelling = false;
+  qDebug() << (ok ? tr("Load complete") : tr("Load incomplete"));
+  emit sig_progress(100);
+  emit sig_finished(ok);
+}
+
+void gui::DesignLoader::loadLegacy()
+{
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly)) {
+    qDebug() << tr("Error when opening file to read: %1").arg(file.errorString());
+    return;
+  }
+  QIODevice *in = GzipDevice::decompressing(&file);
+  if (in == &file)
+    file.setTextModeEnabled(true);
+
+  QXmlStreamReader rs(in);
+  rs.readNextStartElement();
+  design_pan->loadFromFile(&rs);
+  file.close();
+}
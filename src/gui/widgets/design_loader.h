@@ -0,0 +1,158 @@
+/** @file:     design_loader.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Loads designs on a worker thread and populates the design panel
+ *             in time slices on the GUI thread.
+ *
+ *  The worker parses the file into the plain .sqb records (lattice, layer
+ *  table and item chunks) which are queued to the GUI thread. The GUI thread
+ *  turns queued chunks into scene items within a bounded time per event loop
+ *  pass, so the view stays responsive and shows the design while the rest of
+ *  the file is still being read.
+ */
+
+#ifndef _GUI_DESIGN_LOADER_H_
+#define _GUI_DESIGN_LOADER_H_
+
+#include <QtCore>
+
+#include "design_binary.h"
+
+Q_DECLARE_METATYPE(gui::sqb::LayerRecord)
+Q_DECLARE_METATYPE(gui::sqb::LatticeRecord)
+Q_DECLARE_METATYPE(gui::sqb::ItemChunk)
+
+namespace gui{
+
+  class DesignPanel;
+
+  //! Parses a design file into records, lives on the loader thread.
+  class DesignLoadWorker : public QObject, public sqb::DesignSink
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor, opts are read from the settings on the GUI thread.
+    DesignLoadWorker(const QString &path, const sqb::ParseOptions &opts)
+      : path(path), opts(opts) {}
+
+    //! Request the parse to stop at the next item chunk, thread-safe.
+    void cancel() {cancelled.storeRelaxed(1);}
+
+    // DesignSink overrides, forward the records as queued signals
+    void head(const QByteArray &xml) override {emit sig_head(xml);}
+    void lattice(const sqb::LatticeRecord &lat) override {emit sig_lattice(lat);}
+    void layers(const QList<sqb::LayerRecord> &layers) override {emit sig_layers(layers);}
+    bool items(const sqb::ItemChunk &chunk) override;
+
+  public slots:
+
+    //! Open and parse the file.
+    void run();
+
+  signals:
+
+    void sig_head(const QByteArray &xml);
+    void sig_lattice(const gui::sqb::LatticeRecord &lat);
+    void sig_layers(const QList<gui::sqb::LayerRecord> &layers);
+    void sig_items(const gui::sqb::ItemChunk &chunk);
+    //! Percentage of the file read.
+    void sig_progress(int percent);
+    //! Parsing is over, status is an sqb::ParseStatus.
+    void sig_finished(int status, const QString &err);
+
+  private:
+
+    QString path;
+    sqb::ParseOptions opts;
+    QFile *file=nullptr;    // file being parsed, owned by run()
+    int last_percent=-1;
+    QAtomicInt cancelled;
+  };
+
+
+  //! Drives a DesignLoadWorker and instantiates its records in the design
+  //! panel. Only one design loads at a time.
+  class DesignLoader : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    DesignLoader(DesignPanel *design_pan, QObject *parent=nullptr);
+
+    //! Destructor, stops a running load.
+    ~DesignLoader();
+
+    //! Start loading the design at path. Returns false if a load is already
+    //! in progress. Large tiled designs are opened with
+    //! DesignPanel::openTiled() instead of being loaded in full.
+    bool start(const QString &path);
+
+    //! Return whether a design is loading.
+    bool isLoading() const {return thread != nullptr || legacy_pending;}
+
+  public slots:
+
+    //! Stop loading. The design panel keeps the items loaded so far and
+    //! sig_finished(false) is emitted.
+    void cancel();
+
+  signals:
+
+    //! Overall load progress in percent.
+    void sig_progress(int percent);
+
+    //! Emitted once the load is over, ok is false on error or cancellation.
+    void sig_finished(bool ok);
+
+  private slots:
+
+    // records from the worker
+    void receiveHead(const QByteArray &xml);
+    void receiveLattice(const gui::sqb::LatticeRecord &lat);
+    void receiveLayers(const QList<gui::sqb::LayerRecord> &layers);
+    void receiveItems(const gui::sqb::ItemChunk &chunk);
+    void receiveParseProgress(int percent);
+    void parseFinished(int status, const QString &err);
+
+    // instantiate queued chunks for at most one time slice
+    void processPending();
+
+  private:
+
+    // stop the worker thread and wait for it
+    void stopThread();
+
+    // leave the loading state and notify listeners
+    void finish(bool ok);
+
+    // load the file with the synchronous XML loader
+    void loadLegacy();
+
+    DesignPanel *design_pan;
+    QThread *thread=nullptr;
+    DesignLoadWorker *worker=nullptr;
+    QString path;
+
+    QQueue<sqb::ItemChunk> pending; // chunks waiting for instantiation
+    QTimer slice_timer;             // runs slices while chunks are pending
+    int time_slice_ms=15;
+    int parse_percent=0;
+    int chunks_received=0;
+    int chunks_done=0;
+    int last_percent=-1;
+    bool parse_done=false;
+    bool cancelling=false;
+    bool region_shown=false;
+    bool legacy_pending=false;
+    int parse_status=sqb::ParseOk;
+  };
+
+} // end gui namespace
+
+#endif
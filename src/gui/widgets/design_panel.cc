@@ -10,6 +10,7 @@
 #include "settings/settings.h"
 
 #include <algorithm>
+#include <functional>
 
 QColor gui::DesignPanel::background_col;
 QColor gui::DesignPanel::background_col_publish;
@@ -32,6 +33,17 @@ gui::DesignPanel::DesignPanel(QWidget *parent)
   // initialize actions
   initActions();
 
+  // the tiles of a tiled design follow the view once it settles
+  tile_timer.setSingleShot(true);
+  tile_timer.setInterval(50);
+  connect(&tile_timer, &QTimer::timeout, this, &gui::DesignPanel::updateResidentTiles);
+  for (QScrollBar *bar : {horizontalScrollBar(), verticalScrollBar()}) {
+    connect(bar, &QScrollBar::valueChanged,
+            this, [this]() {if (tiled.isOpen()) tile_timer.start();});
+    connect(bar, &QScrollBar::rangeChanged,
+            this, [this]() {if (tiled.isOpen()) tile_timer.start();});
+  }
+
   connect(prim::Emitter::instance(), &prim::Emitter::sig_selectClicked,
           this, &gui::DesignPanel::selectClicked);
   connect(prim::Emitter::instance(), &prim::Emitter::sig_showProperty,
@@ -73,9 +85,45 @@ void gui::DesignPanel::initDesignPanel(QString lattice_file_path, bool init_laye
   connect(undo_stack, &QUndoStack::cleanChanged,
           this, &DesignPanel::emitUndoStackCleanChanged);
 
+  // bound the undo history, the command limit can only be set while empty
+  settings::AppSettings *undo_settings = settings::AppSettings::instance();
+  int max_commands = undo_settings->get<int>("undo/max_commands");
+  if (max_commands > 0)
+    undo_stack->setUndoLimit(max_commands);
+  undo_budget = undo_settings->get<qint64>("undo/budget_kb") * 1024;
+  undo_bytes = 0;
+  undo_over_budget = false;
+  connect(undo_stack, &QUndoStack::indexChanged,
+          this, &DesignPanel::enforceUndoBudget);
+  connect(undo_stack, &QUndoStack::indexChanged,
+          this, [this]() {if (db_density) db_density->refresh();});
+  connect(undo_stack, &QUndoStack::indexChanged,
+          this, [this]() {design_revision++;});
+  connect(undo_stack, &QUndoStack::indexChanged,
+          this, &DesignPanel::pinUndoReferencedItems);
+  design_revision++;
+
+  // the journal resumes with the next autosave checkpoint
+  journal.invalidate();
+
+  // designs start untiled, see openTiled()
+  tiled.close();
+  tile_layer_pos.clear();
+  resident_dbs = 0;
+  undo_pins.clear();
+  tile_timer.stop();
+
+  // the area of interest belongs to the design
+  area_of_interest = prim::AreaOfInterest();
+  aoi_draft.clear();
+
   // initialize contained widgets
   layman = new LayerManager(this);
+  connect(layman, &LayerManager::sig_layerListChanged,
+          this, &DesignPanel::connectDBLayerVisibility);
   property_editor = new PropertyEditor(this);
+  connect(property_editor, &PropertyEditor::sig_itemPropertiesChanged,
+          this, &DesignPanel::itemPropertiesChanged);
   itman = new ItemManager(this, layman);
 
   color_dialog = new ColorDialog(this);
@@ -207,6 +255,8 @@ void gui::DesignPanel::clearDesignPanel(bool reset)
   layman=nullptr;
   itman=nullptr;
   lattice=nullptr;
+  db_density=nullptr; // deleted with the scene
+  aoi_outline=nullptr; // deleted with the scene
 
   // delete layers and contained items
   if(reset) prim::Layer::resetLayers(); // reset layer counter
@@ -224,6 +274,7 @@ void gui::DesignPanel::clearDesignPanel(bool reset)
   // disconnect this signal first otherwise segfaults
   disconnect(undo_stack, &QUndoStack::cleanChanged,
            this, &DesignPanel::emitUndoStackCleanChanged);
+  disconnect(undo_stack, &QUndoStack::indexChanged, this, nullptr);
   delete undo_stack;
 
   qDebug() << tr("Finished clearing design panel");
@@ -238,6 +289,7 @@ void gui::DesignPanel::resetDesignPanel(QString lattice_file_path, bool init_lay
   clearDesignPanel(true);
   initDesignPanel(lattice_file_path, init_layers);
   // REBUILD
+  emit sig_areaOfInterestChanged(area_of_interest);
 
   //let application know that design panel has been reset.
   emit sig_postDPReset();
@@ -266,6 +318,11 @@ void gui::DesignPanel::addItem(prim::Item *item, int layer_index, int ind)
   QPointF old_pos(mapToScene(mapFromParent(rect().center())));
 
   // add Item
+  markTileDirty(item);
+  if (journal.isRecording()) {
+    int count = layer->getItems().count();
+    journal.recordInsert(item, layer->layerID(), (ind < 0 || ind >= count) ? count : ind);
+  }
   layer->addItem(item, ind);
   scene->addItem(item);
 
@@ -274,9 +331,6 @@ void gui::DesignPanel::addItem(prim::Item *item, int layer_index, int ind)
   // correct screen shift
   QPointF new_pos(mapToScene(mapFromParent(rect().center())));
   scrollDelta(new_pos - old_pos);
-
-  // update item manager
-  itman->updateTableAdd();
 }
 
 void gui::DesignPanel::removeItem(prim::Item *item, int layer_index, bool retain_item)
@@ -288,6 +342,9 @@ void gui::DesignPanel::removeItem(prim::Item *item, prim::Layer *layer, bool ret
 {
   // if layer contains the item, delete and remove froms scene, otherwise
   // do nothing
+  if (journal.isRecording() && layer->getItems().contains(item))
+    journal.recordRemove(layer->layerID(), layer->getItems().indexOf(item));
+  markTileDirty(item);
   if(layer->removeItem(item)){
     // record position for screen drift correction
     QPointF old_pos(mapToScene(mapFromParent(rect().center())));
@@ -305,9 +362,73 @@ void gui::DesignPanel::removeItem(prim::Item *item, prim::Layer *layer, bool ret
 
     emit sig_itemRemoved(item);
   }
+}
+
+void gui::DesignPanel::addItems(const QList<prim::Item*> &items, int layer_index,
+    const QVector<int> &indices)
+{
+  // check valid layer index, should not allow access to lattice layer
+  if(layer_index <= 0 || layer_index >= layman->layerCount()){
+    qCritical() << tr("Invalid layer index");
+    return;
+  }
+  if(items.isEmpty())
+    return;
+
+  // record position for screen drift correction
+  QPointF old_pos(mapToScene(mapFromParent(rect().center())));
+
+  // add Items, the scene indexes newly added items lazily on the next query
+  prim::Layer *layer = layman->getLayer(layer_index);
+  for (prim::Item *item : items)
+    markTileDirty(item);
+  if (journal.isRecording()) {
+    int count = layer->getItems().count();
+    for (int i=0; i<items.size(); i++)
+      journal.recordInsert(items[i], layer_index, indices.isEmpty() ? count+i : indices[i]);
+  }
+  layer->addItems(items, indices);
+  for(prim::Item *item : items)
+    scene->addItem(item);
+
+  updateSceneRect();
+
+  // correct screen shift
+  QPointF new_pos(mapToScene(mapFromParent(rect().center())));
+  scrollDelta(new_pos - old_pos);
+}
+
+void gui::DesignPanel::removeItems(const QList<prim::Item*> &items, prim::Layer *layer,
+    bool retain_items)
+{
+  if (journal.isRecording() && !items.isEmpty()) {
+    // removals are replayed one at a time, from the back to keep the indices
+    QSet<prim::Item*> rem_set(items.begin(), items.end());
+    const QStack<prim::Item*> &layer_items = layer->getItems();
+    for (int i=layer_items.size()-1; i>=0; i--)
+      if (rem_set.contains(layer_items[i]))
+        journal.recordRemove(layer->layerID(), i);
+  }
+  for (prim::Item *item : items)
+    markTileDirty(item);
+  if(items.isEmpty() || layer->removeItems(items) == 0)
+    return;
+
+  // record position for screen drift correction
+  QPointF old_pos(mapToScene(mapFromParent(rect().center())));
+
+  for(prim::Item *item : items){
+    scene->removeItem(item);
+    emit sig_itemRemoved(item);
+  }
+  if(!retain_items)
+    qDeleteAll(items);
+
+  updateSceneRect();
 
-  // update item manager
-  itman->updateTableRemove(item);
+  // correct screen shift
+  QPointF new_pos(mapToScene(mapFromParent(rect().center())));
+  scrollDelta(new_pos - old_pos);
 }
 
 void gui::DesignPanel::addItemToScene(prim::Item *item)
@@ -342,6 +463,9 @@ void gui::DesignPanel::fitItemsInView(const bool &include_hidden)
 {
   QRectF rect;
   for (QGraphicsItem *item : scene->items()) {
+    // the density raster bounds are padded to whole occupancy tiles
+    if (item == db_density)
+      continue;
     if (include_hidden || item->isVisible()) {
       rect |= item->sceneBoundingRect();
       qDebug() << rect;
@@ -353,6 +477,21 @@ void gui::DesignPanel::fitItemsInView(const bool &include_hidden)
 }
 
 
+void gui::DesignPanel::informZoomUpdate()
+{
+  qreal zoom = qAbs(transform().m11() + transform().m12());
+  bool low_detail = prim::Item::lowDetail();
+  prim::Item::view_zoom = zoom;
+  if (low_detail != prim::Item::lowDetail()) {
+    // DBs, electrodes and AFM paths change representation
+    if (db_density)
+      db_density->refresh();
+    scene->update();
+  }
+  emit sig_zoom(zoom);
+}
+
+
 QList<prim::Item*> gui::DesignPanel::selectedItems()
 {
   QList<prim::Item*> casted_list;
@@ -388,6 +527,10 @@ void gui::DesignPanel::buildLattice(QString fname)
   }
   qDebug() << tr("Build lattice from file: %1").arg(fname);
 
+  // the density raster refers to the lattice being replaced
+  delete db_density;
+  db_density = nullptr;
+
   if (layman->layerCount() != 0) {
     // if layer manager not empty, clear it
     layman->removeAllLayers();
@@ -413,6 +556,10 @@ void gui::DesignPanel::buildLattice(QString fname)
   // the 2nd lattice is for result display
   layman->addLattice(new prim::Lattice((*lattice), 0), prim::Layer::Result);
   updateBackground();
+
+  // low level-of-detail stand-in for the DBs on the design lattice
+  db_density = new prim::DBDensity(lattice);
+  scene->addItem(db_density);
 }
 
 
@@ -482,48 +629,77 @@ void gui::DesignPanel::setTool(gui::ToolType tool)
   // destroy DB previews
   destroyDBPreviews();
 
+  // drop an unfinished area of interest
+  if (!aoi_draft.isEmpty()) {
+    aoi_draft.clear();
+    updateAreaOfInterestOutline();
+  }
+
   // inform all items of select mode
   prim::Item::tool_type = tool;
 
+  // tools that pass mouse events on to the items
+  bool interactive = true;
   switch(tool){
     case gui::ToolType::SelectTool:
       setDragMode(QGraphicsView::NoDrag);
-      setInteractive(true);
       break;
     case gui::ToolType::DragTool:
       setDragMode(QGraphicsView::ScrollHandDrag);
-      setInteractive(false);
+      interactive = false;
       break;
     case gui::ToolType::DBGenTool:
       layman->setActiveLayer(layman->getMRULayer(prim::Layer::DB));
       setDragMode(QGraphicsView::NoDrag);
-      setInteractive(true);
       break;
     case gui::ToolType::ElectrodeTool:
       layman->setActiveLayer(layman->getMRULayer(prim::Layer::Electrode));
       setDragMode(QGraphicsView::NoDrag);
-      setInteractive(true);
       break;
     case gui::ToolType::ScreenshotAreaTool:
-      setInteractive(true);
       screenman->setClipVisibility(true, true);
       break;
     case gui::ToolType::ScaleBarAnchorTool:
-      setInteractive(true);
       screenman->setScaleBarVisibility(true, true);
       break;
     case gui::ToolType::LabelTool:
-      setInteractive(true);
+      break;
+    case gui::ToolType::AreaOfInterestTool:
+      // vertices are placed on mouse release, items stay unselectable
+      setDragMode(QGraphicsView::NoDrag);
+      interactive = false;
       break;
     default:
       qCritical() << tr("Invalid ToolType... should not have happened");
       return;
   }
 
+  setInteractive(interactive && !edits_blocked);
+
   tool_type = tool;
   emit sig_toolChanged(tool);
 }
 
+void gui::DesignPanel::setEditsBlocked(bool blocked)
+{
+  if (blocked == edits_blocked)
+    return;
+  edits_blocked = blocked;
+  if (blocked) {
+    // drop anything in progress that would edit the design on release
+    if (ghosting)
+      clearGhost();
+    if (rb)
+      rubberBandClear();
+    clicked = false;
+    destroyDBPreviews();
+    setInteractive(false);
+  } else {
+    setInteractive(tool_type != gui::ToolType::DragTool
+        && tool_type != gui::ToolType::AreaOfInterestTool);
+  }
+}
+
 void gui::DesignPanel::setFills(float *fills)
 {
   QList<prim::DBDot *> dbs = getAllDBs();
@@ -543,16 +719,20 @@ void gui::DesignPanel::screenshot(QPainter *painter, const QRectF &region, const
   QList<prim::LatticeDotPreview*> latdot_previews;
   prim::Lattice *lat = static_cast<prim::Lattice*>(layman->getLayer(0, !layman->isSimLayerMode()));
   if (lat->isVisible()) {
-    QList<prim::LatticeCoord> coords = lat->enclosedSites(region);
-    for (prim::LatticeCoord coord : coords) {
+    // pad the region so that partially visible lattice dots are drawn too
+    qreal pad = 0.5 * settings::GUISettings::instance()->get<qreal>(
+        "latdot/diameter") * prim::Item::scale_factor;
+    prim::LatticeSiteWalker walker(lat,
+        QPolygonF(region.adjusted(-pad, -pad, pad, pad)), true);
+    walker.visit([&](const prim::LatticeCoord &coord) {
       if (lat->isOccupied(coord))
-        continue;
+        return;
       prim::LatticeDotPreview *ldp = new prim::LatticeDotPreview(coord);
       ldp->setPos(lat->latticeCoord2ScenePos(coord));
       ldp->setZValue(INT_MIN);
       latdot_previews.append(ldp);
       scene->addItem(ldp);
-    }
+    });
   }
 
   bool clip_reactivate = screenman->clipVisible();
@@ -579,19 +759,168 @@ void gui::DesignPanel::setDisplayMode(DisplayMode mode)
   display_mode = mode;
   prim::Item::display_mode = mode;
 
+  // DBs are drawn larger outside of the design mode
+  for (bool design_layers : {true, false}) {
+    for (prim::Layer *layer : layman->getLayers(prim::Layer::DB, design_layers))
+      static_cast<prim::DBLayer*>(layer)->updateDisplayMode();
+  }
+
   screenman->prepareScreenshotMode(display_mode == ScreenshotMode);
 
   updateBackground();
 }
 
 
+// AREA OF INTEREST
+
+void gui::DesignPanel::setAreaOfInterest(const prim::AreaOfInterest &area)
+{
+  area_of_interest = area.isValid() ? area : prim::AreaOfInterest();
+  updateAreaOfInterestOutline();
+  emit sig_areaOfInterestChanged(area_of_interest);
+}
+
+bool gui::DesignPanel::setAreaOfInterestFromClip()
+{
+  QRectF clip = screenman->clipArea();
+  if (clip.isNull()) {
+    qWarning() << tr("Set a screenshot clip area to use it as the area of interest.");
+    return false;
+  }
+  setAreaOfInterest(prim::AreaOfInterest::fromScenePolygon(QPolygonF(clip),
+        area_of_interest.halo));
+  return true;
+}
+
+QSet<prim::Item*> gui::DesignPanel::areaOfInterestItems(const prim::AreaOfInterest &area)
+{
+  QSet<prim::Item*> area_items;
+  if (!area.isValid()) {
+    qWarning() << tr("No area of interest is set, no items are included.");
+    return area_items;
+  }
+  QPainterPath path = area.scenePath();
+  QRectF bounds = path.boundingRect();
+
+  // the scene only holds the resident tiles of tiled designs
+  if (tiled.isOpen()) {
+    QSet<int> tiled_pos(tile_layer_pos.cbegin(), tile_layer_pos.cend());
+    for (int i=0; i<tiled.tileCount(); i++) {
+      const TiledDesign::Tile &tile = tiled.tile(i);
+      if (!tile.resident && tiled_pos.contains(tile.layer_pos)
+          && tile.scene_rect.intersects(bounds))
+        loadTile(i);
+    }
+  }
+
+  // DBs through the lattice occupancy index, which only visits the sites
+  // within the area bounds, other items by their bounds. Aggregates are
+  // included whole.
+  auto inArea = [&path, &bounds](prim::Item *item)
+  {
+    return item->sceneBoundingRect().intersects(bounds)
+        && path.intersects(item->sceneTransform().map(item->shape()));
+  };
+  qreal db_ext = prim::DBDot::maxExtent();
+  QPolygonF db_bounds(bounds.adjusted(-db_ext, -db_ext, db_ext, db_ext));
+  for (int i=0; i<layman->layerCount(); i++) {
+    prim::Layer *layer = layman->getLayer(i);
+    if (layer->role() != prim::Layer::Design || layer->contentType() == prim::Layer::Lattice)
+      continue;
+    if (layer->contentType() != prim::Layer::DB) {
+      for (prim::Item *item : layer->getItems()) {
+        if (inArea(item))
+          area_items.insert(item);
+      }
+      continue;
+    }
+    prim::Lattice *db_lattice = static_cast<prim::DBLayer*>(layer)->getLattice();
+    for (prim::DBDot *db : db_lattice->dbsInPolygon(db_bounds)) {
+      if (db->layer_id != i || !inArea(db))
+        continue;
+      prim::Item *item = dynamic_cast<prim::Item*>(db->topLevelItem());
+      area_items.insert(item != nullptr ? item : db);
+    }
+  }
+
+  qDebug() << tr("Area of interest: %1 items").arg(area_items.size());
+  return area_items;
+}
+
+void gui::DesignPanel::finishAreaOfInterestDraft()
+{
+  // a double click repeats the vertex placed by its first click
+  while (aoi_draft.size() > 1
+      && QLineF(aoi_draft.last(), aoi_draft[aoi_draft.size()-2]).length() < snap_diameter)
+    aoi_draft.removeLast();
+
+  if (aoi_draft.size() < 3) {
+    qWarning() << tr("An area of interest needs at least 3 vertices.");
+  } else {
+    setAreaOfInterest(prim::AreaOfInterest::fromScenePolygon(aoi_draft,
+          area_of_interest.halo));
+  }
+  aoi_draft.clear();
+  updateAreaOfInterestOutline();
+}
+
+void gui::DesignPanel::updateAreaOfInterestOutline(const QPointF &cursor_scene_pos)
+{
+  if (!area_of_interest.isValid() && aoi_draft.isEmpty()) {
+    if (aoi_outline != nullptr)
+      aoi_outline->setVisible(false);
+    return;
+  }
+
+  if (aoi_outline == nullptr) {
+    aoi_outline = new prim::AreaOfInterestOutline();
+    scene->addItem(aoi_outline);
+  }
+  QPolygonF draft = aoi_draft;
+  if (!draft.isEmpty() && !cursor_scene_pos.isNull())
+    draft.append(cursor_scene_pos);
+  aoi_outline->setArea(area_of_interest);
+  aoi_outline->setDraft(draft);
+  aoi_outline->setVisible(true);
+}
+
+
 // SAVE
 
 void gui::DesignPanel::writeToXmlStream(QXmlStreamWriter *ws,
-                                        DesignInclusionArea inclusion_area)
+                                        DesignInclusionArea inclusion_area,
+                                        const prim::AreaOfInterest &area)
 {
-  // TODO implement inclusion area
+  // tiled designs stream their tiles instead of saving the resident items
+  if (tiled.isOpen() && inclusion_area == IncludeEntireDesign) {
+    if (!sqb::writeSqd(snapshot(inclusion_area), ws))
+      qCritical() << tr("Save: error when writing the tiles of %1").arg(tiled.path());
+    return;
+  }
 
+  writeGUIFlags(ws);
+
+  // save layer properties
+  ws->writeComment("Layer Properties");
+  ws->writeComment("Layer ID is intrinsic to the layer order");
+  ws->writeStartElement("layers");
+  layman->saveLayers(ws);
+  ws->writeEndElement();
+
+  // items in the area of interest
+  QSet<prim::Item*> area_items;
+  if (inclusion_area == IncludeAreaOfInterest)
+    area_items = areaOfInterestItems(area.isValid() ? area : area_of_interest);
+
+  // save item hierarchy
+  ws->writeComment("Item Hierarchy");
+  ws->writeStartElement("design");
+  layman->saveLayerItems(ws, inclusion_area, area_items);
+  ws->writeEndElement(); // end of design node
+}
+
+void gui::DesignPanel::writeGUIFlags(QXmlStreamWriter *ws)
+{
   // save gui flags
   ws->writeComment("GUI Flags");
   ws->writeStartElement("gui");
@@ -612,19 +941,140 @@ void gui::DesignPanel::writeToXmlStream(QXmlStreamWriter *ws,
   ws->writeAttribute("y", QString::number(horizontalScrollBar()->value()));
 
   ws->writeEndElement();  // end of gui node
+}
 
-  // save layer properties
-  ws->writeComment("Layer Properties");
-  ws->writeComment("Layer ID is intrinsic to the layer order");
-  ws->writeStartElement("layers");
-  layman->saveLayers(ws);
-  ws->writeEndElement();
+bool gui::DesignPanel::writeToBinaryStream(sqb::Writer *ws,
+                                           DesignInclusionArea inclusion_area,
+                                           const prim::AreaOfInterest &area)
+{
+  return sqb::writeSqb(snapshot(inclusion_area, area), ws);
+}
 
-  // save item hierarchy
-  ws->writeComment("Item Hierarchy");
-  ws->writeStartElement("design");
-  layman->saveLayerItems(ws, inclusion_area);
-  ws->writeEndElement(); // end of design node
+gui::sqb::DesignSnapshot gui::DesignPanel::snapshot(DesignInclusionArea inclusion_area,
+                                                    const prim::AreaOfInterest &area)
+{
+  sqb::DesignSnapshot snap;
+  snap.float_format = sqb::FloatFormat::fromSettings();
+  snap.tile_cells = tiled.isOpen() ? tiled.tileCells()
+      : settings::AppSettings::instance()->get<int>("save/sqb_tile_cells");
+
+  // gui flags are small and kept as XML
+  QByteArray head;
+  QXmlStreamWriter hs(&head);
+  hs.setAutoFormatting(true);
+  writeGUIFlags(&hs);
+  snap.heads.append(head);
+
+  // layer table, result layers are not saved like in Layer::saveLayer
+  QList<prim::Layer*> save_layers;
+  for (int i=0; i<layman->layerCount(); i++) {
+    prim::Layer *layer = layman->getLayer(i);
+    if (layer->role() == prim::Layer::Result)
+      continue;
+    sqb::LayerRecord rec;
+    rec.name = layer->getName();
+    rec.type = layer->contentTypeString();
+    rec.role = layer->roleString();
+    rec.zoffset = layer->zOffset();
+    rec.zheight = layer->zHeight();
+    rec.visible = layer->isVisible();
+    rec.active = layer->isActive();
+    save_layers.append(layer);
+    snap.layers.append(rec);
+
+    if (layer->contentType() == prim::Layer::Lattice) {
+      prim::Lattice *lattice = static_cast<prim::Lattice*>(layer);
+      snap.lattice.name = lattice->latticeName();
+      snap.lattice.a[0] = lattice->latticeVector(0);
+      snap.lattice.a[1] = lattice->latticeVector(1);
+      for (int j=0; j<lattice->unitCellSiteCount(); j++)
+        snap.lattice.b.append(lattice->siteVector(j));
+      snap.has_lattice = true;
+    }
+  }
+
+  // items in the area of interest
+  QSet<prim::Item*> area_items;
+  if (inclusion_area == IncludeAreaOfInterest)
+    area_items = areaOfInterestItems(area.isValid() ? area : area_of_interest);
+
+  // items of each layer
+  for (int layer_pos=0; layer_pos<save_layers.size(); layer_pos++) {
+    prim::Layer *layer = save_layers[layer_pos];
+    sqb::ItemChunk db_chunk;
+    db_chunk.tag = sqb::DBChunk;
+    db_chunk.dbs.layer_pos = layer_pos;
+    sqb::DBRecord &db_rec = db_chunk.dbs;
+    QList<sqb::ItemChunk> xml_chunks;
+    sqb::ItemChunker chunker(&xml_chunks, layer_pos);
+
+    // DBs of tiled layers are only taken from the scene for edited tiles
+    bool tiled_layer = inclusion_area == IncludeEntireDesign
+        && tile_layer_pos.contains(layer->layerID());
+    QMap<int, sqb::DBRecord> dirty_tiles;
+
+    for (prim::Item *item : layer->getItems()) {
+      if (inclusion_area == IncludeSelectedItems && !item->isSelected())
+        continue;
+      if (inclusion_area == IncludeAreaOfInterest && !area_items.contains(item))
+        continue;
+      quint32 tag;
+      switch (item->item_type) {
+        case prim::Item::DBDot:
+        case prim::Item::Aggregate:
+          // DBs and aggregates go to the packed DB record in save order
+          if (!tiled_layer) {
+            appendDBItem(item, db_rec);
+          } else {
+            int tile_ind = itemTile(item, true);
+            if (tile_ind >= 0 && tiled.tile(tile_ind).dirty)
+              appendDBItem(item, dirty_tiles[tile_ind]);
+          }
+          continue;
+        case prim::Item::Electrode:
+          tag = sqb::ElectrodeChunk;
+          break;
+        case prim::Item::AFMArea:
+        case prim::Item::AFMPath:
+        case prim::Item::AFMNode:
+        case prim::Item::AFMSeg:
+          tag = sqb::AFMChunk;
+          break;
+        case prim::Item::TextLabel:
+          tag = sqb::LabelChunk;
+          break;
+        default:
+          tag = sqb::XmlItemChunk;
+          break;
+      }
+      item->saveItems(chunker.beginItem(tag));
+    }
+    chunker.flush();
+
+    // the DB record of a layer precedes its other items
+    if (tiled_layer) {
+      int file_pos = tile_layer_pos.value(layer->layerID());
+      for (int i=0; i<tiled.tileCount(); i++) {
+        const TiledDesign::Tile &tile = tiled.tile(i);
+        if (tile.layer_pos != file_pos)
+          continue;
+        sqb::ItemChunk tile_chunk = tiled.tileChunk(i, layer_pos);
+        if (tile.dirty && tile.resident) {
+          tile_chunk.dbs = dirty_tiles.value(i);
+          tile_chunk.dbs.layer_pos = layer_pos;
+          tile_chunk.dbs.palette_ids.clear();
+        }
+        if (tile_chunk.tile.isReference() || tile_chunk.dbs.dbCount() > 0)
+          snap.items.append(tile_chunk);
+      }
+    } else {
+      db_rec.palette_ids.clear();
+      if (db_rec.dbCount() > 0)
+        snap.items.append(db_chunk);
+    }
+    snap.items.append(xml_chunks);
+  }
+  return snap;
 }
 
 void gui::DesignPanel::loadFromFile(QXmlStreamReader *rs, bool is_sim_result)
@@ -673,6 +1123,604 @@ void gui::DesignPanel::loadFromFile(QXmlStreamReader *rs, bool is_sim_result)
     qCritical() << tr("XML error: ") << rs->errorString().data();
   }
 
+  finishLoad(visrect, is_sim_result);
+}
+
+void gui::DesignPanel::loadFromFile(sqb::Reader *rs, bool is_sim_result)
+{
+  // hands the parsed parts straight to the descriptor load
+  class PanelLoadSink : public sqb::DesignSink
+  {
+  public:
+    PanelLoadSink(DesignPanel *dp) : dp(dp) {}
+    void head(const QByteArray &xml) override {dp->loadHead(xml);}
+    void lattice(const sqb::LatticeRecord &lat) override {dp->loadLatticeRecord(lat);}
+    void layers(const QList<sqb::LayerRecord> &layers) override {dp->loadLayerTable(layers);}
+    bool items(const sqb::ItemChunk &chunk) override {dp->loadItemChunk(chunk); return true;}
+  private:
+    DesignPanel *dp;
+  };
+
+  beginDescriptorLoad(is_sim_result);
+
+  PanelLoadSink sink(this);
+  sqb::ParseOptions opts = sqb::ParseOptions::fromSettings();
+  opts.batch_dbs = 0;
+  QString err;
+  if (sqb::parseSqb(rs, &sink, opts, err) != sqb::ParseOk)
+    qCritical() << tr("SQB error: %1").arg(err);
+
+  endDescriptorLoad();
+}
+
+void gui::DesignPanel::beginDescriptorLoad(bool is_sim_result)
+{
+  if (!is_sim_result) {
+    // reset the design panel state
+    resetDesignPanel("", false);
+  }
+
+  desc_is_sim_result = is_sim_result;
+  desc_layer_order.clear();
+  desc_visrect = QRectF();
+
+  // the scene index is rebuilt once at the end instead of per item
+  scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+}
+
+void gui::DesignPanel::loadHead(const QByteArray &xml)
+{
+  QXmlStreamReader hrs(QByteArray("<siqad>") + xml + QByteArray("</siqad>"));
+  hrs.readNextStartElement();
+  while (hrs.readNextStartElement()) {
+    if (hrs.name().toString() == "gui" && !desc_is_sim_result)
+      loadGUIFlags(&hrs, desc_visrect);
+    else
+      hrs.skipCurrentElement();
+  }
+}
+
+void gui::DesignPanel::loadLatticeRecord(const sqb::LatticeRecord &lat)
+{
+  layman->getLattice(!desc_is_sim_result)->constructFromParams(lat.name, lat.b,
+      QVector<QPointF>({lat.a[0], lat.a[1]}));
+}
+
+void gui::DesignPanel::loadLayerTable(const QList<sqb::LayerRecord> &layers)
+{
+  for (const sqb::LayerRecord &rec : layers) {
+    loadLayer(rec.name,
+        static_cast<prim::Layer::LayerType>(QMetaEnum::fromType<prim::Layer::LayerType>()
+          .keyToValue(rec.type.toStdString().c_str())),
+        static_cast<prim::Layer::LayerRole>(QMetaEnum::fromType<prim::Layer::LayerRole>()
+          .keyToValue(rec.role.toStdString().c_str())),
+        rec.zoffset, rec.zheight, rec.visible, rec.active,
+        desc_layer_order, desc_is_sim_result);
+  }
+}
+
+void gui::DesignPanel::loadItemChunk(const sqb::ItemChunk &chunk)
+{
+  // resolve the layer of the chunk, skipped layers have no ID
+  int layer_pos = chunk.layerPos();
+  if (layer_pos < 0 || layer_pos >= desc_layer_order.size()
+      || desc_layer_order[layer_pos] == -1)
+    return;
+  prim::Layer *layer = layman->getLayer(desc_layer_order[layer_pos], !desc_is_sim_result);
+  if (layer == nullptr)
+    return;
+
+  if (chunk.tag == sqb::DBChunk) {
+    if (layer->contentType() == prim::Layer::DB)
+      loadDBRecord(chunk.dbs, layer);
+  } else {
+    // items kept as XML are read by their own XML constructors
+    QXmlStreamReader xrs(sqb::wrapLayerFragment(chunk.xml.xml));
+    xrs.readNextStartElement();
+    layer->loadItems(&xrs, scene);
+  }
+}
+
+void gui::DesignPanel::showLoadedRegion()
+{
+  if (!desc_visrect.isNull())
+    fitInView(desc_visrect, Qt::KeepAspectRatio);
+}
+
+void gui::DesignPanel::endDescriptorLoad()
+{
+  scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+  finishLoad(desc_visrect, desc_is_sim_result);
+}
+
+bool gui::DesignPanel::applyJournalRecord(const QByteArray &record)
+{
+  QDataStream in(record);
+  in.setVersion(QDataStream::Qt_6_0);
+  in.setByteOrder(QDataStream::LittleEndian);
+
+  while (!in.atEnd()) {
+    quint8 op;
+    qint32 layer_id, index;
+    in >> op >> layer_id >> index;
+    prim::Layer *layer = (in.status() == QDataStream::Ok && layer_id > 0
+        && layer_id < layman->layerCount()) ? layman->getLayer(layer_id) : nullptr;
+    int count = layer ? layer->getItems().count() : 0;
+    bool replaces = op == DesignJournal::RemoveItem || op == DesignJournal::UpdateItem;
+    if (layer == nullptr || index < 0 || index > count || (replaces && index == count)) {
+      qCritical() << tr("Journal: invalid edit of item %1 in layer %2").arg(index).arg(layer_id);
+      return false;
+    }
+    prim::Lattice *db_lattice = layer->contentType() == prim::Layer::DB
+        ? static_cast<prim::DBLayer*>(layer)->getLattice() : nullptr;
+
+    // an update replaces the item by its recorded state
+    if (replaces) {
+      prim::Item *item = layer->getItem(index);
+      if (db_lattice)
+        releaseLatticeSites(item, db_lattice);
+      removeItem(item, layer);
+      count--;
+    }
+    if (op == DesignJournal::RemoveItem)
+      continue;
+
+    quint8 payload;
+    in >> payload;
+    if (payload == DesignJournal::DBPayload) {
+      qint32 n, m, l;
+      quint32 rgba;
+      in >> n >> m >> l >> rgba;
+      prim::LatticeCoord lc(n, m, l);
+      if (!db_lattice || db_lattice->isOccupied(lc)) {
+        qCritical() << tr("Journal: can't place DB at (%1, %2, %3)").arg(n).arg(m).arg(l);
+        return false;
+      }
+      prim::DBDot *db = new prim::DBDot(lc, layer_id);
+      db->setColor(QColor::fromRgba(rgba));
+      db_lattice->setOccupied(lc, db);
+      moveDBToLatticeCoord(db, lc.n, lc.m, lc.l);
+      layer->addItem(db, index);
+      scene->addItem(db);
+    } else {
+      // other items are read by the layer, which appends them
+      QByteArray xml;
+      in >> xml;
+      QXmlStreamReader xrs(sqb::wrapLayerFragment(xml));
+      xrs.readNextStartElement();
+      layer->loadItems(&xrs, scene);
+      if (layer->getItems().count() != count+1) {
+        qCritical() << tr("Journal: failed to restore item %1 in layer %2").arg(index).arg(layer_id);
+        return false;
+      }
+      if (index < count)
+        layer->addItem(layer->takeItem(count), index);
+    }
+  }
+
+  if (in.status() != QDataStream::Ok) {
+    qCritical() << tr("Journal: truncated record");
+    return false;
+  }
+  updateSceneRect();
+  return true;
+}
+
+void gui::DesignPanel::loadDBRecord(const sqb::DBRecord &rec, prim::Layer *layer)
+{
+  prim::Lattice *db_lattice = static_cast<prim::DBLayer*>(layer)->getLattice();
+  int lay_id = layer->layerID();
+  QVector<QColor> palette;
+  for (QRgb rgb : rec.palette)
+    palette.append(QColor::fromRgba(rgb));
+
+  auto create_db = [&](int i) {
+    const qint32 *c = rec.coords.constData() + 3*i;
+    prim::LatticeCoord lc(c[0], c[1], c[2]);
+    prim::DBDot *dbdot = new prim::DBDot(lc, lay_id);
+    dbdot->setColor(palette[rec.color_ids.isEmpty() ? 0 : rec.color_ids[i]]);
+    db_lattice->setOccupied(lc, dbdot);
+    moveDBToLatticeCoord(dbdot, lc.n, lc.m, lc.l);
+    return dbdot;
+  };
+
+  // rebuild the item hierarchy, top level items are added in one pass
+  QList<prim::Item*> top_items;
+  QStack<QStack<prim::Item*>> open_aggs;
+  int db_ind = 0;
+  auto add_item = [&](prim::Item *item) {
+    if (open_aggs.isEmpty())
+      top_items.append(item);
+    else
+      open_aggs.top().push(item);
+  };
+
+  if (rec.structure.isEmpty()) {
+    for (; db_ind < rec.dbCount(); db_ind++)
+      add_item(create_db(db_ind));
+  }
+  for (qint32 token : rec.structure) {
+    if (token == sqb::OpenAggregate) {
+      open_aggs.push(QStack<prim::Item*>());
+    } else if (token == sqb::CloseAggregate && !open_aggs.isEmpty()) {
+      QStack<prim::Item*> children = open_aggs.pop();
+      add_item(new prim::Aggregate(lay_id, children));
+    } else {
+      for (int i=0; i<token && db_ind < rec.dbCount(); i++)
+        add_item(create_db(db_ind++));
+    }
+  }
+
+  layer->addItems(top_items);
+  for (prim::Item *item : top_items)
+    scene->addItem(item);
+}
+
+void gui::DesignPanel::appendDBItem(prim::Item *item, sqb::DBRecord &rec)
+{
+  if (item->item_type == prim::Item::DBDot) {
+    prim::DBDot *db = static_cast<prim::DBDot*>(item);
+    prim::LatticeCoord lc = db->latticeCoord();
+    rec.append(lc.n, lc.m, lc.l, db->getCurrentFillColor().rgba());
+    rec.appendStructure(1);
+  } else if (item->item_type == prim::Item::Aggregate) {
+    rec.appendStructure(sqb::OpenAggregate);
+    for (prim::Item *child : static_cast<prim::Aggregate*>(item)->getChildren())
+      appendDBItem(child, rec);
+    rec.appendStructure(sqb::CloseAggregate);
+  }
+}
+
+bool gui::DesignPanel::openTiled(const QString &path)
+{
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  TiledDesign opened;
+  sqb::DesignSnapshot base;
+  QString err;
+  if (!opened.open(path, app_settings->get<qint64>("load/tiled_min_dbs"), base, err)) {
+    if (!err.isEmpty())
+      qWarning() << tr("Tiles: can't open %1 as a tiled design: %2").arg(path).arg(err);
+    return false;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // everything but the DB tiles is loaded right away
+  beginDescriptorLoad();
+  for (const QByteArray &head : base.heads)
+    loadHead(head);
+  if (base.has_lattice)
+    loadLatticeRecord(base.lattice);
+  loadLayerTable(base.layers);
+  for (const sqb::ItemChunk &chunk : base.items)
+    loadItemChunk(chunk);
+
+  tiled = opened;
+  for (int layer_pos=0; layer_pos<desc_layer_order.size(); layer_pos++) {
+    int layer_id = desc_layer_order[layer_pos];
+    if (layer_id != -1 && layman->getLayer(layer_id)->contentType() == prim::Layer::DB)
+      tile_layer_pos.insert(layer_id, layer_pos);
+  }
+
+  // the scene covers all tiles so that the view can move to unloaded ones
+  QRectF tiles_rect;
+  for (int i=0; i<tiled.tileCount(); i++) {
+    TiledDesign::Tile &tile = tiled.tile(i);
+    tile.scene_rect = tileSceneRect(tile.tx, tile.ty);
+    tiles_rect |= tile.scene_rect;
+  }
+  min_scene_rect |= tiles_rect;
+
+  endDescriptorLoad();
+  updateResidentTiles();
+
+  qDebug() << tr("Tiles: opened %1 with %2 DBs in %3 tiles of %4 cells in %5 ms")
+      .arg(path).arg(tiled.storedDBCount()).arg(tiled.tileCount())
+      .arg(tiled.tileCells()).arg(timer.elapsed());
+  return true;
+}
+
+void gui::DesignPanel::rebaseTiles(const QString &path)
+{
+  if (!tiled.isOpen())
+    return;
+
+  // DB layers at their position in the saved layer table, see snapshot()
+  QHash<int,int> new_layer_pos;
+  QHash<int,int> pos_map;
+  int layer_pos = 0;
+  for (int i=0; i<layman->layerCount(); i++) {
+    prim::Layer *layer = layman->getLayer(i);
+    if (layer->role() == prim::Layer::Result)
+      continue;
+    if (layer->contentType() == prim::Layer::DB) {
+      new_layer_pos.insert(layer->layerID(), layer_pos);
+      if (tile_layer_pos.contains(layer->layerID()))
+        pos_map.insert(tile_layer_pos.value(layer->layerID()), layer_pos);
+    }
+    layer_pos++;
+  }
+
+  QString err;
+  if (!tiled.rebase(path, pos_map, err)) {
+    qCritical() << tr("Tiles: can't switch to %1, staying with %2: %3")
+        .arg(path).arg(tiled.path()).arg(err);
+    return;
+  }
+  tile_layer_pos = new_layer_pos;
+  for (int i=0; i<tiled.tileCount(); i++) {
+    TiledDesign::Tile &tile = tiled.tile(i);
+    if (tile.scene_rect.isNull())
+      tile.scene_rect = tileSceneRect(tile.tx, tile.ty);
+  }
+  qDebug() << tr("Tiles: design now backed by %1").arg(path);
+}
+
+void gui::DesignPanel::updateResidentTiles()
+{
+  if (!tiled.isOpen())
+    return;
+
+  // items can't be evicted while they are being dragged or pasted
+  if (moving || pasting || resizing) {
+    tile_timer.start();
+    return;
+  }
+
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  qint64 budget = app_settings->get<qint64>("load/tile_budget_dbs");
+  qreal margin = app_settings->get<qreal>("load/tile_margin");
+  int time_slice_ms = qMax(1, app_settings->get<int>("load/time_slice_ms"));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // tiles around the view, unloaded ones nearest to the view center first
+  QRectF view = mapToScene(viewport()->rect()).boundingRect();
+  QRectF wanted = view.adjusted(-margin*view.width(), -margin*view.height(),
+      margin*view.width(), margin*view.height());
+  QSet<int> tiled_pos(tile_layer_pos.cbegin(), tile_layer_pos.cend());
+  QSet<int> wanted_tiles;
+  QList<QPair<qreal,int>> to_load;
+  qint64 load_dbs = 0;
+  for (int i=0; i<tiled.tileCount(); i++) {
+    TiledDesign::Tile &tile = tiled.tile(i);
+    if (!tiled_pos.contains(tile.layer_pos) || !tile.scene_rect.intersects(wanted))
+      continue;
+    wanted_tiles.insert(i);
+    if (tile.resident) {
+      tiled.touch(i);
+    } else {
+      to_load.append(qMakePair(QLineF(tile.scene_rect.center(), view.center()).length(), i));
+      load_dbs += tile.has_overlay ? tile.overlay.dbCount() : tile.db_count;
+    }
+  }
+  std::sort(to_load.begin(), to_load.end());
+
+  // undo commands refer to items by their stack index, only tiles whose items
+  // all lie above the indices the undo history may refer to can be evicted
+  // without shifting them
+  QHash<int,int> unpinned_items;
+  for (auto it = tile_layer_pos.constBegin(); it != tile_layer_pos.constEnd(); ++it) {
+    prim::Layer *layer = layman->getLayer(it.key());
+    if (layer == nullptr || !undo_pins.pinsLayer(it.key()))
+      continue;
+    const QStack<prim::Item*> &items = layer->getItems();
+    for (int i=undo_pins.pin(it.key()); i<items.size(); i++)
+      unpinned_items[itemTile(items[i], false)]++;
+  }
+  auto evictable = [&](int tile_ind) {
+    if (!undo_pins.pinsLayer(tile_layer_pos.key(tiled.tile(tile_ind).layer_pos, -1)))
+      return true;
+    return unpinned_items.value(tile_ind) == tileItems(tile_ind).size();
+  };
+
+  // make room by evicting tiles out of view, least recently used first
+  QList<QPair<quint64,int>> lru;
+  for (int i=0; i<tiled.tileCount(); i++)
+    if (tiled.tile(i).resident && !wanted_tiles.contains(i))
+      lru.append(qMakePair(tiled.tile(i).last_used, i));
+  std::sort(lru.begin(), lru.end());
+  QList<int> evict;
+  qint64 evict_dbs = 0;
+  int pinned = 0;
+  for (const QPair<quint64,int> &entry : lru) {
+    if (resident_dbs - evict_dbs + load_dbs <= budget)
+      break;
+    if (!evictable(entry.second)) {
+      pinned++;
+      continue;
+    }
+    evict.append(entry.second);
+    evict_dbs += tiled.tile(entry.second).db_count;
+  }
+  for (int i : evict)
+    evictTile(i);
+
+  // load the wanted tiles within the budget, one time slice per pass
+  int loaded = 0;
+  for (const QPair<qreal,int> &entry : to_load) {
+    const TiledDesign::Tile &tile = tiled.tile(entry.second);
+    qint64 tile_dbs = tile.has_overlay ? tile.overlay.dbCount() : tile.db_count;
+    if (resident_dbs > 0 && resident_dbs + tile_dbs > budget) {
+      qDebug() << tr("Tiles: the view holds more DBs than the tile budget, "
+          "showing the nearest tiles");
+      break;
+    }
+    if (timer.elapsed() > time_slice_ms) {
+      QTimer::singleShot(0, this, &gui::DesignPanel::updateResidentTiles);
+      break;
+    }
+    if (loadTile(entry.second))
+      loaded++;
+  }
+
+  if (pinned > 0)
+    qDebug() << tr("Tiles: %1 tiles out of view kept for the undo history").arg(pinned);
+  if (loaded > 0 || !evict.isEmpty())
+    qDebug() << tr("Tiles: loaded %1 and evicted %2 tiles in %3 ms, %4 DBs resident")
+        .arg(loaded).arg(evict.size()).arg(timer.elapsed()).arg(resident_dbs);
+}
+
+bool gui::DesignPanel::loadTile(int tile_ind)
+{
+  TiledDesign::Tile &tile = tiled.tile(tile_ind);
+  prim::Layer *layer = layman->getLayer(tile_layer_pos.key(tile.layer_pos, -1));
+  sqb::DBRecord rec;
+  QString err;
+  if (layer == nullptr || !tiled.readTile(tile_ind, rec, err)) {
+    qCritical() << tr("Tiles: can't load tile (%1, %2): %3").arg(tile.tx).arg(tile.ty).arg(err);
+    return false;
+  }
+
+  // the journal doesn't see tile loads, the next autosave is a checkpoint
+  journal.invalidate();
+  loadDBRecord(rec, layer);
+
+  // edited DBs of the tile are saved from the scene again
+  tile.has_overlay = false;
+  tile.overlay = sqb::DBRecord();
+  tile.resident = true;
+  tiled.touch(tile_ind);
+  resident_dbs += rec.dbCount();
+  if (db_density)
+    db_density->refresh();
+  return true;
+}
+
+void gui::DesignPanel::pinUndoReferencedItems()
+{
+  // commands refer to indices below the item count of the layers at the time
+  // they run, tiles loaded since are appended above
+  QHash<int,int> layer_counts;
+  for (auto it = tile_layer_pos.constBegin(); it != tile_layer_pos.constEnd(); ++it) {
+    prim::Layer *layer = layman->getLayer(it.key());
+    if (layer != nullptr)
+      layer_counts.insert(it.key(), layer->getItems().size());
+  }
+  undo_pins.update(undo_stack, layer_counts);
+}
+
+void gui::DesignPanel::evictTile(int tile_ind)
+{
+  TiledDesign::Tile &tile = tiled.tile(tile_ind);
+  prim::Layer *layer = layman->getLayer(tile_layer_pos.key(tile.layer_pos, -1));
+  if (layer == nullptr)
+    return;
+  QList<prim::Item*> items = tileItems(tile_ind);
+
+  // edited DBs are kept until the tile is loaded again or saved
+  if (tile.dirty) {
+    tile.overlay = sqb::DBRecord();
+    tile.overlay.layer_pos = tile.layer_pos;
+    for (prim::Item *item : items)
+      appendDBItem(item, tile.overlay);
+    tile.overlay.palette_ids.clear();
+    tile.has_overlay = true;
+  }
+
+  journal.invalidate();
+  prim::Lattice *db_lattice = static_cast<prim::DBLayer*>(layer)->getLattice();
+  qint64 evicted_dbs = 0;
+  for (prim::Item *item : items) {
+    releaseLatticeSites(item, db_lattice);
+    evicted_dbs += item->item_type == prim::Item::DBDot
+        ? 1 : static_cast<prim::Aggregate*>(item)->dbCount();
+    scene->removeItem(item);
+    emit sig_itemRemoved(item);
+  }
+  layer->removeItems(items);
+  qDeleteAll(items);
+
+  tile.resident = false;
+  resident_dbs = qMax<qint64>(0, resident_dbs - evicted_dbs);
+  if (db_density)
+    db_density->refresh();
+}
+
+int gui::DesignPanel::itemTile(prim::Item *item, bool create)
+{
+  if (!tiled.isOpen() || !tile_layer_pos.contains(item->layer_id))
+    return -1;
+
+  // aggregates belong to the tile of their first DB
+  prim::Item *first = item;
+  while (first && first->item_type == prim::Item::Aggregate) {
+    QStack<prim::Item*> &children = static_cast<prim::Aggregate*>(first)->getChildren();
+    first = children.isEmpty() ? nullptr : children.first();
+  }
+  if (first == nullptr || first->item_type != prim::Item::DBDot)
+    return -1;
+
+  prim::LatticeCoord lc = static_cast<prim::DBDot*>(first)->latticeCoord();
+  int tile_ind = tiled.tileIndex(tile_layer_pos.value(item->layer_id), lc.n, lc.m, create);
+  if (tile_ind >= 0 && tiled.tile(tile_ind).scene_rect.isNull()) {
+    TiledDesign::Tile &tile = tiled.tile(tile_ind);
+    tile.scene_rect = tileSceneRect(tile.tx, tile.ty);
+  }
+  return tile_ind;
+}
+
+void gui::DesignPanel::markTileDirty(prim::Item *item)
+{
+  int tile_ind = itemTile(item, true);
+  if (tile_ind < 0)
+    return;
+
+  // DBs placed in an evicted tile join its stored ones
+  if (!tiled.tile(tile_ind).resident)
+    loadTile(tile_ind);
+  tiled.tile(tile_ind).dirty = true;
+}
+
+QRectF gui::DesignPanel::tileSceneRect(qint32 tx, qint32 ty) const
+{
+  qint32 cells = tiled.tileCells();
+  QPolygonF corners;
+  for (qint32 n : {tx*cells, (tx+1)*cells})
+    for (qint32 m : {ty*cells, (ty+1)*cells})
+      corners << lattice->latticeCoord2ScenePos(prim::LatticeCoord(n, m, 0));
+
+  // sites of the outermost unit cells reach past the corners
+  QPointF cell = lattice->latticeCoord2ScenePos(prim::LatticeCoord(1, 1, 0))
+      - lattice->latticeCoord2ScenePos(prim::LatticeCoord(0, 0, 0));
+  qreal pad = qAbs(cell.x()) + qAbs(cell.y());
+  return corners.boundingRect().adjusted(-pad, -pad, pad, pad);
+}
+
+QList<prim::Item*> gui::DesignPanel::tileItems(int tile_ind)
+{
+  const TiledDesign::Tile &tile = tiled.tile(tile_ind);
+  int layer_id = tile_layer_pos.key(tile.layer_pos, -1);
+  QList<prim::Item*> items;
+  QSet<prim::Item*> seen;
+  for (QGraphicsItem *gitem : scene->items(tile.scene_rect, Qt::IntersectsItemBoundingRect)) {
+    prim::Item *item = dynamic_cast<prim::Item*>(gitem->topLevelItem());
+    if (item == nullptr || item->layer_id != layer_id || seen.contains(item)
+        || (item->item_type != prim::Item::DBDot && item->item_type != prim::Item::Aggregate))
+      continue;
+    seen.insert(item);
+    if (itemTile(item, false) == tile_ind)
+      items.append(item);
+  }
+  return items;
+}
+
+void gui::DesignPanel::releaseLatticeSites(prim::Item *item, prim::Lattice *db_lattice)
+{
+  if (item->item_type == prim::Item::DBDot) {
+    prim::DBDot *db = static_cast<prim::DBDot*>(item);
+    if (db_lattice->dbAt(db->latticeCoord()) == db)
+      db_lattice->setUnoccupied(db->latticeCoord());
+  } else if (item->item_type == prim::Item::Aggregate) {
+    for (prim::Item *child : static_cast<prim::Aggregate*>(item)->getChildren())
+      releaseLatticeSites(child, db_lattice);
+  }
+}
+
+void gui::DesignPanel::finishLoad(const QRectF &visrect, bool is_sim_result)
+{
   if (!is_sim_result) {
     initLayers();   // init missing layers
   }
@@ -696,6 +1744,43 @@ void gui::DesignPanel::loadFromFile(QXmlStreamReader *rs, bool is_sim_result)
   if (!is_sim_result) {
     layman->populateLayerTable();
   }
+
+  // the loaded DBs bypass the undo stack
+  if (db_density)
+    db_density->refresh();
+}
+
+
+void gui::DesignPanel::invalidateDBDensity()
+{
+  if (db_density)
+    db_density->invalidate();
+}
+
+
+void gui::DesignPanel::connectDBLayerVisibility()
+{
+  for (prim::Layer *layer : layman->getLayers(prim::Layer::DB))
+    connect(layer, &prim::Layer::sig_visibilityChanged,
+            this, &DesignPanel::invalidateDBDensity, Qt::UniqueConnection);
+}
+
+
+void gui::DesignPanel::itemPropertiesChanged(prim::Item *item)
+{
+  // the journal and tiles track the items of the layer stacks
+  prim::Item *top = static_cast<prim::Item*>(item->topLevelItem());
+  prim::Layer *layer = layman->getLayer(top->layer_id);
+  int index = layer ? layer->getItems().indexOf(top) : -1;
+  if (index < 0) {
+    qWarning() << tr("Edited item isn't in a design layer, the edit isn't "
+        "recorded for autosave");
+  } else {
+    markTileDirty(top);
+    journal.recordUpdate(top, top->layer_id, index);
+  }
+  design_revision++;
+  undo_stack->resetClean();
 }
 
 
@@ -790,6 +1875,16 @@ void gui::DesignPanel::loadLayerProps(QXmlStreamReader *rs,
     }
   }
 
+  loadLayer(layer_nm, layer_type, layer_role, zoffset, zheight, layer_visible,
+      layer_active, layer_order_id, is_sim_result);
+}
+
+
+void gui::DesignPanel::loadLayer(const QString &layer_nm,
+    prim::Layer::LayerType layer_type, prim::Layer::LayerRole layer_role,
+    float zoffset, float zheight, bool layer_visible, bool layer_active,
+    QList<int> &layer_order_id, bool is_sim_result)
+{
   if (is_sim_result) {
     if (layer_role != prim::Layer::Design) {
       qDebug() << tr("Loading design from simulation problem, skipping layer %1"
@@ -902,8 +1997,6 @@ void gui::DesignPanel::loadDesign(QXmlStreamReader *rs, QList<int> &layer_order_
       rs->skipCurrentElement();
     }
   }
-
-  itman->updateTableAdd();
 }
 
 
@@ -1022,9 +2115,15 @@ void gui::DesignPanel::updateBackground()
     lattice_visible = false;
   }
 
-  if (lattice_visible)
-    scene->setBackgroundBrush(QBrush(lat->tileableLatticeImage(col, display_mode == gui::ScreenshotMode)));
-  else
+  if (lattice_visible) {
+    // publish mode tiles end up in screenshots, never render them below scene
+    // resolution
+    bool publish = display_mode == gui::ScreenshotMode;
+    qreal device_zoom = qAbs(transform().m11() + transform().m12()) * devicePixelRatioF();
+    if (publish)
+      device_zoom = qMax(device_zoom, 1.);
+    scene->setBackgroundBrush(lat->backgroundBrush(col, publish, device_zoom));
+  } else
     scene->setBackgroundBrush(QBrush(col));
 }
 
@@ -1043,6 +2142,13 @@ void gui::DesignPanel::mousePressEvent(QMouseEvent *e)
 {
   Qt::KeyboardModifiers keymods = QApplication::keyboardModifiers();
 
+  // only panning is left while edits are blocked
+  if (edits_blocked && e->button() != Qt::MiddleButton
+      && !(e->button() == Qt::LeftButton && tool_type == DragTool)) {
+    QGraphicsView::mousePressEvent(e);
+    return;
+  }
+
   // set clicked flag and store current mouse position for move behaviour
   clicked = true;
   press_scene_pos = mapToScene(e->pos()).toPoint();
@@ -1115,7 +2221,10 @@ void gui::DesignPanel::mouseMoveEvent(QMouseEvent *e)
     prim::LatticeCoord offset;
     if (snapGhost(scene_pos, offset)) // if there are db dots
       prim::Ghost::instance()->moveByCoord(offset, lattice);
-  } else if (!clicked && tool_type == DBGenTool) {
+  } else if (!clicked && tool_type == AreaOfInterestTool && !aoi_draft.isEmpty()) {
+    // preview the edge to the next vertex
+    updateAreaOfInterestOutline(mapToScene(e->pos()));
+  } else if (!clicked && tool_type == DBGenTool && !edits_blocked) {
     QPoint cursor_pos = mapToScene(e->pos()).toPoint();
     QPoint cursor_offset = cursor_pos - press_scene_pos;
     if (cursor_offset.manhattanLength() > snap_diameter) {
@@ -1131,7 +2240,14 @@ void gui::DesignPanel::mouseMoveEvent(QMouseEvent *e)
             tool_type == ScreenshotAreaTool || tool_type == LabelTool) {
           rubberBandUpdate(e->pos());
         } else if (tool_type == DBGenTool) {
-          createDBPreviews(lattice->enclosedSites(coord_start, lattice->nearestSite(mapToScene(e->pos()), true)));
+          // preview the sites in the lattice index range spanned by the start
+          // and current snapped sites, nothing to walk if it is fully occupied
+          prim::LatticeCoord coord_end = lattice->nearestSite(mapToScene(e->pos()), true);
+          destroyDBPreviews();
+          if (lattice->firstFreeSite(coord_start, coord_end).l >= 0) {
+            lattice->visitSiteRange(coord_start, coord_end,
+                [this](const prim::LatticeCoord &coord) {appendDBPreview(coord);});
+          }
         }
         // use default behaviour for left mouse button
         QGraphicsView::mouseMoveEvent(e);
@@ -1217,6 +2333,11 @@ void gui::DesignPanel::mouseReleaseEvent(QMouseEvent *e)
             // create a label with the rubberband area
             createTextLabel(rb_scene_rect);
             break;
+          case gui::ToolType::AreaOfInterestTool:
+            // add a vertex to the area being drawn
+            aoi_draft.append(mapToScene(e->pos()));
+            updateAreaOfInterestOutline();
+            break;
           case gui::ToolType::DragTool:
             // pan ends
             break;
@@ -1247,6 +2368,11 @@ void gui::DesignPanel::mouseReleaseEvent(QMouseEvent *e)
 
 void gui::DesignPanel::mouseDoubleClickEvent(QMouseEvent *e)
 {
+  // a double click closes the area being drawn at the vertex just placed
+  if (tool_type == AreaOfInterestTool && e->button() == Qt::LeftButton) {
+    finishAreaOfInterestDraft();
+    return;
+  }
   QGraphicsView::mouseDoubleClickEvent(e);
 }
 
@@ -1278,7 +2404,7 @@ void gui::DesignPanel::wheelEvent(QWheelEvent *e)
 void gui::DesignPanel::keyPressEvent(QKeyEvent *e)
 {
   //if an item is selected, move the item instead of scrolling the view.
-  if (!selectedItems().isEmpty()) {
+  if (!edits_blocked && !selectedItems().isEmpty()) {
     QPointF offset(0,0);
     switch(e->key()){
       case Qt::Key_Up:
@@ -1353,6 +2479,15 @@ void gui::DesignPanel::keyReleaseEvent(QKeyEvent *e)
           emit sig_toolChangeRequest(gui::ToolType::SelectTool);
         }
         break;
+      case Qt::Key_Return:
+      case Qt::Key_Enter:
+        // close the area being drawn
+        if (tool_type == gui::ToolType::AreaOfInterestTool) {
+          finishAreaOfInterestDraft();
+          break;
+        }
+        QGraphicsView::keyReleaseEvent(e);
+        break;
       default:
         QGraphicsView::keyReleaseEvent(e);
         break;
@@ -1380,7 +2515,7 @@ void gui::DesignPanel::constructStatics()
 
 void gui::DesignPanel::duplicateSelection()
 {
-  if (selectedItems().isEmpty())
+  if (edits_blocked || selectedItems().isEmpty())
     return;
 
   // raise prompt
@@ -1462,10 +2597,13 @@ void gui::DesignPanel::applyZoom(qreal ds, QWheelEvent *e)
     updateSceneRect();
   }
 
-  // update background if lattice visibility threshold has been crossed
+  // update background if lattice visibility threshold or the background tile
+  // zoom bucket has been crossed, tiles are served from the lattice cache
   qreal new_zoom = qAbs(transform().m11() + transform().m12());
   if ((old_zoom < zoom_visibility_threshold && zoom_visibility_threshold <= new_zoom)
-      || (new_zoom < zoom_visibility_threshold && zoom_visibility_threshold <= old_zoom))
+      || (new_zoom < zoom_visibility_threshold && zoom_visibility_threshold <= old_zoom)
+      || prim::Lattice::backgroundZoomBucket(old_zoom * devicePixelRatioF())
+          != prim::Lattice::backgroundZoomBucket(new_zoom * devicePixelRatioF()))
     updateBackground();
 
   informZoomUpdate();
@@ -1546,6 +2684,8 @@ void gui::DesignPanel::scrollDelta(QPointF delta)
 
 void gui::DesignPanel::contextMenuEvent(QContextMenuEvent *e)
 {
+  if (edits_blocked)
+    return;
   if (!clipboard.isEmpty()) { //not empty, enable pasting
     action_paste->setEnabled(true);
   } else {
@@ -1594,16 +2734,22 @@ void gui::DesignPanel::contextMenuEvent(QContextMenuEvent *e)
 
 void gui::DesignPanel::undoAction()
 {
+    if (edits_blocked)
+      return;
     undo_stack->undo();
 }
 
 void gui::DesignPanel::redoAction()
 {
+    if (edits_blocked)
+      return;
     undo_stack->redo();
 }
 
 void gui::DesignPanel::cutAction()
 {
+    if (edits_blocked)
+      return;
     copySelection();
     deleteSelection();
 }
@@ -1615,12 +2761,16 @@ void gui::DesignPanel::copyAction()
 
 void gui::DesignPanel::pasteAction()
 {
+    if (edits_blocked)
+      return;
     if(!clipboard.isEmpty() && display_mode == DesignMode)
       createGhost(true);
 }
 
 void gui::DesignPanel::deleteAction()
 {
+  if (edits_blocked)
+    return;
   if(tool_type == gui::ToolType::SelectTool && display_mode == DesignMode) {
     qDebug() << "Delete action invoked";
     deleteSelection();
@@ -1906,14 +3056,18 @@ void gui::DesignPanel::createDBPreviews(QList<prim::LatticeCoord> coords)
 
 void gui::DesignPanel::appendDBPreviews(QList<prim::LatticeCoord> coords)
 {
-  for (prim::LatticeCoord coord : coords) {
-    if (lattice->isOccupied(coord))
-      continue;
-    prim::DBDotPreview *db_prev = new prim::DBDotPreview(coord);
-    db_prev->setPos(lattice->latticeCoord2ScenePos(coord));
-    db_previews.append(db_prev);
-    scene->addItem(db_prev);
-  }
+  for (const prim::LatticeCoord &coord : coords)
+    appendDBPreview(coord);
+}
+
+void gui::DesignPanel::appendDBPreview(const prim::LatticeCoord &coord)
+{
+  if (lattice->isOccupied(coord))
+    return;
+  prim::DBDotPreview *db_prev = new prim::DBDotPreview(coord);
+  db_prev->setPos(lattice->latticeCoord2ScenePos(coord));
+  db_previews.append(db_prev);
+  scene->addItem(db_prev);
 }
 
 void gui::DesignPanel::destroyDBPreviews()
@@ -1961,6 +3115,99 @@ prim::Item *gui::DesignPanel::filteredSnapTarget(QPointF scene_pos, QList<prim::
 }
 
 // UNDO/REDO STACK METHODS
+
+QByteArray gui::DesignPanel::compactItem(const prim::Item *item)
+{
+  // only electrodes can currently be rebuilt from their saved XML
+  if (item->item_type != prim::Item::Electrode)
+    return QByteArray();
+  QByteArray xml;
+  QXmlStreamWriter ws(&xml);
+  item->saveItems(&ws);
+  return qCompress(xml);
+}
+
+prim::Item *gui::DesignPanel::restoreItem(const QByteArray &item_xml, int layer_index)
+{
+  // the XML constructor adds the item to the given scene so use a temporary one,
+  // it reads the child elements following the opened electrode element
+  QGraphicsScene tmp_scene;
+  QXmlStreamReader rs(qUncompress(item_xml));
+  if (!rs.readNextStartElement() || rs.name() != QLatin1String("electrode")) {
+    qCritical() << tr("Compacted undo item is not an electrode");
+    return nullptr;
+  }
+  prim::Item *item = new prim::Electrode(&rs, &tmp_scene, layer_index);
+  tmp_scene.removeItem(item);
+  return item;
+}
+
+void gui::DesignPanel::accountUndoBytes(qint64 &accounted, qint64 bytes)
+{
+  undo_bytes += bytes - accounted;
+  accounted = bytes;
+}
+
+qint64 gui::DesignPanel::itemBytes(const prim::Item *item)
+{
+  qint64 size;
+  switch (item->item_type) {
+    case prim::Item::DBDot:
+      size = sizeof(prim::DBDot);
+      break;
+    case prim::Item::Electrode:
+      size = sizeof(prim::Electrode);
+      break;
+    case prim::Item::Aggregate:
+      size = sizeof(prim::Aggregate);
+      break;
+    case prim::Item::TextLabel:
+      size = sizeof(prim::TextLabel);
+      break;
+    default:
+      size = sizeof(prim::Item);
+      break;
+  }
+
+  for (QGraphicsItem *child : item->childItems())
+    size += itemBytes(static_cast<prim::Item*>(child));
+  return size;
+}
+
+void gui::DesignPanel::compactUndoCommand(QUndoCommand *cmd)
+{
+  if (auto batch = dynamic_cast<CreateDBBatch*>(cmd)) {
+    if (!batch->isCompacted())
+      batch->compact();
+  } else if (auto create_item = dynamic_cast<CreateItem*>(cmd)) {
+    if (!create_item->isCompacted())
+      create_item->compact();
+  }
+
+  for (int i=0; i<cmd->childCount(); i++)
+    compactUndoCommand(const_cast<QUndoCommand*>(cmd->child(i)));
+}
+
+void gui::DesignPanel::enforceUndoBudget()
+{
+  // the commands keep undo_bytes up to date as they are pushed, merged,
+  // compacted and dropped
+  if (undo_bytes <= undo_budget) {
+    undo_over_budget = false;
+    return;
+  }
+
+  // spill the oldest commands first, the commands track their own compaction
+  // so dropped or undone commands can't shift what is skipped
+  for (int i=0; i<undo_stack->count() && undo_bytes > undo_budget; i++)
+    compactUndoCommand(const_cast<QUndoCommand*>(undo_stack->command(i)));
+
+  if (undo_bytes > undo_budget && !undo_over_budget)
+    qWarning() << tr("Undo history of %1 KiB exceeds the undo budget after "
+        "compaction").arg(undo_bytes/1024);
+  undo_over_budget = undo_bytes > undo_budget;
+}
+
 // CreateDB class
 
 gui::DesignPanel::CreateDB::CreateDB(prim::LatticeCoord l_coord, int layer_index,
@@ -2012,6 +3259,154 @@ void gui::DesignPanel::CreateDB::destroy()
 }
 
 
+// CreateDBBatch class
+
+gui::DesignPanel::CreateDBBatch::CreateDBBatch(const QVector<prim::LatticeCoord> &l_coords,
+    int layer_index, DesignPanel *dp, bool invert, QUndoCommand *parent)
+  : QUndoCommand(parent), invert(invert), dp(dp), layer_index(layer_index)
+{
+  prim::Layer *layer = dp->layman->getLayer(layer_index);
+  const QStack<prim::Item*> &items = layer->getItems();
+
+  if (!invert) {
+    // like single DB creation, occupied and repeated sites are skipped
+    prim::LatticeOccupancy pending;
+    lat_coords.reserve(l_coords.size());
+    for (const prim::LatticeCoord &coord : l_coords) {
+      if (!dp->lattice->isOccupied(coord) && !pending.contains(coord)) {
+        pending.insert(coord, nullptr);
+        lat_coords.append(coord);
+      }
+    }
+    // new DBs are appended to the layer item stack
+    indices.resize(lat_coords.size());
+    for (int i=0; i<indices.size(); i++)
+      indices[i] = items.size() + i;
+  } else {
+    // find the stack indices of all DBs in one pass over the layer
+    QHash<prim::Item*, prim::LatticeCoord> coord_of;
+    coord_of.reserve(l_coords.size());
+    for (const prim::LatticeCoord &coord : l_coords) {
+      prim::DBDot *db = dp->lattice->dbAt(coord);
+      if (!db)
+        qFatal("Trying to remove a non-existing DB");
+      coord_of.insert(db, coord);
+    }
+    lat_coords.reserve(coord_of.size());
+    indices.reserve(coord_of.size());
+    for (int i=0; i<items.size(); i++) {
+      auto it = coord_of.constFind(items[i]);
+      if (it != coord_of.constEnd()) {
+        lat_coords.append(it.value());
+        indices.append(i);
+      }
+    }
+    if (lat_coords.size() != coord_of.size())
+      qCritical() << QObject::tr("Some DBs to remove aren't in layer %1").arg(layer_index);
+  }
+
+  setText(invert ? QObject::tr("delete %1 dangling bonds").arg(lat_coords.size())
+                 : QObject::tr("create %1 dangling bonds").arg(lat_coords.size()));
+  dp->accountUndoBytes(accounted, bytes());
+}
+
+gui::DesignPanel::CreateDBBatch::~CreateDBBatch()
+{
+  dp->accountUndoBytes(accounted, 0);
+}
+
+void gui::DesignPanel::CreateDBBatch::undo()
+{
+  invert ? create() : destroy();
+  dp->accountUndoBytes(accounted, bytes());
+}
+
+void gui::DesignPanel::CreateDBBatch::redo()
+{
+  invert ? destroy() : create();
+  dp->accountUndoBytes(accounted, bytes());
+}
+
+qint64 gui::DesignPanel::CreateDBBatch::bytes() const
+{
+  return sizeof(*this) + lat_coords.capacity()*sizeof(prim::LatticeCoord)
+      + indices.capacity()*sizeof(int) + packed.capacity();
+}
+
+void gui::DesignPanel::CreateDBBatch::compact()
+{
+  if (!packed.isEmpty() || lat_coords.isEmpty())
+    return;
+
+  // coordinates of arrays are highly regular and compress well
+  QByteArray raw;
+  QDataStream out(&raw, QIODevice::WriteOnly);
+  out << qint32(lat_coords.size());
+  for (int i=0; i<lat_coords.size(); i++)
+    out << qint32(lat_coords[i].n) << qint32(lat_coords[i].m)
+        << qint32(lat_coords[i].l) << qint32(indices[i]);
+  packed = qCompress(raw);
+  lat_coords = QVector<prim::LatticeCoord>();
+  indices = QVector<int>();
+  compacted = true;
+  dp->accountUndoBytes(accounted, bytes());
+}
+
+void gui::DesignPanel::CreateDBBatch::unpack()
+{
+  if (packed.isEmpty())
+    return;
+
+  QByteArray raw = qUncompress(packed);
+  QDataStream in(raw);
+  qint32 count;
+  in >> count;
+  lat_coords.resize(count);
+  indices.resize(count);
+  for (int i=0; i<count; i++) {
+    qint32 n, m, l, ind;
+    in >> n >> m >> l >> ind;
+    lat_coords[i] = prim::LatticeCoord(n, m, l);
+    indices[i] = ind;
+  }
+  packed.clear();
+  compacted = false;
+}
+
+void gui::DesignPanel::CreateDBBatch::create()
+{
+  unpack();
+
+  // place the DBs before adding them to the scene so that they are indexed at
+  // their final positions
+  QList<prim::Item*> new_dbs;
+  new_dbs.reserve(lat_coords.size());
+  for (const prim::LatticeCoord &coord : lat_coords) {
+    prim::DBDot *new_db = new prim::DBDot(coord, layer_index);
+    dp->moveDBToLatticeCoord(new_db, coord.n, coord.m, coord.l);
+    dp->lattice->setOccupied(coord, new_db);
+    new_dbs.append(new_db);
+  }
+  dp->addItems(new_dbs, layer_index, indices);
+}
+
+void gui::DesignPanel::CreateDBBatch::destroy()
+{
+  unpack();
+
+  QList<prim::Item*> dbs;
+  dbs.reserve(lat_coords.size());
+  for (const prim::LatticeCoord &coord : lat_coords) {
+    prim::DBDot *db = dp->lattice->dbAt(coord);
+    if (db) {
+      dp->lattice->setUnoccupied(coord);
+      dbs.append(db);
+    }
+  }
+  dp->removeItems(dbs, dp->layman->getLayer(layer_index));
+}
+
+
 // CreatePotPlot class
 gui::DesignPanel::CreatePotPlot::CreatePotPlot(gui::DesignPanel *dp, QString pot_plot_path, QRectF graph_container, QString pot_anim_path, prim::PotPlot *pp, bool invert, QUndoCommand *parent)
   : QUndoCommand(parent), dp(dp), pot_plot_path(pot_plot_path), graph_container(graph_container), pot_anim_path(pot_anim_path), pp(pp), invert(invert)
@@ -2035,7 +3430,8 @@ void gui::DesignPanel::CreatePotPlot::create()
   dp->addItemToScene(static_cast<prim::Item*>(pp));
   dp->sim_results_items.append(static_cast<prim::Item*>(pp));
   connect(pp->getPotentialAnimation(), &QMovie::frameChanged, dp, &gui::DesignPanel::updateSimMovie);
-
+  // potential plots are simulation results, which designs don't save
+  dp->journal.recordTransientEdit();
 }
 
 void gui::DesignPanel::CreatePotPlot::destroy()
@@ -2045,6 +3441,7 @@ void gui::DesignPanel::CreatePotPlot::destroy()
     dp->sim_results_items.removeOne(static_cast<prim::Item*>(pp));
     pp = 0;
   }
+  dp->journal.recordTransientEdit();
 }
 
 
@@ -2110,6 +3507,7 @@ void gui::DesignPanel::EditTextLabel::undo()
     text_lab->setText(text_orig);
   else
     text_lab->setText(text_new);
+  dp->journal.recordUpdate(text_lab, layer_index, item_index);
 }
 
 void gui::DesignPanel::EditTextLabel::redo()
@@ -2120,6 +3518,7 @@ void gui::DesignPanel::EditTextLabel::redo()
     text_lab->setText(text_new);
   else
     text_lab->setText(text_orig);
+  dp->journal.recordUpdate(text_lab, layer_index, item_index);
 }
 
 
@@ -2133,6 +3532,7 @@ gui::DesignPanel::CreateItem::CreateItem(int layer_index, DesignPanel *dp,
   prim::Layer *layer = dp->layman->getLayer(layer_index);
   item_index = invert ? layer->getItems().indexOf(item) : layer->getItems().size();
   in_scene = invert ? true : false;
+  dp->accountUndoBytes(accounted, bytes());
 }
 
 gui::DesignPanel::CreateItem::~CreateItem()
@@ -2141,26 +3541,55 @@ gui::DesignPanel::CreateItem::~CreateItem()
     qDebug() << tr("Deleting item from QUndoStack");
     delete item;
   }
+  dp->accountUndoBytes(accounted, 0);
 }
 
 void gui::DesignPanel::CreateItem::undo()
 {
   invert ? create() : destroy();
+  dp->accountUndoBytes(accounted, bytes());
 }
 
 void gui::DesignPanel::CreateItem::redo()
 {
   invert ? destroy() : create();
+  dp->accountUndoBytes(accounted, bytes());
 }
 
 void gui::DesignPanel::CreateItem::create()
 {
+  if (!item && !item_xml.isEmpty()) {
+    item = restoreItem(item_xml, layer_index);
+    item_xml.clear();
+    compacted = false;
+  }
   if (!item)
     qCritical() << tr("Item pointer is 0, cannot create new item");
   dp->addItem(item, layer_index, item_index);
   in_scene = true;
 }
 
+qint64 gui::DesignPanel::CreateItem::bytes() const
+{
+  qint64 size = sizeof(*this) + item_xml.capacity();
+  if (!in_scene && item)
+    size += item_bytes;
+  return size;
+}
+
+void gui::DesignPanel::CreateItem::compact()
+{
+  if (in_scene || !item)
+    return;
+  item_xml = compactItem(item);
+  if (item_xml.isEmpty())
+    return;
+  delete item;
+  item = nullptr;
+  compacted = true;
+  dp->accountUndoBytes(accounted, bytes());
+}
+
 void gui::DesignPanel::CreateItem::destroy()
 {
   // NOTE issues will arise if layers have been added/removed
@@ -2169,6 +3598,9 @@ void gui::DesignPanel::CreateItem::destroy()
   dp->removeItem(item, dp->layman->getLayer(item->layer_id));
   item = item_copy;
   in_scene = false;
+
+  // the retained item is owned by this command
+  item_bytes = itemBytes(item);
 }
 
 
@@ -2192,6 +3624,7 @@ void gui::DesignPanel::ResizeItem::undo()
 
   item->resize(-top_left_delta.x(), -top_left_delta.y(),
                -bottom_right_delta.x(), -bottom_right_delta.y(), true);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 void gui::DesignPanel::ResizeItem::redo()
@@ -2202,11 +3635,11 @@ void gui::DesignPanel::ResizeItem::redo()
   // if the user resized manually, then the area is already the right size
   if (manual) {
     manual = false;
-    return;
+  } else {
+    item->resize(top_left_delta.x(), top_left_delta.y(),
+                 bottom_right_delta.x(), bottom_right_delta.y(), true);
   }
-
-  item->resize(top_left_delta.x(), top_left_delta.y(),
-               bottom_right_delta.x(), bottom_right_delta.y(), true);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 
@@ -2225,12 +3658,14 @@ void gui::DesignPanel::RotateItem::undo()
 {
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setRotation(init_ang);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 void gui::DesignPanel::RotateItem::redo()
 {
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setRotation(fin_ang);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 // ChangeColor class
@@ -2249,6 +3684,8 @@ void gui::DesignPanel::ChangeColor::undo()
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setColor(init_col);
   item->update();
+  dp->markTileDirty(item);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 void gui::DesignPanel::ChangeColor::redo()
@@ -2256,6 +3693,8 @@ void gui::DesignPanel::ChangeColor::redo()
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setColor(fin_col);
   item->update();
+  dp->markTileDirty(item);
+  dp->journal.recordUpdate(item, layer_index, item_index);
 }
 
 
@@ -2338,6 +3777,8 @@ void gui::DesignPanel::FormAggregate::form()
   // remove the items from the Layer stack in reverse order
   QStack<prim::Item*> items;
   for(int i=item_inds.count()-1; i>=0; i--) {
+    dp->journal.recordRemove(layer_index, item_inds.at(i));
+    dp->markTileDirty(layer_items.at(item_inds.at(i)));
     items.push(layer->takeItem(item_inds.at(i)));
   }
 
@@ -2356,6 +3797,8 @@ void gui::DesignPanel::FormAggregate::form()
 void gui::DesignPanel::FormAggregate::split()
 {
   prim::Layer *layer = dp->layman->getLayer(layer_index);
+  dp->journal.recordRemove(layer_index, agg_index);
+  dp->markTileDirty(layer->getItem(agg_index));
   prim::Item *item = layer->takeItem(agg_index);
 
   if(item->item_type != prim::Item::Aggregate)
@@ -2389,9 +3832,36 @@ gui::DesignPanel::MoveItem::MoveItem(prim::Item *item, const QPointF &offset,
                                       DesignPanel *dp, QUndoCommand *parent)
   : QUndoCommand(parent), dp(dp), offset(offset)
 {
-  layer_index = item->layer_id;
+  int layer_index = item->layer_id;
   // qDebug() << dp->layman->getLayer(layer_index)->getItemIndex(item);
-  item_index = dp->layman->getLayer(layer_index)->getItems().indexOf(item);
+  int item_index = dp->layman->getLayer(layer_index)->getItems().indexOf(item);
+  item_refs.append(qMakePair(layer_index, item_index));
+  dp->accountUndoBytes(accounted, bytes());
+}
+
+
+gui::DesignPanel::MoveItem::~MoveItem()
+{
+  dp->accountUndoBytes(accounted, 0);
+}
+
+
+bool gui::DesignPanel::MoveItem::mergeWith(const QUndoCommand *other)
+{
+  // only moves by the same offset collapse into one command, which happens
+  // for all items of a selection moved within one macro
+  const MoveItem *other_move = static_cast<const MoveItem*>(other);
+  if (other_move->offset != offset)
+    return false;
+  item_refs.append(other_move->item_refs);
+  dp->accountUndoBytes(accounted, bytes());
+  return true;
+}
+
+
+qint64 gui::DesignPanel::MoveItem::bytes() const
+{
+  return sizeof(*this) + item_refs.capacity()*sizeof(QPair<int,int>);
 }
 
 
@@ -2408,19 +3878,27 @@ void gui::DesignPanel::MoveItem::redo()
 
 void gui::DesignPanel::MoveItem::move(bool invert)
 {
-  prim::Layer *layer = dp->layman->getLayer(layer_index);
-  prim::Item *item = layer->getItem(item_index);
-
   QPointF delta = invert ? -offset : offset;
 
-  // should update original boundingRect after move to handle residual artifacts
-  QRectF old_rect = item->boundingRect();
-  // move the item
-  moveItem(item, delta);
+  // undo in the reverse order of the merged moves so that every DB returns to
+  // a site that was vacated before it
+  for (int i=0; i<item_refs.size(); i++) {
+    const QPair<int,int> &ref = item_refs[invert ? item_refs.size()-1-i : i];
+    prim::Layer *layer = dp->layman->getLayer(ref.first);
+    prim::Item *item = layer->getItem(ref.second);
+
+    // should update original boundingRect after move to handle residual artifacts
+    QRectF old_rect = item->boundingRect();
+    // move the item, DBs may leave their tile
+    dp->markTileDirty(item);
+    moveItem(item, delta);
+    dp->markTileDirty(item);
+    dp->journal.recordUpdate(item, ref.first, ref.second);
 
-  // redraw old and new bounding rects to handle artifacts
-  item->scene()->update(old_rect);
-  item->scene()->update(item->boundingRect());
+    // redraw old and new bounding rects to handle artifacts
+    item->scene()->update(old_rect);
+    item->scene()->update(item->boundingRect());
+  }
 }
 
 
@@ -2465,9 +3943,8 @@ void gui::DesignPanel::MoveItem::moveAggregate(prim::Aggregate *agg, const QPoin
   for(prim::Item *item : agg->getChildren())
     moveItem(item, delta);
 
-  // workaround to make sure the boundingRect scene position is updated
-  agg->setPos(agg->scenePos()+QPointF(1,0));
-  agg->setPos(agg->scenePos()+QPointF(-1,0));
+  // children moved, recompute the cached bounds and hull on demand
+  agg->invalidateGeometry();
 }
 
 bool gui::DesignPanel::commandCreateItem(QString type, QString layer_id, QStringList item_args)
@@ -2614,8 +4091,9 @@ bool gui::DesignPanel::commandMoveItem(QString type, QStringList brackets, QStri
         QPointF offset = findMoveOffset(brackets);
         if (offset.isNull())
           return false;
-        else
-          undo_stack->push(new MoveItem(static_cast<prim::Item*>(item), offset, this));
+        undo_stack->beginMacro(tr("moving item"));
+        undo_stack->push(new MoveItem(static_cast<prim::Item*>(item), offset, this));
+        undo_stack->endMacro();
         return true;
       }
     }
@@ -2667,10 +4145,15 @@ void gui::DesignPanel::createDBs(prim::LatticeCoord lat_coord)
   // save list of lattice coords where DBs should be created
   QList<prim::LatticeCoord> lat_list = QList<prim::LatticeCoord>();
   if (!lat_coord.isValid()) {
-    // multiple creation, from using tool
+    // multiple creation, from using tool. Previews are filtered against the
+    // occupancy index and deduplicated through a scratch index in one pass.
+    prim::LatticeOccupancy pending;
+    lat_list.reserve(db_previews.size());
     for (prim::DBDotPreview *db_prev : db_previews) {
-      if (!lattice->isOccupied(db_prev->latticeCoord())) {
-        lat_list.append(db_prev->latticeCoord());
+      prim::LatticeCoord coord = db_prev->latticeCoord();
+      if (!lattice->isOccupied(coord) && !pending.contains(coord)) {
+        pending.insert(coord, nullptr);
+        lat_list.append(coord);
       }
     }
     destroyDBPreviews();
@@ -2683,11 +4166,7 @@ void gui::DesignPanel::createDBs(prim::LatticeCoord lat_coord)
   if (lat_list.isEmpty()) {
     return;
   }
-  undo_stack->beginMacro(tr("create dangling bonds"));
-  for (prim::LatticeCoord lc: lat_list) {
-    undo_stack->push(new CreateDB(lc, layer_index, this));
-  }
-  undo_stack->endMacro();
+  undo_stack->push(new CreateDBBatch(lat_list, layer_index, this));
 }
 
 void gui::DesignPanel::createElectrode(QRect scene_rect)
@@ -2791,11 +4270,18 @@ void gui::DesignPanel::deleteSelection()
   qDebug() << tr("Deleting %1 items").arg(selection.count());
 
   undo_stack->beginMacro(tr("delete %1 items").arg(selection.count()));
+
+  // remove the selected DBs of each layer in a single command
+  QMap<int, QVector<prim::LatticeCoord>> db_coords;
+  for(prim::Item *item : selection)
+    if(item->item_type == prim::Item::DBDot)
+      db_coords[item->layer_id].append(static_cast<prim::DBDot*>(item)->latticeCoord());
+  for(auto it = db_coords.constBegin(); it != db_coords.constEnd(); ++it)
+    undo_stack->push(new CreateDBBatch(it.value(), it.key(), this, true));
+
   for(prim::Item *item : selection){
     switch(item->item_type){
       case prim::Item::DBDot:
-        undo_stack->push(new CreateDB(static_cast<prim::DBDot*>(item)->latticeCoord(),
-                                      item->layer_id, this, 0, true));
         break;
       case prim::Item::Aggregate:
         destroyAggregate(static_cast<prim::Aggregate*>(item));
@@ -2885,12 +4371,18 @@ void gui::DesignPanel::destroyAggregate(prim::Aggregate *agg)
   QStack<prim::Item*> items = agg->getChildren();
   undo_stack->push(new FormAggregate(agg, 0, this));
 
+  // remove the child DBs in a single command
+  QVector<prim::LatticeCoord> db_coords;
+  for(prim::Item *item : items)
+    if(item->item_type == prim::Item::DBDot)
+      db_coords.append(static_cast<prim::DBDot*>(item)->latticeCoord());
+  if(!db_coords.isEmpty())
+    undo_stack->push(new CreateDBBatch(db_coords, agg->layer_id, this, true));
+
   // recursively destroy all children using undo/redo enabled methods
   for(prim::Item* item : items){
     switch(item->item_type){
       case prim::Item::DBDot:
-        undo_stack->push(new CreateDB(static_cast<prim::DBDot*>(item)->latticeCoord(),
-                                      item->layer_id, this, 0, true));
         break;
       case prim::Item::Aggregate:
         destroyAggregate(static_cast<prim::Aggregate*>(item));
@@ -2926,10 +4418,29 @@ bool gui::DesignPanel::pasteAtGhost()
 
   undo_stack->beginMacro(tr("Paste %1 items").arg(clipboard.count()));
 
+  // consecutive top level DBs are created by a single command, which is pushed
+  // before any other item so that the layer stacking order is kept
+  QVector<prim::LatticeCoord> db_coords;
+  auto flushDBs = [this, &db_coords]() {
+    if(db_coords.isEmpty())
+      return;
+    undo_stack->push(new CreateDBBatch(db_coords,
+          layman->indexOf(layman->getMRULayer(prim::Layer::DB)), this));
+    db_coords.clear();
+  };
   for(int i=0; i<ghost->getCount(); i++){
-    for(prim::Item *item : ghost->getTopItems())
-      pasteItem(ghost, i, item);
+    for(prim::Item *item : ghost->getTopItems()){
+      if(item->item_type == prim::Item::DBDot){
+        auto coord = ghost->getLatticeCoord(static_cast<prim::DBDot*>(item), i);
+        if(lattice->isValid(coord))
+          db_coords.append(coord);
+      } else {
+        flushDBs();
+        pasteItem(ghost, i, item);
+      }
+    }
   }
+  flushDBs();
   undo_stack->endMacro();
 
   pasting=false;
@@ -3017,8 +4528,10 @@ bool gui::DesignPanel::moveToGhost(bool kill)
 
     if (is_all_floating) {//selection is all electrodes. try to move them without snapping.
       //offset is kept inside ghost->pos()
+      undo_stack->beginMacro(tr("Move items"));
       for (prim::Item *item : ghost->getTopItems())
         undo_stack->push(new MoveItem(item, ghost->pos(), this));
+      undo_stack->endMacro();
       return true; //things were moved.
     }
     //either no selection, or selection contains non-electrodes. return false as usual.
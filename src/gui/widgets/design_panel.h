@@ -25,10 +25,14 @@
 #include "managers/screenshot_manager.h"
 #include "color_dialog.h"
 #include "rotate_dialog.h"
+#include "design_binary.h"
+#include "design_journal.h"
+#include "tiled_design.h"
 
 #include "primitives/layer.h"
 #include "primitives/lattice.h"
 #include "primitives/dblayer.h"
+#include "primitives/dbdensity.h"
 #include "primitives/items.h"
 #include "primitives/emitter.h"
 #include "components/sim_job.h"
@@ -101,6 +105,17 @@ namespace gui{
     //! Remove the given Item from the given Layer if possible.
     void removeItem(prim::Item *item, prim::Layer* layer, bool retain_item=false);
 
+    //! Add several new Items to the Layer at the given index with a single
+    //! scene rect update. indices holds the final stack index of each Item in
+    //! ascending order, Items are appended if it is empty.
+    void addItems(const QList<prim::Item*> &items, int layer_index,
+        const QVector<int> &indices=QVector<int>());
+
+    //! Remove several Items contained in the given Layer with a single scene
+    //! rect update.
+    void removeItems(const QList<prim::Item*> &items, prim::Layer *layer,
+        bool retain_items=false);
+
     //! Add a new Item to the graphics scene without adding it to a layer. This
     //! either means the Item is already owned by another class and only needs
     //! to be shown graphically, or the Item is merely a temporary graphics
@@ -121,8 +136,9 @@ namespace gui{
     //! Fit graphics items into design panel view.
     void fitItemsInView(const bool &include_hidden);
 
-    //! Inform new zoom level.
-    void informZoomUpdate() {emit sig_zoom(qAbs(transform().m11() + transform().m12()));}
+    //! Inform new zoom level, switching item level of detail when crossing
+    //! the threshold.
+    void informZoomUpdate();
 
     //! return a list of selected prim::Items
     QList<prim::Item*> selectedItems();
@@ -148,6 +164,14 @@ namespace gui{
     //! update the tool type
     void setTool(gui::ToolType tool);
 
+    //! Block tool interaction and edits of the design while a design loads in
+    //! slices, the view can still be panned and zoomed. Tool changes made in
+    //! the meantime take effect once unblocked.
+    void setEditsBlocked(bool blocked);
+
+    //! Return whether edits are blocked.
+    bool editsBlocked() const {return edits_blocked;}
+
     //! update the fill values for the surface dangling bonds, no check for
     //! array size/contents.
     void setFills(float *fills);
@@ -155,6 +179,9 @@ namespace gui{
     //! set the undo stack as clean at the current index
     void stateSet() {undo_stack->setClean();}
 
+    //! mark the design as changed until the next save, e.g. after recovery
+    void stateUnset() {undo_stack->resetClean();}
+
     //! check if the contents of the DesignPanel have changed
     bool stateChanged() const {return !undo_stack->isClean();}
 
@@ -173,8 +200,47 @@ namespace gui{
     int autosave_ind=0;
     int save_ind=0;
 
-    //! Save layers and items into the given write stream.
-    void writeToXmlStream(QXmlStreamWriter *, DesignInclusionArea);
+    //! Save layers and items into the given write stream. IncludeAreaOfInterest
+    //! saves the items in the given area, or in the panel's area of interest
+    //! if the given area is invalid.
+    void writeToXmlStream(QXmlStreamWriter *, DesignInclusionArea,
+                          const prim::AreaOfInterest &area=prim::AreaOfInterest());
+
+    //! Save layers and items into the given binary container. DBs are stored
+    //! as packed lattice coordinates, other items as XML chunks.
+    bool writeToBinaryStream(sqb::Writer *, DesignInclusionArea,
+                             const prim::AreaOfInterest &area=prim::AreaOfInterest());
+
+    //! Capture layers and items as records which can be written on another
+    //! thread, DBs are packed and the other items serialized to XML.
+    sqb::DesignSnapshot snapshot(DesignInclusionArea,
+                                 const prim::AreaOfInterest &area=prim::AreaOfInterest());
+
+    // AREA OF INTEREST
+
+    //! Return the area of interest, invalid if none is set.
+    prim::AreaOfInterest areaOfInterest() const {return area_of_interest;}
+
+    //! Set the area of interest, an invalid area clears it.
+    void setAreaOfInterest(const prim::AreaOfInterest &area);
+
+    //! Set the area of interest to the screenshot clip area. Returns false if
+    //! no clip area is set.
+    bool setAreaOfInterestFromClip();
+
+    //! Revision of the design content, advanced by every undo stack index
+    //! change and panel reset.
+    quint64 designRevision() const {return design_revision;}
+
+    //! Journal of the item edits made since the last autosave.
+    DesignJournal *designJournal() {return &journal;}
+
+    //! Apply a journal record taken from a DesignJournal of this design.
+    //! Returns false if the record doesn't match the design.
+    bool applyJournalRecord(const QByteArray &record);
+
+    //! Save GUI flags (zoom and displayed region).
+    void writeGUIFlags(QXmlStreamWriter *);
 
 
     // LOAD
@@ -184,6 +250,44 @@ namespace gui{
     //! and instead only load into separately tracked Result layers.
     void loadFromFile(QXmlStreamReader *, bool is_sim_result=false);
 
+    //! Load layers and items from the given binary container, which must have
+    //! its header read already. is_sim_result has the same meaning as for XML.
+    void loadFromFile(sqb::Reader *, bool is_sim_result=false);
+
+    //! Begin loading a design from parsed descriptors, which are handed over
+    //! by the load* functions below in file order. The scene index is
+    //! suspended until endDescriptorLoad().
+    void beginDescriptorLoad(bool is_sim_result=false);
+
+    //! Load program, simulation parameter and GUI flags from XML.
+    void loadHead(const QByteArray &xml);
+
+    //! Apply lattice parameters.
+    void loadLatticeRecord(const sqb::LatticeRecord &lat);
+
+    //! Create the layers of the layer table.
+    void loadLayerTable(const QList<sqb::LayerRecord> &layers);
+
+    //! Create the items of a chunk in their layer.
+    void loadItemChunk(const sqb::ItemChunk &chunk);
+
+    //! Show the region saved in the GUI flags, if any was loaded.
+    void showLoadedRegion();
+
+    //! Finish the descriptor load.
+    void endDescriptorLoad();
+
+    //! Open a tiled .sqb design holding at least load/tiled_min_dbs DBs,
+    //! loading only the tiles around the view. Returns false and leaves the
+    //! panel untouched if the file doesn't qualify.
+    bool openTiled(const QString &path);
+
+    //! Return whether the design is backed by a tiled file.
+    bool isTiled() const {return tiled.isOpen();}
+
+    //! Back the tiles by a tiled .sqb file just saved from the entire design.
+    void rebaseTiles(const QString &path);
+
     //! Load GUI flags.
     void loadGUIFlags(QXmlStreamReader *, QRectF &);
 
@@ -199,6 +303,31 @@ namespace gui{
     void loadDesign(QXmlStreamReader *, QList<int> &layer_order_id, 
         bool is_sim_result);
 
+    //! Create a loaded layer with the given properties and record its ID in
+    //! layer_order_id, -1 if the layer is skipped.
+    void loadLayer(const QString &layer_nm, prim::Layer::LayerType layer_type,
+        prim::Layer::LayerRole layer_role, float zoffset, float zheight,
+        bool layer_visible, bool layer_active, QList<int> &layer_order_id,
+        bool is_sim_result);
+
+    //! Create the DBs and aggregates of a binary DB record in the given layer.
+    void loadDBRecord(const sqb::DBRecord &rec, prim::Layer *layer);
+
+    //! Append the DBs of a DBDot or Aggregate to a binary DB record.
+    static void appendDBItem(prim::Item *item, sqb::DBRecord &rec);
+
+    //! Finish loading a design, shared by XML and binary loads.
+    void finishLoad(const QRectF &visrect, bool is_sim_result);
+
+    //! Serialize an item to compressed XML for a compacted undo command, only
+    //! electrodes can currently be restored. Returns an empty array for other
+    //! item types.
+    static QByteArray compactItem(const prim::Item *item);
+
+    //! Rebuild an item from the output of compactItem, the item is not added to
+    //! any scene or layer.
+    static prim::Item *restoreItem(const QByteArray &item_xml, int layer_index);
+
 
     // SIMULATION RESULT DISPLAY
 
@@ -252,6 +381,15 @@ namespace gui{
     //! Emitted when the undo stack clean stage has changed.
     void emitUndoStackCleanChanged(bool c) {emit sig_undoStackCleanChanged(c);}
 
+    //! Compact the oldest commands until the undo history fits in the undo byte
+    //! budget, returns immediately while the running total is within budget.
+    void enforceUndoBudget();
+
+    //! Load the tiles around the view and evict tiles out of view once the
+    //! resident DBs exceed the tile budget. Tiles with items the undo history
+    //! may refer to stay resident, see UndoPins.
+    void updateResidentTiles();
+
     //! Update background to match current display mode and zoom level.
     void updateBackground();
 
@@ -306,6 +444,9 @@ namespace gui{
     //! Emit the currently selected items. Empty for no selected items.
     void sig_selectedItems(QList<prim::Item*> items);
 
+    //! Emit the new area of interest, invalid if it was cleared.
+    void sig_areaOfInterestChanged(const prim::AreaOfInterest &area);
+
   protected:
 
     void contextMenuEvent(QContextMenuEvent *e) override;
@@ -333,13 +474,42 @@ namespace gui{
     void dummyAction();
     void deleteAction();
 
+    // rebuild the DB density raster after a DB layer was shown or hidden
+    void invalidateDBDensity();
+
+    // track the visibility of DB layers for the DB density raster
+    void connectDBLayerVisibility();
+
+    // record an item edited in the property editor, which bypasses the undo
+    // stack, for autosave and mark the design as changed
+    void itemPropertiesChanged(prim::Item *item);
+
   private:
 
     QGraphicsScene *scene;    // scene for the QGraphicsView
+
+    // state of a descriptor load
+    QList<int> desc_layer_order;  // layer ID of each layer table entry
+    QRectF desc_visrect;          // region saved in the GUI flags
+    bool desc_is_sim_result=false;
     QRectF min_scene_rect;    // minimum size of the scene rect
     gui::ToolType tool_type;  // current cursor tool type
+    bool edits_blocked=false; // tools and edits are disabled, see setEditsBlocked()
     gui::DisplayMode display_mode=DesignMode; // current display mode
     QUndoStack *undo_stack;   // undo stack
+    quint64 design_revision=0;  // advanced on content changes, see designRevision()
+    DesignJournal journal;      // item edits since the last autosave
+
+    // tiled design state, see openTiled()
+    TiledDesign tiled;
+    QHash<int,int> tile_layer_pos;  // file layer position of each tiled layer ID
+    qint64 resident_dbs=0;          // DBs loaded from tiles
+    UndoPins undo_pins;             // items of the tiled layers the undo history
+                                    // may refer to by stack index
+    QTimer tile_timer;              // defers tile updates until the view settles
+    qint64 undo_budget;       // undo history byte budget
+    qint64 undo_bytes=0;      // running estimate of the undo history size in bytes
+    bool undo_over_budget=false; // undo history still exceeded the budget after compaction
 
     // contained widgets
     gui::LayerManager *layman=nullptr;
@@ -373,6 +543,7 @@ namespace gui{
     QList<prim::Item*> clipboard;   // cached deep copy of a set of items for pasting
 
     prim::Lattice *lattice=0;       // lattice for reference
+    prim::DBDensity *db_density=0;  // DB density raster at low zoom
 
     // flags, change later to bit flags
     bool clicked;   // mouse left button is clicked
@@ -429,6 +600,49 @@ namespace gui{
     // when rotating the view or anchoring during zoom.
     void scrollDelta(QPointF delta);
 
+    // TILES
+
+    // load the DBs of a tile into the scene
+    bool loadTile(int tile_ind);
+
+    // update undo_pins with the current item counts of the tiled layers,
+    // called whenever the undo stack index changes
+    void pinUndoReferencedItems();
+
+    // remove the DBs of a tile from the scene, keeping edited DBs as overlay
+    void evictTile(int tile_ind);
+
+    // tile of the first DB of a DB item of a tiled layer, -1 if none
+    int itemTile(prim::Item *item, bool create);
+
+    // mark the tile of a DB item as edited, loading it first if evicted
+    void markTileDirty(prim::Item *item);
+
+    // scene area of the lattice cells of a tile, padded by one unit cell
+    QRectF tileSceneRect(qint32 tx, qint32 ty) const;
+
+    // top level DB items of a resident tile
+    QList<prim::Item*> tileItems(int tile_ind);
+
+    // free the lattice sites of all DBs in the item
+    void releaseLatticeSites(prim::Item *item, prim::Lattice *db_lattice);
+
+    // AREA OF INTEREST
+
+    // top level items within the area or its halo, found through the scene
+    // index. Tiles of tiled designs in the area are loaded first.
+    QSet<prim::Item*> areaOfInterestItems(const prim::AreaOfInterest &area);
+
+    // finish the polygon drawn with the area of interest tool
+    void finishAreaOfInterestDraft();
+
+    // show the area of interest and the polygon being drawn
+    void updateAreaOfInterestOutline(const QPointF &cursor_scene_pos=QPointF());
+
+    prim::AreaOfInterest area_of_interest;  // area of interest, in angstrom
+    QPolygonF aoi_draft;                    // vertices drawn so far, in scene coordinates
+    prim::AreaOfInterestOutline *aoi_outline=nullptr; // deleted with the scene
+
     // RUBBER BAND
 
     QRubberBand *rb=0;    // rubber band object
@@ -478,6 +692,9 @@ namespace gui{
     //! Add DB graphical previews without destroying existing ones.
     void appendDBPreviews(QList<prim::LatticeCoord> coords);
 
+    //! Add a single DB graphical preview if the site is unoccupied.
+    void appendDBPreview(const prim::LatticeCoord &coord);
+
     //! Destroy DB graphical previews.
     void destroyDBPreviews();
 
@@ -490,12 +707,27 @@ namespace gui{
 
     // UNDO/class UndoCommand;redo base class
 
+    //! Command ids for QUndoCommand::mergeWith.
+    enum UndoCommandId{MoveItemId=1};
+
+    //! Update the running undo history size with the new size of a command,
+    //! accounted holds the size previously added by that command.
+    void accountUndoBytes(qint64 &accounted, qint64 bytes);
+
+    //! Estimated memory held by an item and its children, without serializing.
+    static qint64 itemBytes(const prim::Item *item);
+
+    //! Spill the payload of the given undo command and its children to a
+    //! compact serialized form, restored transparently on undo/redo.
+    static void compactUndoCommand(QUndoCommand *cmd);
+
     // fundamental undo/redo command classes, keep memory requirement small
 
     class CreateItem;       // create any prim::Item that doesn't require extra checks
     class ResizeItem;       // resize a ResizableRect
 
     class CreateDB;         // create a dangling bond at a given lattice dot
+    class CreateDBBatch;    // create dangling bonds at many lattice dots
     class FormAggregate;    // form an aggregate from a list of Items
 
     class CreateLayer;      // create a new layer
@@ -598,6 +830,51 @@ namespace gui{
   };
 
 
+  class DesignPanel::CreateDBBatch : public QUndoCommand
+  {
+  public:
+    //! Create dangling bonds at all given lattice dots of one layer in a single
+    //! command, set invert if deleting the DBs at those dots. When creating,
+    //! occupied and repeated dots are skipped.
+    CreateDBBatch(const QVector<prim::LatticeCoord> &l_coords, int layer_index,
+        DesignPanel *dp, bool invert=false, QUndoCommand *parent=0);
+
+    ~CreateDBBatch();
+
+    // destroy the dangling bonds and update the lattice dots
+    virtual void undo();
+
+    // re-create the dangling bonds
+    virtual void redo();
+
+    // estimated memory held by this command
+    qint64 bytes() const;
+
+    // pack the coordinates and indices into a compressed buffer
+    void compact();
+
+    // whether the coordinates and indices are currently packed
+    bool isCompacted() const {return compacted;}
+
+  private:
+
+    void create();    // create the dangling bonds
+    void destroy();   // destroy the dangling bonds
+    void unpack();    // restore the coordinates and indices if compacted
+
+    bool invert;      // swaps create/delete on redo/undo
+
+    QVector<prim::LatticeCoord> lat_coords; // ordered by layer stack index
+    QVector<int> indices;   // index of each DBDot in the layer item stack
+    QByteArray packed;      // compressed lat_coords and indices when compacted
+    bool compacted=false;   // set while packed holds the only copy
+
+    DesignPanel *dp;  // DesignPanel pointer
+    int layer_index;  // index of layer in dp->layers stack
+    qint64 accounted=0; // bytes added to dp->undo_bytes
+  };
+
+
   class DesignPanel::FormAggregate : public QUndoCommand
   {
   public:
@@ -636,15 +913,24 @@ namespace gui{
   public:
     MoveItem(prim::Item *item, const QPointF &offset, DesignPanel *dp, QUndoCommand *parent=0);
 
+    ~MoveItem();
+
     // move the Item back (by the negative of the offset)
     virtual void undo();
 
     // move the Item by the offset
     virtual void redo();
 
+    // moves of several Items by the same offset within a macro are merged
+    virtual int id() const override {return MoveItemId;}
+    virtual bool mergeWith(const QUndoCommand *other) override;
+
+    // estimated memory held by this command
+    qint64 bytes() const;
+
   private:
 
-    // move the item either by offset or -offset
+    // move the items either by offset or -offset
     void move(bool invert=false);
 
     // handler for moving an Item by a given delta
@@ -658,9 +944,9 @@ namespace gui{
 
     DesignPanel *dp;
 
-    QPointF offset;   // amount by which to move the Item
-    int layer_index;  // index of layer containing the Item
-    int item_index;   // index of item in Layer imte stack
+    QPointF offset;   // amount by which to move the Items
+    QVector<QPair<int,int>> item_refs; // layer index and item stack index of each Item
+    qint64 accounted=0; // bytes added to dp->undo_bytes
   };
 
 
@@ -747,6 +1033,15 @@ namespace gui{
     virtual void undo();
     virtual void redo();
 
+    // estimated memory held by this command
+    qint64 bytes() const;
+
+    // serialize a retained item to compressed XML and release it
+    void compact();
+
+    // whether the retained item is currently held as compressed XML
+    bool isCompacted() const {return compacted;}
+
   private:
     void create();
     void destroy();
@@ -756,7 +1051,11 @@ namespace gui{
     bool in_scene;
     int layer_index;  // index of layer in layer manager
     int item_index;   // index of item in layer
-    prim::Item *item; // pointer to item, this pointer should always be valid for recreation
+    prim::Item *item; // pointer to item, valid for recreation unless compacted
+    QByteArray item_xml; // compressed item XML when compacted
+    bool compacted=false; // set while item_xml holds the only copy
+    qint64 item_bytes=0; // estimated size of the retained item
+    qint64 accounted=0;  // bytes added to dp->undo_bytes
   };
 
   //! Resize a ResizableRect
@@ -0,0 +1,278 @@
+// @file:     gzip_device.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Streaming gzip compression of designs through a QIODevice.
+
+#include "gzip_device.h"
+#include "../../libs/miniz/miniz.h"
+
+#include <QtEndian>
+
+namespace {
+
+  const char gzip_magic[2] = {'\x1f', '\x8b'};
+  const int gzip_header_size = 10;
+  const int gzip_trailer_size = 8;
+  const qint64 gzip_buffer_size = 1 << 16;
+
+  // header flags
+  enum GzipFlag : quint8 {FHCRC=0x2, FEXTRA=0x4, FNAME=0x8, FCOMMENT=0x10};
+
+}
+
+struct gui::GzipDevice::ZStream
+{
+  mz_stream s;
+  bool deflating=false;
+};
+
+
+gui::GzipDevice::GzipDevice(QIODevice *dev, int level, QObject *parent)
+  : QIODevice(parent), dev(dev), level(qBound(0, level, 9))
+{}
+
+gui::GzipDevice::~GzipDevice()
+{
+  close();
+}
+
+bool gui::GzipDevice::isGzip(QIODevice *dev)
+{
+  return dev->peek(2) == QByteArray(gzip_magic, 2);
+}
+
+bool gui::GzipDevice::isGzipPath(const QString &path)
+{
+  return QFileInfo(path).suffix().compare("gz", Qt::CaseInsensitive) == 0;
+}
+
+QString gui::GzipDevice::stripGzipSuffix(const QString &path)
+{
+  return isGzipPath(path) ? path.chopped(3) : path;
+}
+
+QIODevice *gui::GzipDevice::decompressing(QIODevice *dev)
+{
+  if (!isGzip(dev))
+    return dev;
+  GzipDevice *gz = new GzipDevice(dev, DefaultLevel, dev);
+  if (!gz->open(QIODevice::ReadOnly))
+    qWarning() << tr("Can't decompress: %1").arg(gz->errorString());
+  return gz;
+}
+
+QIODevice *gui::GzipDevice::compressing(QIODevice *dev, const QString &path, int level)
+{
+  if (!isGzipPath(path))
+    return dev;
+  GzipDevice *gz = new GzipDevice(dev, level, dev);
+  if (!gz->open(QIODevice::WriteOnly))
+    qWarning() << tr("Can't compress: %1").arg(gz->errorString());
+  return gz;
+}
+
+bool gui::GzipDevice::open(QIODevice::OpenMode mode)
+{
+  if (isOpen() || !(mode & QIODevice::ReadWrite) || (mode & QIODevice::ReadWrite) == QIODevice::ReadWrite) {
+    setErrorString(tr("Gzip devices are opened either for reading or for writing."));
+    return false;
+  }
+
+  zs.reset(new ZStream);
+  memset(&zs->s, 0, sizeof(zs->s));
+  crc = MZ_CRC32_INIT;
+  total = 0;
+  stream_end = false;
+  buf.clear();
+
+  if (mode & QIODevice::ReadOnly) {
+    // raw deflate data follows the gzip header
+    if (!readHeader()) {
+      zs.reset();
+      return false;
+    }
+    if (mz_inflateInit2(&zs->s, -MZ_DEFAULT_WINDOW_BITS) != MZ_OK) {
+      setErrorString(tr("Can't initialize decompression."));
+      zs.reset();
+      return false;
+    }
+  } else {
+    if (mz_deflateInit2(&zs->s, level, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9,
+          MZ_DEFAULT_STRATEGY) != MZ_OK) {
+      setErrorString(tr("Can't initialize compression."));
+      zs.reset();
+      return false;
+    }
+    zs->deflating = true;
+    // no file name or time stamp, extra flags hint at the level
+    QByteArray header(gzip_magic, 2);
+    header.append(char(MZ_DEFLATED));
+    header.append(5, '\0');
+    header.append(char(level >= BestLevel ? 2 : (level <= FastLevel ? 4 : 0)));
+    header.append('\xff');
+    if (dev->write(header) != header.size()) {
+      setErrorString(dev->errorString());
+      mz_deflateEnd(&zs->s);
+      zs.reset();
+      return false;
+    }
+  }
+  return QIODevice::open(mode);
+}
+
+void gui::GzipDevice::close()
+{
+  if (!isOpen())
+    return;
+
+  if (zs->deflating) {
+    // finish the deflate stream and append the CRC and size
+    zs->s.next_in = nullptr;
+    zs->s.avail_in = 0;
+    bool ok = deflateInput(MZ_FINISH);
+    if (ok) {
+      QByteArray trailer(gzip_trailer_size, '\0');
+      qToLittleEndian<quint32>(crc, trailer.data());
+      qToLittleEndian<quint32>(total, trailer.data() + 4);
+      ok = dev->write(trailer) == trailer.size();
+      if (!ok)
+        setErrorString(dev->errorString());
+    }
+    if (!ok)
+      qWarning() << tr("Gzip: error when finishing the compressed data: %1").arg(errorString());
+    mz_deflateEnd(&zs->s);
+  } else {
+    mz_inflateEnd(&zs->s);
+  }
+  zs.reset();
+  buf.clear();
+  QIODevice::close();
+}
+
+bool gui::GzipDevice::atEnd() const
+{
+  return stream_end && QIODevice::atEnd();
+}
+
+qint64 gui::GzipDevice::readData(char *data, qint64 max_size)
+{
+  if (stream_end || max_size <= 0)
+    return 0;
+
+  mz_uint32 out_size = static_cast<mz_uint32>(qMin<qint64>(max_size, gzip_buffer_size));
+  zs->s.next_out = reinterpret_cast<unsigned char*>(data);
+  zs->s.avail_out = out_size;
+  // block until some data is inflated, readers take no output as the end
+  while (zs->s.avail_out == out_size && !stream_end) {
+    if (zs->s.avail_in == 0) {
+      buf.resize(gzip_buffer_size);
+      qint64 read = dev->read(buf.data(), buf.size());
+      if (read <= 0) {
+        setErrorString(read < 0 ? dev->errorString()
+            : tr("Compressed data ends prematurely."));
+        return -1;
+      }
+      zs->s.next_in = reinterpret_cast<const unsigned char*>(buf.constData());
+      zs->s.avail_in = static_cast<mz_uint32>(read);
+    }
+    int status = mz_inflate(&zs->s, MZ_NO_FLUSH);
+    if (status == MZ_STREAM_END) {
+      stream_end = true;
+    } else if (status != MZ_OK && status != MZ_BUF_ERROR) {
+      setErrorString(tr("Compressed data is corrupt."));
+      return -1;
+    }
+  }
+
+  qint64 inflated = out_size - zs->s.avail_out;
+  crc = static_cast<quint32>(mz_crc32(crc, reinterpret_cast<const unsigned char*>(data), inflated));
+  total += static_cast<quint32>(inflated);
+  if (stream_end && !readTrailer())
+    return -1;
+  return inflated;
+}
+
+qint64 gui::GzipDevice::writeData(const char *data, qint64 size)
+{
+  crc = static_cast<quint32>(mz_crc32(crc, reinterpret_cast<const unsigned char*>(data), size));
+  total += static_cast<quint32>(size);
+  zs->s.next_in = reinterpret_cast<const unsigned char*>(data);
+  zs->s.avail_in = static_cast<mz_uint32>(size);
+  return deflateInput(MZ_NO_FLUSH) ? size : -1;
+}
+
+bool gui::GzipDevice::readHeader()
+{
+  QByteArray header = dev->read(gzip_header_size);
+  if (header.size() != gzip_header_size || !header.startsWith(QByteArray(gzip_magic, 2))
+      || header.at(2) != char(MZ_DEFLATED)) {
+    setErrorString(tr("Not a gzip file."));
+    return false;
+  }
+
+  // skip the optional fields
+  quint8 flags = static_cast<quint8>(header.at(3));
+  bool ok = true;
+  if (flags & FEXTRA) {
+    QByteArray len = dev->read(2);
+    ok = len.size() == 2;
+    if (ok) {
+      qint64 extra_len = qFromLittleEndian<quint16>(len.constData());
+      ok = dev->read(extra_len).size() == extra_len;
+    }
+  }
+  for (quint8 str_flag : {FNAME, FCOMMENT}) {
+    char c = 1;
+    if (flags & str_flag)
+      while (ok && c != '\0')
+        ok = dev->getChar(&c);
+  }
+  if (ok && (flags & FHCRC))
+    ok = dev->read(2).size() == 2;
+  if (!ok)
+    setErrorString(tr("Gzip header is truncated."));
+  return ok;
+}
+
+bool gui::GzipDevice::readTrailer()
+{
+  // the trailer starts in the remaining input
+  QByteArray trailer(reinterpret_cast<const char*>(zs->s.next_in),
+      qMin<int>(zs->s.avail_in, gzip_trailer_size));
+  if (trailer.size() < gzip_trailer_size)
+    trailer += dev->read(gzip_trailer_size - trailer.size());
+  if (trailer.size() < gzip_trailer_size) {
+    setErrorString(tr("Gzip trailer is truncated."));
+    return false;
+  }
+  if (qFromLittleEndian<quint32>(trailer.constData()) != crc
+      || qFromLittleEndian<quint32>(trailer.constData() + 4) != total) {
+    setErrorString(tr("Compressed data fails its checksum."));
+    return false;
+  }
+  return true;
+}
+
+bool gui::GzipDevice::deflateInput(int flush)
+{
+  buf.resize(gzip_buffer_size);
+  forever {
+    zs->s.next_out = reinterpret_cast<unsigned char*>(buf.data());
+    zs->s.avail_out = static_cast<mz_uint32>(buf.size());
+    int status = mz_deflate(&zs->s, flush);
+    if (status != MZ_OK && status != MZ_STREAM_END && status != MZ_BUF_ERROR) {
+      setErrorString(tr("Compression failed."));
+      return false;
+    }
+    qint64 deflated = buf.size() - zs->s.avail_out;
+    if (deflated > 0 && dev->write(buf.constData(), deflated) != deflated) {
+      setErrorString(dev->errorString());
+      return false;
+    }
+    if (flush == MZ_FINISH ? status == MZ_STREAM_END
+        : (zs->s.avail_in == 0 && zs->s.avail_out != 0))
+      return true;
+  }
+}
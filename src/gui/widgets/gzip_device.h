@@ -0,0 +1,96 @@
+/** @file:     gzip_device.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Streaming gzip compression of designs through a QIODevice.
+ *
+ *  Designs saved as .sqd.gz and compressed autosave checkpoints are gzip
+ *  files holding the plain .sqd XML. GzipDevice sits between the
+ *  QXmlStreamReader/Writer and the file, (de)compressing with the bundled
+ *  miniz as the XML streams through, so the XML readers and writers work
+ *  unchanged. Compressed files are recognized by their gzip magic when read
+ *  and by their .gz suffix when written.
+ */
+
+#ifndef _GUI_GZIP_DEVICE_H_
+#define _GUI_GZIP_DEVICE_H_
+
+#include <QtCore>
+#include <memory>
+
+namespace gui{
+
+  //! Sequential device (de)compressing a single gzip member from or to
+  //! another device. Open it ReadOnly to decompress or WriteOnly to compress,
+  //! the underlying device must already be open. Close the gzip device before
+  //! the underlying device, closing writes the gzip trailer.
+  class GzipDevice : public QIODevice
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Compression levels, 1 to 9 trade speed for size.
+    enum Level{FastLevel=1, DefaultLevel=6, BestLevel=9};
+
+    //! Construct a device on dev compressing at the given level.
+    GzipDevice(QIODevice *dev, int level=DefaultLevel, QObject *parent=nullptr);
+
+    //! Destructor, closes the device.
+    ~GzipDevice() override;
+
+    //! Return whether dev holds gzip data, without consuming it.
+    static bool isGzip(QIODevice *dev);
+
+    //! Return whether path names a gzip file.
+    static bool isGzipPath(const QString &path);
+
+    //! Return the path without a .gz suffix.
+    static QString stripGzipSuffix(const QString &path);
+
+    //! Return dev, or a decompressing device reading from dev if dev holds
+    //! gzip data. The gzip device is a child of dev.
+    static QIODevice *decompressing(QIODevice *dev);
+
+    //! Return dev, or a device compressing to dev at the given level if
+    //! path names a gzip file. The gzip device is a child of dev.
+    static QIODevice *compressing(QIODevice *dev, const QString &path, int level=DefaultLevel);
+
+    // QIODevice overrides
+    bool isSequential() const override {return true;}
+    bool open(QIODevice::OpenMode mode) override;
+    void close() override;
+    bool atEnd() const override;
+
+  protected:
+
+    qint64 readData(char *data, qint64 max_size) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+  private:
+
+    // read and check the gzip header
+    bool readHeader();
+
+    // read and check the gzip trailer after the deflate stream
+    bool readTrailer();
+
+    // write the compressed output of the stream to the underlying device
+    // until the stream is done with flush
+    bool deflateInput(int flush);
+
+    struct ZStream;
+
+    QIODevice *dev;
+    int level;
+    std::unique_ptr<ZStream> zs;
+    QByteArray buf;         // compressed input or output
+    quint32 crc=0;          // CRC-32 of the uncompressed data
+    quint32 total=0;        // uncompressed size modulo 2^32
+    bool stream_end=false;  // the deflate stream is over
+  };
+
+} // end gui namespace
+
+#endif
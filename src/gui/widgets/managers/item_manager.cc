@@ -8,8 +8,259 @@
 
 #include "item_manager.h"
 
+#include <algorithm>
+
 namespace gui{
 
+// ItemTableModel
+
+ItemTableModel::ItemTableModel(LayerManager *layman, QObject *parent)
+  : QAbstractTableModel(parent), layman(layman)
+{
+  connect(layman, &LayerManager::sig_layerListChanged,
+          this, &ItemTableModel::resetLayers);
+  resetLayers();
+}
+
+void ItemTableModel::resetLayers()
+{
+  beginResetModel();
+  layers.clear();
+  row_offsets.clear();
+  total_rows = 0;
+  for (int i=0; i<layman->layerCount(); i++) {
+    prim::Layer *layer = layman->getLayer(i);
+    layers.append(layer);
+    row_offsets.append(total_rows);
+    total_rows += layer->getItems().size();
+
+    // connections of deleted layers are dropped by Qt, UniqueConnection
+    // prevents duplicates for layers that remain
+    connect(layer, &prim::Layer::sig_itemsAboutToBeInserted,
+            this, &ItemTableModel::layerItemsAboutToBeInserted, Qt::UniqueConnection);
+    connect(layer, &prim::Layer::sig_itemsInserted,
+            this, &ItemTableModel::layerItemsInserted, Qt::UniqueConnection);
+    connect(layer, &prim::Layer::sig_itemsAboutToBeRemoved,
+            this, &ItemTableModel::layerItemsAboutToBeRemoved, Qt::UniqueConnection);
+    connect(layer, &prim::Layer::sig_itemsRemoved,
+            this, &ItemTableModel::layerItemsRemoved, Qt::UniqueConnection);
+    connect(layer, &prim::Layer::sig_itemsAboutToBeReset,
+            this, &ItemTableModel::layerItemsAboutToBeReset, Qt::UniqueConnection);
+    connect(layer, &prim::Layer::sig_itemsReset,
+            this, &ItemTableModel::layerItemsReset, Qt::UniqueConnection);
+  }
+  endResetModel();
+}
+
+void ItemTableModel::layerItemsAboutToBeInserted(int first, int last)
+{
+  int lay_pos = layerPosition(sender());
+  if (lay_pos >= 0)
+    beginInsertRows(QModelIndex(), row_offsets[lay_pos]+first, row_offsets[lay_pos]+last);
+}
+
+void ItemTableModel::layerItemsInserted(int first, int last)
+{
+  int lay_pos = layerPosition(sender());
+  if (lay_pos < 0)
+    return;
+  shiftOffsets(lay_pos, last-first+1);
+  endInsertRows();
+}
+
+void ItemTableModel::layerItemsAboutToBeRemoved(int first, int last)
+{
+  int lay_pos = layerPosition(sender());
+  if (lay_pos >= 0)
+    beginRemoveRows(QModelIndex(), row_offsets[lay_pos]+first, row_offsets[lay_pos]+last);
+}
+
+void ItemTableModel::layerItemsRemoved(int first, int last)
+{
+  int lay_pos = layerPosition(sender());
+  if (lay_pos < 0)
+    return;
+  shiftOffsets(lay_pos, -(last-first+1));
+  endRemoveRows();
+}
+
+void ItemTableModel::layerItemsAboutToBeReset()
+{
+  if (layerPosition(sender()) >= 0)
+    beginResetModel();
+}
+
+void ItemTableModel::layerItemsReset()
+{
+  int lay_pos = layerPosition(sender());
+  if (lay_pos < 0)
+    return;
+  // only the size of the sending layer changed
+  int old_size = (lay_pos+1 < row_offsets.size() ? row_offsets[lay_pos+1] : total_rows)
+      - row_offsets[lay_pos];
+  shiftOffsets(lay_pos, layers[lay_pos]->getItems().size() - old_size);
+  endResetModel();
+}
+
+int ItemTableModel::layerPosition(QObject *layer) const
+{
+  // only a handful of layers exist, a linear scan is cheapest
+  for (int i=0; i<layers.size(); i++)
+    if (layers[i] == layer)
+      return i;
+  return -1;
+}
+
+void ItemTableModel::shiftOffsets(int lay_pos, int delta)
+{
+  for (int i=lay_pos+1; i<row_offsets.size(); i++)
+    row_offsets[i] += delta;
+  total_rows += delta;
+}
+
+prim::Item *ItemTableModel::itemAt(int row) const
+{
+  if (row < 0 || row >= total_rows)
+    return nullptr;
+  // last layer whose first row is at or before the requested row
+  int lay_pos = std::upper_bound(row_offsets.constBegin(), row_offsets.constEnd(),
+      row) - row_offsets.constBegin() - 1;
+  QStack<prim::Item*> &items = layers[lay_pos]->getItems();
+  int ind = row - row_offsets[lay_pos];
+  return ind < items.size() ? items.at(ind) : nullptr;
+}
+
+int ItemTableModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : total_rows;
+}
+
+int ItemTableModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(ColumnCount);
+}
+
+QVariant ItemTableModel::data(const QModelIndex &index, int role) const
+{
+  if (!index.isValid() || role != Qt::DisplayRole)
+    return QVariant();
+  prim::Item *item = itemAt(index.row());
+  if (item == nullptr)
+    return QVariant();
+
+  switch (index.column()) {
+    case Type:
+      return item->getQStringItemType();
+    case LayerName:
+    {
+      prim::Layer *layer = layman->getLayer(item->layer_id);
+      return layer ? layer->getName() : QString();
+    }
+    case LayerID:
+      return item->layer_id;
+    case Index:
+    {
+      int lay_pos = std::upper_bound(row_offsets.constBegin(), row_offsets.constEnd(),
+          index.row()) - row_offsets.constBegin() - 1;
+      return index.row() - row_offsets[lay_pos];
+    }
+    case Properties:
+      //the text must be exactly "Show properties" in order to trigger showProps() from items
+      return QString("Show properties");
+    default:
+      return QVariant();
+  }
+}
+
+QVariant ItemTableModel::headerData(int section, Qt::Orientation orientation,
+    int role) const
+{
+  if (orientation != Qt::Horizontal)
+    return QVariant();
+
+  if (role == Qt::DisplayRole) {
+    switch (section) {
+      case Type:        return QString("Type");
+      case LayerName:   return QString("Layer Name");
+      case LayerID:     return QString("Layer ID");
+      case Index:       return QString("Index");
+      case Properties:  return QString("Properties");
+      default:          break;
+    }
+  } else if (role == Qt::ToolTipRole) {
+    switch (section) {
+      case Type:        return QString("Item type: DBDot, Electrode, etc.");
+      case LayerName:   return QString("Layer Name");
+      case LayerID:     return QString("Layer ID");
+      case Index:       return QString("Item index");
+      case Properties:  return QString("Show properties");
+      default:          break;
+    }
+  }
+  return QVariant();
+}
+
+
+// PropertiesButtonDelegate
+
+QStyleOptionButton PropertiesButtonDelegate::buttonOption(
+    const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+  QStyleOptionButton button;
+  button.rect = option.rect;
+  button.text = index.data().toString();
+  button.state = QStyle::State_Enabled;
+  button.state |= (index == pressed_index) ? QStyle::State_Sunken : QStyle::State_Raised;
+  return button;
+}
+
+void PropertiesButtonDelegate::paint(QPainter *painter,
+    const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+  QStyleOptionButton button = buttonOption(option, index);
+  QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+  style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+}
+
+QSize PropertiesButtonDelegate::sizeHint(const QStyleOptionViewItem &option,
+    const QModelIndex &index) const
+{
+  QStyleOptionButton button = buttonOption(option, index);
+  QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+  QSize text_size = option.fontMetrics.size(Qt::TextShowMnemonic, button.text);
+  return style->sizeFromContents(QStyle::CT_PushButton, &button, text_size, option.widget);
+}
+
+bool PropertiesButtonDelegate::editorEvent(QEvent *event, QAbstractItemModel *,
+    const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+  switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    {
+      QMouseEvent *e = static_cast<QMouseEvent*>(event);
+      if (e->button() == Qt::LeftButton && option.rect.contains(e->position().toPoint()))
+        pressed_index = index;
+      break;
+    }
+    case QEvent::MouseButtonRelease:
+    {
+      QMouseEvent *e = static_cast<QMouseEvent*>(event);
+      bool clicked = pressed_index == index && option.rect.contains(e->position().toPoint());
+      pressed_index = QPersistentModelIndex();
+      if (clicked)
+        emit sig_clicked(index.row());
+      break;
+    }
+    default:
+      break;
+  }
+  // let the view handle selection as with any other cell
+  return false;
+}
+
+
+// ItemManager
+
 ItemManager::ItemManager(QWidget *parent, LayerManager* layman_in)
   : QWidget(parent, Qt::Dialog)
 {
@@ -19,23 +270,35 @@ ItemManager::ItemManager(QWidget *parent, LayerManager* layman_in)
 
 ItemManager::~ItemManager()
 {
-  clearItemTable();
   layman = 0;
   delete item_table;
+  delete item_model;
   delete main_vl;
 }
 
 void ItemManager::initItemManager()
 {
-  // item_table = new QTableWidget(this);
-  item_table = new TableWidget(this);
+  item_model = new ItemTableModel(layman);
+
+  item_table = new TableView(this);
+  item_table->setModel(item_model);
   connect(item_table, SIGNAL(sig_update_selection()),
           this, SLOT(updateItemSelection()));
   connect(item_table, SIGNAL(sig_delete_selection()),
           this, SLOT(deleteItemSelection()));
+
+  PropertiesButtonDelegate *bt_delegate = new PropertiesButtonDelegate(item_table);
+  item_table->setItemDelegateForColumn(static_cast<int>(ItemTableModel::Properties),
+      bt_delegate);
+  connect(bt_delegate, &PropertiesButtonDelegate::sig_clicked,
+          this, &ItemManager::showProperties);
+
+  // reduce width of columns, done once while the table is small since sizing
+  // to contents touches every row
+  item_table->resizeColumnsToContents();
+
   main_vl = new QVBoxLayout;
   main_vl->addWidget(item_table);
-  initItemTableHeaders();
   setLayout(main_vl);
 }
 
@@ -43,9 +306,10 @@ void ItemManager::updateItemSelection()
 {
   //deselect all items
   emit sig_deselect();
-  for (QTableWidgetItem *item : item_table->selectedItems()){
-    ItemTableRowContent* content = table_row_contents[item->row()];
-    content->item->setSelected(true);
+  for (const QModelIndex &index : item_table->selectionModel()->selectedRows()) {
+    prim::Item *item = item_model->itemAt(index.row());
+    if (item)
+      item->setSelected(true);
   }
 }
 
@@ -55,138 +319,42 @@ void ItemManager::deleteItemSelection()
   // qDebug() << "Deleting item";
 }
 
-void ItemManager::clearItemTable()
-{
-  while (!table_row_contents.isEmpty()) {
-    ItemTableRowContent *row_content = table_row_contents.takeLast();
-    row_content->bt_show_properties->disconnect();
-    delete row_content;
-  }
-  item_table->setRowCount(0);  // delete all rows from layer table
-}
-
-void ItemManager::initItemTableHeaders()
-{
-  qDebug() << "Initializing item table headers";
-  QStringList table_headers;
-
-  // TODO take enum type instead of this stringlist
-  table_headers <<
-    "Type" <<       // item_type QString
-    "Layer Name" <<      // owning layer's index
-    "Layer ID" <<      // owning layer's index
-    "Index" <<      // item's index within the layer
-    "Properties"; // button to show properties
-
-  item_table->setColumnCount(table_headers.length());
-  item_table->setHorizontalHeaderLabels(table_headers);
-  item_table->resizeColumnToContents(static_cast<int>(Type)); // reduce width of visibility column
-  item_table->resizeColumnToContents(static_cast<int>(LayerName)); // reduce width of visibility column
-  item_table->resizeColumnToContents(static_cast<int>(LayerID)); // reduce width of visibility column
-  item_table->resizeColumnToContents(static_cast<int>(Index)); // reduce width of visibility column
-  item_table->resizeColumnToContents(static_cast<int>(Properties)); // reduce width of visibility column
-
-  // header tooltips
-  item_table->horizontalHeaderItem(static_cast<int>(Type))->
-      setToolTip("Item type: DBDot, Electrode, etc.");
-  item_table->horizontalHeaderItem(static_cast<int>(LayerName))->
-      setToolTip("Layer Name");
-  item_table->horizontalHeaderItem(static_cast<int>(LayerID))->
-      setToolTip("Layer ID");
-  item_table->horizontalHeaderItem(static_cast<int>(Index))->
-      setToolTip("Item index");
-  item_table->horizontalHeaderItem(static_cast<int>(Properties))->
-      setToolTip("Show properties");
-}
-
-void ItemManager::updateTableAdd()
-{
-  for (int i=0;i < layman->layerCount(); i++) {
-    prim::Layer* layer = layman->getLayer(i);
-    for (prim::Item* item : layer->getItems()) {
-      addItemRow(item);
-    }
-  }
-}
-
-void ItemManager::addItemRow(prim::Item *item)
+void ItemManager::showProperties(int row)
 {
-  if (item == 0)
+  prim::Item *item = item_model->itemAt(row);
+  if (item == nullptr)
     return;
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->item == item) {
-      return;
-    }
-  }
-  ItemTableRowContent *new_content = new ItemTableRowContent();
-  new_content->item = item;
-  new_content->type = new QTableWidgetItem(item->getQStringItemType());
-  new_content->layer_name = new QTableWidgetItem(layman->getLayer(item->layer_id)->getName());
-  new_content->layer_id = new QTableWidgetItem(QString::number(item->layer_id));
-  new_content->index = new QTableWidgetItem(QString::number(layman->getLayer(item->layer_id)->getItemIndex(item)));
-  //the QString in buttons must be exactly "Show properties" in order to trigger showProps() from items
-  new_content->bt_show_properties = new QPushButton(QString("Show properties"), this);
-  connect(new_content->bt_show_properties, &QAbstractButton::clicked, this, &ItemManager::showProperties);
-
-  table_row_contents.append(new_content);
-  int curr_row = item_table->rowCount();
-  item_table->insertRow(curr_row);
-  item_table->setItem(curr_row, static_cast<int>(Type), new_content->type);
-  item_table->setItem(curr_row, static_cast<int>(LayerName), new_content->layer_name);
-  item_table->setItem(curr_row, static_cast<int>(LayerID), new_content->layer_id);
-  item_table->setItem(curr_row, static_cast<int>(Index), new_content->index);
-  item_table->setCellWidget(curr_row, static_cast<int>(Properties), new_content->bt_show_properties);
-}
-
-
-void ItemManager::showProperties()
-{
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->bt_show_properties == static_cast<QPushButton *>(sender())) {
-      QAction temp_action;
-      temp_action.setText(row_content->bt_show_properties->text());
-      row_content->item->performAction(&temp_action);
-      return;
-    }
-  }
-}
-
-void ItemManager::updateTableRemove(prim::Item *item)
-{
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->item == item) {
-      table_row_contents.removeAt(table_row_contents.indexOf(row_content));
-      item_table->removeRow(item_table->row(row_content->type));
-      row_content->bt_show_properties->disconnect();
-      return;
-    }
-  }
+  QAction temp_action;
+  temp_action.setText(item_model->index(row, ItemTableModel::Properties).data().toString());
+  item->performAction(&temp_action);
 }
 
-TableWidget::TableWidget(QWidget *parent)
-  :QTableWidget(parent)
+TableView::TableView(QWidget *parent)
+  :QTableView(parent)
 {
-  initTableWidget();
+  initTableView();
   delete_action = menu.addAction("Delete", this, SLOT(deleteItems()));
 }
 
-void TableWidget::initTableWidget()
+void TableView::initTableView()
 {
   //hide the left hand column of numbers
   verticalHeader()->hide();
+  //rows share one height so that only visible rows are ever queried
+  verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
   //force full row selection
   setSelectionBehavior(QAbstractItemView::SelectRows);
 }
 
-void TableWidget::deleteItems()
+void TableView::deleteItems()
 {
   emit sig_delete_selection();
 }
 
-void TableWidget::showContextMenu(const QPoint& p)
+void TableView::showContextMenu(const QPoint& p)
 {
   QPoint p_global = mapToGlobal(p);
-  if (selectedItems().length() == 0)
+  if (!selectionModel() || !selectionModel()->hasSelection())
   {
     delete_action->setEnabled(false);
   } else {
@@ -195,24 +363,24 @@ void TableWidget::showContextMenu(const QPoint& p)
   menu.exec(p_global);
 }
 
-void TableWidget::mousePressEvent(QMouseEvent *e)
+void TableView::mousePressEvent(QMouseEvent *e)
 {
   switch(e->button()) {
     case Qt::RightButton:
     {
       // qDebug() << "Right Clicked!";
-      QTableWidget::mousePressEvent(e);
+      QTableView::mousePressEvent(e);
       break;
     }
     default:
     {
-      QTableWidget::mousePressEvent(e);
+      QTableView::mousePressEvent(e);
       break;
     }
   }
 }
 
-void TableWidget::mouseReleaseEvent(QMouseEvent *e)
+void TableView::mouseReleaseEvent(QMouseEvent *e)
 {
   // qDebug() << "Release";
   switch(e->button()) {
@@ -221,22 +389,22 @@ void TableWidget::mouseReleaseEvent(QMouseEvent *e)
       //catch the release off the left mouse button.
       //Update selection of items on the scene according to the
       //selected items in the manager.
-      QTableWidget::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       emit sig_update_selection();
       break;
     }
     case Qt::RightButton:
     {
       // qDebug() << "Right Clicked!";
-      // QTableWidget::mouseReleaseEvent(e);
-      QTableWidget::mouseReleaseEvent(e);
+      // QTableView::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       emit sig_update_selection();
       showContextMenu(e->pos());
       break;
     }
     default:
     {
-      QTableWidget::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       break;
     }
   }
@@ -15,59 +15,129 @@
 #include "layer_manager.h"
 
 namespace gui{
-  class ItemManager : public QWidget
+
+  //! Table model exposing the items of all design layers, one row per item in
+  //! layer order. Rows are read directly from the layers' item stacks and the
+  //! model follows the layers' insertion and removal signals, so adding or
+  //! removing an item only shifts the row offsets of the following layers.
+  class ItemTableModel : public QAbstractTableModel
   {
     Q_OBJECT
 
   public:
 
-    enum ItemManagerColumn{Type, LayerName, LayerID, Index, Properties};
-    Q_ENUM(ItemManagerColumn)
+    enum ItemTableColumn{Type, LayerName, LayerID, Index, Properties, ColumnCount};
+    Q_ENUM(ItemTableColumn)
 
+    //! Constructor.
+    ItemTableModel(LayerManager *layman, QObject *parent=nullptr);
 
-    ItemManager(QWidget *parent, LayerManager* layman_in);
-    ~ItemManager();
+    //! Return the item shown in the given row, or nullptr if out of range.
+    prim::Item *itemAt(int row) const;
+
+    // QAbstractTableModel overrides
+    int rowCount(const QModelIndex &parent=QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent=QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+        int role=Qt::DisplayRole) const override;
 
-    // bool eventFilter(QObject *object, QEvent *event);
+  public slots:
+
+    //! Rebuild the layer list after layers were added or removed.
+    void resetLayers();
+
+  private slots:
+
+    // follow item insertion and removal of the sending layer
+    void layerItemsAboutToBeInserted(int first, int last);
+    void layerItemsInserted(int first, int last);
+    void layerItemsAboutToBeRemoved(int first, int last);
+    void layerItemsRemoved(int first, int last);
+    void layerItemsAboutToBeReset();
+    void layerItemsReset();
+
+  private:
 
-    struct ItemTableRowContent
-    {
-      prim::Item *item;
-      QTableWidgetItem *type;
-      QTableWidgetItem *layer_name;
-      QTableWidgetItem *layer_id;
-      QTableWidgetItem *index;
-      QPushButton *bt_show_properties;
-    };
+    // find the position of the layer in the layer list, -1 if absent
+    int layerPosition(QObject *layer) const;
+
+    // shift row offsets of the layers following layer position lay_pos
+    void shiftOffsets(int lay_pos, int delta);
+
+    LayerManager *layman;
+    QVector<prim::Layer*> layers; // design layers in row order
+    QVector<int> row_offsets;     // first row of each layer
+    int total_rows=0;
+  };
+
+
+  //! Delegate drawing a "Show properties" button in place of a per-row
+  //! QPushButton widget.
+  class PropertiesButtonDelegate : public QStyledItemDelegate
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    PropertiesButtonDelegate(QObject *parent=nullptr) : QStyledItemDelegate(parent) {}
+
+    // QStyledItemDelegate overrides
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+        const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option,
+        const QModelIndex &index) const override;
+    bool editorEvent(QEvent *event, QAbstractItemModel *model,
+        const QStyleOptionViewItem &option, const QModelIndex &index) override;
+
+  signals:
+
+    //! Emitted when the button in the given row has been clicked.
+    void sig_clicked(int row);
+
+  private:
+
+    // button option for the given cell
+    QStyleOptionButton buttonOption(const QStyleOptionViewItem &option,
+        const QModelIndex &index) const;
+
+    QPersistentModelIndex pressed_index; // cell with the button held down
+  };
+
+
+  class ItemManager : public QWidget
+  {
+    Q_OBJECT
+
+  public:
+
+    ItemManager(QWidget *parent, LayerManager* layman_in);
+    ~ItemManager();
 
   signals:
     void sig_deselect();
     void sig_delete_selected();
 
   public slots:
-    void updateTableAdd();
-    void updateTableRemove(prim::Item* item);
-    void showProperties();
+    void showProperties(int row);
     void updateItemSelection();
     void deleteItemSelection();
 
   private:
     void initItemManager();
-    void initItemTableHeaders();
-    void addItemRow(prim::Item *item);
-    void clearItemTable();
 
     LayerManager *layman;
-    QTableWidget *item_table;
-    QList<ItemTableRowContent*> table_row_contents;
+    ItemTableModel *item_model;
+    QTableView *item_table;
     QVBoxLayout *main_vl;
   };
 
-  class TableWidget: public QTableWidget
+  class TableView: public QTableView
   {
     Q_OBJECT
   public:
-    TableWidget(QWidget *parent = 0);
+    TableView(QWidget *parent = 0);
 
   signals:
     void sig_update_selection();
@@ -82,7 +152,7 @@ namespace gui{
     void mousePressEvent(QMouseEvent *e) Q_DECL_OVERRIDE;
 
   private:
-    void initTableWidget();
+    void initTableView();
 
     QMenu menu;
     QAction *delete_action = 0;
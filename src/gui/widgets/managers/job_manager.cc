@@ -9,7 +9,9 @@
 #include "job_manager.h"
 #include "global.h"
 #include "helpers/map_helper.h"
+#include "../components/result_cache.h"
 #include <initializer_list>
+#include <algorithm>
 
 using namespace gui;
 
@@ -20,6 +22,18 @@ JobManager::JobManager(PluginManager *plugin_manager, SimVisualizer *sim_visuali
   : QWidget(parent, Qt::Dialog), plugin_manager(plugin_manager),
     sim_visualizer(sim_visualizer)
 {
+  // wait times of queued jobs tick while the queue isn't empty
+  wait_timer = new QTimer(this);
+  wait_timer->setInterval(1000);
+  connect(wait_timer, &QTimer::timeout,
+          [this]()
+          {
+            for (comp::SimJob *job : job_queue)
+              updateJobViewRow(job);
+            if (job_queue.isEmpty())
+              wait_timer->stop();
+          });
+
   initJobManagerGUI();
 }
 
@@ -55,14 +69,21 @@ void JobManager::addJob(comp::SimJob *job)
   // TODO better implementation in the future, current implementation is a quick hack
   QList<QStandardItem*> row_job_info;
   row_job_info.append(new QStandardItem(job->name()));
+  row_job_info.append(new QStandardItem());  // state
+  row_job_info.append(new QStandardItem());  // cores
+  row_job_info.append(new QStandardItem());  // wait time
   job_view_model->insertRow(0, row_job_info); // prepend row
+  job_view_items.insert(job, row_job_info.first());
+  updateJobViewRow(job);
 
   QList<QWidget*> row_widgets({
         job->guiControlElems().pb_terminate,
         job->guiControlElems().pb_sim_visualize,
         job->guiControlElems().pb_job_terminal,
-        job->guiControlElems().pb_export_results
+        job->guiControlElems().pb_export_results,
+        job->guiControlElems().pb_sweep_table
       });
+  job->guiControlElems().pb_sweep_table->setEnabled(job->isSweep());
 
   tv_job_view->resizeColumnToContents(0);
   QModelIndex mi_back = job_view_model->indexFromItem(row_job_info.back());
@@ -77,11 +98,28 @@ void JobManager::addJob(comp::SimJob *job)
 void JobManager::runJob(comp::SimJob *job)
 {
   addJob(job);
-  job->beginJob();
+  // export the problems now, the design may change while the job waits
+  job->prepareJob();
+  job->enqueue();
+  job_queue.append(job);
+  qDebug() << tr("Queued job %1 needing %2 cores.").arg(job->name())
+    .arg(job->coreRequirement());
+  startQueuedJobs();
+  updateJobViewRow(job);
+  if (!job_queue.isEmpty())
+    wait_timer->start();
 }
 
 void JobManager::processFinishedJob(comp::SimJob *job, comp::SimJob::JobState)
 {
+  // free the cores of the job and let waiting jobs take them once the
+  // finishing job's signal handlers are done
+  job_queue.removeAll(job);
+  job_cores.remove(job);
+  updateJobViewRow(job);
+  updateCacheStats();
+  QTimer::singleShot(0, this, &JobManager::startQueuedJobs);
+
   // TODO if successful, check that result files are all successfully read (add
   // a flag in job steps to facilitate this)
 
@@ -111,6 +149,20 @@ void JobManager::processFinishedJob(comp::SimJob *job, comp::SimJob::JobState)
   }
 }
 
+void JobManager::setQueuePaused(bool paused)
+{
+  queue_paused = paused;
+  qDebug() << (paused ? "Job queue paused." : "Job queue resumed.");
+  if (!paused)
+    startQueuedJobs();
+}
+
+int JobManager::coreBudget()
+{
+  int budget = settings::AppSettings::instance()->get<int>("plugs/job_core_budget");
+  return budget > 0 ? budget : qMax(1, QThread::idealThreadCount());
+}
+
 bool JobManager::eligibleForSimVisualizer(comp::SimJob *job)
 {
   for (comp::JobResult::ResultType type : job->resultTypeStepMap().keys())
@@ -484,14 +536,32 @@ QWidget *JobManager::initJobSetupPanel()
               mb_no_js.exec();
               return;
             }
-            hide();
             auto job_details = job_details_pane->finalJobDetails();
+            prim::AreaOfInterest job_area;
+            if (job_details.inclusion_area == gui::IncludeAreaOfInterest) {
+              job_area = jobAreaOfInterest();
+              if (!job_area.isValid()) {
+                QMessageBox *msg = new QMessageBox(this);
+                msg->setAttribute(Qt::WA_DeleteOnClose);
+                msg->setText(tr("No area of interest is set. Draw one with "
+                      "Tools -> Area of Interest before running the job."));
+                msg->open();
+                return;
+              }
+              job_area.halo = job_details.aoi_halo;
+            }
+            hide();
             if (job_details.name.isEmpty()) {
               job_details.name = comp::SimJob::defaultJobName();
             }
             // create sim job and submit to application
             comp::SimJob *new_job = new comp::SimJob(job_details.name, nullptr);
             new_job->setInclusionArea(job_details.inclusion_area);
+            new_job->setAreaOfInterest(job_area);
+            new_job->setMaxParallelSteps(job_details.max_parallel_steps);
+            new_job->setPriority(job_details.priority);
+            new_job->setUseResultCache(job_details.use_result_cache);
+            QList<int> prev_placements; // steps the previous job step expanded to
             for (int i=0; i<job_steps_model->rowCount(); i++) {
               QStandardItem *si_job_step = job_steps_model->item(i);
               EngineDataset *eng_dataset = static_cast<JobStepViewListItem*>(si_job_step)->eng_dataset;
@@ -510,10 +580,57 @@ QWidget *JobManager::initJobSetupPanel()
 
                 return;
               }
-              // create a sim job step and add it to the job
-              new_job->addJobStep(new comp::JobStep(eng_dataset->engine,
-                                                    eng_dataset->command_format.split("\n"),
-                                                    eng_dataset->prop_form->finalProperties()));
+              // numeric parameters entered as sweep expressions expand the
+              // job step into a step per sweep point, text parameters are
+              // passed on as entered
+              gui::PropertyMap props = eng_dataset->prop_form->finalProperties();
+              comp::ParameterSweep sweep(job_details.sweep_mode);
+              QString sweep_err;
+              for (const QString &key : props.keys()) {
+                if (!eng_dataset->prop_form->isNumeric(key))
+                  continue;
+                QString text = eng_dataset->prop_form->formText(key);
+                if (comp::ParameterSweep::isSweepExpression(text)
+                    && !sweep.addParameter(key, text, sweep_err))
+                  break;
+              }
+              if (sweep_err.isEmpty())
+                sweep.validate(sweep_err);
+              if (!sweep_err.isEmpty()) {
+                delete new_job;
+
+                QMessageBox *msg = new QMessageBox(this);
+                msg->setAttribute(Qt::WA_DeleteOnClose);
+                msg->setText(tr("Invalid parameter sweep for plugin %1, "
+                      "aborting job.\n%2").arg(eng_dataset->engine->name())
+                    .arg(sweep_err));
+                msg->open();
+
+                return;
+              }
+
+              // create sim job steps and add them to the job, sweep points
+              // share the problem exported for the first point
+              QList<int> placements;
+              int first_placement = new_job->jobSteps().length();
+              for (int p=0; p<qMax(1, sweep.pointCount()); p++) {
+                gui::PropertyMap point_props = props;
+                QMap<QString, QString> point = sweep.isEmpty()
+                  ? QMap<QString, QString>() : sweep.point(p);
+                for (auto it = point.cbegin(); it != point.cend(); ++it)
+                  point_props[it.key()].value = it.value();
+                comp::JobStep *js = new comp::JobStep(eng_dataset->engine,
+                                                      eng_dataset->command_format.split("\n"),
+                                                      point_props);
+                if (eng_dataset->after_previous_step)
+                  js->setDependencies(prev_placements);
+                js->setSweepPoint(point);
+                if (p > 0)
+                  js->setProblemSource(first_placement);
+                placements.append(new_job->jobSteps().length());
+                new_job->addJobStep(js);
+              }
+              prev_placements = placements;
             }
             runJob(new_job);
           });
@@ -543,7 +660,8 @@ QWidget *JobManager::initJobSetupPanel()
 QWidget *JobManager::initJobViewPanel()
 {
   job_view_model = new QStandardItemModel();
-  job_view_model->setColumnCount(5);  // TODO make dynamic
+  job_view_model->setColumnCount(9);  // TODO make dynamic
+  job_view_model->setHorizontalHeaderLabels({"Job", "State", "Cores", "Wait"});
   tv_job_view = new QTreeView();
   tv_job_view->header()->setStretchLastSection(false);
   tv_job_view->setModel(job_view_model);
@@ -553,13 +671,46 @@ QWidget *JobManager::initJobViewPanel()
 
   QPushButton *pb_close = new QPushButton("Close", this);
   QPushButton *pb_import_job_results = new QPushButton("Import Past Results", this);
+  QPushButton *pb_pause_queue = new QPushButton("Pause Queue", this);
+  pb_pause_queue->setCheckable(true);
+  pb_pause_queue->setToolTip(tr("Keep queued jobs from starting, running jobs "
+        "continue. Jobs share %1 cores, set by plugs/job_core_budget.")
+      .arg(coreBudget()));
   pb_close->setShortcut(Qt::Key_Escape);
   QDialogButtonBox *dbb_job_view_buttons = new QDialogButtonBox();
   dbb_job_view_buttons->addButton(pb_close, QDialogButtonBox::RejectRole);
   dbb_job_view_buttons->addButton(pb_import_job_results, QDialogButtonBox::ActionRole);
+  dbb_job_view_buttons->addButton(pb_pause_queue, QDialogButtonBox::ActionRole);
+
+  connect(pb_pause_queue, &QPushButton::toggled,
+          [this, pb_pause_queue](bool checked)
+          {
+            pb_pause_queue->setText(checked ? "Resume Queue" : "Pause Queue");
+            setQueuePaused(checked);
+          });
+
+  // result cache statistics and controls
+  l_cache_stats = new QLabel();
+  QCheckBox *cb_cache_enabled = new QCheckBox("Use result cache for new jobs");
+  cb_cache_enabled->setChecked(comp::ResultCache::enabledByDefault());
+  QPushButton *pb_clear_cache = new QPushButton("Clear Cache");
+  connect(cb_cache_enabled, &QCheckBox::toggled,
+          [](bool checked){comp::ResultCache::setEnabledByDefault(checked);});
+  connect(pb_clear_cache, &QPushButton::clicked,
+          [this]()
+          {
+            comp::ResultCache::instance()->clear();
+            updateCacheStats();
+          });
+  QHBoxLayout *hl_cache = new QHBoxLayout();
+  hl_cache->addWidget(l_cache_stats);
+  hl_cache->addStretch();
+  hl_cache->addWidget(cb_cache_enabled);
+  hl_cache->addWidget(pb_clear_cache);
 
   vl_job_view = new QVBoxLayout();
   vl_job_view->addWidget(tv_job_view);
+  vl_job_view->addLayout(hl_cache);
   vl_job_view->addWidget(dbb_job_view_buttons);
 
   QWidget *vl_job_view_widget = new QWidget();
@@ -580,6 +731,99 @@ QWidget *JobManager::initJobViewPanel()
   return vl_job_view_widget;
 }
 
+void JobManager::startQueuedJobs()
+{
+  if (queue_paused || job_queue.isEmpty())
+    return;
+
+  // higher priority first, queue order within a priority
+  std::stable_sort(job_queue.begin(), job_queue.end(),
+      [](comp::SimJob *a, comp::SimJob *b)
+      {
+        return a->jobPriority() > b->jobPriority();
+      });
+
+  int budget = coreBudget();
+  int used = 0;
+  for (int cores : job_cores)
+    used += cores;
+
+  while (!job_queue.isEmpty()) {
+    comp::SimJob *job = job_queue.first();
+    // jobs needing more than the budget run alone
+    int cores = qMin(job->coreRequirement(), budget);
+    if (used > 0 && used + cores > budget)
+      break;
+    job_queue.removeFirst();
+    job_cores.insert(job, cores);
+    used += cores;
+    qDebug() << tr("Starting job %1 on %2 of %3 cores after waiting %4 s.")
+      .arg(job->name()).arg(cores).arg(budget).arg(job->waitSecs());
+    // a job failing to begin reports its finish state right away and frees
+    // its cores
+    job->beginJob();
+    if (!job_cores.contains(job))
+      used -= cores;
+    updateJobViewRow(job);
+  }
+}
+
+void JobManager::updateJobViewRow(comp::SimJob *job)
+{
+  QStandardItem *si_name = job_view_items.value(job);
+  if (si_name == nullptr)
+    return;
+  int row = si_name->row();
+  comp::SimJob::JobState state = job->jobState();
+
+  QString cores_str;
+  if (job_cores.contains(job))
+    cores_str = QString::number(job_cores.value(job));
+  else if (state == comp::SimJob::Queued)
+    cores_str = QString::number(qMin(job->coreRequirement(), coreBudget()));
+
+  QString wait_str;
+  if (job->queueTime().isValid()) {
+    qint64 secs = job->waitSecs();
+    wait_str = QString("%1:%2:%3").arg(secs / 3600)
+      .arg((secs / 60) % 60, 2, 10, QChar('0')).arg(secs % 60, 2, 10, QChar('0'));
+  }
+
+  QString state_str = QMetaEnum::fromType<comp::SimJob::JobState>().valueToKey(state);
+  if (state == comp::SimJob::Queued) {
+    state_str += tr(" (%1)").arg(QMetaEnum::fromType<comp::SimJob::JobPriority>()
+        .valueToKey(job->jobPriority()));
+  }
+  job_view_model->item(row, 1)->setText(state_str);
+  job_view_model->item(row, 2)->setText(cores_str);
+  job_view_model->item(row, 3)->setText(wait_str);
+}
+
+void JobManager::updateCacheStats()
+{
+  comp::ResultCache::Stats stats = comp::ResultCache::instance()->stats();
+  int lookups = stats.hits + stats.misses;
+  l_cache_stats->setText(tr("Result cache: %1 hits, %2 misses (%3% hit rate), "
+        "%4 entries, %5 MB")
+      .arg(stats.hits).arg(stats.misses)
+      .arg(lookups > 0 ? 100 * stats.hits / lookups : 0)
+      .arg(stats.entries).arg(stats.bytes / 1048576.0, 0, 'f', 1));
+  l_cache_stats->setToolTip(tr("%1 results stored and %2 evicted this session.")
+      .arg(stats.stores).arg(stats.evictions));
+}
+
+prim::AreaOfInterest JobManager::jobAreaOfInterest() const
+{
+  if (area_of_interest.isValid())
+    return area_of_interest;
+  for (int i=sim_jobs.size()-1; i>=0; i--) {
+    prim::AreaOfInterest job_area = sim_jobs[i]->areaOfInterest();
+    if (job_area.isValid())
+      return job_area;
+  }
+  return prim::AreaOfInterest();
+}
+
 comp::PluginEngine *JobManager::selectedEngine()
 {
   QModelIndex model_index = lv_engines->currentIndex();
@@ -637,6 +881,53 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
     cbb_inclusion_area->addItem(inclusion_area_enum.key(i));
   }
 
+  // the halo only applies to the area of interest
+  sb_aoi_halo = new QDoubleSpinBox();
+  sb_aoi_halo->setRange(0, 1e4);
+  sb_aoi_halo->setDecimals(1);
+  sb_aoi_halo->setSuffix(" Å");
+  sb_aoi_halo->setValue(settings::AppSettings::instance()->get<qreal>("plugs/aoi_halo"));
+  sb_aoi_halo->setToolTip(tr("Items within this distance of the area of "
+        "interest are exported as context."));
+  connect(cbb_inclusion_area, &QComboBox::currentTextChanged,
+          [this, inclusion_area_enum](const QString &text)
+          {
+            sb_aoi_halo->setEnabled(inclusion_area_enum.keyToValue(text.toLatin1())
+                == gui::IncludeAreaOfInterest);
+          });
+  sb_aoi_halo->setEnabled(false);
+
+  // independent steps of a job run concurrently up to this count
+  sb_parallel_steps = new QSpinBox();
+  sb_parallel_steps->setRange(1, qMax(1, QThread::idealThreadCount()));
+  sb_parallel_steps->setValue(settings::AppSettings::instance()->get<int>("plugs/max_parallel_job_steps"));
+  sb_parallel_steps->setToolTip(tr("Maximum number of job steps running at the "
+        "same time. Only steps that don't wait for another step run in parallel."));
+
+  // queued jobs start in priority order
+  cbb_priority = new QComboBox();
+  QMetaEnum priority_enum = QMetaEnum::fromType<comp::SimJob::JobPriority>();
+  for (int i=0; i<priority_enum.keyCount(); i++) {
+    cbb_priority->addItem(QString(priority_enum.key(i)).remove("Priority"),
+        priority_enum.value(i));
+  }
+  cbb_priority->setCurrentIndex(cbb_priority->findData(comp::SimJob::NormalPriority));
+
+  // runtime parameters entered as sweep expressions expand into sweep points
+  cbb_sweep_mode = new QComboBox();
+  cbb_sweep_mode->addItem("Cartesian product", comp::ParameterSweep::CartesianSweep);
+  cbb_sweep_mode->addItem("Zipped", comp::ParameterSweep::ZippedSweep);
+  cb_use_result_cache = new QCheckBox("Use result cache");
+  cb_use_result_cache->setChecked(comp::ResultCache::enabledByDefault());
+  cb_use_result_cache->setToolTip(tr("Restore the results of steps whose "
+        "problem, plugin and parameters match an earlier run instead of "
+        "running the plugin again. Uncheck to bypass the cache."));
+
+  cbb_sweep_mode->setToolTip(tr("Sweep a runtime parameter by entering a range "
+        "start:stop:step or a list [a, b, c]. Swept parameters are combined "
+        "into every combination (Cartesian product) or value by value "
+        "(zipped). Each sweep point runs as its own job step."));
+
   // Job
   QHBoxLayout *hl_auto_job_name = new QHBoxLayout();
   hl_auto_job_name->addStretch();
@@ -645,6 +936,11 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   fl_job_props->addRow(new QLabel("Job name"), le_job_name);
   fl_job_props->addRow(hl_auto_job_name);
   fl_job_props->addRow(new QLabel("Inclusion area"), cbb_inclusion_area);
+  fl_job_props->addRow(new QLabel("Area halo"), sb_aoi_halo);
+  fl_job_props->addRow(new QLabel("Parallel steps"), sb_parallel_steps);
+  fl_job_props->addRow(new QLabel("Priority"), cbb_priority);
+  fl_job_props->addRow(new QLabel("Parameter sweep"), cbb_sweep_mode);
+  fl_job_props->addRow(cb_use_result_cache);
   fl_job_props->setSizeConstraint(QLayout::SetMinimumSize);
   gb_job_props->setLayout(fl_job_props);
 
@@ -672,11 +968,27 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   hl_command->addStretch();
   hl_command->addWidget(tb_command_preset);
 
+  cbb_step_start = new QComboBox();
+  cbb_step_start->addItem("After the previous step");
+  cbb_step_start->addItem("At job start");
+  cbb_step_start->setToolTip(tr("Steps started at job start don't wait for "
+        "the results of other steps and may run alongside them."));
+
   QFormLayout *fl_plugin_props = new QFormLayout();
   fl_plugin_props->addRow(hl_command);
   fl_plugin_props->addRow(te_command);
+  fl_plugin_props->addRow(new QLabel("Start"), cbb_step_start);
   gb_plugin_props->setLayout(fl_plugin_props);
 
+  // update the step dependency in engine dataset
+  connect(cbb_step_start, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          [this](int index)
+          {
+            if (eng_dataset == nullptr)
+              return;
+            eng_dataset->after_previous_step = (index == 0);
+          });
+
   // update command format in engine dataset to the newest textedit content
   connect(te_command, &QTextEdit::textChanged,
           [this]()
@@ -808,6 +1120,7 @@ void JobSetupDetailsPane::setEngineDataset(JobManager::EngineDataset *t_eng_data
   }
 
   te_command->setText(eng_dataset->command_format);
+  cbb_step_start->setCurrentIndex(eng_dataset->after_previous_step ? 0 : 1);
 
   // update engine command preset menu
   menu_command_preset->clear();
@@ -15,6 +15,7 @@
 #include "../property_form.h"
 #include "../components/plugin_engine.h"
 #include "../components/sim_job.h"
+#include "../components/parameter_sweep.h"
 #include "../visualizers/sim_visualizer.h"
 
 namespace gui{
@@ -62,6 +63,7 @@ namespace gui{
       comp::PluginEngine *engine=nullptr;
       QString command_format;           // command format with arguments delimited by "\n".
       PropertyForm *prop_form=nullptr;
+      bool after_previous_step=true;    // the step depends on the step before it, otherwise it runs at job start
     };
 
     //! Constructor.
@@ -76,13 +78,23 @@ namespace gui{
     //! the job.
     void addJob(comp::SimJob *job);
 
-    //! Run the specified job, if the job hasn't already been added to the 
-    //! manager it will be added.
+    //! Queue the specified job, if the job hasn't already been added to the 
+    //! manager it will be added. The job starts once its core requirement
+    //! fits in the core budget left by the running jobs.
     void runJob(comp::SimJob *job);
 
     //! Process a finished job.
     void processFinishedJob(comp::SimJob *job, comp::SimJob::JobState finish_state);
 
+    //! Stop or resume starting queued jobs, running jobs are unaffected.
+    void setQueuePaused(bool paused);
+
+    //! Return whether the job queue is paused.
+    bool queuePaused() const {return queue_paused;}
+
+    //! Return the number of CPU cores shared by running jobs.
+    static int coreBudget();
+
     //! Returns whether the job can be shown in SimVisualizer (might want to make
     //! this a SimVisualizer function instead).
     bool eligibleForSimVisualizer(comp::SimJob *job);
@@ -93,12 +105,17 @@ namespace gui{
     //! Show job manager and set pane to View Jobs directly.
     void showViewJobs() {show(); lw_job_action->setCurrentItem(lwi_view_jobs);}
 
+    //! Set the design's area of interest used by new IncludeAreaOfInterest
+    //! jobs.
+    void setAreaOfInterest(const prim::AreaOfInterest &area) {area_of_interest = area;}
+
   signals:
 
     //! Request application to save a job problem file to the specified path, 
     //! can be used either in preparation of running a simulation or exporting 
     //! for future use.
-    void sig_exportJobProblem(comp::JobStep *job_step, gui::DesignInclusionArea inclusion_area);
+    void sig_exportJobProblem(comp::JobStep *job_step, gui::DesignInclusionArea inclusion_area,
+                              const prim::AreaOfInterest &area);
 
     //! Emit a SiQAD command for commander to parse.
     void sig_executeSQCommand(QString command);
@@ -110,7 +127,7 @@ namespace gui{
 
     void showEvent(QShowEvent *e) override
     {
-      loadWidgetState(); QWidget::showEvent(e);
+      loadWidgetState(); updateCacheStats(); QWidget::showEvent(e);
     }
 
     void hideEvent(QHideEvent *e) override
@@ -153,10 +170,31 @@ namespace gui{
     //! pointer if none is selected.
     comp::PluginEngine *selectedEngine();
 
+    //! Return the area of interest for a new job: the design's area, or the
+    //! area of the latest job that had one so repeated runs reuse it.
+    prim::AreaOfInterest jobAreaOfInterest() const;
+
+    //! Start queued jobs in priority order, then queue order, while the head
+    //! of the queue fits in the core budget. Lower priority jobs don't skip
+    //! ahead of a waiting job so large jobs aren't starved.
+    void startQueuedJobs();
+
+    //! Update the state, core and wait time columns of the job in the job view.
+    void updateJobViewRow(comp::SimJob *job);
+
+    //! Show the result cache statistics in the job view.
+    void updateCacheStats();
+
     PluginManager *plugin_manager;
     SimVisualizer *sim_visualizer;         // pointer to the sim_visualizer
 
     QList<comp::SimJob*> sim_jobs;        // list of all jobs
+    QList<comp::SimJob*> job_queue;       // jobs waiting for cores
+    QHash<comp::SimJob*, int> job_cores;  // cores held by each running job
+    QHash<comp::SimJob*, QStandardItem*> job_view_items;  // name item of each job in job_view_model
+    bool queue_paused=false;              // queued jobs are not started
+    QTimer *wait_timer;                   // refreshes the wait times of queued jobs
+    QLabel *l_cache_stats;                // result cache statistics
     QListView *lv_engines;                // list view of engines in the engine list
     QListView *lv_job_steps;              // list view of job steps
     QVBoxLayout *vl_job_view;             // vertical layout of job view with the tree view and useful buttons
@@ -173,6 +211,8 @@ namespace gui{
     QListWidgetItem *lwi_new_job;         // list item for new job
     QListWidgetItem *lwi_view_jobs;       // list item for viewing jobs
 
+    prim::AreaOfInterest area_of_interest;  // the design's area of interest
+
   };
 
   //! JobStepViewListItem is a QStandardItem subclass which is used specifically
@@ -210,6 +250,11 @@ namespace gui{
     {
       QString name;
       gui::DesignInclusionArea inclusion_area;
+      qreal aoi_halo=0;   // halo of the area of interest in angstrom
+      int max_parallel_steps=1; // job steps running at the same time
+      comp::SimJob::JobPriority priority=comp::SimJob::NormalPriority;
+      comp::ParameterSweep::SweepMode sweep_mode=comp::ParameterSweep::CartesianSweep;
+      bool use_result_cache=true;
     };
 
     //! Constructor.
@@ -234,6 +279,13 @@ namespace gui{
       QMetaEnum inc_a_enum = QMetaEnum::fromType<IA>();
       job_details.inclusion_area = static_cast<IA>(inc_a_enum.keyToValue(
             cbb_inclusion_area->currentText().toLatin1()));
+      job_details.aoi_halo = sb_aoi_halo->value();
+      job_details.max_parallel_steps = sb_parallel_steps->value();
+      job_details.priority = static_cast<comp::SimJob::JobPriority>(
+          cbb_priority->currentData().toInt());
+      job_details.sweep_mode = static_cast<comp::ParameterSweep::SweepMode>(
+          cbb_sweep_mode->currentData().toInt());
+      job_details.use_result_cache = cb_use_result_cache->isChecked();
       return job_details;
     }
     
@@ -247,11 +299,17 @@ namespace gui{
     QVBoxLayout *vl_institutions;                   // list of institutions
     QVBoxLayout *vl_links;                          // list of links
     QComboBox *cbb_inclusion_area;                  // inclusion area
+    QDoubleSpinBox *sb_aoi_halo;                    // area of interest halo
+    QSpinBox *sb_parallel_steps;                    // job steps running at the same time
+    QComboBox *cbb_priority;                        // queue priority
+    QComboBox *cbb_sweep_mode;                      // how swept parameters combine
+    QCheckBox *cb_use_result_cache;                 // reuse cached results of identical steps
     QLabel *l_plugin_name;                          // plugin name
     QLabel *l_plugin_status;                        // plugin status
     QPushButton *pb_refresh_status;                 // refresh the plugin status
     QMenu *menu_command_preset;                     // command format preset selection menu
     QTextEdit *te_command;                          // command format edit field
+    QComboBox *cbb_step_start;                      // whether the step waits for the previous step
     QVBoxLayout *vl_plugin_params;                  // layout holding engine property form
   };
 
@@ -65,6 +65,8 @@ void LayerManager::addLattice(prim::Lattice *lattice, prim::Layer::LayerRole rol
   lattice->setLayerID(laylist.size());
   lattice->setRole(role);
   laylist.append(lattice);
+
+  emit sig_layerListChanged();
 }
 
 prim::Lattice *LayerManager::getLattice(bool design_role)
@@ -104,6 +106,7 @@ prim::Layer *LayerManager::addLayer(const QString &name, const prim::Layer::Laye
   if (side_widget != nullptr)
     side_widget->refreshLists(layers, simvislayers);
 
+  emit sig_layerListChanged();
   return layer;
 }
 
@@ -126,6 +129,7 @@ prim::DBLayer *LayerManager::addDBLayer(prim::Lattice *lattice,
   if (side_widget != nullptr)
     side_widget->refreshLists(layers, simvislayers);
 
+  emit sig_layerListChanged();
   return layer;
 }
 
@@ -158,6 +162,8 @@ void LayerManager::removeLayer(int n)
   // update side widget
   if (side_widget != nullptr)
     side_widget->refreshLists(layers, simvislayers);
+
+  emit sig_layerListChanged();
 }
 
 void LayerManager::removeLayer(prim::Layer *layer)
@@ -289,10 +295,11 @@ void LayerManager::saveLayers(QXmlStreamWriter *ws) const
     layer->saveLayer(ws);
 }
 
-void LayerManager::saveLayerItems(QXmlStreamWriter *ws, DesignInclusionArea inclusion_area) const
+void LayerManager::saveLayerItems(QXmlStreamWriter *ws, DesignInclusionArea inclusion_area,
+                                  const QSet<prim::Item*> &area_items) const
 {
   for(prim::Layer *layer : layers)
-    layer->saveItems(ws, inclusion_area);
+    layer->saveItems(ws, inclusion_area, area_items);
 }
 
 void LayerManager::tableSelectionChanged(int row)
@@ -224,7 +224,8 @@ namespace gui{
     void saveLayers(QXmlStreamWriter *) const;
 
     //! Save items contained in all layers to XML stream. TODO improve structure
-    void saveLayerItems(QXmlStreamWriter *, DesignInclusionArea) const;
+    void saveLayerItems(QXmlStreamWriter *, DesignInclusionArea,
+                        const QSet<prim::Item*> &area_items=QSet<prim::Item*>()) const;
 
 
     // GUI
@@ -251,6 +252,12 @@ namespace gui{
     void refreshLayerTable();
     void clearLayerTable();
 
+  signals:
+
+    //! Emitted after layers have been added to or removed from the layer
+    //! stacks.
+    void sig_layerListChanged();
+
   public slots:
     void updateLayerPropFromTable(int row, int column);
     void addLayerRow(); // wrapper, prompt user for new layer info and add to layer table
@@ -7,6 +7,7 @@
 // @desc:     Class that contains information for 2D AFM scans
 
 #include "afmarea.h"
+#include "gui/save_context.h"
 
 namespace prim {
 
@@ -129,23 +130,25 @@ void AFMArea::initAFMArea(int lay_id, const QRectF &scene_rect,
 // Save to XML
 void AFMArea::saveItems(QXmlStreamWriter *ws) const
 {
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
   ws->writeStartElement("afmarea");
 
-  ws->writeTextElement("layer_id", QString::number(layer_id));
+  ws->writeTextElement("layer_id", ctx->number(layer_id));
 
   // dimensions
   ws->writeEmptyElement("dimensions");
-  ws->writeAttribute("x1", QString::number(sceneRect().topLeft().x()/scale_factor));
-  ws->writeAttribute("y1", QString::number(sceneRect().topLeft().y()/scale_factor));
-  ws->writeAttribute("x2", QString::number(sceneRect().bottomRight().x()/scale_factor));
-  ws->writeAttribute("y2", QString::number(sceneRect().bottomRight().y()/scale_factor));
+  ws->writeAttribute("x1", ctx->number(sceneRect().topLeft().x()/scale_factor));
+  ws->writeAttribute("y1", ctx->number(sceneRect().topLeft().y()/scale_factor));
+  ws->writeAttribute("x2", ctx->number(sceneRect().bottomRight().x()/scale_factor));
+  ws->writeAttribute("y2", ctx->number(sceneRect().bottomRight().y()/scale_factor));
 
   // tip parameters
-  ws->writeTextElement("h_orientation", QString::number(horizontalOrientation()));
-  ws->writeTextElement("z_speed", QString::number(zSpeed()));
-  ws->writeTextElement("h_speed", QString::number(horizontalSpeed()));
-  ws->writeTextElement("v_speed", QString::number(verticalSpeed()));
-  ws->writeTextElement("v_displacement", QString::number(
+  ws->writeTextElement("h_orientation", ctx->number(horizontalOrientation()));
+  ws->writeTextElement("z_speed", ctx->number(zSpeed()));
+  ws->writeTextElement("h_speed", ctx->number(horizontalSpeed()));
+  ws->writeTextElement("v_speed", ctx->number(verticalSpeed()));
+  ws->writeTextElement("v_displacement", ctx->number(
       verticalDisplacementBetweenScans()));
 
   // end of afmarea
@@ -7,6 +7,7 @@
 // @desc:     Node in AFM travel path
 
 #include "afmnode.h"
+#include "gui/save_context.h"
 
 namespace prim{
 
@@ -97,15 +98,17 @@ void AFMNode::initAFMNode(int lay_id, QPointF scenepos, float z_offset)
 // Save to XML
 void AFMNode::saveItems(QXmlStreamWriter *ws) const
 {
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
   ws->writeStartElement("afmnode");
 
-  ws->writeTextElement("layer_id", QString::number(layer_id));
+  ws->writeTextElement("layer_id", ctx->number(layer_id));
 
   ws->writeEmptyElement("physloc"); // TODO consider changing to saving physloc
-  ws->writeAttribute("x", QString::number(scenePos().x()/scale_factor));
-  ws->writeAttribute("y", QString::number(scenePos().y()/scale_factor));
+  ws->writeAttribute("x", ctx->number(scenePos().x()/scale_factor));
+  ws->writeAttribute("y", ctx->number(scenePos().y()/scale_factor));
 
-  ws->writeTextElement("zoffset", QString::number(zOffset()));
+  ws->writeTextElement("zoffset", ctx->number(zOffset()));
 
   // TODO other properties
 
@@ -134,6 +137,10 @@ QRectF AFMNode::boundingRect() const
 
 void AFMNode::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
+  // the parent path draws a simplified polyline when zoomed out
+  if (lowDetail())
+    return;
+
   if (tool_type == gui::SelectTool && upSelected()) {
     fill_col = fill_col_sel;
     bd_col = bd_col_sel;
@@ -254,8 +254,74 @@ QList<QPointF> AFMPath::unfoldedPath()
 }
 
 
-void AFMPath::paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *)
+QPolygonF AFMPath::simplifyPolyline(const QPolygonF &points, qreal tolerance)
 {
+  if (points.size() < 3)
+    return points;
+
+  // Douglas-Peucker with an explicit stack of index ranges
+  QVector<bool> keep(points.size(), false);
+  keep.first() = keep.last() = true;
+  QVector<QPair<int,int>> ranges;
+  ranges.append(qMakePair(0, points.size()-1));
+  qreal tol_sq = tolerance*tolerance;
+  while (!ranges.isEmpty()) {
+    QPair<int,int> range = ranges.takeLast();
+    const QPointF &p0 = points[range.first];
+    QPointF dir = points[range.second] - p0;
+    qreal len_sq = QPointF::dotProduct(dir, dir);
+    qreal max_dist_sq = -1;
+    int max_ind = -1;
+    for (int i=range.first+1; i<range.second; i++) {
+      QPointF d = points[i] - p0;
+      qreal dist_sq;
+      if (len_sq > 0) {
+        qreal t = qBound<qreal>(0, QPointF::dotProduct(d, dir)/len_sq, 1);
+        QPointF r = d - t*dir;
+        dist_sq = QPointF::dotProduct(r, r);
+      } else {
+        dist_sq = QPointF::dotProduct(d, d);
+      }
+      if (dist_sq > max_dist_sq) {
+        max_dist_sq = dist_sq;
+        max_ind = i;
+      }
+    }
+    if (max_ind >= 0 && max_dist_sq > tol_sq) {
+      keep[max_ind] = true;
+      ranges.append(qMakePair(range.first, max_ind));
+      ranges.append(qMakePair(max_ind, range.second));
+    }
+  }
+
+  QPolygonF simplified;
+  for (int i=0; i<points.size(); i++)
+    if (keep[i])
+      simplified.append(points[i]);
+  return simplified;
+}
+
+
+void AFMPath::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+  // nodes and segments skip painting when zoomed out, draw the path as a
+  // single polyline simplified to about a device pixel instead
+  if (lowDetail() && nodeCount() > 1) {
+    QPolygonF points;
+    for (prim::AFMNode *node : path_nodes)
+      points.append(node->pos());
+    const QTransform &tf = painter->worldTransform();
+    qreal device_scale = qSqrt(tf.m11()*tf.m11() + tf.m12()*tf.m12());
+    if (device_scale > 0)
+      points = simplifyPolyline(points, 1./device_scale);
+
+    QPen paint_pen(line_col_default);
+    paint_pen.setCosmetic(true);
+    painter->setPen(paint_pen);
+    painter->drawPolyline(points);
+    return;
+  }
+
   /* draw line
   if (select_mode && upSelected()) {
     line_col = line_col_sel;
@@ -80,6 +80,10 @@ namespace prim{
     // unfold path that will be used during simulation
     QList<QPointF> unfoldedPath();
 
+    // simplify a polyline with the Douglas-Peucker algorithm, dropping points
+    // which deviate less than tolerance from the simplified line
+    static QPolygonF simplifyPolyline(const QPolygonF &points, qreal tolerance);
+
     // Graphics
     virtual QRectF boundingRect() const override; // conform to segment shapes
     virtual void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
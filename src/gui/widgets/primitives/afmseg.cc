@@ -99,7 +99,8 @@ QRectF AFMSeg::boundingRect() const
 
 void AFMSeg::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
-  if (!segmentIsValid())
+  // the parent path draws a simplified polyline when zoomed out
+  if (!segmentIsValid() || lowDetail())
     return;
 
   if (tool_type == gui::SelectTool && upSelected()) {
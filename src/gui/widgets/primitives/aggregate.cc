@@ -99,10 +99,26 @@ void prim::Aggregate::addChildren(QStack<Item*> &items)
     else if (item->item_type == prim::Item::Aggregate)
       db_count += static_cast<prim::Aggregate*>(item)->dbCount();
   }
+
+  invalidateGeometry();
+}
+
+void prim::Aggregate::invalidateGeometry()
+{
+  prepareGeometryChange();
+  rect_valid = shape_valid = false;
+
+  // the bounds and hull of enclosing aggregates depend on this one
+  QGraphicsItem *parent = parentItem();
+  if (parent && static_cast<prim::Item*>(parent)->item_type == prim::Item::Aggregate)
+    static_cast<prim::Aggregate*>(parent)->invalidateGeometry();
 }
 
 QRectF prim::Aggregate::boundingRect() const
 {
+  if (rect_valid)
+    return cached_rect;
+
   // smallest bounding box around all children items
   bool unset = true;
   qreal xmin=-1, ymin=-1, xmax=-1, ymax=-1;
@@ -126,7 +142,9 @@ QRectF prim::Aggregate::boundingRect() const
 
   qreal width = xmax-xmin+edge_width;
   qreal height = ymax-ymin+edge_width;
-  return QRectF(.5*(xmax+xmin-width), .5*(ymax+ymin-height), width, height);
+  cached_rect = QRectF(.5*(xmax+xmin-width), .5*(ymax+ymin-height), width, height);
+  rect_valid = true;
+  return cached_rect;
 }
 
 void prim::Aggregate::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
@@ -156,14 +174,19 @@ void prim::Aggregate::paint(QPainter *painter, const QStyleOptionGraphicsItem *,
 
 QPainterPath prim::Aggregate::shape() const
 {
-  QPainterPath path;
+  if (shape_valid)
+    return cached_shape;
 
+  // the hull is found in scene coordinates, keep it in local coordinates so
+  // that it stays valid when the aggregate itself is moved
   hull::ConvexHull hull(items);
   hull.solve();
-  path.addPolygon(hull.getPolygon());
-  path.closeSubpath();
+  cached_shape = QPainterPath();
+  cached_shape.addPolygon(mapFromScene(hull.getPolygon()));
+  cached_shape.closeSubpath();
+  shape_valid = true;
 
-  return path;
+  return cached_shape;
 }
 
 
@@ -199,6 +222,14 @@ void prim::Aggregate::prepareStatics()
 }
 
 
+QVariant prim::Aggregate::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+  if (change == QGraphicsItem::ItemChildRemovedChange)
+    invalidateGeometry();
+  return prim::Item::itemChange(change, value);
+}
+
+
 void prim::Aggregate::mousePressEvent(QGraphicsSceneMouseEvent *e)
 {
   // QGraphicsItem order precedence will trigger the children before the Aggregate
@@ -40,6 +40,11 @@ namespace prim{
     //! Get the number of DBs in this aggregate.
     int dbCount() {return db_count;}
 
+    //! Discard the cached bounding rect and hull after children were added,
+    //! removed or moved, or after a child DB changed size with the display
+    //! mode. Enclosing aggregates are invalidated as well.
+    void invalidateGeometry();
+
     // necessary derived class member functions
     virtual QRectF boundingRect() const override;
     virtual void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
@@ -62,6 +67,16 @@ namespace prim{
 
     int db_count=0;   // number of DBs in the aggregate
 
+    // cached geometry in local coordinates, recomputed on demand after
+    // invalidateGeometry()
+    mutable QRectF cached_rect;
+    mutable QPainterPath cached_shape;
+    mutable bool rect_valid=false;
+    mutable bool shape_valid=false;
+
+    // invalidate the geometry when children are removed, e.g. on split
+    virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
     // initialise the static class variables
     void prepareStatics();
 
@@ -0,0 +1,124 @@
+// @file:     dbdensity.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     DBDensity implementation.
+
+#include "dbdensity.h"
+#include "dbdot.h"
+
+using namespace prim;
+
+
+DBDensity::DBDensity(prim::Lattice *lattice)
+  : prim::Item(prim::Item::DBDensity), lattice(lattice)
+{
+  fill_col = settings::GUISettings::instance()->get<QColor>("dbdot/fill_col");
+  refresh();
+}
+
+
+void DBDensity::refresh()
+{
+  const prim::LatticeOccupancy &occ = lattice->occupancy();
+  if (occ.revision() == bounds_rev)
+    return;
+  bounds_rev = occ.revision();
+
+  QRectF new_bounds;
+  if (occ.tileBounds(n_min, n_max, m_min, m_max)) {
+    QPointF a0 = lattice->sceneLatticeVector(0);
+    QPointF a1 = lattice->sceneLatticeVector(1);
+    QPolygonF corners;
+    corners << n_min*a0 + m_min*a1 << (n_max+1)*a0 + m_min*a1
+            << n_min*a0 + (m_max+1)*a1 << (n_max+1)*a0 + (m_max+1)*a1;
+    qreal pad = prim::DBDot::maxExtent();
+    new_bounds = corners.boundingRect().adjusted(-pad, -pad, pad, pad);
+  } else {
+    n_max = n_min - 1;
+    m_max = m_min - 1;
+  }
+
+  if (new_bounds != bounds) {
+    prepareGeometryChange();
+    bounds = new_bounds;
+  }
+  update();
+}
+
+
+void DBDensity::invalidate()
+{
+  raster_rev = ~quint64(0);
+  update();
+}
+
+
+void DBDensity::paint(QPainter *painter, const QStyleOptionGraphicsItem *,
+    QWidget *widget)
+{
+  if (!lowDetail() || display_mode != gui::DesignMode || n_min > n_max)
+    return;
+
+  // pick the number of lattice cells per raster pixel from the device scale
+  const QTransform &tf = painter->worldTransform();
+  qreal device_scale = qSqrt(tf.m11()*tf.m11() + tf.m12()*tf.m12());
+  if (widget != nullptr)
+    device_scale *= widget->devicePixelRatioF();
+  QPointF a0 = lattice->sceneLatticeVector(0);
+  QPointF a1 = lattice->sceneLatticeVector(1);
+  qreal cell_px = device_scale * qMin(qSqrt(QPointF::dotProduct(a0, a0)),
+                                      qSqrt(QPointF::dotProduct(a1, a1)));
+  int k = 1;
+  while (k*cell_px < 1 && k < (1 << 20))
+    k *= 2;
+  while ((n_max-n_min+1)/k >= max_raster_dim || (m_max-m_min+1)/k >= max_raster_dim)
+    k *= 2;
+
+  if (k != raster_k || lattice->occupancy().revision() != raster_rev)
+    rebuildRaster(k);
+
+  // map raster pixels onto k x k lattice cell blocks
+  QTransform raster_tf(a0.x()*k, a0.y()*k, a1.x()*k, a1.y()*k,
+      n_min*a0.x() + m_min*a1.x(), n_min*a0.y() + m_min*a1.y());
+  painter->save();
+  painter->setTransform(raster_tf, true);
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+  painter->drawImage(QPointF(0, 0), raster);
+  painter->restore();
+}
+
+
+void DBDensity::rebuildRaster(int k)
+{
+  const prim::LatticeOccupancy &occ = lattice->occupancy();
+  raster_k = k;
+  raster_rev = occ.revision();
+
+  int width = (n_max-n_min)/k + 1;
+  int height = (m_max-m_min)/k + 1;
+  QVector<int> counts(width*height, 0);
+  occ.forEachInRange(n_min, n_max, m_min, m_max,
+      [&](int n, int m, int, prim::DBDot *db) {
+        if (db == nullptr || db->isVisible())
+          counts[((m-m_min)/k)*width + (n-n_min)/k]++;
+      });
+
+  // single DBs stay visible, denser blocks become more opaque
+  qreal capacity = qreal(k)*k*qMax(1, lattice->unitCellSiteCount());
+  raster = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+  for (int y=0; y<height; y++) {
+    QRgb *line = reinterpret_cast<QRgb*>(raster.scanLine(y));
+    const int *count = counts.constData() + y*width;
+    for (int x=0; x<width; x++) {
+      if (count[x] == 0) {
+        line[x] = 0;
+        continue;
+      }
+      qreal alpha = fill_col.alphaF() * (0.35 + 0.65*qMin<qreal>(1, count[x]/capacity));
+      line[x] = qPremultiply(qRgba(fill_col.red(), fill_col.green(),
+            fill_col.blue(), qRound(255*alpha)));
+    }
+  }
+}
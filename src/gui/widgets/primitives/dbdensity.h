@@ -0,0 +1,66 @@
+/** @file:     dbdensity.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Low level-of-detail density raster of the DBs on a lattice.
+ */
+
+#ifndef _GUI_PR_DB_DENSITY_H_
+#define _GUI_PR_DB_DENSITY_H_
+
+#include "item.h"
+#include "lattice.h"
+
+namespace prim{
+
+  //! Draws the design DBs as a density raster when zoomed out below the level
+  //! of detail threshold, in place of the individual DBDot items. The raster
+  //! is built from the lattice occupancy index with one pixel per block of
+  //! k x k lattice cells, k chosen from the view scale so that a pixel is
+  //! about one device pixel, and is drawn through the lattice vectors so that
+  //! it stays aligned with skewed lattices. DBs of hidden layers are left out.
+  class DBDensity : public prim::Item
+  {
+  public:
+
+    //! Construct a density raster for the DBs occupying the given lattice.
+    DBDensity(prim::Lattice *lattice);
+
+    //! Destructor.
+    ~DBDensity() {}
+
+    //! Update the bounds after the lattice occupancy changed, the raster itself
+    //! is rebuilt lazily on the next low detail paint.
+    void refresh();
+
+    //! Rebuild the raster on the next low detail paint, e.g. after DB layers
+    //! were shown or hidden.
+    void invalidate();
+
+    // virtual methods
+    QRectF boundingRect() const override {return bounds;}
+    void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+  private:
+
+    // rebuild the raster with k x k lattice cells per pixel
+    void rebuildRaster(int k);
+
+    static const int max_raster_dim = 2048;  // raster size limit per dimension
+
+    prim::Lattice *lattice;
+    QRectF bounds;                // scene bounds of the populated lattice range
+    quint64 bounds_rev=~quint64(0); // occupancy revision of the bounds
+    int n_min=0, n_max=-1, m_min=0, m_max=-1; // populated lattice range
+
+    QImage raster;
+    int raster_k=0;               // lattice cells per raster pixel
+    quint64 raster_rev=~quint64(0); // occupancy revision of the raster
+
+    QColor fill_col;
+  };
+
+} // end prim namespace
+
+#endif
@@ -8,7 +8,10 @@
 
 
 #include "dbdot.h"
+#include "dblayer_renderer.h"
+#include "aggregate.h"
 #include "settings/settings.h"
+#include "gui/save_context.h"
 // Initialize statics
 
 qreal prim::DBDot::diameter_m = -1;
@@ -87,6 +90,12 @@ prim::DBDot::DBDot(QXmlStreamReader *rs, QGraphicsScene *, int lay_id)
   }
 }
 
+prim::DBDot::~DBDot()
+{
+  if (renderer != nullptr)
+    renderer->detach(this);
+}
+
 void prim::DBDot::setColor(QColor color)
 {
   //Change the default color used for later dbs
@@ -118,7 +127,7 @@ void prim::DBDot::initDBDot(prim::LatticeCoord coord, int lay_id, bool cp)
   setColor(fill_col_def.normal);
   setLayerID(lay_id);
   fill_fact = 0.;
-  diameter = diameter_m;
+  diameter = modeDiameter();
 
   // flags
   setFlag(QGraphicsItem::ItemIsSelectable, true);
@@ -143,69 +152,138 @@ QRectF prim::DBDot::boundingRect() const
 
 void prim::DBDot::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
-  QColor fill_col_state;
-  QColor edge_col_state;
+  // drawn by the layer renderer in batched mode, the item only remains as a
+  // handle for selection, hovering and hit testing
+  if (renderer != nullptr)
+    return;
+
+  // drawn by the density raster below the level of detail threshold
+  if (lowDetail() && display_mode == gui::DesignMode)
+    return;
+
+  paintDot(painter, paintState());
+}
+
+
+void prim::DBDot::updateDisplayMode()
+{
+  qreal mode_diameter = modeDiameter();
+  if (mode_diameter == diameter)
+    return;
+  prepareGeometryChange();
+  diameter = mode_diameter;
+
+  // enclosing aggregates cache their bounds and hull
+  QGraphicsItem *parent = parentItem();
+  if (parent && static_cast<prim::Item*>(parent)->item_type == prim::Item::Aggregate)
+    static_cast<prim::Aggregate*>(parent)->invalidateGeometry();
+}
+
+
+qreal prim::DBDot::modeDiameter() const
+{
+  return (display_mode == gui::SimDisplayMode || display_mode == gui::ScreenshotMode)
+      ? diameter_l : diameter_m;
+}
+
+
+prim::DBDot::PaintState prim::DBDot::paintState()
+{
+  PaintState state;
   if (display_mode == gui::SimDisplayMode ||
       display_mode == gui::ScreenshotMode) {
-    setFill(abs(show_elec));
-    diameter = diameter_l;
+    state.fill_fact = abs(show_elec);
     if (show_elec < 0) {
-      fill_col_state = getCurrentStateColor(fill_col_hole);
-      edge_col_state = getCurrentStateColor(edge_col_hole);
+      state.fill_col = getCurrentStateColor(fill_col_hole);
+      state.edge_col = getCurrentStateColor(edge_col_hole);
     } else if (show_elec > 0) {
-      fill_col_state = getCurrentStateColor(fill_col_electron);
-      edge_col_state = getCurrentStateColor(edge_col_electron);
+      state.fill_col = getCurrentStateColor(fill_col_electron);
+      state.edge_col = getCurrentStateColor(edge_col_electron);
     } else {
-      fill_col_state = getCurrentStateColor(fill_col_neutral);
-      edge_col_state = getCurrentStateColor(edge_col_neutral);
+      state.fill_col = getCurrentStateColor(fill_col_neutral);
+      state.edge_col = getCurrentStateColor(edge_col_neutral);
     }
     // TODO figure out a good color explicitly for DB0 sites
   } else {
-    setFill(1);
-    diameter = diameter_m;
+    state.fill_fact = 1;
     // fill_col_state = getCurrentStateColor(fill_col_def);
-    fill_col_state = getCurrentStateColor(fill_col);
-    edge_col_state = getCurrentStateColor(edge_col);
+    state.fill_col = getCurrentStateColor(fill_col);
+    state.edge_col = getCurrentStateColor(edge_col);
   }
 
-  qreal edge_width_paint = edge_width;
-  qreal diameter_paint = diameter;
+  state.edge_width = edge_width;
+  state.diameter = diameter;
   if (display_mode == gui::ScreenshotMode) {
-    edge_width_paint *= publish_scale;
-    diameter_paint *= publish_scale;
+    state.edge_width *= publish_scale;
+    state.diameter *= publish_scale;
   }
+  state.rect = boundingRect();
+  return state;
+}
 
 
-  QRectF rect = boundingRect();
-  qreal dxy = 0.5 * edge_width_paint;
+void prim::DBDot::paintDot(QPainter *painter, const PaintState &state)
+{
+  QRectF rect = state.rect;
+  qreal dxy = 0.5 * state.edge_width;
   rect.adjust(dxy,dxy,-dxy,-dxy);
 
   // draw outer circle (or skip altogether if completely transparent)
-  if (edge_col_state.alpha() != 0) {
-    painter->setPen(QPen(edge_col_state, edge_width_paint));
-    fill_fact == 1 ? painter->setBrush(fill_col_state) : painter->setBrush(Qt::NoBrush);
+  if (state.edge_col.alpha() != 0) {
+    painter->setPen(QPen(state.edge_col, state.edge_width));
+    state.fill_fact == 1 ? painter->setBrush(state.fill_col) : painter->setBrush(Qt::NoBrush);
     painter->drawEllipse(rect);
   }
 
   // draw inner fill if a fill exists and the fill factor is less than 1 (in which
   // case it would already have been drawn above)
-  if(fill_fact > 0 && fill_fact < 1){
-    QRectF rect = boundingRect();
+  if(state.fill_fact > 0 && state.fill_fact < 1){
+    QRectF rect = state.rect;
     QPointF center = rect.center();
-    QSizeF size(diameter_paint, diameter_paint);
-    rect.setSize(size*qSqrt(fill_fact));
+    QSizeF size(state.diameter, state.diameter);
+    rect.setSize(size*qSqrt(state.fill_fact));
     rect.moveCenter(center);
 
     // draw inner circle or skip if completely transparent
-    if (fill_col_state.alpha() != 0) {
+    if (state.fill_col.alpha() != 0) {
       painter->setPen(Qt::NoPen);
-      painter->setBrush(fill_col_state);
+      painter->setBrush(state.fill_col);
       painter->drawEllipse(rect);
     }
   }
 }
 
 
+qreal prim::DBDot::maxExtent()
+{
+  // read from settings so that this works before any DBDot is constructed
+  settings::GUISettings *gui_settings = settings::GUISettings::instance();
+  qreal diam_l = gui_settings->get<qreal>("dbdot/diameter_l")*scale_factor;
+  qreal edge_w = gui_settings->get<qreal>("dbdot/edge_width")*diam_l;
+  return 0.5 * (diam_l+2*edge_w)
+      * qMax<qreal>(1, gui_settings->get<qreal>("dbdot/publish_scale"));
+}
+
+
+QVariant prim::DBDot::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+  if (change == QGraphicsItem::ItemSceneHasChanged) {
+    // (re)attach to the batched renderer of the layer, if any
+    if (renderer != nullptr)
+      renderer->detach(this);
+    if (scene() != nullptr) {
+      prim::DBLayerRenderer *layer_renderer = prim::DBLayerRenderer::forLayer(layer_id);
+      if (layer_renderer != nullptr)
+        layer_renderer->attach(this);
+    }
+  } else if (change == QGraphicsItem::ItemScenePositionHasChanged
+      && renderer != nullptr) {
+    renderer->moveDB(this);
+  }
+  return prim::Item::itemChange(change, value);
+}
+
+
 prim::Item *prim::DBDot::deepCopy() const
 {
   prim::DBDot *cp = new DBDot(lat_coord, layer_id, true);
@@ -216,20 +294,22 @@ prim::Item *prim::DBDot::deepCopy() const
 
 void prim::DBDot::saveItems(QXmlStreamWriter *ws) const
 {
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
   ws->writeStartElement("dbdot");
 
   // layer id
-  ws->writeTextElement("layer_id", QString::number(layer_id));
+  ws->writeTextElement("layer_id", ctx->number(layer_id));
 
   // physical location
   ws->writeEmptyElement("latcoord");
-  ws->writeAttribute("n", QString::number(lat_coord.n));
-  ws->writeAttribute("m", QString::number(lat_coord.m));
-  ws->writeAttribute("l", QString::number(lat_coord.l));
+  ws->writeAttribute("n", ctx->number(lat_coord.n));
+  ws->writeAttribute("m", ctx->number(lat_coord.m));
+  ws->writeAttribute("l", ctx->number(lat_coord.l));
 
   ws->writeEmptyElement("physloc");
-  ws->writeAttribute("x", QString::number(physloc.x()));
-  ws->writeAttribute("y", QString::number(physloc.y()));
+  ws->writeAttribute("x", ctx->number(physloc.x()));
+  ws->writeAttribute("y", ctx->number(physloc.y()));
 
   // color
   ws->writeTextElement("color", fill_col.normal.name(QColor::HexArgb));
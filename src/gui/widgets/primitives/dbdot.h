@@ -17,6 +17,8 @@
 
 namespace prim{
 
+  class DBLayerRenderer;
+
   class DBDot: public prim::Item
   {
   public:
@@ -30,7 +32,17 @@ namespace prim{
     void initDBDot(prim::LatticeCoord coord, int lay_id, bool cp);
 
     // destructor
-    ~DBDot(){}
+    ~DBDot();
+
+    //! Resolved colors and dimensions for painting the DB in its current state.
+    struct PaintState {
+      QColor fill_col;
+      QColor edge_col;
+      qreal diameter;
+      qreal edge_width;
+      qreal fill_fact;
+      QRectF rect;      // bounding rect in item coordinates
+    };
 
     // accessors
 
@@ -61,14 +73,39 @@ namespace prim{
     
     virtual QColor getCurrentFillColor() override {return fill_col.normal;}
 
+    //! Resolve the paint state for the current display mode and item state
+    //! without modifying the DB, the diameter follows updateDisplayMode().
+    PaintState paintState();
+
+    //! Resize the DB for the current display mode, to be called on every DB
+    //! when the display mode changes.
+    void updateDisplayMode();
+
+    //! Paint a DB with the given state centered at the painter origin.
+    static void paintDot(QPainter *painter, const PaintState &state);
+
+    //! Largest half-extent of a DB over all display modes, in scene pixels.
+    static qreal maxExtent();
+
+    //! Return the batched layer renderer drawing this DB, or nullptr if the DB
+    //! paints itself.
+    prim::DBLayerRenderer *layerRenderer() const {return renderer;}
+
+    //! Set the batched layer renderer, only to be called by DBLayerRenderer.
+    void setLayerRenderer(prim::DBLayerRenderer *r) {renderer = r;}
+
   protected:
     virtual void mousePressEvent(QGraphicsSceneMouseEvent *e) override;
+    virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
   private:
 
     // construct static variables
     void constructStatics();
 
+    // dot diameter in the current display mode
+    qreal modeDiameter() const;
+
     // VARIABLES
     prim::LatticeCoord lat_coord; // lattice coordinates of the DB
     QPointF physloc;             // physical location
@@ -76,6 +113,8 @@ namespace prim{
 
     qreal fill_fact;          // area proportional of dot filled
 
+    prim::DBLayerRenderer *renderer=nullptr; // batched renderer, if any
+
     prim::Item::StateColors fill_col;
     // static class parameters for painting
 
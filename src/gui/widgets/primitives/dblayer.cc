@@ -7,9 +7,15 @@
  */
 
 #include "dblayer.h"
+#include "dblayer_renderer.h"
 
 using namespace prim;
 
+DBLayer::~DBLayer()
+{
+  setBatchRendering(false);
+}
+
 QList<prim::DBDot*> DBLayer::getDBs()
 {
   QList<prim::DBDot*> db_list;
@@ -25,8 +31,11 @@ QList<prim::DBDot*> DBLayer::getDBsAtLocs(const QList<QPointF> &phys_locs)
 {
   QList<prim::DBDot*> dbs;
 
-  for (const QPointF &phys_loc : phys_locs) {
-    prim::DBDot *db = lattice->dbAt(lattice->nearestSite(phys_loc, false));
+  QVector<prim::LatticeCoord> coords = lattice->nearestSites(
+      QVector<QPointF>(phys_locs.begin(), phys_locs.end()), false);
+  for (int i=0; i<coords.size(); i++) {
+    const QPointF &phys_loc = phys_locs.at(i);
+    prim::DBDot *db = lattice->dbAt(coords.at(i));
     if (db == nullptr) {
       qFatal("%s", tr("Invalid DB location (%1, %2), aborting DB gathering.")
           .arg(phys_loc.x()).arg(phys_loc.y()).toLatin1().constData());
@@ -36,3 +45,50 @@ QList<prim::DBDot*> DBLayer::getDBsAtLocs(const QList<QPointF> &phys_locs)
   }
   return dbs;
 }
+
+void DBLayer::setBatchRendering(bool batch)
+{
+  if (batch == batchRendering())
+    return;
+
+  if (!batch) {
+    delete renderer;
+    renderer = nullptr;
+    return;
+  }
+
+  renderer = new DBLayerRenderer(this);
+
+  // attach DBs already in the scene
+  for (prim::DBDot *db : allDBs()) {
+    if (db->scene() != nullptr)
+      renderer->attach(db);
+  }
+}
+
+void DBLayer::updateDisplayMode()
+{
+  for (prim::DBDot *db : allDBs())
+    db->updateDisplayMode();
+}
+
+QList<prim::DBDot*> DBLayer::allDBs()
+{
+  QList<prim::DBDot*> dbs;
+  QList<prim::Item*> stack(getItems().begin(), getItems().end());
+  while (!stack.isEmpty()) {
+    prim::Item *item = stack.takeLast();
+    if (item->item_type == prim::Item::DBDot) {
+      dbs.append(static_cast<prim::DBDot*>(item));
+    } else if (item->item_type == prim::Item::Aggregate) {
+      for (QGraphicsItem *child : item->childItems())
+        stack.append(static_cast<prim::Item*>(child));
+    }
+  }
+  return dbs;
+}
+
+void DBLayer::initBatchRendering()
+{
+  setBatchRendering(settings::GUISettings::instance()->get<bool>("dbdot/batch_render"));
+}
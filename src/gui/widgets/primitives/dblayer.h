@@ -15,6 +15,8 @@
 
 namespace prim{
 
+  class DBLayerRenderer;
+
   //! DB object layer class
   class DBLayer : public Layer
   {
@@ -27,7 +29,10 @@ namespace prim{
         const LayerRole &role=LayerRole::Design, float z_offset=0, 
         float z_height=0, int lay_id=-1, QObject *parent=nullptr)
       : Layer(nm, DB, role, z_offset, z_height, lay_id, parent),
-        lattice(lattice) {};
+        lattice(lattice)
+    {
+      initBatchRendering();
+    }
 
     //! XML Stream constructor.
     DBLayer(QXmlStreamReader *rs, int lay_id=-1, bool override_role=false, 
@@ -36,8 +41,12 @@ namespace prim{
     {
       if (override_role)
         layer_role = role_override;
+      initBatchRendering();
     }
 
+    //! Destructor.
+    ~DBLayer();
+
     //! Get lattice pointer.
     prim::Lattice *getLattice() {return lattice;}
 
@@ -48,9 +57,27 @@ namespace prim{
     //! any of the locations is not a valid DB site, a fatal error is reported.
     QList<prim::DBDot*> getDBsAtLocs(const QList<QPointF> &phys_locs);
 
+    //! Enable or disable batched rendering, where a single DBLayerRenderer
+    //! item draws all DBs of this layer and the DBDot items only remain as
+    //! handles for selection and hovering.
+    void setBatchRendering(bool batch);
+
+    //! Return whether the DBs of this layer are rendered in batched mode.
+    bool batchRendering() const {return renderer != nullptr;}
+
+    //! Resize the DBs of this layer for the current display mode.
+    void updateDisplayMode();
+
   private:
 
+    // all DBs of this layer, including those inside aggregates
+    QList<prim::DBDot*> allDBs();
+
+    // enable batched rendering if set in the GUI settings
+    void initBatchRendering();
+
     prim::Lattice *lattice;
+    prim::DBLayerRenderer *renderer=nullptr;
 
 
   };
@@ -0,0 +1,229 @@
+// @file:     dblayer_renderer.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     DBLayerRenderer implementation.
+
+#include "dblayer_renderer.h"
+#include "dblayer.h"
+
+using namespace prim;
+
+QList<DBLayerRenderer*> DBLayerRenderer::renderers;
+
+
+DBLayerRenderer::DBLayerRenderer(prim::DBLayer *layer)
+  : prim::Item(prim::Item::DBLayerRenderer), layer(layer)
+{
+  extent = prim::DBDot::maxExtent();
+  cell_size = settings::GUISettings::instance()->get<qreal>(
+      "dbdot/batch_cell_size") * scale_factor;
+  setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+  // above the lattice and the electrodes (-1), below AFM paths (1)
+  setZValue(0.5);
+  renderers.append(this);
+}
+
+
+DBLayerRenderer::~DBLayerRenderer()
+{
+  renderers.removeOne(this);
+  for (prim::DBDot *db : cell_of.keys()) {
+    db->setLayerRenderer(nullptr);
+    db->setFlag(QGraphicsItem::ItemSendsScenePositionChanges, false);
+    db->update();
+  }
+}
+
+
+DBLayerRenderer *DBLayerRenderer::forLayer(int lay_id)
+{
+  for (DBLayerRenderer *renderer : renderers)
+    if (renderer->layer->layerID() == lay_id)
+      return renderer;
+  return nullptr;
+}
+
+
+void DBLayerRenderer::attach(prim::DBDot *db)
+{
+  if (cell_of.contains(db))
+    return;
+  if (scene() == nullptr && db->scene() != nullptr)
+    db->scene()->addItem(this);
+
+  QPointF pos = db->scenePos();
+  quint64 key = cellKey(pos);
+  cells[key].append(Entry{pos, db});
+  cell_of.insert(db, key);
+  db->setLayerRenderer(this);
+  db->setFlag(QGraphicsItem::ItemSendsScenePositionChanges, true);
+
+  growBounds(pos);
+  update(QRectF(pos, pos).adjusted(-extent, -extent, extent, extent));
+}
+
+
+void DBLayerRenderer::detach(prim::DBDot *db)
+{
+  QPointF pos;
+  if (!removeEntry(db, &pos))
+    return;
+  db->setLayerRenderer(nullptr);
+  db->setFlag(QGraphicsItem::ItemSendsScenePositionChanges, false);
+  update(QRectF(pos, pos).adjusted(-extent, -extent, extent, extent));
+}
+
+
+void DBLayerRenderer::moveDB(prim::DBDot *db)
+{
+  QPointF old_pos;
+  if (!removeEntry(db, &old_pos))
+    return;
+  QPointF pos = db->scenePos();
+  quint64 key = cellKey(pos);
+  cells[key].append(Entry{pos, db});
+  cell_of.insert(db, key);
+
+  growBounds(pos);
+  update(QRectF(old_pos, old_pos).adjusted(-extent, -extent, extent, extent));
+  update(QRectF(pos, pos).adjusted(-extent, -extent, extent, extent));
+}
+
+
+void DBLayerRenderer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+    QWidget *widget)
+{
+  if (cell_of.isEmpty() || (lowDetail() && display_mode == gui::DesignMode))
+    return;
+
+  // sprites are rendered at the power of two bucket of the device scale
+  const QTransform &tf = painter->worldTransform();
+  qreal device_scale = qSqrt(tf.m11()*tf.m11() + tf.m12()*tf.m12());
+  if (widget != nullptr)
+    device_scale *= widget->devicePixelRatioF();
+  int scale_exp = device_scale > 0 ? qBound(-6, qCeil(std::log2(device_scale) - 1e-9), 2) : 0;
+  qreal inv_scale = qPow(2, -scale_exp);
+
+  // cull the grid against the exposed rect
+  QRectF exposed = option->exposedRect.adjusted(-extent, -extent, extent, extent);
+  qint64 cn_min = qFloor(exposed.left()/cell_size), cn_max = qFloor(exposed.right()/cell_size);
+  qint64 cm_min = qFloor(exposed.top()/cell_size), cm_max = qFloor(exposed.bottom()/cell_size);
+  bool scan_cells = (cn_max-cn_min+1)*(cm_max-cm_min+1) > cells.size();
+
+  // bound the sprite cache, e.g. after many zoom or color changes
+  if (sprites.size() >= max_sprites) {
+    sprites.clear();
+    fragments.clear();
+  }
+  for (auto it = fragments.begin(); it != fragments.end(); ++it)
+    it.value().resize(0);
+
+  auto collect = [&](const QVector<Entry> &entries) {
+    for (const Entry &entry : entries) {
+      if (!entry.db->isVisible() || !exposed.contains(entry.pos))
+        continue;
+      SpriteKey key;
+      const QPixmap &pix = sprite(entry.db->paintState(), scale_exp, key);
+      fragments[key].append(QPainter::PixmapFragment::create(entry.pos,
+            QRectF(pix.rect()), inv_scale, inv_scale));
+    }
+  };
+
+  if (scan_cells) {
+    for (auto it = cells.constBegin(); it != cells.constEnd(); ++it) {
+      qint64 cn = qint32(quint32(it.key() >> 32));
+      qint64 cm = qint32(quint32(it.key() & 0xffffffff));
+      if (cn >= cn_min && cn <= cn_max && cm >= cm_min && cm <= cm_max)
+        collect(it.value());
+    }
+  } else {
+    for (qint64 cm=cm_min; cm<=cm_max; cm++) {
+      for (qint64 cn=cn_min; cn<=cn_max; cn++) {
+        auto it = cells.constFind((quint64(quint32(cn)) << 32) | quint64(quint32(cm)));
+        if (it != cells.constEnd())
+          collect(it.value());
+      }
+    }
+  }
+
+  // one pass per sprite
+  for (auto it = fragments.constBegin(); it != fragments.constEnd(); ++it) {
+    if (it.value().isEmpty())
+      continue;
+    painter->drawPixmapFragments(it.value().constData(), it.value().size(),
+        sprites.value(it.key()));
+  }
+}
+
+
+quint64 DBLayerRenderer::cellKey(const QPointF &pos) const
+{
+  qint32 cn = qFloor(pos.x()/cell_size);
+  qint32 cm = qFloor(pos.y()/cell_size);
+  return (quint64(quint32(cn)) << 32) | quint64(quint32(cm));
+}
+
+
+bool DBLayerRenderer::removeEntry(prim::DBDot *db, QPointF *old_pos)
+{
+  auto cell_it = cell_of.find(db);
+  if (cell_it == cell_of.end())
+    return false;
+  auto it = cells.find(cell_it.value());
+  cell_of.erase(cell_it);
+  if (it == cells.end())
+    return false;
+
+  QVector<Entry> &entries = it.value();
+  for (int i=0; i<entries.size(); i++) {
+    if (entries[i].db != db)
+      continue;
+    if (old_pos)
+      *old_pos = entries[i].pos;
+    entries[i] = entries.last();
+    entries.removeLast();
+    break;
+  }
+  if (entries.isEmpty())
+    cells.erase(it);
+  return true;
+}
+
+
+void DBLayerRenderer::growBounds(const QPointF &pos)
+{
+  QRectF dot_rect = QRectF(pos, pos).adjusted(-extent, -extent, extent, extent);
+  if (bounds.contains(dot_rect))
+    return;
+  prepareGeometryChange();
+  bounds = bounds.isNull() ? dot_rect : bounds.united(dot_rect);
+}
+
+
+const QPixmap &DBLayerRenderer::sprite(const prim::DBDot::PaintState &state,
+    int scale_exp, SpriteKey &key)
+{
+  key = SpriteKey{state.fill_col.rgba(), state.edge_col.rgba(),
+      qRound(state.diameter*16), qRound(state.edge_width*16),
+      qRound(state.fill_fact*256), scale_exp};
+  auto it = sprites.find(key);
+  if (it != sprites.end())
+    return it.value();
+
+  // render the dot centered in the sprite, with a pixel of padding for
+  // antialiasing
+  qreal scale = qPow(2, scale_exp);
+  int dim = qCeil(state.rect.width()*scale) + 2;
+  QPixmap pix(dim, dim);
+  pix.fill(Qt::transparent);
+  QPainter painter(&pix);
+  painter.setRenderHint(QPainter::Antialiasing, true);
+  painter.translate(0.5*dim, 0.5*dim);
+  painter.scale(scale, scale);
+  prim::DBDot::paintDot(&painter, state);
+  painter.end();
+
+  return sprites.insert(key, pix).value();
+}
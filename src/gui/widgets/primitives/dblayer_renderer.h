@@ -0,0 +1,118 @@
+/** @file:     dblayer_renderer.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Batched renderer drawing all DBs of a DB layer in one item.
+ */
+
+#ifndef _GUI_PR_DB_LAYER_RENDERER_H_
+#define _GUI_PR_DB_LAYER_RENDERER_H_
+
+#include "item.h"
+#include "dbdot.h"
+
+namespace prim{
+
+  class DBLayer;
+
+  //! Single scene item that draws every DB of a DB layer. Only painting is
+  //! batched: the DBDot items stay in the scene, and in its index, for
+  //! selection, hovering and hit testing, so those cost the same as without
+  //! the renderer. The handles skip painting and their updates invalidate the
+  //! region the renderer repaints. DB positions are packed into a uniform
+  //! grid which is culled against the exposed rect, and each visible DB is
+  //! blitted from a sprite pre-rendered per paint state and zoom bucket with
+  //! one drawPixmapFragments call per sprite.
+  class DBLayerRenderer : public prim::Item
+  {
+  public:
+
+    //! Construct a renderer for the given layer.
+    DBLayerRenderer(prim::DBLayer *layer);
+
+    //! Destructor, hands painting back to all attached DBs.
+    ~DBLayerRenderer();
+
+    //! Return the renderer of the layer with the given layer id, or nullptr if
+    //! that layer doesn't render in batched mode.
+    static DBLayerRenderer *forLayer(int lay_id);
+
+    //! Start drawing the given DB, which then stops painting itself.
+    void attach(prim::DBDot *db);
+
+    //! Stop drawing the given DB, which then paints itself again.
+    void detach(prim::DBDot *db);
+
+    //! Update the packed position of the given DB after it moved.
+    void moveDB(prim::DBDot *db);
+
+    //! Return the number of DBs drawn by this renderer.
+    int count() const {return cell_of.size();}
+
+    // virtual methods
+    QRectF boundingRect() const override {return bounds;}
+    void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+  private:
+
+    //! Packed DB entry.
+    struct Entry {
+      QPointF pos;        // scene position
+      prim::DBDot *db;    // handle
+    };
+
+    //! Key of a pre-rendered sprite.
+    struct SpriteKey {
+      QRgb fill_col;
+      QRgb edge_col;
+      int diameter;       // in 1/16 scene pixels
+      int edge_width;     // in 1/16 scene pixels
+      int fill_fact;      // in 1/256
+      int scale_exp;      // sprite scale is 2^scale_exp
+
+      bool operator==(const SpriteKey &other) const {
+        return fill_col == other.fill_col && edge_col == other.edge_col
+            && diameter == other.diameter && edge_width == other.edge_width
+            && fill_fact == other.fill_fact && scale_exp == other.scale_exp;
+      }
+
+      friend size_t qHash(const SpriteKey &key, size_t seed=0) {
+        return qHashMulti(seed, key.fill_col, key.edge_col, key.diameter,
+            key.edge_width, key.fill_fact, key.scale_exp);
+      }
+    };
+
+    // grid cell key of the given scene position
+    quint64 cellKey(const QPointF &pos) const;
+
+    // remove the entry of db from its cell, returns false if not found
+    bool removeEntry(prim::DBDot *db, QPointF *old_pos=nullptr);
+
+    // grow the bounding rect to include the dot at the given position
+    void growBounds(const QPointF &pos);
+
+    // return the sprite for the given state and scale exponent
+    const QPixmap &sprite(const prim::DBDot::PaintState &state, int scale_exp,
+        SpriteKey &key);
+
+    static QList<DBLayerRenderer*> renderers; // all live renderers
+
+    static const int max_sprites = 256;   // sprite cache is cleared beyond this
+
+    prim::DBLayer *layer;
+    qreal cell_size;          // grid cell size in scene pixels
+    qreal extent;             // largest DB half-extent in scene pixels
+    QRectF bounds;            // bounding rect of all attached DBs
+
+    QHash<quint64, QVector<Entry>> cells;     // packed entries per grid cell
+    QHash<prim::DBDot*, quint64> cell_of;     // grid cell of each handle
+    QHash<SpriteKey, QPixmap> sprites;        // pre-rendered DB sprites
+
+    // per-paint scratch buffers, kept to avoid reallocation
+    QHash<SpriteKey, QVector<QPainter::PixmapFragment>> fragments;
+  };
+
+} // end prim namespace
+
+#endif
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include "electrode.h"
 #include "settings/settings.h"
+#include "gui/save_context.h"
 
 
 
@@ -51,7 +52,7 @@ prim::Electrode::Electrode(QXmlStreamReader *ls, QGraphicsScene *scene, int lay_
     constructStatics();
   }
   QPointF ld_point1, ld_point2;
-  qreal angle_in;
+  qreal angle_in=0;
   QColor color;
   while(ls->readNextStartElement()) {
     QString elem_name = ls->name().toString();
@@ -187,6 +188,9 @@ void prim::Electrode::paint(QPainter *painter, const QStyleOptionGraphicsItem *,
     painter->setPen(Qt::NoPen);
     painter->setBrush(selected_col);
   }
+  // the outline is sub-pixel when zoomed out, fill only
+  if (lowDetail())
+    painter->setPen(Qt::NoPen);
   painter->drawPolygon(getPolygon());
 }
 
@@ -201,18 +205,20 @@ prim::Item *prim::Electrode::deepCopy() const
 
 void prim::Electrode::saveItems(QXmlStreamWriter *ss) const
 {
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
   ss->writeStartElement("electrode");
   // layer id
-  ss->writeTextElement("layer_id", QString::number(layer_id));
+  ss->writeTextElement("layer_id", ctx->number(layer_id));
 
   // top left and bottom right locations
   ss->writeEmptyElement("dim");
-  ss->writeAttribute("x1", QString::number(sceneRect().topLeft().x()/scale_factor)); //convert to angstrom
-  ss->writeAttribute("y1", QString::number(sceneRect().topLeft().y()/scale_factor));
-  ss->writeAttribute("x2", QString::number(sceneRect().bottomRight().x()/scale_factor));
-  ss->writeAttribute("y2", QString::number(sceneRect().bottomRight().y()/scale_factor));
-  ss->writeTextElement("pixel_per_angstrom", QString::number(scale_factor));
-  ss->writeTextElement("angle", QString::number(getAngleDegrees()));
+  ss->writeAttribute("x1", ctx->number(sceneRect().topLeft().x()/scale_factor)); //convert to angstrom
+  ss->writeAttribute("y1", ctx->number(sceneRect().topLeft().y()/scale_factor));
+  ss->writeAttribute("x2", ctx->number(sceneRect().bottomRight().x()/scale_factor));
+  ss->writeAttribute("y2", ctx->number(sceneRect().bottomRight().y()/scale_factor));
+  ss->writeTextElement("pixel_per_angstrom", ctx->number(scale_factor));
+  ss->writeTextElement("angle", ctx->number(getAngleDegrees()));
   ss->writeTextElement("color", fill_col.normal.name(QColor::HexArgb));
   ss->writeStartElement("property_map");
   gui::PropertyMap::writeValuesToXMLStream(properties(), ss);
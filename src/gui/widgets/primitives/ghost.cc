@@ -266,12 +266,22 @@ void prim::Ghost::setValid(bool val)
 bool prim::Ghost::checkValid(const prim::LatticeCoord &offset, prim::Lattice *lattice)
 {
 
-  for(int n=0; n<sets.count(); n++)
+  // gather the shifted coordinates of each set and resolve them against the
+  // occupancy index in one pass
+  QVector<prim::LatticeCoord> coords;
+  for(int n=0; n<sets.count(); n++){
+    coords.resize(0);
+    coords.reserve(sets.at(n).count());
+    prim::LatticeCoord set_offset = offset*(n+1);
     for(prim::GhostDot *dot : sets.at(n)){
-      prim::LatticeCoord coord = dot->latticeCoord()+offset*(n+1);
-      if(!lattice->isValid(coord) || lattice->isOccupied(coord))
+      prim::LatticeCoord coord = dot->latticeCoord()+set_offset;
+      if(!lattice->isValid(coord))
         return false;
+      coords.append(dot->latticeCoord());
     }
+    if(lattice->anyOccupied(coords, set_offset))
+      return false;
+  }
   return true;
 }
 
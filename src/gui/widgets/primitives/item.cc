@@ -16,6 +16,8 @@ qreal prim::Item::scale_factor_nm;
 
 gui::DisplayMode prim::Item::display_mode;
 gui::ToolType prim::Item::tool_type;
+qreal prim::Item::view_zoom = 1;
+qreal prim::Item::lod_zoom_threshold;
 
 
 // CLASS::Item
@@ -24,6 +26,7 @@ void prim::Item::init()
 {
   scale_factor = settings::GUISettings::instance()->get<qreal>("view/scale_fact");
   scale_factor_nm = scale_factor*10;
+  lod_zoom_threshold = settings::GUISettings::instance()->get<qreal>("view/lod_zoom_threshold");
 }
 
 prim::Item::Item(ItemType type, int lay_id, QGraphicsItem *parent)
@@ -40,7 +40,8 @@ namespace prim{
                   Text, Electrode, GhostBox, AFMArea, AFMPath, AFMNode, AFMSeg,
                   PotPlot, ResizeFrame, ResizeHandle, TextLabel,
                   GhostPolygon, ScreenshotClipArea, ScaleBar, ResizeRotateFrame, 
-                  ResizeRotateHandle, LastItemType};
+                  ResizeRotateHandle, DBLayerRenderer, DBDensity,
+                  AreaOfInterestOutline, LastItemType};
 
     //! constructor, layer = 0 should indicate temporary objects that do not
     //! belong to any particular layer
@@ -119,9 +120,18 @@ namespace prim{
     static qreal scale_factor_nm;         // pixels/nm scaling factor
     static gui::ToolType tool_type;       // current tool type of the GUI
     static gui::DisplayMode display_mode; // current display mode of the GUI
+    static qreal view_zoom;               // current zoom of the main view
+    static qreal lod_zoom_threshold;      // zoom below which detail is reduced
 
     static void init();
 
+    //! True if items should paint in reduced level of detail at the current
+    //! view zoom. Screenshots are always rendered in full detail.
+    static bool lowDetail()
+    {
+      return view_zoom < lod_zoom_threshold && display_mode != gui::ScreenshotMode;
+    }
+
     // SAVE LOAD
     virtual void saveItems(QXmlStreamWriter *) const {}
     virtual void loadFromFile(QXmlStreamReader *) {} // TODO instead of using this function, switch to using constructor
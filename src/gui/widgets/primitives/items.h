@@ -23,5 +23,6 @@
 #include "labels/textlabel.h"
 #include "visual_aids/screenshot_clip_area.h"
 #include "visual_aids/scale_bar.h"
+#include "visual_aids/area_of_interest.h"
 
 #endif
@@ -9,6 +9,7 @@
 
 #include "textlabel.h"
 #include "settings/settings.h"
+#include "gui/save_context.h"
 
 #include <QInputDialog>
 
@@ -26,6 +27,31 @@ TextLabel::TextLabel(const QRectF &rect, int lay_id)
   initTextLabel(rect, textPrompt());
 }
 
+TextLabel::TextLabel(QXmlStreamReader *rs, int lay_id)
+  : prim::ResizableRect(prim::Item::TextLabel, QRectF(), lay_id)
+{
+  QRectF rect;
+  QString text;
+  while (rs->readNextStartElement()) {
+    if (rs->name() == QLatin1String("dim")) {
+      // convert from angstrom to pixel
+      rect.setTopLeft(QPointF(rs->attributes().value("x1").toDouble(),
+            rs->attributes().value("y1").toDouble()) * scale_factor);
+      rect.setBottomRight(QPointF(rs->attributes().value("x2").toDouble(),
+            rs->attributes().value("y2").toDouble()) * scale_factor);
+      rs->skipCurrentElement();
+    } else if (rs->name() == QLatin1String("text")) {
+      text = rs->readElementText();
+    } else {
+      qDebug() << QObject::tr("TextLabel: invalid element encountered on line %1 - %2")
+        .arg(rs->lineNumber()).arg(rs->name().toString());
+      rs->skipCurrentElement();
+    }
+  }
+  setSceneRect(rect.normalized());
+  initTextLabel(rect.normalized(), text);
+}
+
 void TextLabel::setText(const QString &text)
 {
   block_text = text;
@@ -65,6 +91,21 @@ prim::Item *TextLabel::deepCopy() const
   return new TextLabel(sceneRect(), layer_id, block_text);
 }
 
+void TextLabel::saveItems(QXmlStreamWriter *ws) const
+{
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
+  ws->writeStartElement("textlabel");
+  // top left and bottom right locations in angstrom
+  ws->writeEmptyElement("dim");
+  ws->writeAttribute("x1", ctx->number(sceneRect().topLeft().x()/scale_factor));
+  ws->writeAttribute("y1", ctx->number(sceneRect().topLeft().y()/scale_factor));
+  ws->writeAttribute("x2", ctx->number(sceneRect().bottomRight().x()/scale_factor));
+  ws->writeAttribute("y2", ctx->number(sceneRect().bottomRight().y()/scale_factor));
+  ws->writeTextElement("text", block_text);
+  ws->writeEndElement();
+}
+
 void TextLabel::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *)
 {
   //setText(textPrompt(text()));
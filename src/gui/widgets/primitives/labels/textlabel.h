@@ -24,6 +24,10 @@ namespace prim{
     //! for text immediately.
     TextLabel(const QRectF &rect, int lay_id);
 
+    //! Constructor that reads the label from the design file, after its
+    //! textlabel element was opened.
+    TextLabel(QXmlStreamReader *rs, int lay_id);
+
     //! Destructor
     ~TextLabel() {};
 
@@ -50,6 +54,9 @@ namespace prim{
     //! Return a copy of this text label.
     virtual Item *deepCopy() const override;
 
+    //! Save the label to the design file.
+    virtual void saveItems(QXmlStreamWriter *) const override;
+
   protected:
 
     //! show text editor on double click
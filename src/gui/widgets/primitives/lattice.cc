@@ -8,10 +8,12 @@
 
 
 #include "lattice.h"
+#include "gui/save_context.h"
 #include "settings/settings.h"
 
 #include <QtMath>
 #include <QDialog>
+#include <QThreadPool>
 #include <algorithm>
 
 
@@ -27,6 +29,9 @@ QColor prim::Lattice::lat_edge_col_pb;
 QColor prim::Lattice::lat_fill_col;
 QColor prim::Lattice::lat_fill_col_pb;
 
+QCache<prim::Lattice::BkgTileKey, QImage> prim::Lattice::bkg_tile_cache;
+QMutex prim::Lattice::bkg_tile_mutex;
+
 prim::Lattice::Lattice(QXmlStreamReader *rs, int lay_id)
   : Layer(tr("Lattice"), Layer::Lattice, LayerRole::Design, 0)
 {
@@ -110,10 +115,7 @@ void prim::Lattice::constructFromParams(const QString &in_lattice_name,
     a2[i] = QPointF::dotProduct(a[i], a[i]);
   }
 
-  qreal dtrm = a[0].x()*a[1].y() - a[0].y()*a[1].x();
-  coth = QPointF::dotProduct(a[0], a[1]) / dtrm;
-
-  orthog = qAbs(coth) < 1e-4;
+  constructSnapLookup();
 
   // generate lattice and site vectors for display (all integer)
   a_scene[0] = QPointF(tileApprox().topRight() * prim::Item::scale_factor).toPoint();
@@ -121,6 +123,8 @@ void prim::Lattice::constructFromParams(const QString &in_lattice_name,
   b_scene.clear();
   for (QPointF site : b)
     b_scene.append(QPointF(site * prim::Item::scale_factor).toPoint());
+
+  prewarmBackgroundTiles();
 }
 
 
@@ -128,10 +132,7 @@ void prim::Lattice::saveLayer(QXmlStreamWriter *ws) const
 {
   ws->writeStartElement("layer_prop");
 
-  int fp = settings::AppSettings::instance()->get<int>("float_prc");
-  QString fmt_st = settings::AppSettings::instance()->get<QString>("float_fmt");
-  char fmt = fmt_st.at(0).toLatin1();
-  QString str;
+  gui::SaveContext *ctx = gui::SaveContext::current();
 
   // common layer properties
   saveLayerProperties(ws);
@@ -141,14 +142,14 @@ void prim::Lattice::saveLayer(QXmlStreamWriter *ws) const
   ws->writeTextElement("name", lattice_name);
   for (int i=0; i<2; i++) {
     ws->writeEmptyElement(QObject::tr("a%1").arg(i+1));
-    ws->writeAttribute("x", str.setNum(a[i].x(), fmt, fp));
-    ws->writeAttribute("y", str.setNum(a[i].y(), fmt, fp));
+    ws->writeAttribute("x", ctx->real(a[i].x()));
+    ws->writeAttribute("y", ctx->real(a[i].y()));
   }
-  ws->writeTextElement("N", QString::number(n_cell));
+  ws->writeTextElement("N", ctx->number(n_cell));
   for (int i=0; i<b.size(); i++) {
     ws->writeEmptyElement(QObject::tr("b%1").arg(i+1));
-    ws->writeAttribute("x", str.setNum(b[i].x(), fmt, fp));
-    ws->writeAttribute("y", str.setNum(b[i].y(), fmt, fp));
+    ws->writeAttribute("x", ctx->real(b[i].x()));
+    ws->writeAttribute("y", ctx->real(b[i].y()));
   }
   ws->writeEndElement();  // end of lat_vec
 
@@ -167,36 +168,78 @@ prim::LatticeCoord prim::Lattice::nearestSite(const QPointF &pos,
 prim::LatticeCoord prim::Lattice::nearestSite(const QPointF &pos, 
     QPointF &nearest_site_pos, bool is_scene_pos) const
 {
-  LatticeCoord coord(0,0,-1);
-
-  int n0[2];
-  qreal proj;
   QPointF x = is_scene_pos ? pos/prim::Item::scale_factor : pos;
+  QPointF nearest_phys;
+  LatticeCoord coord = nearestSitePhys(x, nearest_phys);
+  nearest_site_pos = nearest_phys * prim::Item::scale_factor;
+  return coord;
+}
 
-  for(int i=0; i<2; i++){
-    proj = QPointF::dotProduct(x, a[i])/a2[i];
-    if(!orthog){
-      qreal x2 = QPointF::dotProduct(x,x);
-      proj += (proj>0 ? -1:1)*coth*qSqrt(qMax(0.,x2/a2[i]-proj*proj));
-    }
-    n0[i] = qFloor(proj);
+
+QVector<prim::LatticeCoord> prim::Lattice::nearestSites(
+    const QVector<QPointF> &pos, bool is_scene_pos) const
+{
+  const int count = pos.size();
+  QVector<LatticeCoord> coords(count);
+  if (count == 0)
+    return coords;
+
+  // first pass: fractional coordinates of all points through the reciprocal
+  // basis. Kept as plain arrays so the compiler can vectorize the loop.
+  const qreal sc = is_scene_pos ? 1./prim::Item::scale_factor : 1.;
+  const qreal r00 = a_inv[0][0]*sc, r01 = a_inv[0][1]*sc;
+  const qreal r10 = a_inv[1][0]*sc, r11 = a_inv[1][1]*sc;
+  QVector<qreal> fn(count), fm(count);
+  const QPointF *p = pos.constData();
+  qreal *pfn = fn.data(), *pfm = fm.data();
+  for (int i=0; i<count; i++) {
+    pfn[i] = r00*p[i].x() + r01*p[i].y();
+    pfm[i] = r10*p[i].x() + r11*p[i].y();
   }
 
-  qreal mdist = qMax(a2[0], a2[1]);         // nearest Manhattan length
-  for(int n=n0[0]-1; n<n0[0]+2; n++){
-    for(int m=n0[1]-1; m<n0[1]+2; m++){
-      QPointF x0 = n*a[0]+m*a[1];
-      for (int l=0; l<b.size(); l++){
-        QPointF temp = x0 + b[l];
-        qreal dist = (temp-x).manhattanLength();
-        if(dist<=mdist) {
-          mdist = dist;
-          nearest_site_pos = temp * prim::Item::scale_factor;
-          coord.n = n;
-          coord.m = m;
-          coord.l = l;
-        }
-      }
+  // second pass: resolve each point against the candidates of its bin
+  QPointF nearest_phys;
+  for (int i=0; i<count; i++)
+    coords[i] = nearestSiteFrac(p[i] * sc, pfn[i], pfm[i], nearest_phys);
+
+  return coords;
+}
+
+
+prim::LatticeCoord prim::Lattice::nearestSitePhys(const QPointF &x,
+    QPointF &nearest_phys) const
+{
+  // fractional coordinates through the reciprocal basis
+  qreal fn = a_inv[0][0]*x.x() + a_inv[0][1]*x.y();
+  qreal fm = a_inv[1][0]*x.x() + a_inv[1][1]*x.y();
+  return nearestSiteFrac(x, fn, fm, nearest_phys);
+}
+
+
+prim::LatticeCoord prim::Lattice::nearestSiteFrac(const QPointF &x, qreal fn,
+    qreal fm, QPointF &nearest_phys) const
+{
+  LatticeCoord coord(0,0,-1);
+  int n0 = qFloor(fn);
+  int m0 = qFloor(fm);
+
+  // look up the candidates of the unit cell bin that x falls in
+  int bu = qBound(0, int((fn-n0)*snap_res), snap_res-1);
+  int bv = qBound(0, int((fm-m0)*snap_res), snap_res-1);
+  int bin = bu*snap_res + bv;
+
+  qreal mdist = -1;   // nearest squared Euclidean distance
+  for (int k=snap_cand_ind[bin]; k<snap_cand_ind[bin+1]; k++) {
+    const SiteOffset &c = snap_cands[k];
+    QPointF temp = (n0+c.dn)*a[0] + (m0+c.dm)*a[1] + b[c.l];
+    QPointF d = temp - x;
+    qreal dist = QPointF::dotProduct(d, d);
+    if (mdist < 0 || dist <= mdist) {
+      mdist = dist;
+      nearest_phys = temp;
+      coord.n = n0+c.dn;
+      coord.m = m0+c.dm;
+      coord.l = c.l;
     }
   }
 
@@ -207,50 +250,24 @@ prim::LatticeCoord prim::Lattice::nearestSite(const QPointF &pos,
   //qDebug() << tr("Nearest Lattice Site: %1 :: %2").arg(mp.x()).arg(mp.y());
 
   return coord;
-  //return mp;                            // physical (angstrom) coords
-  //return mp*prim::Item::scale_factor;   // scene (pixel) coords
 }
 
 
 QList<prim::LatticeCoord> prim::Lattice::enclosedSites(const QRectF &scene_rect) const
 {
-  LatticeCoord coord1 = nearestSite(scene_rect.topLeft(), true);
-  LatticeCoord coord2 = nearestSite(scene_rect.bottomRight(), true);
-  return enclosedSites(coord1, coord2);
+  QList<LatticeCoord> coords;
+  LatticeSiteWalker walker(this, QPolygonF(scene_rect.normalized()), true);
+  walker.visit([&coords](const LatticeCoord &coord) {coords.append(coord);});
+  return coords;
 }
 
 
 QList<prim::LatticeCoord> prim::Lattice::enclosedSites(const prim::LatticeCoord &coord1,
     const prim::LatticeCoord &coord2) const
 {
-  // WARNING assumes n is purely horizontal and m is purely vertical. Might not
-  // be the case!
-  int n_min = qMin(coord1.n, coord2.n);
-  int n_max = qMax(coord1.n, coord2.n);
-  int m_min = qMin(coord1.m, coord2.m);
-  int m_max = qMax(coord1.m, coord2.m);
-  int l_tl, l_br; // top left and bottom right
-  if (coord1.m == coord2.m) {
-    l_tl = qMin(coord1.l, coord2.l);
-    l_br = qMax(coord1.l, coord2.l);
-  } else {
-    l_tl = coord1.m < coord2.m ? coord1.l : coord2.l; // top left
-    l_br = coord1.m > coord2.m ? coord1.l : coord2.l; // bottom right
-  }
-
   QList<prim::LatticeCoord> coords;
-
-  for (int n_site=n_min; n_site<=n_max; n_site++) {
-    for (int m_site=m_min; m_site<=m_max; m_site++) {
-      for (int l_site=0; l_site<n_cell; l_site++) {
-        if (  !(m_min == m_max && l_tl != l_br)
-              && ((m_site == m_min && l_site < l_tl)
-                  || (m_site == m_max && l_site > l_br)))
-          continue;
-        coords.append(prim::LatticeCoord(n_site, m_site, l_site));
-      }
-    }
-  }
+  visitSiteRange(coord1, coord2,
+      [&coords](const LatticeCoord &coord) {coords.append(coord);});
   return coords;
 }
 
@@ -294,8 +311,10 @@ QList<prim::DBDot*> prim::Lattice::dbsAtPhysLocs(const QList<QPointF> &physlocs)
 {
   QList<prim::DBDot*> dbs;
 
-  for (const QPointF &physloc : physlocs) {
-    prim::DBDot *db = dbAt(nearestSite(physloc, false));
+  QVector<prim::LatticeCoord> coords = nearestSites(QVector<QPointF>(
+        physlocs.begin(), physlocs.end()), false);
+  for (const prim::LatticeCoord &coord : coords) {
+    prim::DBDot *db = dbAt(coord);
     if (db == nullptr) {
       qFatal("No DB at specified location, aborting DB gathering.");
       return QList<prim::DBDot*>();
@@ -306,6 +325,36 @@ QList<prim::DBDot*> prim::Lattice::dbsAtPhysLocs(const QList<QPointF> &physlocs)
 }
 
 
+QList<prim::DBDot*> prim::Lattice::dbsInPolygon(const QPolygonF &scene_poly) const
+{
+  QList<prim::DBDot*> dbs;
+  if (scene_poly.isEmpty() || occ_index.count() == 0)
+    return dbs;
+
+  // bound the polygon in fractional lattice coordinates, padded by one cell
+  // to cover unit cell site offsets
+  qreal f_min[2] = {qInf(), qInf()};
+  qreal f_max[2] = {-qInf(), -qInf()};
+  for (const QPointF &scene_pt : scene_poly) {
+    QPointF x = scene_pt / prim::Item::scale_factor;
+    for (int i=0; i<2; i++) {
+      qreal f = a_inv[i][0]*x.x() + a_inv[i][1]*x.y();
+      f_min[i] = qMin(f_min[i], f);
+      f_max[i] = qMax(f_max[i], f);
+    }
+  }
+
+  occ_index.forEachInRange(qFloor(f_min[0])-1, qCeil(f_max[0])+1,
+      qFloor(f_min[1])-1, qCeil(f_max[1])+1,
+      [&](int n, int m, int l, prim::DBDot *db) {
+        QPointF pos = latticeCoord2ScenePos(prim::LatticeCoord(n, m, l));
+        if (scene_poly.containsPoint(pos, Qt::OddEvenFill))
+          dbs.append(db);
+      });
+  return dbs;
+}
+
+
 QRectF prim::Lattice::tileApprox()
 {
   qreal r = QPointF::dotProduct(a[0], a[1])/QPointF::dotProduct(a[0], a[0]);
@@ -324,52 +373,188 @@ QRectF prim::Lattice::tileApprox()
 }
 
 
-QImage prim::Lattice::tileableLatticeImage(QColor bkg_col, bool publish)
+QImage prim::Lattice::tileableLatticeImage(QColor bkg_col, bool publish,
+    qreal render_scale)
+{
+  return renderBackgroundTile(backgroundTileGeom(publish), bkg_col, render_scale);
+}
+
+
+QBrush prim::Lattice::backgroundBrush(const QColor &bkg_col, bool publish,
+    qreal device_zoom)
+{
+  int zoom_exp = backgroundZoomExp(device_zoom);
+  BkgTileKey key = backgroundTileKey(bkg_col, publish, zoom_exp);
+  BkgTileGeom geom = backgroundTileGeom(publish);
+
+  QImage tile = cachedBackgroundTile(key);
+  if (tile.isNull()) {
+    tile = renderBackgroundTile(geom, bkg_col, qPow(2, zoom_exp));
+    cacheBackgroundTile(key, tile);
+  }
+
+  // map the tile back to scene pixels
+  QBrush brush(tile);
+  brush.setTransform(QTransform::fromScale(
+        qreal(geom.tile_size.width()) / tile.width(),
+        qreal(geom.tile_size.height()) / tile.height()));
+  return brush;
+}
+
+
+qreal prim::Lattice::backgroundZoomBucket(qreal device_zoom)
+{
+  return qPow(2, backgroundZoomExp(device_zoom));
+}
+
+
+void prim::Lattice::prewarmBackgroundTiles()
+{
+  settings::GUISettings *gui_settings = settings::GUISettings::instance();
+  qreal zoom_threshold = gui_settings->get<qreal>("latdot/zoom_vis_threshold");
+  qreal zoom_max = gui_settings->get<qreal>("view/zoom_max");
+
+  QList<qreal> dprs({1.});
+  for (QScreen *screen : QGuiApplication::screens())
+    if (!dprs.contains(screen->devicePixelRatio()))
+      dprs.append(screen->devicePixelRatio());
+
+  // collect the keys to render on the GUI thread, the worker only gets copies
+  QList<QPair<BkgTileKey, QColor>> todo;
+  for (bool publish : {false, true}) {
+    QColor bkg_col = gui_settings->get<QColor>(publish ? "view/bg_col_pb" : "view/bg_col");
+    for (qreal dpr : dprs) {
+      for (int zoom_exp = backgroundZoomExp(zoom_threshold*dpr);
+          zoom_exp <= backgroundZoomExp(zoom_max*dpr); zoom_exp++) {
+        BkgTileKey key = backgroundTileKey(bkg_col, publish, zoom_exp);
+        bool listed = false;
+        for (const QPair<BkgTileKey, QColor> &item : todo)
+          listed |= item.first == key;
+        if (!listed)
+          todo.append(qMakePair(key, bkg_col));
+      }
+    }
+  }
+
+  BkgTileGeom geom = backgroundTileGeom(false);
+  BkgTileGeom geom_pb = backgroundTileGeom(true);
+  QThreadPool::globalInstance()->start([todo, geom, geom_pb]() {
+    for (const QPair<BkgTileKey, QColor> &item : todo) {
+      if (!cachedBackgroundTile(item.first).isNull())
+        continue;
+      QImage tile = renderBackgroundTile(item.first.publish ? geom_pb : geom,
+          item.second, qPow(2, item.first.zoom_exp));
+      cacheBackgroundTile(item.first, tile);
+    }
+  });
+}
+
+
+int prim::Lattice::backgroundZoomExp(qreal device_zoom)
 {
-  qreal lat_diam_paint = publish ? lat_diam_pb : lat_diam;
-  qreal lat_edge_width_paint = publish ? lat_edge_width_pb : lat_edge_width;
-  QColor lat_edge_col_paint = publish ? lat_edge_col_pb : lat_edge_col;
-  QColor lat_fill_col_paint = publish ? lat_fill_col_pb : lat_fill_col;
+  if (device_zoom <= 0)
+    return bkg_zoom_exp_min;
+  return qBound(bkg_zoom_exp_min, qCeil(std::log2(device_zoom) - 1e-9),
+      bkg_zoom_exp_max);
+}
+
 
-  // First generate a bitmap background with latdots drawn with their top left
-  // coordinate at the site coord, rather than their centers. This is to 
-  // prevent dots at the edge from having cut-off parts when tiled.
-  QPixmap bkg_pixmap(QSize(a_scene[0].x(), a_scene[1].y()));
-  bkg_pixmap.fill(bkg_col);
-  QPainter painter(&bkg_pixmap);
-  //painter.setRenderHint(QPainter::Antialiasing);
+prim::Lattice::BkgTileGeom prim::Lattice::backgroundTileGeom(bool publish)
+{
+  BkgTileGeom geom;
+  geom.tile_size = QSizeF(tileApprox().size()*prim::Item::scale_factor).toSize();
+  geom.sites = b_scene;
+  geom.diam = publish ? lat_diam_pb : lat_diam;
+  geom.edge_width = publish ? lat_edge_width_pb : lat_edge_width;
+  geom.edge_col = publish ? lat_edge_col_pb : lat_edge_col;
+  geom.fill_col = publish ? lat_fill_col_pb : lat_fill_col;
+  return geom;
+}
+
+
+prim::Lattice::BkgTileKey prim::Lattice::backgroundTileKey(const QColor &bkg_col,
+    bool publish, int zoom_exp) const
+{
+  size_t lattice_hash = qHashMulti(0, a_scene[0].x(), a_scene[0].y(),
+      a_scene[1].x(), a_scene[1].y());
+  for (const QPoint &site : b_scene)
+    lattice_hash = qHashMulti(lattice_hash, site.x(), site.y());
+  return BkgTileKey{publish, bkg_col.rgba(), zoom_exp, lattice_hash};
+}
+
+
+QImage prim::Lattice::renderBackgroundTile(const BkgTileGeom &geom,
+    const QColor &bkg_col, qreal render_scale)
+{
+  qreal lat_diam_paint = geom.diam;
+  qreal lat_edge_width_paint = geom.edge_width;
+  QColor lat_edge_col_paint = geom.edge_col;
+  QColor lat_fill_col_paint = geom.fill_col;
+
+  // QImage rather than QPixmap so that tiles can be rendered off the GUI
+  // thread. Painting is done in scene pixels through a scaled painter.
+  QSize img_size(qMax(1, qCeil(geom.tile_size.width()*render_scale)),
+                 qMax(1, qCeil(geom.tile_size.height()*render_scale)));
+  QImage bkg_img(img_size, QImage::Format_ARGB32_Premultiplied);
+  bkg_img.fill(bkg_col);
+  if (geom.tile_size.isEmpty())
+    return bkg_img;
+
+  QPainter painter(&bkg_img);
   painter.setRenderHint(QPainter::Antialiasing, true);
-  for (QPoint site : b_scene) {
-    QRect circ(site.x()+lat_edge_width_paint,site.y()+lat_edge_width_paint,
-               lat_diam_paint, lat_diam_paint);
-
-    // outer edge
-    painter.setBrush(Qt::NoBrush);
-    painter.setPen(QPen(lat_edge_col_paint, lat_edge_width_paint));
-    painter.drawEllipse(circ);
-
-    // inner fill
-    circ.adjust(lat_edge_width_paint/2, lat_edge_width_paint/2, 
-                -lat_edge_width_paint/2, -lat_edge_width_paint/2);
-    painter.setBrush(lat_fill_col_paint);
-    painter.setPen(Qt::NoPen);
-    painter.drawEllipse(circ);
+  painter.scale(qreal(img_size.width()) / geom.tile_size.width(),
+                qreal(img_size.height()) / geom.tile_size.height());
+
+  // dots are centered on the site positions, dots crossing the tile edges are
+  // also drawn wrapped around so that the tile remains seamless
+  qreal r_out = 0.5 * (lat_diam_paint + lat_edge_width_paint);
+  for (const QPoint &site : geom.sites) {
+    for (int dx=-1; dx<=1; dx++) {
+      for (int dy=-1; dy<=1; dy++) {
+        QPointF center(site.x() + dx*geom.tile_size.width(),
+                       site.y() + dy*geom.tile_size.height());
+        if (center.x() + r_out < 0 || center.x() - r_out > geom.tile_size.width()
+            || center.y() + r_out < 0 || center.y() - r_out > geom.tile_size.height())
+          continue;
+        QRectF circ(center.x() - 0.5*lat_diam_paint, center.y() - 0.5*lat_diam_paint,
+                    lat_diam_paint, lat_diam_paint);
+
+        // outer edge
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(lat_edge_col_paint, lat_edge_width_paint));
+        painter.drawEllipse(circ);
+
+        // inner fill
+        circ.adjust(lat_edge_width_paint/2, lat_edge_width_paint/2,
+                    -lat_edge_width_paint/2, -lat_edge_width_paint/2);
+        painter.setBrush(lat_fill_col_paint);
+        painter.setPen(Qt::NoPen);
+        painter.drawEllipse(circ);
+      }
+    }
   }
   painter.end();
 
-  // then generate a single tile with properly offset circles
-  QImage bkg_img(QSize(
-            QSizeF(tileApprox().size()*prim::Item::scale_factor).toSize()),
-            QImage::Format_ARGB32);
-  QPainter painter_offset(&bkg_img);
-  int offset = 0.5 * lat_diam_paint + lat_edge_width_paint;
-  painter_offset.drawTiledPixmap(bkg_pixmap.rect(), bkg_pixmap, QPoint(offset,offset));
-  painter_offset.end();
-
   return bkg_img;
 }
 
 
+QImage prim::Lattice::cachedBackgroundTile(const BkgTileKey &key)
+{
+  QMutexLocker locker(&bkg_tile_mutex);
+  QImage *tile = bkg_tile_cache.object(key);
+  return tile ? *tile : QImage();
+}
+
+
+void prim::Lattice::cacheBackgroundTile(const BkgTileKey &key, const QImage &tile)
+{
+  QMutexLocker locker(&bkg_tile_mutex);
+  int cost = qMax<qsizetype>(1, tile.sizeInBytes() / 1024);
+  bkg_tile_cache.insert(key, new QImage(tile), cost);
+}
+
+
 void prim::Lattice::setVisible(bool visible)
 {
   static_cast<prim::Layer*>(this)->setVisible(visible);
@@ -390,16 +575,87 @@ void prim::Lattice::construct()
     a2[i] = QPointF::dotProduct(a[i], a[i]);
   }
 
-  qreal dtrm = a[0].x()*a[1].y() - a[0].y()*a[1].x();
-  coth = QPointF::dotProduct(a[0], a[1]) / dtrm;
-
-  orthog = qAbs(coth) < 1e-4;
+  constructSnapLookup();
 
   // generate lattice and site vectors for display (all integer)
   a_scene[0] = QPointF(tileApprox().topRight() * prim::Item::scale_factor).toPoint();
   a_scene[1] = QPointF(tileApprox().bottomLeft() * prim::Item::scale_factor).toPoint();
   for (QPointF site : b)
     b_scene.append(QPointF(site * prim::Item::scale_factor).toPoint());
+
+  prewarmBackgroundTiles();
+}
+
+
+void prim::Lattice::constructSnapLookup()
+{
+  snap_cands.clear();
+  snap_cand_ind.clear();
+
+  // reciprocal basis: inverse of the matrix with a[0] and a[1] as columns
+  qreal dtrm = a[0].x()*a[1].y() - a[0].y()*a[1].x();
+  if (qAbs(dtrm) < 1e-12 || b.isEmpty()) {
+    qCritical() << tr("Degenerate lattice vectors, nearest site lookup unavailable");
+    snap_cand_ind.fill(0, snap_res*snap_res+1);
+    return;
+  }
+  a_inv[0][0] = a[1].y() / dtrm;
+  a_inv[0][1] = -a[1].x() / dtrm;
+  a_inv[1][0] = -a[0].y() / dtrm;
+  a_inv[1][1] = a[0].x() / dtrm;
+
+  // search range in unit cells: any site nearer than the distance bound
+  // below differs in fractional coordinates by at most |row of a_inv| * bound
+  qreal b_max = 0;
+  for (const QPointF &site : b)
+    b_max = qMax(b_max, qSqrt(QPointF::dotProduct(site, site)));
+  qreal dist_bound = qSqrt(a2[0]) + qSqrt(a2[1]) + 2*b_max;
+  int range[2];
+  for (int i=0; i<2; i++)
+    range[i] = qCeil(qSqrt(a_inv[i][0]*a_inv[i][0] + a_inv[i][1]*a_inv[i][1])
+        * dist_bound) + 1;
+
+  // every site in the search range, in (n, m, l) ascending order so that ties
+  // resolve the same way as the previous neighbourhood search
+  QList<SiteOffset> sites;
+  for (int dn=-range[0]; dn<=range[0]+1; dn++)
+    for (int dm=-range[1]; dm<=range[1]+1; dm++)
+      for (int l=0; l<b.size(); l++)
+        sites.append({dn, dm, l});
+
+  // for each bin, keep the sites which can be the nearest site of some point
+  // in the bin: with bin center c and bin radius r, a site s can only win if
+  // |c-s| - r <= min_s'(|c-s'|) + r
+  snap_cand_ind.append(0);
+  QVector<qreal> dists(sites.size());
+  for (int bu=0; bu<snap_res; bu++) {
+    for (int bv=0; bv<snap_res; bv++) {
+      qreal u0 = qreal(bu)/snap_res, v0 = qreal(bv)/snap_res;
+      qreal du = 1./snap_res, dv = 1./snap_res;
+      QPointF c = (u0+.5*du)*a[0] + (v0+.5*dv)*a[1];
+      qreal r = 0;
+      for (int cu=0; cu<2; cu++)
+        for (int cv=0; cv<2; cv++) {
+          QPointF corner = (u0+cu*du)*a[0] + (v0+cv*dv)*a[1] - c;
+          r = qMax(r, qSqrt(QPointF::dotProduct(corner, corner)));
+        }
+
+      qreal dmin = -1;
+      for (int k=0; k<sites.size(); k++) {
+        QPointF d = sites[k].dn*a[0] + sites[k].dm*a[1] + b[sites[k].l] - c;
+        dists[k] = qSqrt(QPointF::dotProduct(d, d));
+        if (dmin < 0 || dists[k] < dmin)
+          dmin = dists[k];
+      }
+
+      // small tolerance guards against rounding at the bin boundaries
+      qreal cutoff = dmin + 2*r + 1e-9;
+      for (int k=0; k<sites.size(); k++)
+        if (dists[k] <= cutoff)
+          snap_cands.append(sites[k]);
+      snap_cand_ind.append(snap_cands.size());
+    }
+  }
 }
 
 
@@ -436,6 +692,104 @@ void prim::Lattice::constructStatics()
   lat_edge_col_pb = gui_settings->get<QColor>("latdot/edge_col_pb");
   lat_fill_col = gui_settings->get<QColor>("latdot/fill_col");
   lat_fill_col_pb = gui_settings->get<QColor>("latdot/fill_col_pb");
+
+  QMutexLocker locker(&bkg_tile_mutex);
+  bkg_tile_cache.setMaxCost(gui_settings->get<int>("latdot/bkg_cache_kb"));
+}
+
+
+// LatticeSiteWalker Class
+
+prim::LatticeSiteWalker::LatticeSiteWalker(const prim::Lattice *lattice,
+    const QPolygonF &poly, bool is_scene_pos)
+{
+  if (lattice == nullptr || poly.isEmpty())
+    return;
+
+  // walk in the same basis as the positions are given in, scene positions use
+  // the integer scene vectors so the result agrees with latticeCoord2ScenePos
+  QPointF a0 = is_scene_pos ? QPointF(lattice->sceneLatticeVector(0)) : lattice->latticeVector(0);
+  QPointF a1 = is_scene_pos ? QPointF(lattice->sceneLatticeVector(1)) : lattice->latticeVector(1);
+  qreal det = a0.x()*a1.y() - a1.x()*a0.y();
+  if (qFuzzyIsNull(det)) {
+    qWarning() << QObject::tr("Degenerate lattice vectors, no sites to walk.");
+    return;
+  }
+  qreal inv[2][2] = {{a1.y()/det, -a1.x()/det}, {-a0.y()/det, a0.x()/det}};
+
+  n_cell = lattice->unitCellSiteCount();
+  n_verts = poly.size();
+  frac_verts.resize(n_cell*n_verts);
+  qreal fm_min = qInf(), fm_max = -qInf();
+  for (int l=0; l<n_cell; l++) {
+    QPointF site = is_scene_pos ? QPointF(lattice->sceneSiteVector(l)) : lattice->siteVector(l);
+    for (int i=0; i<n_verts; i++) {
+      QPointF x = poly.at(i) - site;
+      QPointF f(inv[0][0]*x.x() + inv[0][1]*x.y(), inv[1][0]*x.x() + inv[1][1]*x.y());
+      frac_verts[l*n_verts+i] = f;
+      fm_min = qMin(fm_min, f.y());
+      fm_max = qMax(fm_max, f.y());
+    }
+  }
+  m_first = qCeil(fm_min - frac_eps);
+  m_last = qFloor(fm_max + frac_eps);
+}
+
+
+QList<QPair<int,int>> prim::LatticeSiteWalker::rowRanges(int parts) const
+{
+  QList<QPair<int,int>> ranges;
+  if (isEmpty() || parts < 1)
+    return ranges;
+  qint64 rows = qint64(m_last) - m_first + 1;
+  parts = int(qMin<qint64>(parts, rows));
+  for (int i=0; i<parts; i++) {
+    int m_begin = m_first + int(rows*i/parts);
+    int m_end = m_first + int(rows*(i+1)/parts) - 1;
+    ranges.append(qMakePair(m_begin, m_end));
+  }
+  return ranges;
+}
+
+
+qint64 prim::LatticeSiteWalker::count() const
+{
+  qint64 total = 0;
+  int n_lo, n_hi;
+  for (int m=m_first; m<=m_last; m++)
+    for (int l=0; l<n_cell; l++)
+      if (rowInterval(m, l, n_lo, n_hi))
+        total += n_hi - n_lo + 1;
+  return total;
+}
+
+
+bool prim::LatticeSiteWalker::rowInterval(int m, int l, int &n_lo, int &n_hi) const
+{
+  // intersect the horizontal line fm = m with each polygon edge
+  const QPointF *v = frac_verts.constData() + l*n_verts;
+  qreal lo = qInf(), hi = -qInf();
+  for (int i=0; i<n_verts; i++) {
+    const QPointF &p = v[i];
+    const QPointF &q = v[(i+1)%n_verts];
+    if (m < qMin(p.y(), q.y()) - frac_eps || m > qMax(p.y(), q.y()) + frac_eps)
+      continue;
+    qreal dy = q.y() - p.y();
+    if (qAbs(dy) <= frac_eps) {
+      lo = qMin(lo, qMin(p.x(), q.x()));
+      hi = qMax(hi, qMax(p.x(), q.x()));
+    } else {
+      qreal t = qBound(0., (m - p.y()) / dy, 1.);
+      qreal x = p.x() + t*(q.x() - p.x());
+      lo = qMin(lo, x);
+      hi = qMax(hi, x);
+    }
+  }
+  if (lo > hi)
+    return false;
+  n_lo = qCeil(lo - frac_eps);
+  n_hi = qFloor(hi + frac_eps);
+  return n_lo <= n_hi;
 }
 
 
@@ -12,7 +12,9 @@
 #define _GUI_PR_LATTICE_H_
 
 #include "layer.h"
+#include "lattice_occupancy.h"
 #include <QHash>
+#include <climits>
 
 namespace prim{
 
@@ -89,6 +91,18 @@ namespace prim{
     //! Return specified site vector after graphical scaling
     QPoint sceneSiteVector(int ind) const {return b_scene[ind];}
 
+    //! Return the lattice name
+    QString latticeName() const {return lattice_name;}
+
+    //! Return specified lattice vector in angstrom
+    QPointF latticeVector(int dim) const {return a[dim];}
+
+    //! Return specified site vector in angstrom
+    QPointF siteVector(int ind) const {return b[ind];}
+
+    //! Return the number of sites in the unit cell
+    int unitCellSiteCount() const {return n_cell;}
+
     //! Identify the nearest lattice site to the given scene position.
     LatticeCoord nearestSite(const QPointF &pos, bool is_scene_pos) const;
 
@@ -97,15 +111,32 @@ namespace prim{
     LatticeCoord nearestSite(const QPointF &pos, QPointF &nearest_site_pos,
         bool is_scene_pos) const;
 
+    //! Identify the nearest lattice site to each of the given positions. This
+    //! is the batch form of nearestSite and should be preferred when snapping
+    //! large numbers of points at once.
+    QVector<LatticeCoord> nearestSites(const QVector<QPointF> &pos,
+        bool is_scene_pos=false) const;
+
     //! Return a QList of lattice site coordinates enclosed in a given QRectF 
-    //! in scene coordinates. WARNING this won't work with rotated lattices!
+    //! in scene coordinates. Prefer LatticeSiteWalker for large regions, which
+    //! visits the same sites without materializing the list.
     QList<LatticeCoord> enclosedSites(const QRectF &scene_rect) const;
 
-    //! Return all sites enclosed in given lattice coordinates. WARNING this won't
-    //! work with rotated lattices!
+    //! Return all sites enclosed in given lattice coordinates, see
+    //! visitSiteRange.
     QList<prim::LatticeCoord> enclosedSites(const prim::LatticeCoord &coord1,
         const prim::LatticeCoord &coord2) const;
 
+    //! Call f(const LatticeCoord &) for each site in the lattice index range
+    //! spanned by the given coordinates, without materializing the list. All
+    //! unit cell sites of the inner rows are visited, the first row starts at
+    //! the unit cell site of the upper coordinate and the last row ends at
+    //! the unit cell site of the lower one. The range follows the lattice
+    //! vectors, so it is a parallelogram on skewed lattices.
+    template<typename Func>
+    void visitSiteRange(const prim::LatticeCoord &coord1,
+        const prim::LatticeCoord &coord2, Func f) const;
+
     //! Convert lattice coordinates to scene position in QPointF. Does not check 
     //! for validity.
     QPointF latticeCoord2ScenePos(const prim::LatticeCoord &l_coord) const;
@@ -119,23 +150,29 @@ namespace prim{
 
     //! Set lattice dot location to be occupied
     void setOccupied(const prim::LatticeCoord &l_coord, prim::DBDot *dbdot) {
-      qDebug() << tr("set occupied %1, %2, %3").arg(l_coord.n).arg(l_coord.m).arg(l_coord.l);
-      occ_latdots.insert(l_coord, dbdot);
+      occ_index.insert(l_coord, dbdot);
     }
 
     //! Set lattice dot location to be unoccupied
     void setUnoccupied(const prim::LatticeCoord &l_coord) {
-      occ_latdots.remove(l_coord);
+      occ_index.remove(l_coord);
     }
 
     //! Clear occupation list (the pointers aren't actually deleted).
     void clearOccupation() {
-      occ_latdots.clear();
+      occ_index.clear();
     }
 
     //! Return whether lattice dot location is occupied.
-    bool isOccupied(const prim::LatticeCoord &l_coord) {
-      return occ_latdots.contains(l_coord);
+    bool isOccupied(const prim::LatticeCoord &l_coord) const {
+      return occ_index.contains(l_coord);
+    }
+
+    //! Return whether any of the given lattice coordinates, shifted by offset,
+    //! is occupied.
+    bool anyOccupied(const QVector<prim::LatticeCoord> &l_coords,
+        const prim::LatticeCoord &offset=prim::LatticeCoord(0,0,0)) const {
+      return occ_index.anyOccupied(l_coords, offset);
     }
 
     //! Return whether the given lattice coordinate is a valid coordinate.
@@ -144,8 +181,24 @@ namespace prim{
     }
 
     //! Return the DBDot pointer at the specified lattice coord, or nullptr if none.
-    prim::DBDot *dbAt(const prim::LatticeCoord &l_coord) {
-      return occ_latdots.contains(l_coord) ? occ_latdots.value(l_coord) : nullptr;
+    prim::DBDot *dbAt(const prim::LatticeCoord &l_coord) const {
+      return occ_index.value(l_coord);
+    }
+
+    //! Return the occupancy index of the lattice for range queries.
+    const prim::LatticeOccupancy &occupancy() const {return occ_index;}
+
+    //! Return the DBDot pointers at lattice sites within the given polygon in
+    //! scene coordinates.
+    QList<prim::DBDot*> dbsInPolygon(const QPolygonF &scene_poly) const;
+
+    //! Return the first unoccupied lattice site in the inclusive range spanned
+    //! by the two given lattice coordinates, or a coordinate with l = -1 if all
+    //! sites are occupied.
+    prim::LatticeCoord firstFreeSite(const prim::LatticeCoord &coord1,
+        const prim::LatticeCoord &coord2) const {
+      return occ_index.firstFreeSite(qMin(coord1.n, coord2.n), qMax(coord1.n, coord2.n),
+          qMin(coord1.m, coord2.m), qMax(coord1.m, coord2.m), n_cell);
     }
 
     //! Return a list of DBDot pointers at specified physical locations (angstrom).
@@ -154,8 +207,25 @@ namespace prim{
     //! identify the bounding rect of an approximately rectangular supercell
     QRectF tileApprox();
 
-    //! Return a tileable image that represents the lattice.
-    QImage tileableLatticeImage(QColor bkg_col, bool publish=false);
+    //! Return a tileable image that represents the lattice, rendered at the
+    //! given scale relative to scene pixels.
+    QImage tileableLatticeImage(QColor bkg_col, bool publish=false,
+        qreal render_scale=1.);
+
+    //! Return the background brush tiling the lattice for the given view zoom
+    //! in device pixels per scene pixel. Tiles are rendered at the resolution
+    //! of the zoom bucket and served from a LRU cache shared by all lattices.
+    QBrush backgroundBrush(const QColor &bkg_col, bool publish, qreal device_zoom);
+
+    //! Return the tile render scale bucket for the given device zoom, the
+    //! smallest power of two not below it (within bounds).
+    static qreal backgroundZoomBucket(qreal device_zoom);
+
+    //! Render the background tiles for the configured background colours, all
+    //! zoom buckets above the lattice visibility threshold and the device pixel
+    //! ratios of all screens on a worker thread, so that later zooming is
+    //! served from the cache.
+    void prewarmBackgroundTiles();
 
     //! Set the visiblity of the lattice
     void setVisible(bool);
@@ -173,11 +243,82 @@ namespace prim{
     qreal Lx;           // x-bound on lattice vectors, in Angstroms
     qreal Ly;           // y-bound on lattice vectors, in Angstroms
 
-    qreal coth;         // cotangent of angle between lattice vectors
-    bool orthog;        // lattice vectors are orthogonal
     qreal a2[2];        // square magnitudes of lattice vectors
-
-    QHash<prim::LatticeCoord, prim::DBDot*> occ_latdots; // set of occupied lattice dots
+    qreal a_inv[2][2];  // reciprocal basis, maps positions to fractional coords
+
+    //! Lattice site relative to the unit cell that a position falls in.
+    struct SiteOffset {
+      int dn;
+      int dm;
+      int l;
+    };
+
+    // Voronoi lookup of the unit cell: the unit cell is binned into a
+    // snap_res x snap_res grid in fractional coordinates and each bin holds
+    // the (conservative) list of sites which can be nearest to any point in
+    // that bin. Stored in compressed form, candidates of bin i are
+    // snap_cands[snap_cand_ind[i]] to snap_cands[snap_cand_ind[i+1]-1].
+    static const int snap_res = 16;
+    QVector<SiteOffset> snap_cands;
+    QVector<int> snap_cand_ind;
+
+    prim::LatticeOccupancy occ_index; // occupied lattice dots
+
+    // background tile cache
+
+    //! Key of a cached background tile.
+    struct BkgTileKey {
+      bool publish;
+      QRgb bkg_col;
+      int zoom_exp;         // render scale is 2^zoom_exp
+      size_t lattice_hash;  // hash of the scene lattice and site vectors
+
+      bool operator==(const BkgTileKey &other) const {
+        return publish == other.publish && bkg_col == other.bkg_col
+            && zoom_exp == other.zoom_exp && lattice_hash == other.lattice_hash;
+      }
+
+      friend size_t qHash(const BkgTileKey &key, size_t seed=0) {
+        return qHashMulti(seed, key.publish, key.bkg_col, key.zoom_exp,
+            key.lattice_hash);
+      }
+    };
+
+    //! Geometry and dot style needed to render a background tile, copied by
+    //! value so that tiles can be rendered on worker threads.
+    struct BkgTileGeom {
+      QSize tile_size;        // tile size in scene pixels
+      QList<QPoint> sites;    // site positions in scene pixels
+      qreal diam;             // dot diameter in scene pixels
+      qreal edge_width;       // dot edge width in scene pixels
+      QColor edge_col;        // dot edge colour
+      QColor fill_col;        // dot fill colour
+    };
+
+    static QCache<BkgTileKey, QImage> bkg_tile_cache;  // cost in KiB
+    static QMutex bkg_tile_mutex;
+
+    static const int bkg_zoom_exp_min = -8;
+    static const int bkg_zoom_exp_max = 2;
+
+    // zoom bucket exponent of the given device zoom
+    static int backgroundZoomExp(qreal device_zoom);
+
+    // return the geometry of this lattice's background tile in the given mode
+    BkgTileGeom backgroundTileGeom(bool publish);
+
+    // return the key of the background tile with the given parameters
+    BkgTileKey backgroundTileKey(const QColor &bkg_col, bool publish, int zoom_exp) const;
+
+    // render a background tile at the given scale, safe to call off the GUI thread
+    static QImage renderBackgroundTile(const BkgTileGeom &geom, const QColor &bkg_col,
+        qreal render_scale);
+
+    // return the cached tile for the key, or a null image if not cached
+    static QImage cachedBackgroundTile(const BkgTileKey &key);
+
+    // insert a tile into the cache
+    static void cacheBackgroundTile(const BkgTileKey &key, const QImage &tile);
 
     // constants
 
@@ -187,6 +328,18 @@ namespace prim{
     // construct lattice from lattice settings
     void construct();
 
+    // construct the reciprocal basis and unit cell Voronoi lookup used for
+    // nearest site identification, must be called whenever a or b changes
+    void constructSnapLookup();
+
+    // resolve the nearest site given the position in angstrom
+    LatticeCoord nearestSitePhys(const QPointF &x, QPointF &nearest_phys) const;
+
+    // resolve the nearest site of x (angstrom) against the candidates of the
+    // unit cell bin of its fractional coordinates fn and fm
+    LatticeCoord nearestSiteFrac(const QPointF &x, qreal fn, qreal fm,
+                                 QPointF &nearest_phys) const;
+
     // Find a rational approximation of a given float
     QPair<int,int> rationalize(qreal x, int k=0);
 
@@ -204,6 +357,116 @@ namespace prim{
     static QColor lat_fill_col_pb;
   };  // end of Lattice class
 
+  //! Streaming walk over the lattice sites enclosed in a convex polygon, in
+  //! scene or physical coordinates. The polygon is mapped to fractional
+  //! coordinates of each unit cell site so any lattice vectors (skewed or
+  //! rotated) are handled, and each lattice row m is reduced to an interval of
+  //! n. Visiting allocates nothing per site and rows may be split into ranges
+  //! that are visited independently, e.g. by parallel consumers. Sites lying on
+  //! the polygon boundary are included. Non-convex polygons are walked as the
+  //! per-row span of their edges.
+  class LatticeSiteWalker
+  {
+  public:
+    //! Construct a walker over the sites of lattice enclosed in poly.
+    LatticeSiteWalker(const prim::Lattice *lattice, const QPolygonF &poly,
+        bool is_scene_pos=true);
+
+    //! Return whether no rows intersect the polygon.
+    bool isEmpty() const {return m_first > m_last;}
+
+    //! First lattice row m intersecting the polygon.
+    int firstRow() const {return m_first;}
+
+    //! Last lattice row m intersecting the polygon.
+    int lastRow() const {return m_last;}
+
+    //! Split the rows into at most parts contiguous inclusive ranges of
+    //! roughly equal size.
+    QList<QPair<int,int>> rowRanges(int parts) const;
+
+    //! Call f(const LatticeCoord &) for each enclosed site, in m, n, l order.
+    template<typename Func>
+    void visit(Func f) const {visitRows(m_first, m_last, f);}
+
+    //! Call f(const LatticeCoord &) for each enclosed site in the inclusive
+    //! row range. Safe to call concurrently on disjoint ranges.
+    template<typename Func>
+    void visitRows(int m_begin, int m_end, Func f) const;
+
+    //! Return the number of enclosed sites.
+    qint64 count() const;
+
+  private:
+
+    // inclusive n interval of the given row for unit cell site l, returns
+    // false if the row doesn't intersect the polygon for that site
+    bool rowInterval(int m, int l, int &n_lo, int &n_hi) const;
+
+    static constexpr qreal frac_eps = 1e-7; // boundary tolerance in fractional coords
+
+    int n_cell=0;
+    int m_first=0;
+    int m_last=-1;
+    int n_verts=0;
+    QVector<QPointF> frac_verts; // polygon vertices in fractional coords of
+                                 // each site, n_verts per site
+  };
+
+  template<typename Func>
+  void Lattice::visitSiteRange(const prim::LatticeCoord &coord1,
+      const prim::LatticeCoord &coord2, Func f) const
+  {
+    int n_min = qMin(coord1.n, coord2.n);
+    int n_max = qMax(coord1.n, coord2.n);
+    int m_min = qMin(coord1.m, coord2.m);
+    int m_max = qMax(coord1.m, coord2.m);
+    int l_tl, l_br; // top left and bottom right
+    if (coord1.m == coord2.m) {
+      l_tl = qMin(coord1.l, coord2.l);
+      l_br = qMax(coord1.l, coord2.l);
+    } else {
+      l_tl = coord1.m < coord2.m ? coord1.l : coord2.l;
+      l_br = coord1.m > coord2.m ? coord1.l : coord2.l;
+    }
+
+    for (int n_site=n_min; n_site<=n_max; n_site++) {
+      for (int m_site=m_min; m_site<=m_max; m_site++) {
+        for (int l_site=0; l_site<n_cell; l_site++) {
+          if (  !(m_min == m_max && l_tl != l_br)
+                && ((m_site == m_min && l_site < l_tl)
+                    || (m_site == m_max && l_site > l_br)))
+            continue;
+          f(prim::LatticeCoord(n_site, m_site, l_site));
+        }
+      }
+    }
+  }
+
+  template<typename Func>
+  void LatticeSiteWalker::visitRows(int m_begin, int m_end, Func f) const
+  {
+    m_begin = qMax(m_begin, m_first);
+    m_end = qMin(m_end, m_last);
+    QVarLengthArray<int, 8> lo(n_cell), hi(n_cell);
+    for (int m=m_begin; m<=m_end; m++) {
+      int row_lo = INT_MAX, row_hi = INT_MIN;
+      for (int l=0; l<n_cell; l++) {
+        if (!rowInterval(m, l, lo[l], hi[l])) {
+          lo[l] = INT_MAX;
+          hi[l] = INT_MIN;
+          continue;
+        }
+        row_lo = qMin(row_lo, lo[l]);
+        row_hi = qMax(row_hi, hi[l]);
+      }
+      for (int n=row_lo; n<=row_hi; n++)
+        for (int l=0; l<n_cell; l++)
+          if (n >= lo[l] && n <= hi[l])
+            f(prim::LatticeCoord(n, m, l));
+    }
+  }
+
   class LatticeDotPreview : public Item
   {
   public:
@@ -242,9 +505,9 @@ namespace prim{
   };  // end of LatticeDotPreview class
 
   //! Hash function for lattice coordinates
-  inline uint qHash(const prim::LatticeCoord &l_coord, uint seed=0)
+  inline size_t qHash(const prim::LatticeCoord &l_coord, size_t seed=0)
   {
-    return ::qHash(l_coord.n, seed) + ::qHash(l_coord.m, seed) + ::qHash(l_coord.l, seed);
+    return qHashMulti(seed, l_coord.n, l_coord.m, l_coord.l);
   }
 
 } // end prim namespace
@@ -0,0 +1,254 @@
+// @file:     lattice_occupancy.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     LatticeOccupancy implementation.
+
+#include "lattice_occupancy.h"
+#include "lattice.h"
+
+#include <climits>
+
+using namespace prim;
+
+
+void LatticeOccupancy::insert(const LatticeCoord &coord, DBDot *db)
+{
+  if (coord.l < 0) {
+    qWarning() << QObject::tr("Attempted to occupy lattice coordinate with "
+        "invalid site index %1").arg(coord.l);
+    return;
+  }
+  int tn = tileIndex(coord.n), tm = tileIndex(coord.m);
+  Tile *&tile = tiles[tileKey(tn, tm)];
+  if (!tile)
+    tile = new Tile();
+  if (tile->planes.size() <= coord.l)
+    tile->planes.resize(coord.l+1);
+
+  Plane &plane = tile->planes[coord.l];
+  int bit = cellBit(coord.n, coord.m, tn, tm);
+  int rank = plane.rank(bit);
+  if (plane.test(bit)) {
+    plane.dbs[rank] = db;
+    return;
+  }
+  plane.bits[bit >> 6] |= Q_UINT64_C(1) << (bit & 63);
+  plane.dbs.insert(rank, db);
+  tile->count++;
+  total++;
+  rev++;
+}
+
+
+bool LatticeOccupancy::remove(const LatticeCoord &coord)
+{
+  if (coord.l < 0)
+    return false;
+  int tn = tileIndex(coord.n), tm = tileIndex(coord.m);
+  auto it = tiles.find(tileKey(tn, tm));
+  if (it == tiles.end())
+    return false;
+  Tile *tile = it.value();
+  if (tile->planes.size() <= coord.l)
+    return false;
+
+  Plane &plane = tile->planes[coord.l];
+  int bit = cellBit(coord.n, coord.m, tn, tm);
+  if (!plane.test(bit))
+    return false;
+  plane.dbs.remove(plane.rank(bit));
+  plane.bits[bit >> 6] &= ~(Q_UINT64_C(1) << (bit & 63));
+  total--;
+  rev++;
+  if (--tile->count == 0) {
+    delete tile;
+    tiles.erase(it);
+  }
+  return true;
+}
+
+
+void LatticeOccupancy::clear()
+{
+  qDeleteAll(tiles);
+  tiles.clear();
+  total = 0;
+  rev++;
+}
+
+
+bool LatticeOccupancy::tileBounds(int &n_min, int &n_max, int &m_min, int &m_max) const
+{
+  if (tiles.isEmpty())
+    return false;
+  int tn_min = INT_MAX, tn_max = INT_MIN, tm_min = INT_MAX, tm_max = INT_MIN;
+  for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+    int tn = qint32(quint32(it.key() >> 32));
+    int tm = qint32(quint32(it.key() & 0xffffffff));
+    tn_min = qMin(tn_min, tn);
+    tn_max = qMax(tn_max, tn);
+    tm_min = qMin(tm_min, tm);
+    tm_max = qMax(tm_max, tm);
+  }
+  n_min = tn_min*tile_dim;
+  n_max = tn_max*tile_dim + tile_dim - 1;
+  m_min = tm_min*tile_dim;
+  m_max = tm_max*tile_dim + tile_dim - 1;
+  return true;
+}
+
+
+bool LatticeOccupancy::contains(const LatticeCoord &coord) const
+{
+  if (coord.l < 0)
+    return false;
+  int tn = tileIndex(coord.n), tm = tileIndex(coord.m);
+  const Tile *tile = tileAt(tn, tm);
+  if (!tile || tile->planes.size() <= coord.l)
+    return false;
+  return tile->planes[coord.l].test(cellBit(coord.n, coord.m, tn, tm));
+}
+
+
+DBDot *LatticeOccupancy::value(const LatticeCoord &coord) const
+{
+  if (coord.l < 0)
+    return nullptr;
+  int tn = tileIndex(coord.n), tm = tileIndex(coord.m);
+  const Tile *tile = tileAt(tn, tm);
+  if (!tile || tile->planes.size() <= coord.l)
+    return nullptr;
+  const Plane &plane = tile->planes[coord.l];
+  int bit = cellBit(coord.n, coord.m, tn, tm);
+  return plane.test(bit) ? plane.dbs[plane.rank(bit)] : nullptr;
+}
+
+
+bool LatticeOccupancy::anyInRange(int n_min, int n_max, int m_min, int m_max) const
+{
+  if (n_min > n_max || m_min > m_max || total == 0)
+    return false;
+  int tn_min = tileIndex(n_min), tn_max = tileIndex(n_max);
+  int tm_min = tileIndex(m_min), tm_max = tileIndex(m_max);
+
+  auto tile_hit = [&](int tn, int tm, const Tile *tile) -> bool {
+    int cn_min = qMax(n_min, tn*tile_dim) - tn*tile_dim;
+    int cn_max = qMin(n_max, tn*tile_dim+tile_dim-1) - tn*tile_dim;
+    int cm_min = qMax(m_min, tm*tile_dim) - tm*tile_dim;
+    int cm_max = qMin(m_max, tm*tile_dim+tile_dim-1) - tm*tile_dim;
+    // mask of the n-range within a single row
+    quint64 row_mask = ((Q_UINT64_C(1) << (cn_max-cn_min+1)) - 1) << cn_min;
+    for (const Plane &plane : tile->planes) {
+      for (int m=cm_min; m<=cm_max; m++) {
+        int bit = m*tile_dim;
+        if ((plane.bits[bit >> 6] >> (bit & 63)) & row_mask)
+          return true;
+      }
+    }
+    return false;
+  };
+
+  qint64 range_tiles = qint64(tn_max-tn_min+1) * qint64(tm_max-tm_min+1);
+  if (range_tiles <= tiles.size()) {
+    for (int tm=tm_min; tm<=tm_max; tm++)
+      for (int tn=tn_min; tn<=tn_max; tn++)
+        if (const Tile *tile = tileAt(tn, tm))
+          if (tile_hit(tn, tm, tile))
+            return true;
+  } else {
+    for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+      int tn = qint32(quint32(it.key() >> 32));
+      int tm = qint32(quint32(it.key() & 0xffffffff));
+      if (tn >= tn_min && tn <= tn_max && tm >= tm_min && tm <= tm_max)
+        if (tile_hit(tn, tm, it.value()))
+          return true;
+    }
+  }
+  return false;
+}
+
+
+bool LatticeOccupancy::anyOccupied(const QVector<LatticeCoord> &coords,
+    const LatticeCoord &offset) const
+{
+  if (total == 0)
+    return false;
+
+  // coordinates in a ghost or preview are spatially coherent, so remember the
+  // last resolved tile
+  quint64 cached_key = 0;
+  const Tile *cached_tile = nullptr;
+  bool cached = false;
+  for (const LatticeCoord &c : coords) {
+    LatticeCoord coord = c + offset;
+    if (coord.l < 0)
+      continue;
+    int tn = tileIndex(coord.n), tm = tileIndex(coord.m);
+    quint64 key = tileKey(tn, tm);
+    if (!cached || key != cached_key) {
+      cached_tile = tiles.value(key, nullptr);
+      cached_key = key;
+      cached = true;
+    }
+    if (cached_tile && coord.l < cached_tile->planes.size()
+        && cached_tile->planes[coord.l].test(cellBit(coord.n, coord.m, tn, tm)))
+      return true;
+  }
+  return false;
+}
+
+
+QList<LatticeCoord> LatticeOccupancy::occupiedInRange(int n_min, int n_max,
+    int m_min, int m_max) const
+{
+  QList<LatticeCoord> coords;
+  forEachInRange(n_min, n_max, m_min, m_max,
+      [&coords](int n, int m, int l, DBDot *) {
+        coords.append(LatticeCoord(n, m, l));
+      });
+  return coords;
+}
+
+
+LatticeCoord LatticeOccupancy::firstFreeSite(int n_min, int n_max, int m_min,
+    int m_max, int n_cell) const
+{
+  if (n_min > n_max || m_min > m_max || n_cell <= 0)
+    return LatticeCoord();
+
+  int tn_min = tileIndex(n_min), tn_max = tileIndex(n_max);
+  for (int m=m_min; m<=m_max; m++) {
+    int tm = tileIndex(m);
+    int cm = m - tm*tile_dim;
+    for (int tn=tn_min; tn<=tn_max; tn++) {
+      const Tile *tile = tileAt(tn, tm);
+      int cn_min = qMax(n_min, tn*tile_dim) - tn*tile_dim;
+      int cn_max = qMin(n_max, tn*tile_dim+tile_dim-1) - tn*tile_dim;
+      if (!tile)
+        return LatticeCoord(tn*tile_dim+cn_min, m, 0);
+
+      // cells of this row in which every site l is occupied
+      quint64 full = ~Q_UINT64_C(0);
+      int bit = cm*tile_dim;
+      for (int l=0; l<n_cell; l++) {
+        if (l >= tile->planes.size()) {
+          full = 0;
+          break;
+        }
+        full &= tile->planes[l].bits[bit >> 6] >> (bit & 63);
+      }
+      quint64 row_mask = ((Q_UINT64_C(1) << (cn_max-cn_min+1)) - 1) << cn_min;
+      quint64 free_cells = ~full & row_mask;
+      if (free_cells) {
+        int cn = qCountTrailingZeroBits(free_cells);
+        int n = tn*tile_dim + cn;
+        for (int l=0; l<n_cell; l++)
+          if (l >= tile->planes.size() || !tile->planes[l].test(bit+cn))
+            return LatticeCoord(n, m, l);
+      }
+    }
+  }
+  return LatticeCoord();
+}
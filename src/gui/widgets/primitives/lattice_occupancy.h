@@ -0,0 +1,201 @@
+/** @file:     lattice_occupancy.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Sparse tiled occupancy index of lattice sites. The (n,m) plane
+ *             is chunked into fixed size tiles, each tile holding one bitset
+ *             per unit cell site l and a compact array of DBDot pointers
+ *             ordered by bit position.
+ */
+
+#ifndef _GUI_PR_LATTICE_OCCUPANCY_H_
+#define _GUI_PR_LATTICE_OCCUPANCY_H_
+
+#include <QtCore>
+
+namespace prim{
+
+  class DBDot;
+  struct LatticeCoord;
+
+  //! Occupancy index of lattice sites. Point lookups cost one hash lookup of
+  //! the tile plus a popcount rank within the tile; range queries and free
+  //! site scans skip empty tiles entirely and operate on whole bitset words.
+  class LatticeOccupancy
+  {
+  public:
+
+    //! Tile edge length in lattice cells, tiles hold tile_dim x tile_dim
+    //! cells in (n,m) for every unit cell site l.
+    static const int tile_dim = 32;
+
+    //! Constructor.
+    LatticeOccupancy() {}
+
+    //! Destructor.
+    ~LatticeOccupancy() {clear();}
+
+    //! Set the DBDot pointer at the given coordinate, replacing any existing.
+    void insert(const prim::LatticeCoord &coord, prim::DBDot *db);
+
+    //! Remove the given coordinate. Returns true if it was occupied.
+    bool remove(const prim::LatticeCoord &coord);
+
+    //! Remove all entries (the DBDot pointers aren't deleted).
+    void clear();
+
+    //! Return whether the given coordinate is occupied.
+    bool contains(const prim::LatticeCoord &coord) const;
+
+    //! Return the DBDot pointer at the given coordinate, or nullptr if none.
+    prim::DBDot *value(const prim::LatticeCoord &coord) const;
+
+    //! Return the total number of occupied sites.
+    int count() const {return total;}
+
+    //! Return a counter which changes whenever the occupancy changes.
+    quint64 revision() const {return rev;}
+
+    //! Get the inclusive (n,m) range covered by the populated tiles, which
+    //! bounds all occupied sites. Returns false if nothing is occupied.
+    bool tileBounds(int &n_min, int &n_max, int &m_min, int &m_max) const;
+
+    //! Return whether any site in the inclusive (n,m) range is occupied.
+    bool anyInRange(int n_min, int n_max, int m_min, int m_max) const;
+
+    //! Return whether any of the given coordinates (shifted by offset) is
+    //! occupied. Coordinates are resolved with a tile cache so spatially
+    //! coherent lists mostly skip the tile hash lookup.
+    bool anyOccupied(const QVector<prim::LatticeCoord> &coords,
+        const prim::LatticeCoord &offset) const;
+
+    //! Call f(n, m, l, db) for each occupied site in the inclusive (n,m) range.
+    template<typename Func>
+    void forEachInRange(int n_min, int n_max, int m_min, int m_max, Func f) const;
+
+    //! Return the occupied coordinates in the inclusive (n,m) range.
+    QList<prim::LatticeCoord> occupiedInRange(int n_min, int n_max,
+        int m_min, int m_max) const;
+
+    //! Return the first unoccupied site in the inclusive (n,m) range with
+    //! n_cell sites per unit cell, scanning in m, then n, then l order.
+    //! Returns a coordinate with l = -1 if every site is occupied.
+    prim::LatticeCoord firstFreeSite(int n_min, int n_max, int m_min,
+        int m_max, int n_cell) const;
+
+  private:
+
+    Q_DISABLE_COPY(LatticeOccupancy)
+
+    static const int tile_cells = tile_dim * tile_dim;
+    static const int tile_words = tile_cells / 64;
+
+    //! Occupancy of one unit cell site l within a tile.
+    struct Plane {
+      quint64 bits[tile_words] = {};
+      QVector<prim::DBDot*> dbs;  // pointers ordered by bit index
+
+      //! Index of the given bit in dbs if the bit is set.
+      int rank(int bit) const
+      {
+        int r = 0;
+        int w = bit >> 6;
+        for (int i=0; i<w; i++)
+          r += qPopulationCount(bits[i]);
+        return r + qPopulationCount(bits[w] & ((Q_UINT64_C(1) << (bit & 63)) - 1));
+      }
+
+      bool test(int bit) const {return bits[bit >> 6] & (Q_UINT64_C(1) << (bit & 63));}
+    };
+
+    //! Tile of tile_dim x tile_dim cells.
+    struct Tile {
+      QVector<Plane> planes;  // one per unit cell site l, grown on demand
+      int count = 0;          // occupied sites in this tile
+    };
+
+    //! Tile key from tile indices.
+    static quint64 tileKey(int tn, int tm)
+    {
+      return (quint64(quint32(tn)) << 32) | quint64(quint32(tm));
+    }
+
+    //! Floor division by the tile dimension.
+    static int tileIndex(int v)
+    {
+      return v >= 0 ? v / tile_dim : -((-v + tile_dim - 1) / tile_dim);
+    }
+
+    //! Bit index of a cell within its tile, cells are stored row by row in m.
+    static int cellBit(int n, int m, int tn, int tm)
+    {
+      return (m - tm*tile_dim) * tile_dim + (n - tn*tile_dim);
+    }
+
+    //! Return the tile at the given tile indices, or nullptr if none.
+    const Tile *tileAt(int tn, int tm) const
+    {
+      return tiles.value(tileKey(tn, tm), nullptr);
+    }
+
+    QHash<quint64, Tile*> tiles;
+    int total=0;
+    quint64 rev=0;
+  };
+
+
+  // Template implementations
+
+  template<typename Func>
+  void LatticeOccupancy::forEachInRange(int n_min, int n_max, int m_min,
+      int m_max, Func f) const
+  {
+    if (n_min > n_max || m_min > m_max || total == 0)
+      return;
+    int tn_min = tileIndex(n_min), tn_max = tileIndex(n_max);
+    int tm_min = tileIndex(m_min), tm_max = tileIndex(m_max);
+
+    // walk whichever is smaller: the tiles overlapping the range or the
+    // populated tiles
+    qint64 range_tiles = qint64(tn_max-tn_min+1) * qint64(tm_max-tm_min+1);
+    auto visit_tile = [&](int tn, int tm, const Tile *tile) {
+      int cn_min = qMax(n_min, tn*tile_dim), cn_max = qMin(n_max, tn*tile_dim+tile_dim-1);
+      int cm_min = qMax(m_min, tm*tile_dim), cm_max = qMin(m_max, tm*tile_dim+tile_dim-1);
+      for (int l=0; l<tile->planes.size(); l++) {
+        const Plane &plane = tile->planes[l];
+        int rank = 0;
+        for (int w=0; w<tile_words; w++) {
+          quint64 word = plane.bits[w];
+          while (word) {
+            int b = qCountTrailingZeroBits(word);
+            word &= word - 1;
+            int bit = (w << 6) + b;
+            int n = tn*tile_dim + bit % tile_dim;
+            int m = tm*tile_dim + bit / tile_dim;
+            if (n >= cn_min && n <= cn_max && m >= cm_min && m <= cm_max)
+              f(n, m, l, plane.dbs[rank]);
+            rank++;
+          }
+        }
+      }
+    };
+
+    if (range_tiles <= tiles.size()) {
+      for (int tm=tm_min; tm<=tm_max; tm++)
+        for (int tn=tn_min; tn<=tn_max; tn++)
+          if (const Tile *tile = tileAt(tn, tm))
+            visit_tile(tn, tm, tile);
+    } else {
+      for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+        int tn = qint32(quint32(it.key() >> 32));
+        int tm = qint32(quint32(it.key() & 0xffffffff));
+        if (tn >= tn_min && tn <= tn_max && tm >= tm_min && tm <= tm_max)
+          visit_tile(tn, tm, it.value());
+      }
+    }
+  }
+
+} // end prim namespace
+
+#endif
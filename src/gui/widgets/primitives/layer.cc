@@ -10,8 +10,10 @@
 #include "aggregate.h"
 #include "dbdot.h"
 #include "electrode.h"
+#include "labels/textlabel.h"
 #include "dblayer.h"
 #include "lattice.h"
+#include "gui/save_context.h"
 
 
 // statics
@@ -97,7 +99,10 @@ void prim::Layer::addItem(prim::Item *item, int index)
 {
   if(!items.contains(item)){
     if(index <= items.size()){
-      items.insert(index < 0 ? items.size() : index, item);
+      int ind = index < 0 ? items.size() : index;
+      emit sig_itemsAboutToBeInserted(ind, ind);
+      items.insert(ind, item);
+      emit sig_itemsInserted(ind, ind);
       // set item flags to agree with layer
       item->setActive(active);
       item->setVisible(visible);
@@ -113,22 +118,122 @@ void prim::Layer::addItem(prim::Item *item, int index)
 
 bool prim::Layer::removeItem(prim::Item *item)
 {
-  bool found = items.removeOne(item);
-  if(!found)
+  int ind = items.indexOf(item);
+  if(ind < 0){
     qDebug() << tr("item not found in layer...");
-  return found;
+    return false;
+  }
+  emit sig_itemsAboutToBeRemoved(ind, ind);
+  items.removeAt(ind);
+  emit sig_itemsRemoved(ind, ind);
+  return true;
 }
 
 
 prim::Item *prim::Layer::takeItem(int ind)
 {
   if(ind==-1 && !items.isEmpty())
-    return items.takeLast();
+    ind = items.count()-1;
   if(ind < 0 || ind >= items.count()){
     qCritical() << tr("Invalid item index...");
     return 0;
   }
-  return items.takeAt(ind);
+  emit sig_itemsAboutToBeRemoved(ind, ind);
+  prim::Item *item = items.takeAt(ind);
+  emit sig_itemsRemoved(ind, ind);
+  return item;
+}
+
+
+void prim::Layer::addItems(const QList<prim::Item*> &new_items,
+    const QVector<int> &indices)
+{
+  if(new_items.isEmpty())
+    return;
+  if(!indices.isEmpty() && indices.size() != new_items.size()){
+    qCritical() << tr("Layer item index count doesn't match item count");
+    return;
+  }
+  if(!indices.isEmpty() && indices.last() >= items.size()+new_items.size()){
+    qCritical() << tr("Layer item index invalid");
+    return;
+  }
+
+  for(prim::Item *item : new_items){
+    // set item flags to agree with layer
+    item->setActive(active);
+    item->setVisible(visible);
+  }
+
+  // appending is the common case and keeps the change a single range
+  bool append = true;
+  for(int i=0; i<indices.size() && append; i++)
+    append = indices[i] == items.size()+i;
+  if(append){
+    int first = items.size();
+    int last = first + new_items.size() - 1;
+    emit sig_itemsAboutToBeInserted(first, last);
+    items.reserve(items.size() + new_items.size());
+    for(prim::Item *item : new_items)
+      items.append(item);
+    emit sig_itemsInserted(first, last);
+    return;
+  }
+
+  // merge the new items into their target positions
+  emit sig_itemsAboutToBeReset();
+  QStack<prim::Item*> merged;
+  merged.reserve(items.size() + new_items.size());
+  int old_ind = 0;
+  for(int i=0; i<new_items.size(); i++){
+    while(merged.size() < indices[i] && old_ind < items.size())
+      merged.append(items[old_ind++]);
+    merged.append(new_items[i]);
+  }
+  while(old_ind < items.size())
+    merged.append(items[old_ind++]);
+  items = merged;
+  emit sig_itemsReset();
+}
+
+
+int prim::Layer::removeItems(const QList<prim::Item*> &rem_items)
+{
+  if(rem_items.isEmpty())
+    return 0;
+
+  QSet<prim::Item*> rem_set(rem_items.begin(), rem_items.end());
+  int first = -1, last = -1, found = 0;
+  for(int i=0; i<items.size(); i++){
+    if(rem_set.contains(items[i])){
+      if(first < 0)
+        first = i;
+      last = i;
+      found++;
+    }
+  }
+  if(found == 0){
+    qDebug() << tr("items not found in layer...");
+    return 0;
+  }
+
+  bool contiguous = last - first + 1 == found;
+  if(contiguous)
+    emit sig_itemsAboutToBeRemoved(first, last);
+  else
+    emit sig_itemsAboutToBeReset();
+  QStack<prim::Item*> kept;
+  kept.reserve(items.size() - found);
+  for(prim::Item *item : items)
+    if(!rem_set.contains(item))
+      kept.append(item);
+  items = kept;
+  if(contiguous)
+    emit sig_itemsRemoved(first, last);
+  else
+    emit sig_itemsReset();
+
+  return found;
 }
 
 void prim::Layer::setVisible(bool vis)
@@ -166,21 +271,19 @@ void prim::Layer::saveLayer(QXmlStreamWriter *ws) const
 
 void prim::Layer::saveLayerProperties(QXmlStreamWriter *ws) const
 {
-  int fp = settings::AppSettings::instance()->get<int>("float_prc");
-  QString fmt_st = settings::AppSettings::instance()->get<QString>("float_fmt");
-  char fmt = fmt_st.at(0).toLatin1();
-  QString str;
+  gui::SaveContext *ctx = gui::SaveContext::current();
 
   ws->writeTextElement("name", getName());
   ws->writeTextElement("type", contentTypeString());
   ws->writeTextElement("role", roleString()); // added in SiQAD v0.2.2
-  ws->writeTextElement("zoffset", str.setNum(zOffset(), fmt, fp));
-  ws->writeTextElement("zheight", str.setNum(zHeight(), fmt, fp));
-  ws->writeTextElement("visible", QString::number(isVisible()));
-  ws->writeTextElement("active", QString::number(isActive()));
+  ws->writeTextElement("zoffset", ctx->real(zOffset()));
+  ws->writeTextElement("zheight", ctx->real(zHeight()));
+  ws->writeTextElement("visible", ctx->number(isVisible()));
+  ws->writeTextElement("active", ctx->number(isActive()));
 }
 
-void prim::Layer::saveItems(QXmlStreamWriter *ws, gui::DesignInclusionArea inclusion_area) const
+void prim::Layer::saveItems(QXmlStreamWriter *ws, gui::DesignInclusionArea inclusion_area,
+                            const QSet<prim::Item*> &area_items) const
 {
   if (layer_role == LayerRole::Result) {
     qDebug() << tr("Skipping layer %1: %2 as the role is Simulation Result.")
@@ -200,7 +303,11 @@ void prim::Layer::saveItems(QXmlStreamWriter *ws, gui::DesignInclusionArea inclu
         if (item->isSelected())
           item->saveItems(ws);
         break;
-      // TODO implement IncludeAreaOfInterest
+      case gui::IncludeAreaOfInterest:
+        // save only items in the area of interest
+        if (area_items.contains(item))
+          item->saveItems(ws);
+        break;
       case gui::IncludeEntireDesign:
       default:
         // save entire design
@@ -239,8 +346,11 @@ void prim::Layer::loadItems(QXmlStreamReader *rs, QGraphicsScene *scene)
       }
       new_items.clear();
     } else if (elem_name == "electrode") {
-      rs->readNext();
       addItem(new prim::Electrode(rs, scene, layer_id));
+    } else if (elem_name == "textlabel") {
+      prim::TextLabel *label = new prim::TextLabel(rs, layer_id);
+      addItem(label);
+      scene->addItem(label);
     } else {
       qDebug() << QObject::tr("Layer load item: invalid element encountered on line %1 - %2").arg(rs->lineNumber()).arg(elem_name);
       rs->skipCurrentElement();
@@ -93,6 +93,15 @@ namespace prim{
     //! pop the Item given by the index. Returns 0 if invalid index.
     prim::Item *takeItem(int ind=-1);
 
+    //! add several new Items in one pass. indices holds the final index of
+    //! each Item in ascending order, Items are appended if indices is empty.
+    //! The Items must not already be in the layer.
+    void addItems(const QList<prim::Item*> &new_items,
+        const QVector<int> &indices=QVector<int>());
+
+    //! remove several Items in one pass. Returns the number of Items removed.
+    int removeItems(const QList<prim::Item*> &rem_items);
+
     //! update the layer visibility, calls setVisible(vis) for all Items in the
     //! layer. If vis==visibility, do nothing.
     void setVisible(bool vis);
@@ -136,13 +145,29 @@ namespace prim{
     // SAVE LOAD
     virtual void saveLayer(QXmlStreamWriter *) const;
     void saveLayerProperties(QXmlStreamWriter *) const;
-    virtual void saveItems(QXmlStreamWriter *, gui::DesignInclusionArea) const;
+    //! Save the items in the inclusion area, area_items holds the items in the
+    //! area of interest for IncludeAreaOfInterest.
+    virtual void saveItems(QXmlStreamWriter *, gui::DesignInclusionArea,
+                           const QSet<prim::Item*> &area_items=QSet<prim::Item*>()) const;
     virtual void loadItems(QXmlStreamReader *, QGraphicsScene *);
 
   signals:
 
     void sig_visibilityChanged(bool visible);
 
+    //! Emitted around insertion and removal of the items at indices first to
+    //! last of the item stack, allowing models to follow the stack
+    //! incrementally.
+    void sig_itemsAboutToBeInserted(int first, int last);
+    void sig_itemsInserted(int first, int last);
+    void sig_itemsAboutToBeRemoved(int first, int last);
+    void sig_itemsRemoved(int first, int last);
+
+    //! Emitted around bulk changes of the item stack which aren't a single
+    //! contiguous range.
+    void sig_itemsAboutToBeReset();
+    void sig_itemsReset();
+
   protected:
 
     int layer_id;     // layer index in design panel's layers stack
@@ -0,0 +1,158 @@
+/** @file:     area_of_interest.cc
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Area of interest for region exports and its outline preview.
+ */
+
+#include "area_of_interest.h"
+#include "settings/settings.h"
+#include "gui/save_context.h"
+
+qreal prim::AreaOfInterestOutline::edge_width=-1;
+QColor prim::AreaOfInterestOutline::edge_col;
+QColor prim::AreaOfInterestOutline::halo_col;
+
+namespace prim{
+
+// AreaOfInterest
+
+QPainterPath AreaOfInterest::scenePath() const
+{
+  QPainterPath path;
+  if (!isValid())
+    return path;
+
+  QPolygonF scene_poly;
+  for (const QPointF &pt : polygon)
+    scene_poly << pt * Item::scale_factor;
+  path.addPolygon(scene_poly);
+  path.closeSubpath();
+  path.setFillRule(Qt::WindingFill);
+
+  if (halo > 0) {
+    // round joins keep every point within the halo distance of the edges
+    QPainterPathStroker stroker;
+    stroker.setWidth(2 * halo * Item::scale_factor);
+    stroker.setJoinStyle(Qt::RoundJoin);
+    stroker.setCapStyle(Qt::RoundCap);
+    path = path.united(stroker.createStroke(path));
+  }
+  return path;
+}
+
+AreaOfInterest AreaOfInterest::fromScenePolygon(const QPolygonF &scene_poly, qreal t_halo)
+{
+  AreaOfInterest area;
+  for (const QPointF &pt : scene_poly)
+    area.polygon << pt / Item::scale_factor;
+  area.halo = t_halo;
+  return area;
+}
+
+void AreaOfInterest::writeXml(QXmlStreamWriter *ws, const QString &elem_name) const
+{
+  gui::SaveContext *ctx = gui::SaveContext::current();
+
+  ws->writeStartElement(elem_name);
+  ws->writeAttribute("halo", ctx->number(halo));
+  for (const QPointF &pt : polygon) {
+    ws->writeEmptyElement("vertex");
+    ws->writeAttribute("x", ctx->number(pt.x()));
+    ws->writeAttribute("y", ctx->number(pt.y()));
+  }
+  ws->writeEndElement();
+}
+
+AreaOfInterest AreaOfInterest::fromXml(QXmlStreamReader *rs)
+{
+  AreaOfInterest area;
+  area.halo = rs->attributes().value("halo").toDouble();
+  while (rs->readNextStartElement()) {
+    if (rs->name() == QLatin1String("vertex")) {
+      area.polygon << QPointF(rs->attributes().value("x").toDouble(),
+                              rs->attributes().value("y").toDouble());
+    } else {
+      qWarning() << QObject::tr("Area of interest: invalid element %1")
+          .arg(rs->name().toString());
+    }
+    rs->skipCurrentElement();
+  }
+  return area;
+}
+
+
+// AreaOfInterestOutline
+
+AreaOfInterestOutline::AreaOfInterestOutline()
+  : prim::Item(prim::Item::AreaOfInterestOutline)
+{
+  // initialize static variables
+  if (edge_width < 0)
+    constructStatics();
+
+  // drawn above the design and never picked by the select tool
+  setZValue(std::numeric_limits<qreal>::max());
+  setAcceptedMouseButtons(Qt::NoButton);
+  setAcceptHoverEvents(false);
+}
+
+void AreaOfInterestOutline::setArea(const prim::AreaOfInterest &area)
+{
+  prepareGeometryChange();
+  area_poly.clear();
+  halo_path = QPainterPath();
+  if (!area.isValid())
+    return;
+  for (const QPointF &pt : area.polygon)
+    area_poly << pt * scale_factor;
+  if (area.halo > 0)
+    halo_path = area.scenePath();
+}
+
+void AreaOfInterestOutline::setDraft(const QPolygonF &t_draft)
+{
+  prepareGeometryChange();
+  draft = t_draft;
+}
+
+void AreaOfInterestOutline::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+  painter->setBrush(Qt::NoBrush);
+  if (!halo_path.isEmpty()) {
+    painter->setPen(QPen(halo_col, edge_width, Qt::DashLine));
+    painter->drawPath(halo_path);
+  }
+  if (!area_poly.isEmpty()) {
+    painter->setPen(QPen(edge_col, edge_width));
+    painter->drawPolygon(area_poly);
+  }
+  if (!draft.isEmpty()) {
+    painter->setPen(QPen(edge_col, edge_width, Qt::DashLine));
+    painter->drawPolyline(draft);
+  }
+}
+
+// PROTECTED
+
+QRectF AreaOfInterestOutline::boundingRect() const
+{
+  QRectF rect = area_poly.boundingRect() | halo_path.boundingRect()
+      | draft.boundingRect();
+  return rect.adjusted(-edge_width,-edge_width,edge_width,edge_width);
+}
+
+// PRIVATE
+
+void AreaOfInterestOutline::constructStatics()
+{
+  settings::GUISettings *gui_settings = settings::GUISettings::instance();
+
+  edge_width = gui_settings->get<qreal>("areaofinterest/edge_width") * scale_factor;
+  edge_col = gui_settings->get<QColor>("areaofinterest/edge_col");
+  halo_col = gui_settings->get<QColor>("areaofinterest/halo_col");
+}
+
+
+}
@@ -0,0 +1,89 @@
+/** @file:     area_of_interest.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Area of interest for region exports and its outline preview.
+ */
+
+#ifndef _GUI_PR_AREA_OF_INTEREST_H_
+#define _GUI_PR_AREA_OF_INTEREST_H_
+
+
+#include <QtWidgets>
+#include "../item.h"
+
+namespace prim{
+
+  //! Region of the design exported with the IncludeAreaOfInterest inclusion
+  //! area. Items intersecting the polygon or lying within the halo distance of
+  //! it are exported, the halo keeps electrostatic context around the region.
+  struct AreaOfInterest
+  {
+    QPolygonF polygon;  // vertices in angstrom
+    qreal halo=0;       // context distance around the polygon in angstrom
+
+    //! Return whether the area encloses a region.
+    bool isValid() const {return polygon.size() >= 3;}
+
+    //! Return the scene area covered by the polygon grown by the halo.
+    QPainterPath scenePath() const;
+
+    //! Return an area from a polygon in scene coordinates.
+    static AreaOfInterest fromScenePolygon(const QPolygonF &scene_poly, qreal t_halo=0);
+
+    //! Write the area as an XML element with the given name.
+    void writeXml(QXmlStreamWriter *ws, const QString &elem_name="area_of_interest") const;
+
+    //! Read the area from the current XML element.
+    static AreaOfInterest fromXml(QXmlStreamReader *rs);
+  };
+
+
+  //! Outline of the area of interest and of the polygon being drawn with the
+  //! area of interest tool.
+  class AreaOfInterestOutline: public prim::Item
+  {
+  public:
+
+    //! Construct an outline without area.
+    AreaOfInterestOutline();
+
+    //! Destructor.
+    ~AreaOfInterestOutline() {};
+
+    //! Set the area to outline, an invalid area hides the outline.
+    void setArea(const prim::AreaOfInterest &area);
+
+    //! Set the open polygon being drawn in scene coordinates.
+    void setDraft(const QPolygonF &t_draft);
+
+    //! Overridden paint function.
+    virtual void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+  protected:
+
+    //! Return the bounding rect of the area and draft plus border.
+    virtual QRectF boundingRect() const override;
+
+  private:
+
+    //! Construct static variables.
+    void constructStatics();
+
+    // VARIABLES
+    QPolygonF area_poly;  // area polygon in scene coordinates
+    QPainterPath halo_path; // area grown by the halo, empty if there is none
+    QPolygonF draft;      // open polygon being drawn
+
+    // static class parameters for painting
+    static qreal edge_width;
+    static QColor edge_col;
+    static QColor halo_col;
+  };
+
+} // end prim namespace
+
+
+
+#endif
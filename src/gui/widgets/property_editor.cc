@@ -62,11 +62,15 @@ void PropertyEditor::applyForms()
     PropertyMap final_map = p.first->finalProperties();
     prim::Item *item = p.second;
 
+    bool changed = false;
     for (const QString &key : item->properties().keys()) {
       if (item->getProperty(key).value != final_map.value(key).value) {
         item->setProperty(key, final_map.value(key).value);
+        changed = true;
       }
     }
+    if (changed)
+      emit sig_itemPropertiesChanged(item);
   }
 }
 
@@ -76,11 +80,15 @@ void PropertyEditor::applyFormToAll()
   PropertyMap final_map = static_cast<PropertyForm*>(form_tab_widget->currentWidget())->finalProperties();
   for (QPair<PropertyForm*, prim::Item*> p : form_item_pair) {
     prim::Item *item = p.second;
+    bool changed = false;
     for (const QString &key : item->properties().keys()) {
       if (item->getProperty(key).value != final_map.value(key).value) {
         item->setProperty(key, final_map.value(key).value);
+        changed = true;
       }
     }
+    if (changed)
+      emit sig_itemPropertiesChanged(item);
   }
   //close the form. The form doesn't update until closed and reopened.
   discardForms();
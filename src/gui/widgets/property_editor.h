@@ -61,6 +61,9 @@ namespace gui{
 
   signals:
 
+    //! Emitted for each item whose properties were changed by applying a form.
+    void sig_itemPropertiesChanged(prim::Item *item);
+
   protected:
     // void keyPressEvent(QKeyEvent *e) Q_DECL_OVERRIDE;
     virtual void closeEvent(QCloseEvent *event) Q_DECL_OVERRIDE;
@@ -87,6 +87,31 @@ QVariant PropertyForm::formValue(const QString &key)
 }
 
 
+QString PropertyForm::formText(const QString &key)
+{
+  if (orig_map[key].value_selection.type != LineEdit)
+    return QString();
+  QLineEdit *prop_field = QObject::findChild<QLineEdit*>(key);
+  return prop_field ? prop_field->text() : QString();
+}
+
+
+bool PropertyForm::isNumeric(const QString &key)
+{
+  switch (static_cast<QMetaType::Type>(orig_map[key].value.typeId())) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
 void PropertyForm::initForm()
 {
   setWindowTitle("Property Editor");
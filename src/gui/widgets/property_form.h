@@ -44,6 +44,13 @@ namespace gui{
     //! Return the form field content for the specified key value.
     QVariant formValue(const QString &key);
 
+    //! Return the text of the line edit field of the specified key, or an
+    //! empty string if the key isn't edited in a line edit.
+    QString formText(const QString &key);
+
+    //! Return whether the property of the specified key holds a number.
+    bool isNumeric(const QString &key);
+
   private:
 
     //! Initialize the form
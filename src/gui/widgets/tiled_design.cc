@@ -0,0 +1,262 @@
+// @file:     tiled_design.cc
+// @author:   SiQAD contributors
+// @created:  2026.10.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Tile bookkeeping of designs opened from tiled .sqb files.
+
+#include "tiled_design.h"
+
+
+bool gui::TiledDesign::open(const QString &path, quint64 min_dbs,
+    sqb::DesignSnapshot &base, QString &err)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    err = file.errorString();
+    return false;
+  }
+  if (!sqb::isBinaryDesign(&file))
+    return false;
+
+  // the tile index is found from the end of the file
+  sqb::Reader rd(&file);
+  sqb::TileIndex index;
+  if (!rd.begin() || !rd.readTileIndex(index)) {
+    err = rd.errorString();
+    return false;
+  }
+  if (index.dbCount() < min_dbs)
+    return false;
+
+  // read everything but the DB tiles in file order
+  if (!file.seek(0) || !rd.begin()) {
+    err = rd.errorString();
+    return false;
+  }
+  quint32 tag;
+  QByteArray raw;
+  bool chunk_ok = true;
+  while (chunk_ok && rd.readChunk(tag, raw, sqb::DBChunk)) {
+    switch (tag) {
+      case sqb::HeadChunk:
+        base.heads.append(raw);
+        break;
+      case sqb::LatticeChunk:
+        chunk_ok = sqb::Reader::readLattice(raw, base.lattice);
+        base.has_lattice = chunk_ok;
+        break;
+      case sqb::LayerChunk:
+        chunk_ok = sqb::Reader::readLayers(raw, base.layers);
+        break;
+      case sqb::ElectrodeChunk:
+      case sqb::AFMChunk:
+      case sqb::LabelChunk:
+      case sqb::XmlItemChunk:
+      {
+        sqb::ItemChunk chunk;
+        chunk.tag = tag;
+        chunk_ok = sqb::Reader::readXmlItems(raw, chunk.xml);
+        base.items.append(chunk);
+        break;
+      }
+      default:
+        // DB tiles and the tile index
+        break;
+    }
+  }
+  if (!chunk_ok || rd.hasError()) {
+    err = rd.hasError() ? rd.errorString()
+        : QObject::tr("Malformed SQB chunk %1.").arg(tag, 8, 16);
+    return false;
+  }
+
+  src_path = path;
+  tile_cells = index.tile_cells;
+  setTiles(index);
+  return true;
+}
+
+void gui::TiledDesign::close()
+{
+  src_path.clear();
+  tile_cells = 0;
+  tiles.clear();
+  lookup.clear();
+  use_clock = 0;
+}
+
+quint64 gui::TiledDesign::storedDBCount() const
+{
+  quint64 count = 0;
+  for (const Tile &tile : tiles)
+    count += tile.db_count;
+  return count;
+}
+
+int gui::TiledDesign::tileIndex(int layer_pos, qint32 n, qint32 m, bool create)
+{
+  TileKey key(layer_pos, sqb::tileCoord(n, tile_cells), sqb::tileCoord(m, tile_cells));
+  int i = lookup.value(key, -1);
+  if (i >= 0 || !create)
+    return i;
+
+  Tile tile;
+  tile.layer_pos = layer_pos;
+  tile.tx = std::get<1>(key);
+  tile.ty = std::get<2>(key);
+  tile.resident = tile.dirty = true;
+  tiles.append(tile);
+  lookup.insert(key, tiles.size()-1);
+  touch(tiles.size()-1);
+  return tiles.size()-1;
+}
+
+bool gui::TiledDesign::readTile(int i, sqb::DBRecord &rec, QString &err) const
+{
+  const Tile &tile = tiles[i];
+  if (tile.has_overlay) {
+    rec = tile.overlay;
+    return true;
+  }
+  rec = sqb::DBRecord();
+  rec.layer_pos = tile.layer_pos;
+  if (tile.offset < 0)
+    return true;
+
+  QFile file(src_path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    err = file.errorString();
+    return false;
+  }
+  sqb::Reader rd(&file);
+  quint32 tag;
+  QByteArray raw;
+  if (!rd.readChunkAt(tile.offset, tag, raw) || tag != sqb::DBChunk
+      || !sqb::Reader::readDBs(raw, rec)) {
+    err = rd.hasError() ? rd.errorString()
+        : QObject::tr("SQB tile chunk at offset %1 is corrupt.").arg(tile.offset);
+    return false;
+  }
+  return true;
+}
+
+gui::sqb::ItemChunk gui::TiledDesign::tileChunk(int i, int layer_pos) const
+{
+  const Tile &tile = tiles[i];
+  sqb::ItemChunk chunk;
+  chunk.tag = sqb::DBChunk;
+  chunk.tile.is_tile = true;
+  chunk.tile.tx = tile.tx;
+  chunk.tile.ty = tile.ty;
+  if (tile.has_overlay) {
+    chunk.dbs = tile.overlay;
+  } else if (!tile.dirty && tile.offset >= 0) {
+    chunk.tile.source = src_path;
+    chunk.tile.offset = tile.offset;
+    chunk.tile.source_layer_pos = tile.layer_pos;
+    chunk.tile.db_count = tile.db_count;
+  }
+  chunk.dbs.layer_pos = layer_pos;
+  return chunk;
+}
+
+bool gui::TiledDesign::rebase(const QString &path, const QHash<int,int> &pos_map,
+    QString &err)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    err = file.errorString();
+    return false;
+  }
+  // designs without DBs are saved without tile index
+  sqb::Reader rd(&file);
+  sqb::TileIndex index;
+  index.tile_cells = tile_cells;
+  if (!rd.begin() || (!rd.readTileIndex(index) && rd.hasError())) {
+    err = rd.errorString();
+    return false;
+  }
+  if (index.tile_cells != tile_cells) {
+    err = QObject::tr("The saved tile size %1 differs from the design's %2.")
+        .arg(index.tile_cells).arg(tile_cells);
+    return false;
+  }
+
+  // carry over the residency of the tiles that were already tiled
+  QMap<TileKey, Tile> old_tiles;
+  for (const Tile &tile : tiles)
+    if (pos_map.contains(tile.layer_pos))
+      old_tiles.insert(TileKey(pos_map.value(tile.layer_pos), tile.tx, tile.ty), tile);
+
+  setTiles(index);
+  for (Tile &tile : tiles) {
+    auto it = old_tiles.constFind(TileKey(tile.layer_pos, tile.tx, tile.ty));
+    if (it == old_tiles.constEnd()) {
+      tile.resident = true;
+    } else {
+      tile.resident = it->resident;
+      tile.last_used = it->last_used;
+      tile.scene_rect = it->scene_rect;
+    }
+  }
+  src_path = path;
+  return true;
+}
+
+void gui::TiledDesign::setTiles(const sqb::TileIndex &index)
+{
+  tiles.clear();
+  lookup.clear();
+  tiles.reserve(index.tiles.size());
+  for (const sqb::TileEntry &entry : index.tiles) {
+    Tile tile;
+    tile.layer_pos = entry.layer_pos;
+    tile.tx = entry.tx;
+    tile.ty = entry.ty;
+    tile.offset = entry.offset;
+    tile.db_count = entry.db_count;
+    lookup.insert(TileKey(tile.layer_pos, tile.tx, tile.ty), tiles.size());
+    tiles.append(tile);
+  }
+}
+
+
+void gui::UndoPins::update(const QUndoStack *stack, const QHash<int,int> &layer_counts)
+{
+  // the commands between the last and the current index ran, an unchanged
+  // index means that the last command was merged into or pushed while the
+  // oldest command was dropped
+  int index = stack->index();
+  int from = qMin(last_index, index);
+  int to = qMax(last_index, index);
+  if (from == to)
+    from = index - 1;
+  last_index = index;
+  for (int i=qMax(0, from); i<qMin(to, stack->count()); i++) {
+    QHash<int,int> &counts = cmd_counts[stack->command(i)];
+    for (auto it = layer_counts.cbegin(); it != layer_counts.cend(); ++it)
+      counts[it.key()] = qMax(counts.value(it.key()), it.value());
+  }
+
+  // commands dropped from the stack release their items
+  QHash<const QUndoCommand*, QHash<int,int>> kept;
+  pins.clear();
+  for (int i=0; i<stack->count(); i++) {
+    const QUndoCommand *cmd = stack->command(i);
+    if (!cmd_counts.contains(cmd))
+      continue;
+    const QHash<int,int> &counts = cmd_counts[cmd];
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+      pins[it.key()] = qMax(pins.value(it.key()), it.value());
+    kept.insert(cmd, counts);
+  }
+  cmd_counts = kept;
+}
+
+void gui::UndoPins::clear()
+{
+  cmd_counts.clear();
+  pins.clear();
+  last_index = 0;
+}
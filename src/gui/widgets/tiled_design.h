@@ -0,0 +1,144 @@
+/** @file:     tiled_design.h
+ *  @author:   SiQAD contributors
+ *  @created:  2026.10.16
+ *  @license:  GNU LGPL v3
+ *
+ *  @brief:    Tile bookkeeping of designs opened from tiled .sqb files.
+ *
+ *  Designs with more DBs than the scene can hold are opened from a tiled .sqb
+ *  file (see design_binary.h) without reading its DB tiles. The design panel
+ *  loads the tiles around the view into the scene and evicts tiles out of
+ *  view once the resident DBs exceed the tile budget. Edits mark the tiles of
+ *  the edited DBs dirty: resident dirty tiles are saved from the scene,
+ *  evicted dirty tiles keep their DBs in an overlay record and clean tiles
+ *  are copied from the file as stored.
+ */
+
+#ifndef _GUI_TILED_DESIGN_H_
+#define _GUI_TILED_DESIGN_H_
+
+#include <QtCore>
+#include <QUndoStack>
+#include <tuple>
+
+#include "design_binary.h"
+
+namespace gui{
+
+  class TiledDesign
+  {
+  public:
+
+    //! One tile of one DB layer.
+    struct Tile
+    {
+      int layer_pos=-1;       // layer position in the file's layer table
+      qint32 tx=0;
+      qint32 ty=0;
+      qint64 offset=-1;       // stored chunk in the file, -1 if none
+      quint32 db_count=0;     // DBs of the stored chunk
+      bool resident=false;    // the DBs are in the scene
+      bool dirty=false;       // edited since the file was written
+      bool has_overlay=false; // evicted after edits, the overlay replaces the stored chunk
+      sqb::DBRecord overlay;
+      quint64 last_used=0;    // use stamp, least recently used tiles are evicted first
+      QRectF scene_rect;      // scene area of the tile's lattice cells, set by the panel
+    };
+
+    //! Open the tiled design at path if it holds at least min_dbs DBs,
+    //! reading everything but the DB tiles into base. Returns false if the
+    //! file isn't tiled or too small, err is set if it can't be read.
+    bool open(const QString &path, quint64 min_dbs, sqb::DesignSnapshot &base, QString &err);
+
+    //! Forget the open design.
+    void close();
+
+    //! Return whether a tiled design is open.
+    bool isOpen() const {return !src_path.isEmpty();}
+
+    //! Path of the file backing the clean tiles.
+    QString path() const {return src_path;}
+
+    //! Lattice cells per tile side.
+    int tileCells() const {return tile_cells;}
+
+    //! DBs stored in the file.
+    quint64 storedDBCount() const;
+
+    int tileCount() const {return tiles.size();}
+    Tile &tile(int i) {return tiles[i];}
+    const Tile &tile(int i) const {return tiles[i];}
+
+    //! Return the tile of the layer holding lattice cell (n, m). If there is
+    //! none, create it if create is set, otherwise return -1. Tiles are only
+    //! created for edits, so new tiles are resident and dirty.
+    int tileIndex(int layer_pos, qint32 n, qint32 m, bool create=false);
+
+    //! Read the DBs of a tile from its overlay or the file.
+    bool readTile(int i, sqb::DBRecord &rec, QString &err) const;
+
+    //! Mark a tile as used now.
+    void touch(int i) {tiles[i].last_used = ++use_clock;}
+
+    //! Snapshot chunk of a tile for the layer at layer_pos of the snapshot.
+    //! Clean tiles are handed over by reference to their stored chunk and
+    //! evicted dirty tiles by their overlay. The DBs of resident dirty tiles
+    //! are left for the caller to fill in.
+    sqb::ItemChunk tileChunk(int i, int layer_pos) const;
+
+    //! Switch to a tiled file just written from a snapshot of this design.
+    //! pos_map gives the new layer position of each old one. Tiles take their
+    //! offsets from the new file and are clean afterwards, tiles new to the
+    //! file came from the scene and are resident.
+    bool rebase(const QString &path, const QHash<int,int> &pos_map, QString &err);
+
+  private:
+
+    typedef std::tuple<int, qint32, qint32> TileKey;  // layer position, tx, ty
+
+    // set the tiles from a tile index
+    void setTiles(const sqb::TileIndex &index);
+
+    QString src_path;
+    int tile_cells=0;
+    QVector<Tile> tiles;
+    QMap<TileKey, int> lookup;  // tile of each key
+    quint64 use_clock=0;
+  };
+
+
+  //! Items of the tiled layers the undo history may refer to. Undo commands
+  //! refer to items by their layer stack index, a command may refer to any
+  //! index below the item count of the layer when it last ran. Tiles loaded
+  //! since are appended above and can be evicted without shifting the indices
+  //! the history refers to.
+  class UndoPins
+  {
+  public:
+
+    //! Record the item counts of the tiled layers for the commands that ran
+    //! since the last update and forget commands no longer on the stack. To
+    //! be called whenever the stack index changes, which includes pushes,
+    //! merges, commands dropped beyond the undo limit and clearing.
+    void update(const QUndoStack *stack, const QHash<int,int> &layer_counts);
+
+    //! Forget all commands, e.g. for a new undo stack.
+    void clear();
+
+    //! Return whether the undo history may refer to items of the layer.
+    bool pinsLayer(int layer_id) const {return pins.contains(layer_id);}
+
+    //! Return the item count of the layer below which the undo history may
+    //! refer to items.
+    int pin(int layer_id) const {return pins.value(layer_id);}
+
+  private:
+
+    QHash<const QUndoCommand*, QHash<int,int>> cmd_counts;  // item counts per command
+    QHash<int,int> pins;  // highest item count of each layer over the commands
+    int last_index=0;     // stack index at the last update
+  };
+
+} // end gui namespace
+
+#endif
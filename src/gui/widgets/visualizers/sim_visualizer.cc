@@ -54,6 +54,7 @@ SimVisualizer::SimVisualizer(DesignPanel *design_pan, QWidget *parent)
           [this]()
           {
             if (sim_job != nullptr) {
+              sim_job->extractArchive();
               QDesktopServices::openUrl(QUrl::fromLocalFile(sim_job->runtimeTempPath()));
             }
           });
@@ -251,6 +252,37 @@ void SimVisualizer::showJob(comp::SimJob *job)
   } else {
     gb_pot_landscape->setEnabled(false);
   }
+
+  // steps of a running job add their results as they are parsed
+  results_conn = connect(job, &comp::SimJob::sig_jobStepResultsAvailable, this,
+          [this](comp::SimJob *t_job, int placement)
+          {
+            if (t_job == sim_job)
+              addJobStepResults(placement);
+          });
+}
+
+void SimVisualizer::addJobStepResults(int placement)
+{
+  comp::JobStep *step = sim_job->getJobStep(placement);
+  QMap<JR::ResultType, comp::JobStep::ResultParseMetrics> metrics = step->resultParseMetrics();
+  auto addStep = [step, placement, &metrics](QGroupBox *gb, QComboBox *cb, JR::ResultType type)
+  {
+    if (!step->jobResults().contains(type) || cb->findText(QString::number(placement)) >= 0)
+      return;
+    gb->setEnabled(true);
+    // keep the descending placement order of the job's result type map
+    int index = 0;
+    while (index < cb->count() && cb->itemText(index).toInt() > placement)
+      index++;
+    cb->insertItem(index, QString::number(placement));
+    if (metrics.contains(type)) {
+      cb->setItemData(index, tr("Parsed in %1 ms (%2 characters)")
+          .arg(metrics.value(type).parse_ms).arg(metrics.value(type).chars), Qt::ToolTipRole);
+    }
+  };
+  addStep(gb_charge_configs, cb_job_steps_charge_configs, JR::ChargeConfigsResult);
+  addStep(gb_pot_landscape, cb_job_steps_pot_landscape, JR::PotentialLandscapeResult);
 }
 
 void SimVisualizer::clearJob()
@@ -262,6 +294,7 @@ void SimVisualizer::clearJob()
   charge_config_set_visualizer->clearVisualizer();
   pot_landscape_visualizer->clearVisualizer();
 
+  disconnect(results_conn);
   sim_job = nullptr;
 
   // disable user interaction to the entire plugin
@@ -37,6 +37,10 @@ namespace gui{
     //! Clear the job result from this and children visualizers.
     void clearJob();
 
+    //! Offer the results of a job step of the shown job that have become
+    //! available after the job was shown.
+    void addJobStepResults(int placement);
+
     //! Take actions after design panel reset
     void designPanelResetActions();
 
@@ -95,6 +99,7 @@ namespace gui{
 
     gui::DesignPanel *design_pan;             // pointer to the design panel
     comp::SimJob *sim_job=nullptr;            // current job result being shown
+    QMetaObject::Connection results_conn;     // results of the shown job arriving while it runs
 
     ChargeConfigSetVisualizer *charge_config_set_visualizer;
     PotentialLandscapeVisualizer *pot_landscape_visualizer;
@@ -14,6 +14,7 @@
 #include <QDebug>
 
 #include "gui/application.h"
+#include "gui/widgets/design_binary.h"
 #include "settings/settings.h"
 
 #include <cstdlib>
@@ -85,6 +86,11 @@ int main(int argc, char **argv){
   parser.addHelpOption();
   parser.addVersionOption();
   parser.addPositionalArgument("file", "Design file to open (normally *.sqd).");
+  QCommandLineOption convert_option("convert",
+      "Convert the design file between the XML (*.sqd, *.sqd.gz) and binary "
+      "(*.sqb) formats and write it to <output> instead of opening it. The "
+      "direction is given by the suffix of <output>.", "output");
+  parser.addOption(convert_option);
 
   parser.process(app);
   const QStringList args = parser.positionalArguments();
@@ -94,6 +100,23 @@ int main(int argc, char **argv){
     qDebug() << QObject::tr("CML file path: %1").arg(f_path);
   }
 
+  // convert without launching the GUI
+  if (parser.isSet(convert_option)) {
+    if (f_path.isEmpty())
+      parser.showHelp(1);
+    QString out_path = parser.value(convert_option);
+    QString err;
+    bool ok = gui::sqb::isBinaryDesignPath(out_path)
+        ? gui::sqb::sqdToSqb(f_path, out_path, err)
+        : gui::sqb::sqbToSqd(f_path, out_path, err);
+    if (!ok) {
+      qCritical() << QObject::tr("Conversion of %1 failed: %2").arg(f_path).arg(err);
+      return 1;
+    }
+    qDebug() << QObject::tr("Converted %1 to %2").arg(f_path).arg(out_path);
+    return 0;
+  }
+
   // pre-launch setup
   settings::AppSettings *app_settings = settings::AppSettings::instance();
 
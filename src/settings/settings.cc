@@ -140,13 +140,36 @@ QSettings *settings::AppSettings::m_defs()
   }));
   S->setValue("plugs/preset_root_path", QString("<CONFIG>/plugins/"));
   S->setValue("plugs/runtime_tmp_root_path", QString("<SYSTMP>/plugins/"));
+  S->setValue("plugs/aoi_halo", 20.); // default area of interest halo in angstrom
+  S->setValue("plugs/job_export_level", 6); // deflate level of exported jobs, 0 stores the files
+  S->setValue("plugs/max_parallel_job_steps", 2); // independent job steps running at the same time
+  S->setValue("plugs/job_core_budget", 0); // CPU cores shared by running jobs, 0 for all cores
+  S->setValue("plugs/default_plugin_cores", 1); // cores used by plugins that don't declare <cores>
+  S->setValue("plugs/plugin_cores", QVariantMap()); // core requirement overrides keyed by plugin name
+  S->setValue("plugs/result_cache_enabled", true); // new jobs reuse cached results of identical steps
+  S->setValue("plugs/result_cache_path", QString("<APPLOCALDATA>/result_cache/"));
+  S->setValue("plugs/result_cache_max_mb", 1024); // least recently used results are evicted beyond this size
 
   S->setValue("float_prc", 6);  // float precision specified in QString::setNum; not always obeyed.
   S->setValue("float_fmt", "g");   // float format specified in QString::setNum; not always obeyed.
 
   S->setValue("save/autosaveroot", QString("<SYSTMP>/autosave/"));
   S->setValue("save/autosavenum", 10);
+  S->setValue("save/autosave_gzip_level", 1);  // deflate level of autosave checkpoints from 1 (fastest) to 9, 0 writes them uncompressed
+  S->setValue("save/gzip_level", 6);  // deflate level of designs saved as .sqd.gz from 1 (fastest) to 9
   S->setValue("save/autosaveinterval", 60); // in seconds
+  S->setValue("save/journal_checkpoint_every", 10); // autosaves between full checkpoints, others append to the journal
+  S->setValue("save/sqb_tile_cells", 0);  // lattice cells per side of the DB tiles of .sqb files, 0 for untiled DB layers
+  S->setValue("save/compact_sim_problems", true);  // write simulation problems without indentation and with faster float formatting
+
+  S->setValue("undo/budget_kb", 65536);   // undo history size before old commands are compacted
+  S->setValue("undo/max_commands", 10000); // 0 for no limit
+
+  S->setValue("load/batch_dbs", 4096);      // DBs per batch handed from the load worker to the GUI thread
+  S->setValue("load/time_slice_ms", 15);    // time the GUI thread spends creating loaded items per event loop pass
+  S->setValue("load/tiled_min_dbs", 1000000);   // tiled .sqb designs with this many DBs only load the tiles around the view
+  S->setValue("load/tile_budget_dbs", 2000000); // DBs kept in the scene before tiles out of view are evicted
+  S->setValue("load/tile_margin", 0.5);         // margin around the view whose tiles are loaded, relative to the view size
 
   return S;
 }
@@ -190,6 +213,7 @@ QSettings* settings::GUISettings::m_defs()
   S->setValue("view/zoom_boost", 2);              // must have factor*boost < 1
   S->setValue("view/zoom_min", .001);             // minimum zoom factor
   S->setValue("view/zoom_max", 1);                // maximum zoom factor
+  S->setValue("view/lod_zoom_threshold", 0.01);   // zoom below which DBs, electrodes and AFM paths are drawn with reduced detail
   S->setValue("view/wheel_pan_step", 20);         // screen pan per wheel tick
   S->setValue("view/wheel_pan_boost", 5);         // shift-boost factor
   S->setValue("view/padding", .1);                // additional space around draw region
@@ -199,6 +223,8 @@ QSettings* settings::GUISettings::m_defs()
   S->setValue("dbdot/diameter_l", 2);           // dot diameter (large)
   S->setValue("dbdot/publish_scale", 1.8);      // scaling for publish mode
   S->setValue("dbdot/edge_width", .15);         // edge width rel. to diameter
+  S->setValue("dbdot/batch_render", false);     // draw DB layers with a single batched renderer item
+  S->setValue("dbdot/batch_cell_size", 50.);    // batched renderer grid cell size in angstrom
   S->setValue("dbdot/edge_col", QColor(255,255,255));     // edge color
   S->setValue("dbdot/edge_col_sel", QColor(0,100,255));   // edge color (selected)
   S->setValue("dbdot/edge_col_hovered", QColor(0,100,255)); // edge color (hovered)
@@ -247,6 +273,7 @@ QSettings* settings::GUISettings::m_defs()
   S->setValue("latdot/edge_width", .15);                  // edge width rel. to diameter
   S->setValue("latdot/edge_width_pb", .2);
   S->setValue("latdot/zoom_vis_threshold", 0.03);         // the zoom threshold (m11 transform) below which the lattice stops being shown
+  S->setValue("latdot/bkg_cache_kb", 32768);              // size limit of the lattice background tile cache in KiB
   S->setValue("latdot/edge_col", QColor(0,0,0,0)); // edge color
   S->setValue("latdot/edge_col_pb", QColor("#BABABA"));    // edge color (publish mode)
   S->setValue("latdot/fill_col", QColor(255,255,255,60));        // fill color
@@ -333,6 +360,11 @@ QSettings* settings::GUISettings::m_defs()
   S->setValue("screenshotcliparea/edge_width", .5);                    // edge width in angstrom
   S->setValue("screenshotcliparea/edge_col", QColor(0,0,0,255));      // edge color
 
+  // area of interest outline parameters
+  S->setValue("areaofinterest/edge_width", .5);                       // edge width in angstrom
+  S->setValue("areaofinterest/edge_col", QColor(255,140,0,255));      // area edge color
+  S->setValue("areaofinterest/halo_col", QColor(255,140,0,140));      // halo edge color
+
   // scale bar parameters
   S->setValue("scalebar/edge_width", 1.5);
   S->setValue("scalebar/text_height", 3);
@@ -37,6 +37,7 @@ void SettingsDialog::applyPendingChanges()
       s_cat->setValue(changed_prop.meta["key"], changed_prop.value);
     }
   }
+  emit sig_settingsApplied();
 }
 
 
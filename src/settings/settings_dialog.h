@@ -46,6 +46,9 @@ namespace settings{
     //! Signal application.cc to reset all settings at application destruction.
     void sig_resetSettings();
 
+    //! Emitted after changes made in the settings forms were applied.
+    void sig_settingsApplied();
+
   public slots:
 
     //! Apply changes made in the settings forms.
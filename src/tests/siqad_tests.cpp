@@ -2,6 +2,15 @@
 
 #include "gui/widgets/managers/layer_manager.h"
 #include "gui/widgets/primitives/lattice.h"
+#include "gui/widgets/design_panel.h"
+#include "gui/widgets/design_binary.h"
+#include "gui/widgets/gzip_device.h"
+#include "gui/widgets/tiled_design.h"
+#include "gui/widgets/components/parameter_sweep.h"
+#include "gui/widgets/components/sim_job.h"
+#include "gui/widgets/components/job_exporter.h"
+#include "libs/miniz/miniz.h"
+#include "gui/save_context.h"
 
 class SiQADTests: public QObject
 {
@@ -9,7 +18,541 @@ class SiQADTests: public QObject
 
 // functions in these slots are automatically called
 private slots:
-  
+
+  void initTestCase()
+  {
+    prim::Item::init();
+  }
+
+  // electrodes spilled from the undo history must come back unchanged
+  void testCompactedElectrodeRoundTrip()
+  {
+    prim::Electrode elec(2, QRectF(QPointF(10, 20), QPointF(110, 70)));
+    elec.setRotation(30);
+    elec.setColor(QColor("#80ff0000"));
+
+    QByteArray item_xml = gui::DesignPanel::compactItem(&elec);
+    QVERIFY(!item_xml.isEmpty());
+
+    prim::Item *item = gui::DesignPanel::restoreItem(item_xml, 2);
+    QVERIFY(item != nullptr);
+    QCOMPARE(item->item_type, prim::Item::Electrode);
+    QCOMPARE(item->layer_id, 2);
+    QVERIFY(item->scene() == nullptr);
+    prim::Electrode *restored = static_cast<prim::Electrode*>(item);
+    QCOMPARE(restored->sceneRect(), elec.sceneRect());
+    QCOMPARE(restored->getAngleDegrees(), elec.getAngleDegrees());
+    QCOMPARE(restored->getCurrentFillColor(), elec.getCurrentFillColor());
+    delete item;
+
+    // only electrodes are compacted
+    prim::DBDot db(prim::LatticeCoord(0, 0, 0), 1);
+    QVERIFY(gui::DesignPanel::compactItem(&db).isEmpty());
+  }
+
+  // sqb chunks must come back intact and damaged chunks must be rejected
+  void testSqbChunks()
+  {
+    QByteArray payload = QByteArray("0123456789abcdef").repeated(256);
+
+    // round trip, the payload compresses so it is stored deflated
+    QBuffer buf;
+    buf.open(QIODevice::WriteOnly);
+    gui::sqb::Writer wr(&buf);
+    QVERIFY(wr.begin());
+    QVERIFY(wr.writeChunk(gui::sqb::HeadChunk, payload));
+    QVERIFY(wr.finish());
+    buf.close();
+    QByteArray file = buf.data();
+    QVERIFY(file.size() < payload.size());
+
+    quint32 tag;
+    QByteArray raw;
+    buf.open(QIODevice::ReadOnly);
+    gui::sqb::Reader rd(&buf);
+    QVERIFY(rd.begin());
+    QVERIFY(rd.readChunk(tag, raw));
+    QCOMPARE(tag, quint32(gui::sqb::HeadChunk));
+    QCOMPARE(raw, payload);
+    QVERIFY(!rd.readChunk(tag, raw));
+    QVERIFY(!rd.hasError());
+    buf.close();
+
+    // chunks start after the 8 byte file header, the raw size follows the
+    // tag and flags and the CRC-32 ends the 28 byte chunk header
+    const int chunk_pos = 8;
+    const int raw_size_pos = chunk_pos + 8;
+    const int payload_pos = chunk_pos + 28;
+    auto readFirstChunk = [&tag, &raw](QByteArray data, QString &err)
+    {
+      QBuffer dbuf(&data);
+      dbuf.open(QIODevice::ReadOnly);
+      gui::sqb::Reader drd(&dbuf);
+      if (!drd.begin() || drd.readChunk(tag, raw))
+        return false;
+      err = drd.errorString();
+      return drd.hasError();
+    };
+    QString err;
+
+    // CRC mismatch of a stored chunk
+    QBuffer plain_buf;
+    plain_buf.open(QIODevice::WriteOnly);
+    gui::sqb::Writer plain_wr(&plain_buf, 0);
+    QVERIFY(plain_wr.begin());
+    QVERIFY(plain_wr.writeChunk(gui::sqb::HeadChunk, payload));
+    QVERIFY(plain_wr.finish());
+    QByteArray corrupt = plain_buf.data();
+    corrupt[payload_pos + 100] = corrupt[payload_pos + 100] ^ 0x01;
+    QVERIFY(readFirstChunk(corrupt, err));
+    QVERIFY(err.contains("checksum"));
+
+    // truncated chunk payload
+    QVERIFY(readFirstChunk(file.left(payload_pos + 10), err));
+
+    // a raw size beyond what deflate can expand to is refused before any
+    // allocation
+    corrupt = file;
+    qToLittleEndian<quint64>(Q_UINT64_C(1) << 40, corrupt.data() + raw_size_pos);
+    QVERIFY(readFirstChunk(corrupt, err));
+    QVERIFY(err.contains("size is corrupt"));
+  }
+
+  // sqd -> sqb -> sqd keeps the DBs, their aggregates and colors, and a DB
+  // chunk with a corrupt structure is rejected without a partial output file
+  void testSqbDesignRoundTrip()
+  {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString sqd_path = dir.filePath("design.sqd");
+    QString sqb_path = dir.filePath("design.sqb");
+    QString back_path = dir.filePath("design_back.sqd");
+
+    // two sites per unit cell, loose DBs around nested aggregates
+    {
+      QFile file(sqd_path);
+      QVERIFY(file.open(QIODevice::WriteOnly));
+      QXmlStreamWriter ws(&file);
+      ws.setAutoFormatting(true);
+      ws.writeStartDocument();
+      ws.writeStartElement("siqad");
+      ws.writeStartElement("layers");
+      ws.writeStartElement("layer_prop");
+      ws.writeTextElement("name", "Lattice");
+      ws.writeTextElement("type", "Lattice");
+      ws.writeStartElement("lat_vec");
+      ws.writeTextElement("name", "test");
+      ws.writeEmptyElement("a1");
+      ws.writeAttribute("x", "3.84");
+      ws.writeAttribute("y", "0");
+      ws.writeEmptyElement("a2");
+      ws.writeAttribute("x", "0");
+      ws.writeAttribute("y", "7.68");
+      ws.writeTextElement("N", "2");
+      ws.writeEmptyElement("b1");
+      ws.writeAttribute("x", "0");
+      ws.writeAttribute("y", "0");
+      ws.writeEmptyElement("b2");
+      ws.writeAttribute("x", "0");
+      ws.writeAttribute("y", "2.25");
+      ws.writeEndElement();
+      ws.writeEndElement();
+      ws.writeStartElement("layer_prop");
+      ws.writeTextElement("name", "Surface");
+      ws.writeTextElement("type", "DB");
+      ws.writeEndElement();
+      ws.writeEndElement();
+
+      auto writeDB = [&ws](int n, int m, int l, const QString &color) {
+        ws.writeStartElement("dbdot");
+        ws.writeEmptyElement("latcoord");
+        ws.writeAttribute("n", QString::number(n));
+        ws.writeAttribute("m", QString::number(m));
+        ws.writeAttribute("l", QString::number(l));
+        ws.writeTextElement("color", color);
+        ws.writeEndElement();
+      };
+      ws.writeStartElement("design");
+      ws.writeStartElement("layer");
+      ws.writeAttribute("type", "Lattice");
+      ws.writeEndElement();
+      ws.writeStartElement("layer");
+      ws.writeAttribute("type", "DB");
+      writeDB(1, 2, 0, "#ffff0000");
+      ws.writeStartElement("aggregate");
+      writeDB(3, 4, 1, "#ff00ff00");
+      ws.writeStartElement("aggregate");
+      writeDB(5, 6, 0, "#ff0000ff");
+      ws.writeEndElement();
+      writeDB(7, 8, 1, "#ff00ff00");
+      ws.writeEndElement();
+      writeDB(-1, -2, 1, "#ffff0000");
+      ws.writeEndElement();
+      ws.writeEndElement();
+      ws.writeEndElement();
+      ws.writeEndDocument();
+    }
+
+    struct DBCollector : gui::sqb::DesignSink
+    {
+      void head(const QByteArray &) override {}
+      void lattice(const gui::sqb::LatticeRecord &) override {}
+      void layers(const QList<gui::sqb::LayerRecord> &) override {}
+      bool items(const gui::sqb::ItemChunk &chunk) override
+      {
+        if (chunk.tag == gui::sqb::DBChunk)
+          dbs.appendRecord(chunk.dbs);
+        return true;
+      }
+      gui::sqb::DBRecord dbs;
+    };
+    auto readDBs = [](const QString &path, gui::sqb::DBRecord &dbs) {
+      QFile file(path);
+      if (!file.open(QIODevice::ReadOnly))
+        return false;
+      DBCollector sink;
+      QString err;
+      if (gui::sqb::parseDesign(&file, &sink, gui::sqb::ParseOptions(), err) != gui::sqb::ParseOk)
+        return false;
+      dbs = sink.dbs;
+      return true;
+    };
+
+    QString err;
+    QVERIFY2(gui::sqb::sqdToSqb(sqd_path, sqb_path, err), qPrintable(err));
+    QVERIFY2(gui::sqb::sqbToSqd(sqb_path, back_path, err), qPrintable(err));
+    QVERIFY(!QFile::exists(sqb_path + ".writing"));
+    QVERIFY(!QFile::exists(back_path + ".writing"));
+
+    gui::sqb::DBRecord orig, binary, back;
+    QVERIFY(readDBs(sqd_path, orig));
+    QVERIFY(readDBs(sqb_path, binary));
+    QVERIFY(readDBs(back_path, back));
+    QCOMPARE(orig.dbCount(), 5);
+    QCOMPARE(orig.structure, QVector<qint32>({1, gui::sqb::OpenAggregate, 1,
+          gui::sqb::OpenAggregate, 1, gui::sqb::CloseAggregate, 1,
+          gui::sqb::CloseAggregate, 1}));
+    for (const gui::sqb::DBRecord *rec : {&binary, &back}) {
+      QCOMPARE(rec->coords, orig.coords);
+      QCOMPARE(rec->structure, orig.structure);
+      for (int i=0; i<orig.dbCount(); i++)
+        QCOMPARE(rec->color(i), orig.color(i));
+    }
+
+    // unbalanced aggregates and runs not covering the DBs are refused
+    auto structureAccepted = [](const QVector<qint32> &structure) {
+      gui::sqb::DBRecord rec;
+      rec.layer_pos = 1;
+      rec.append(0, 0, 0, 0xffff0000);
+      rec.append(1, 0, 0, 0xffff0000);
+      rec.structure = structure;
+      QBuffer buf;
+      buf.open(QIODevice::WriteOnly);
+      gui::sqb::Writer wr(&buf);
+      if (!wr.begin() || !wr.writeDBs(rec) || !wr.finish())
+        return false;
+      buf.close();
+      buf.open(QIODevice::ReadOnly);
+      gui::sqb::Reader rd(&buf);
+      quint32 tag;
+      QByteArray raw;
+      gui::sqb::DBRecord read;
+      return rd.begin() && rd.readChunk(tag, raw) && gui::sqb::Reader::readDBs(raw, read);
+    };
+    QVERIFY(structureAccepted({gui::sqb::OpenAggregate, 2, gui::sqb::CloseAggregate}));
+    QVERIFY(!structureAccepted({gui::sqb::OpenAggregate, 2}));
+    QVERIFY(!structureAccepted({2, gui::sqb::CloseAggregate}));
+    QVERIFY(!structureAccepted({gui::sqb::CloseAggregate, 2, gui::sqb::OpenAggregate}));
+    QVERIFY(!structureAccepted({1}));
+    QVERIFY(!structureAccepted({3}));
+    QVERIFY(!structureAccepted({0, 2}));
+
+    // a failed conversion keeps the previous output
+    QString corrupt_path = dir.filePath("corrupt.sqb");
+    {
+      QFile file(corrupt_path);
+      QVERIFY(file.open(QIODevice::WriteOnly));
+      gui::sqb::Writer wr(&file);
+      gui::sqb::LayerRecord layer;
+      gui::sqb::DBRecord rec;
+      rec.layer_pos = 0;
+      rec.append(0, 0, 0, 0xffff0000);
+      rec.structure = {gui::sqb::OpenAggregate, 1};
+      QVERIFY(wr.begin() && wr.writeLayers({layer}) && wr.writeDBs(rec) && wr.finish());
+    }
+    QFile back_file(back_path);
+    QVERIFY(back_file.open(QIODevice::ReadOnly));
+    QByteArray back_content = back_file.readAll();
+    back_file.close();
+    QVERIFY(!gui::sqb::sqbToSqd(corrupt_path, back_path, err));
+    QVERIFY(!err.isEmpty());
+    QVERIFY(!QFile::exists(back_path + ".writing"));
+    QVERIFY(back_file.open(QIODevice::ReadOnly));
+    QCOMPARE(back_file.readAll(), back_content);
+  }
+
+  // gzip compression through GzipDevice must round trip and detect damage
+  void testGzipDevice()
+  {
+    QByteArray data;
+    for (int i=0; i<20000; i++)
+      data += QByteArray::number(i) + ' ';
+
+    QBuffer buf;
+    buf.open(QIODevice::WriteOnly);
+    {
+      gui::GzipDevice gz(&buf, gui::GzipDevice::BestLevel);
+      QVERIFY(gz.open(QIODevice::WriteOnly));
+      // write in pieces to stream through the compressor
+      for (int pos=0; pos<data.size(); pos+=1000)
+        QCOMPARE(gz.write(data.mid(pos, 1000)), qint64(data.mid(pos, 1000).size()));
+      gz.close();
+    }
+    buf.close();
+    QByteArray compressed = buf.data();
+    QVERIFY(compressed.size() < data.size());
+
+    buf.open(QIODevice::ReadOnly);
+    QVERIFY(gui::GzipDevice::isGzip(&buf));
+    QCOMPARE(buf.pos(), qint64(0));
+    {
+      gui::GzipDevice gz(&buf);
+      QVERIFY(gz.open(QIODevice::ReadOnly));
+      QCOMPARE(gz.readAll(), data);
+    }
+    buf.close();
+
+    // plain data isn't taken for gzip
+    QBuffer plain(&data);
+    plain.open(QIODevice::ReadOnly);
+    QVERIFY(!gui::GzipDevice::isGzip(&plain));
+    QVERIFY(gui::GzipDevice::decompressing(&plain) == &plain);
+
+    // a damaged CRC-32 in the trailer is reported
+    compressed[compressed.size()-8] = compressed[compressed.size()-8] ^ 0x01;
+    QBuffer corrupt(&compressed);
+    corrupt.open(QIODevice::ReadOnly);
+    gui::GzipDevice gz(&corrupt);
+    QVERIFY(gz.open(QIODevice::ReadOnly));
+    gz.readAll();
+    QVERIFY(gz.errorString().contains("checksum"));
+  }
+
+  // ranges include their stop value and may count down
+  void testSweepExpressions()
+  {
+    QStringList values;
+    QString err;
+
+    QVERIFY(comp::ParameterSweep::expandExpression("-0.35:-0.25:0.05", values, err));
+    QCOMPARE(values, QStringList({"-0.35", "-0.3", "-0.25"}));
+
+    QVERIFY(comp::ParameterSweep::expandExpression("1:0:-0.25", values, err));
+    QCOMPARE(values, QStringList({"1", "0.75", "0.5", "0.25", "0"}));
+
+    QVERIFY(comp::ParameterSweep::expandExpression("[5.6, 8.0, 11.7]", values, err));
+    QCOMPARE(values, QStringList({"5.6", "8.0", "11.7"}));
+
+    // steps leading away from the stop value are malformed
+    QVERIFY(!comp::ParameterSweep::expandExpression("0:1:-0.5", values, err));
+    QVERIFY(!comp::ParameterSweep::expandExpression("0:1:0", values, err));
+
+    // max_points values are accepted, one more is refused
+    int max_points = comp::ParameterSweep::max_points;
+    QVERIFY(comp::ParameterSweep::expandExpression(
+          QString("1:%1:1").arg(max_points), values, err));
+    QCOMPARE(values.size(), max_points);
+    QVERIFY(!comp::ParameterSweep::expandExpression(
+          QString("0:%1:1").arg(max_points), values, err));
+  }
+
+  // the result cache key of a problem doesn't depend on its layout
+  void testCanonicalXmlHash()
+  {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    auto writeProblem = [](const QString &path, gui::SaveContext::Layout layout,
+        const QString &date, double mu, double zoom=1)
+    {
+      QFile file(path);
+      if (!file.open(QFile::WriteOnly))
+        return false;
+      gui::SaveContext ctx(layout, 6, 'g');
+      QXmlStreamWriter ws(&file);
+      ctx.setupWriter(&ws);
+      ws.writeStartDocument();
+      ws.writeStartElement("siqad");
+      ws.writeStartElement("program");
+      ws.writeTextElement("date", date);
+      ws.writeEndElement();
+      ws.writeStartElement("gui");
+      ws.writeTextElement("zoom", ctx.real(zoom));
+      ws.writeEmptyElement("displayed_region");
+      ws.writeAttribute("x1", ctx.real(-10*zoom));
+      ws.writeAttribute("y1", ctx.real(-5*zoom));
+      ws.writeEndElement();
+      ws.writeStartElement("sim_params");
+      ws.writeTextElement("muzm", ctx.real(mu));
+      // numbers in different notations
+      ws.writeTextElement("debye_length", layout == gui::SaveContext::Pretty ? "5" : "5.0");
+      ws.writeEndElement();
+      ws.writeStartElement("dbdot");
+      // attribute order differs between the layouts
+      if (layout == gui::SaveContext::Pretty) {
+        ws.writeAttribute("n", ctx.number(1));
+        ws.writeAttribute("m", ctx.number(2));
+      } else {
+        ws.writeAttribute("m", ctx.number(2));
+        ws.writeAttribute("n", ctx.number(1));
+      }
+      ws.writeEndElement();
+      ws.writeEndElement();
+      ws.writeEndDocument();
+      return true;
+    };
+    auto hashOf = [](const QString &path)
+    {
+      QCryptographicHash hash(QCryptographicHash::Sha256);
+      return comp::JobStep::addCanonicalXml(hash, path) ? hash.result() : QByteArray();
+    };
+
+    QString pretty_path = dir.filePath("pretty.xml");
+    QString compact_path = dir.filePath("compact.xml");
+    QString changed_path = dir.filePath("changed.xml");
+    QString zoomed_path = dir.filePath("zoomed.xml");
+    QVERIFY(writeProblem(pretty_path, gui::SaveContext::Pretty, "2026-10-17", -0.28));
+    QVERIFY(writeProblem(compact_path, gui::SaveContext::Compact, "2026-10-18", -0.28));
+    QVERIFY(writeProblem(changed_path, gui::SaveContext::Compact, "2026-10-18", -0.29));
+    QVERIFY(writeProblem(zoomed_path, gui::SaveContext::Pretty, "2026-10-17", -0.28, 2.5));
+
+    QByteArray pretty_hash = hashOf(pretty_path);
+    QVERIFY(!pretty_hash.isEmpty());
+    QCOMPARE(hashOf(compact_path), pretty_hash);
+    // panning and zooming between runs must not miss the cache
+    QCOMPARE(hashOf(zoomed_path), pretty_hash);
+    QVERIFY(hashOf(changed_path) != pretty_hash);
+    QVERIFY(hashOf(dir.filePath("missing.xml")).isEmpty());
+  }
+
+  // files above the batch bound are written on their own, stored or not
+  void testJobExportLargeFiles()
+  {
+    QTemporaryDir src_dir, out_dir;
+    QVERIFY(src_dir.isValid() && out_dir.isValid());
+
+    QMap<QString, QByteArray> files;
+    files["a_small.txt"] = QByteArray("small file");
+    files["b_large.txt"] = QByteArray("compressible text ").repeated(512);
+    files["c_large.png"] = QByteArray("not really a png ").repeated(512);
+    files["sub/d_small.txt"] = QByteArray("another small file");
+    QDir().mkpath(src_dir.filePath("sub"));
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+      QFile file(src_dir.filePath(it.key()));
+      QVERIFY(file.open(QIODevice::WriteOnly));
+      file.write(it.value());
+    }
+
+    // level 0 stores every file, which used to stall on stored large files
+    for (int level : {0, 6}) {
+      QString out_path = out_dir.filePath(QString("job_%1.sqjx.zip").arg(level));
+      comp::JobExporter exporter(src_dir.path(), out_path, level);
+      exporter.setBatchBytes(1024);
+      QSignalSpy finished(&exporter, &comp::JobExporter::sig_finished);
+      exporter.start();
+      QVERIFY(finished.wait(10000));
+      QVERIFY(finished.first().at(0).toBool());
+
+      mz_zip_archive zip;
+      memset(&zip, 0, sizeof(zip));
+      QVERIFY(mz_zip_reader_init_file(&zip, QFile::encodeName(out_path).constData(), 0));
+      QCOMPARE(int(mz_zip_reader_get_num_files(&zip)), files.size());
+      for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        size_t size = 0;
+        void *data = mz_zip_reader_extract_file_to_heap(&zip, it.key().toUtf8().constData(),
+            &size, 0);
+        QVERIFY(data != nullptr);
+        QCOMPARE(QByteArray(static_cast<const char*>(data), qsizetype(size)), it.value());
+        mz_free(data);
+      }
+      mz_zip_reader_end(&zip);
+    }
+  }
+
+  // tiles pinned by the undo history can be evicted once the commands
+  // referring to them left the history
+  void testUndoPinsRelease()
+  {
+    const int layer_id = 1;
+    QUndoStack stack;
+    stack.setUndoLimit(2);
+    gui::UndoPins pins;
+    auto push = [&](int item_count) {
+      stack.push(new QUndoCommand());
+      pins.update(&stack, {{layer_id, item_count}});
+    };
+
+    // an edit while a large tile is resident pins it
+    push(300);
+    QVERIFY(pins.pinsLayer(layer_id));
+    QCOMPARE(pins.pin(layer_id), 300);
+
+    // later edits with fewer items resident keep the pin of the first one
+    push(100);
+    QCOMPARE(pins.pin(layer_id), 300);
+
+    // undoing and redoing runs the command again
+    stack.undo();
+    pins.update(&stack, {{layer_id, 120}});
+    QCOMPARE(pins.pin(layer_id), 300);
+    stack.redo();
+    pins.update(&stack, {{layer_id, 120}});
+    QCOMPARE(pins.pin(layer_id), 300);
+
+    // the undo limit drops the first edit, its tile can be evicted again
+    push(100);
+    QCOMPARE(stack.count(), 2);
+    QCOMPARE(pins.pin(layer_id), 120);
+
+    // clearing the history releases everything
+    stack.clear();
+    pins.update(&stack, {{layer_id, 100}});
+    QVERIFY(!pins.pinsLayer(layer_id));
+    QCOMPARE(pins.pin(layer_id), 0);
+  }
+
+  // free site and range scans over the occupancy index, across tile
+  // boundaries and negative coordinates
+  void testOccupancyRangeQueries()
+  {
+    const int n_cell = 2;
+    prim::LatticeOccupancy occ;
+    QCOMPARE(occ.firstFreeSite(0, 3, 0, 3, n_cell), prim::LatticeCoord(0, 0, 0));
+
+    // the first row is full, the first cell of the second row half full
+    for (int n=0; n<=3; n++)
+      for (int l=0; l<n_cell; l++)
+        occ.insert(prim::LatticeCoord(n, 0, l), nullptr);
+    occ.insert(prim::LatticeCoord(0, 1, 0), nullptr);
+    QCOMPARE(occ.firstFreeSite(0, 3, 0, 3, n_cell), prim::LatticeCoord(0, 1, 1));
+    QCOMPARE(occ.firstFreeSite(0, 3, 0, 0, n_cell).l, -1);
+    QCOMPARE(occ.occupiedInRange(0, 3, 0, 3).size(), 4*n_cell + 1);
+
+    // a full row spanning two tiles left of the origin
+    const int n_first = -prim::LatticeOccupancy::tile_dim - 8;
+    for (int n=n_first; n<0; n++)
+      for (int l=0; l<n_cell; l++)
+        occ.insert(prim::LatticeCoord(n, -5, l), nullptr);
+    QCOMPARE(occ.firstFreeSite(n_first, -1, -5, -5, n_cell).l, -1);
+    QCOMPARE(occ.firstFreeSite(n_first, 2, -5, -5, n_cell), prim::LatticeCoord(0, -5, 0));
+    QCOMPARE(occ.occupiedInRange(n_first, 0, -5, -5).size(), -n_first*n_cell);
+    QVERIFY(occ.occupiedInRange(n_first, 3, -4, -1).isEmpty());
+
+    // freed sites are found again
+    occ.remove(prim::LatticeCoord(-3, -5, 1));
+    QCOMPARE(occ.firstFreeSite(n_first, -1, -5, -5, n_cell), prim::LatticeCoord(-3, -5, 1));
+  }
+
   // void testLayerManager()
   // {
   //   gui::LayerManager *layman = new gui::LayerManager(nullptr);